@@ -166,6 +166,8 @@ float Visibility(float NdotV, float NdotL, float rough) {
 	return ggxV * ggxL * 0.25;
 }
 
+// Shade lights which are binned into the cluster of the fragment instead of looping over all lights.
+#define CLUSTERED_LIGHTING
 #include "light.sh"
 
 void main()
@@ -1,5 +1,40 @@
 #include "../UniformDefines/U_Light.sh"
 
+#if defined(CLUSTERED_LIGHTING)
+// Lights are binned into view space clusters on CPU, see ClusteredLightUniforms.h.
+// s_lightData : 5 texels per light in the same layout as u_lightParams.
+// s_lightGrid : (offset, count) of every cluster's list in s_lightIndices. x is the tile and y is the slice.
+// s_lightIndices : light indexes of all clusters.
+// u_clusterParams[0] : tile count x, tile count y, slice count, width of s_lightIndices.
+// u_clusterParams[1] : slice scale, slice bias, light count, unused. slice = log(view depth) * scale + bias.
+SAMPLER2D(s_lightData, 6);
+SAMPLER2D(s_lightGrid, 7);
+SAMPLER2D(s_lightIndices, 8);
+uniform vec4 u_clusterParams[2];
+
+U_Light GetClusteredLightParams(int lightIndex) {
+	vec4 params0 = texelFetch(s_lightData, ivec2(0, lightIndex), 0);
+	vec4 params1 = texelFetch(s_lightData, ivec2(1, lightIndex), 0);
+	vec4 params2 = texelFetch(s_lightData, ivec2(2, lightIndex), 0);
+	vec4 params3 = texelFetch(s_lightData, ivec2(3, lightIndex), 0);
+	vec4 params4 = texelFetch(s_lightData, ivec2(4, lightIndex), 0);
+	
+	U_Light light;
+	light.type              = params0.x;
+	light.position          = params0.yzw;
+	light.intensity         = params1.x;
+	light.color             = params1.yzw;
+	light.range             = params2.x;
+	light.direction         = params2.yzw;
+	light.radius            = params3.x;
+	light.up                = params3.yzw;
+	light.width             = params4.x;
+	light.height            = params4.y;
+	light.lightAngleScale   = params4.z;
+	light.lightAngleOffeset = params4.w;
+	return light;
+}
+#else
 uniform vec4 u_lightParams[LIGHT_LENGTH];
 
 U_Light GetLightParams(int pointer) {
@@ -26,6 +61,7 @@ U_Light GetLightParams(int pointer) {
 	light.lightAngleOffeset = u_lightParams[pointer + 4].w;
 	return light;
 }
+#endif
 
 // -------------------- Utils -------------------- //
 
@@ -506,6 +542,28 @@ vec3 CalculateLight(U_Light light, Material material, vec3 worldPos, vec3 viewDi
 	return color;
 }
 
+#if defined(CLUSTERED_LIGHTING)
+vec3 CalculateLights(Material material, vec3 worldPos, vec3 viewDir, vec3 diffuseBRDF) {
+	// Find the cluster by the tile in NDC and the exponential slice of view depth.
+	vec4 viewPos = mul(u_view, vec4(worldPos, 1.0));
+	vec4 clipPos = mul(u_proj, viewPos);
+	vec2 tileCount = u_clusterParams[0].xy;
+	vec2 tile = clamp(floor((clipPos.xy / clipPos.w * 0.5 + 0.5) * tileCount), vec2_splat(0.0), tileCount - 1.0);
+	float slice = clamp(floor(log(max(viewPos.z, 0.0001)) * u_clusterParams[1].x + u_clusterParams[1].y), 0.0, u_clusterParams[0].z - 1.0);
+	vec2 lightRange = texelFetch(s_lightGrid, ivec2(int(tile.y * tileCount.x + tile.x), int(slice)), 0).xy;
+	
+	int indexWidth = int(u_clusterParams[0].w);
+	int firstIndex = int(lightRange.x);
+	vec3 color = vec3_splat(0.0);
+	for(int index = firstIndex; index < firstIndex + int(lightRange.y); ++index) {
+		int row = index / indexWidth;
+		int lightIndex = int(texelFetch(s_lightIndices, ivec2(index - row * indexWidth, row), 0).x);
+		U_Light light = GetClusteredLightParams(lightIndex);
+		color += CalculateLight(light, material, worldPos, viewDir, diffuseBRDF);
+	}
+	return color;
+}
+#else
 vec3 CalculateLights(Material material, vec3 worldPos, vec3 viewDir, vec3 diffuseBRDF) {
 	vec3 color = vec3_splat(0.0);
 	for(int lightIndex = 0; lightIndex < int(u_lightCount[0].x); ++lightIndex) {
@@ -515,3 +573,4 @@ vec3 CalculateLights(Material material, vec3 worldPos, vec3 viewDir, vec3 diffus
 	}
 	return color;
 }
+#endif
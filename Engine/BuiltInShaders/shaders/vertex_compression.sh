@@ -0,0 +1,16 @@
+// Decoders of packed vertex attributes, see VertexCompression.hpp.
+// Meshes whose positions aren't quantized set the identity : offset 0 and scale 1.
+uniform vec4 u_positionDequantize[2];
+
+vec3 DecodePosition(vec3 position) {
+	return u_positionDequantize[0].xyz + position * u_positionDequantize[1].xyz;
+}
+
+// Unorm8 octahedral encoding. The lower hemisphere is folded onto the corners.
+vec3 DecodeOctahedral(vec2 encoded) {
+	vec2 e = encoded * 2.0 - 1.0;
+	vec3 direction = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float fold = max(-direction.z, 0.0);
+	direction.xy += mix(vec2_splat(fold), vec2_splat(-fold), step(vec2_splat(0.0), direction.xy));
+	return normalize(direction);
+}
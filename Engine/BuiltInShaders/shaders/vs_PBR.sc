@@ -1,17 +1,23 @@
-$input a_position, a_normal, a_tangent, a_texcoord0
+$input a_position, a_normal, a_texcoord0
 $output v_worldPos, v_normal, v_texcoord0, v_TBN
 
 #include "../common/common.sh"
 #include "uniforms.sh"
+#include "vertex_compression.sh"
 
 void main()
 {
-	gl_Position = mul(u_modelViewProj, vec4(a_position, 1.0));
+	// Position is quantized in the mesh bounds, normal and tangent are packed into a_normal.
+	vec3 position = DecodePosition(a_position);
+	vec3 normal   = DecodeOctahedral(a_normal.xy);
+	vec3 tangent  = DecodeOctahedral(a_normal.zw);
+	
+	gl_Position = mul(u_modelViewProj, vec4(position, 1.0));
 
-	v_worldPos = mul(u_model[0], vec4(a_position, 1.0)).xyz;
+	v_worldPos = mul(u_model[0], vec4(position, 1.0)).xyz;
 	
-	v_normal     = normalize(mul(u_modelInvTrans, vec4(a_normal, 0.0)).xyz);
-	vec3 tangent = normalize(mul(u_modelInvTrans, vec4(a_tangent, 0.0)).xyz);
+	v_normal = normalize(mul(u_modelInvTrans, vec4(normal, 0.0)).xyz);
+	tangent  = normalize(mul(u_modelInvTrans, vec4(tangent, 0.0)).xyz);
 	
 	// re-orthogonalize T with respect to N
 	tangent        = normalize(tangent - dot(tangent, v_normal) * v_normal);
@@ -0,0 +1,37 @@
+$input a_position, a_normal, a_texcoord0, i_data0, i_data1, i_data2, i_data3
+$output v_worldPos, v_normal, v_texcoord0, v_TBN
+
+#include "../common/common.sh"
+#include "uniforms.sh"
+#include "vertex_compression.sh"
+
+// Same as vs_PBR but world matrices come from per-instance data instead of u_model.
+void main()
+{
+	mat4 model = mtxFromCols(i_data0, i_data1, i_data2, i_data3);
+	vec4 worldPos = mul(model, vec4(DecodePosition(a_position), 1.0));
+	gl_Position = mul(u_viewProj, worldPos);
+
+	v_worldPos = worldPos.xyz;
+	
+	// The cofactor matrix is the inverse transpose of the upper 3x3 matrix scaled by its determinant.
+	// Normalization removes the scale but not its sign, which flips normals of mirrored instances.
+	vec3 axisX = i_data0.xyz;
+	vec3 axisY = i_data1.xyz;
+	vec3 axisZ = i_data2.xyz;
+	vec3 cofactorX = cross(axisY, axisZ);
+	float determinantSign = dot(axisX, cofactorX) < 0.0 ? -1.0 : 1.0;
+	mat3 modelInvTrans = mtxFromCols(cofactorX * determinantSign, cross(axisZ, axisX) * determinantSign, cross(axisX, axisY) * determinantSign);
+	
+	v_normal     = normalize(mul(modelInvTrans, DecodeOctahedral(a_normal.xy)));
+	vec3 tangent = normalize(mul(modelInvTrans, DecodeOctahedral(a_normal.zw)));
+	
+	// re-orthogonalize T with respect to N
+	tangent        = normalize(tangent - dot(tangent, v_normal) * v_normal);
+	vec3 biTangent = normalize(cross(v_normal, tangent));
+	
+	// TBN
+	v_TBN = mtxFromCols(tangent, biTangent, v_normal);
+	
+	v_texcoord0 = a_texcoord0;
+}
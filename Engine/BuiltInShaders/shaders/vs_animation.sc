@@ -3,6 +3,7 @@ $output v_worldPos
 
 #include "../common/common.sh"
 #include "uniforms.sh"
+#include "vertex_compression.sh"
 
 uniform mat4 u_boneMatrices[128];
 
@@ -13,8 +14,10 @@ void main()
 	boneTransform += u_boneMatrices[a_indices[2]] * a_weight[2];
 	boneTransform += u_boneMatrices[a_indices[3]] * a_weight[3];
 	
-	vec4 localPosition = mul(boneTransform, vec4(a_position, 1.0));
+	// Bone indexes are uint8 and weights are unorm8 which are converted by the input assembler.
+	vec3 position = DecodePosition(a_position);
+	vec4 localPosition = mul(boneTransform, vec4(position, 1.0));
 	gl_Position = mul(u_modelViewProj, localPosition);
 	
-	v_worldPos = mul(u_model[0], vec4(a_position, 1.0)).xyz;
+	v_worldPos = mul(u_model[0], vec4(position, 1.0)).xyz;
 }
\ No newline at end of file
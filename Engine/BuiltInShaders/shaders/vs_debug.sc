@@ -10,7 +10,7 @@ void main()
 
 	v_worldPos = mul(u_model[0], vec4(a_position, 1.0)).xyz;
 
-	v_normal = normalize(mul(u_modelInvTrans, vec4(a_normal, 0.0)).xyz);
+	v_normal = normalize(mul(u_modelInvTrans, vec4(a_normal.xyz, 0.0)).xyz);
 
 	v_bc = a_color1;
 }
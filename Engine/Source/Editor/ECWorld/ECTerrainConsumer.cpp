@@ -71,6 +71,10 @@ void ECTerrainConsumer::AddStaticMesh(engine::Entity entity, const cd::Mesh* mes
 	engine::StaticMeshComponent& staticMeshComponent = pWorld->CreateComponent<engine::StaticMeshComponent>(entity);
 	staticMeshComponent.SetMeshData(mesh);
 	staticMeshComponent.SetRequiredVertexFormat(&vertexFormat);
+	// TerrainRenderer draws full terrain meshes.
+	engine::MeshLODBuilder::Settings lodSettings;
+	lodSettings.lodCount = 0;
+	staticMeshComponent.SetLODSettings(lodSettings);
 	staticMeshComponent.Build();
 }
 
@@ -63,10 +63,10 @@ void ECWorldConsumer::Execute(const cd::SceneDatabase* pSceneDatabase)
 		CD_WARN("[ECWorldConsumer] No valid meshes in the consumed SceneDatabase.");
 	}
 
-	auto ParseMesh = [&](cd::MeshID meshID, const cd::Transform& tranform)
+	auto ParseMesh = [&](cd::MeshID meshID)
 	{
 		engine::Entity meshEntity = m_pSceneWorld->GetWorld()->CreateEntity();
-		AddTransform(meshEntity, tranform);
+		AddTransform(meshEntity, cd::Transform::Identity());
 
 		const auto& mesh = pSceneDatabase->GetMesh(meshID.Data());
 
@@ -75,7 +75,7 @@ void ECWorldConsumer::Execute(const cd::SceneDatabase* pSceneDatabase)
 		if (isStaticMesh)
 		{
 			engine::MaterialType* pMaterialType = m_pSceneWorld->GetPBRMaterialType();
-			AddStaticMesh(meshEntity, mesh, pMaterialType->GetRequiredVertexFormat());
+			AddStaticMesh(meshEntity, mesh, pMaterialType->GetRequiredVertexFormat(), pMaterialType->GetVertexCompression());
 
 			cd::MaterialID meshMaterialID = mesh.GetMaterialID();
 			if (meshMaterialID.IsValid())
@@ -86,13 +86,15 @@ void ECWorldConsumer::Execute(const cd::SceneDatabase* pSceneDatabase)
 		else
 		{
 			engine::MaterialType* pMaterialType = m_pSceneWorld->GetAnimationMaterialType();
-			AddSkinMesh(meshEntity, mesh, pMaterialType->GetRequiredVertexFormat());
+			AddSkinMesh(meshEntity, mesh, pMaterialType->GetRequiredVertexFormat(), pMaterialType->GetVertexCompression());
 
 			// TODO : Use a standalone .cdanim file to play animation.
 			// Currently, we assume that imported SkinMesh will play animation automatically for testing.
 			AddAnimation(meshEntity, pSceneDatabase->GetAnimation(0), pSceneDatabase);
 			AddMaterial(meshEntity, nullptr, pMaterialType, pSceneDatabase);
 		}
+
+		return meshEntity;
 	};
 
 	// There are multiple kinds of cases in the SceneDatabase:
@@ -100,34 +102,60 @@ void ECWorldConsumer::Execute(const cd::SceneDatabase* pSceneDatabase)
 	// 2. Only a root node with multiple meshes.
 	// 3. Node hierarchy.
 	// Another case is that we want to skip Node/Mesh which alreay parsed previously.
-	std::set<uint32_t> parsedMeshIDs;
-	for (const auto& mesh : pSceneDatabase->GetMeshes())
+	// Nodes keep their local transforms and are linked to parent nodes by HierarchyComponent.
+	// Meshes are children of nodes which reference them, so TransformSystem places them by node world matrices.
+	std::map<uint32_t, engine::Entity> nodeEntities;
+	for (const auto& node : pSceneDatabase->GetNodes())
 	{
-		if (m_meshMinID > mesh.GetID().Data())
+		if (m_nodeMinID > node.GetID().Data())
 		{
 			continue;
 		}
 
-		ParseMesh(mesh.GetID(), cd::Transform::Identity());
-		parsedMeshIDs.insert(mesh.GetID().Data());
+		engine::Entity nodeEntity = m_pSceneWorld->GetWorld()->CreateEntity();
+		AddNode(nodeEntity, node);
+		nodeEntities[node.GetID().Data()] = nodeEntity;
 	}
 
+	// Parents are linked after all node entities are created as a parent node may be stored after its children.
+	std::set<uint32_t> parsedMeshIDs;
 	for (const auto& node : pSceneDatabase->GetNodes())
 	{
-		if (m_nodeMinID > node.GetID().Data())
+		auto itNodeEntity = nodeEntities.find(node.GetID().Data());
+		if (itNodeEntity == nodeEntities.end())
 		{
 			continue;
 		}
 
+		if (node.GetParentID().IsValid())
+		{
+			auto itParentEntity = nodeEntities.find(node.GetParentID().Data());
+			if (itParentEntity != nodeEntities.end())
+			{
+				AddHierarchy(itNodeEntity->second, itParentEntity->second);
+			}
+		}
+
 		for (cd::MeshID meshID : node.GetMeshIDs())
 		{
-			if (parsedMeshIDs.contains(meshID.Data()))
+			if (m_meshMinID > meshID.Data())
 			{
 				continue;
 			}
 
-			ParseMesh(meshID, node.GetTransform());
+			AddHierarchy(ParseMesh(meshID), itNodeEntity->second);
+			parsedMeshIDs.insert(meshID.Data());
+		}
+	}
+
+	for (const auto& mesh : pSceneDatabase->GetMeshes())
+	{
+		if (m_meshMinID > mesh.GetID().Data() || parsedMeshIDs.contains(mesh.GetID().Data()))
+		{
+			continue;
 		}
+
+		ParseMesh(mesh.GetID());
 	}
 
 	for (const auto& camera : pSceneDatabase->GetCameras())
@@ -185,6 +213,22 @@ void ECWorldConsumer::AddLight(engine::Entity entity, const cd::Light& light)
 	transformComponent.Build();
 }
 
+void ECWorldConsumer::AddNode(engine::Entity entity, const cd::Node& node)
+{
+	engine::World* pWorld = m_pSceneWorld->GetWorld();
+	engine::NameComponent& nameComponent = pWorld->CreateComponent<engine::NameComponent>(entity);
+	nameComponent.SetName(node.GetName());
+
+	AddTransform(entity, node.GetTransform());
+}
+
+void ECWorldConsumer::AddHierarchy(engine::Entity entity, engine::Entity parentEntity)
+{
+	engine::World* pWorld = m_pSceneWorld->GetWorld();
+	engine::HierarchyComponent& hierarchyComponent = pWorld->CreateComponent<engine::HierarchyComponent>(entity);
+	hierarchyComponent.SetParentEntity(parentEntity);
+}
+
 void ECWorldConsumer::AddTransform(engine::Entity entity, const cd::Transform& transform)
 {
 	engine::World* pWorld = m_pSceneWorld->GetWorld();
@@ -193,7 +237,7 @@ void ECWorldConsumer::AddTransform(engine::Entity entity, const cd::Transform& t
 	transformComponent.Build();
 }
 
-void ECWorldConsumer::AddStaticMesh(engine::Entity entity, const cd::Mesh& mesh, const cd::VertexFormat& vertexFormat)
+void ECWorldConsumer::AddStaticMesh(engine::Entity entity, const cd::Mesh& mesh, const cd::VertexFormat& vertexFormat, engine::VertexCompression vertexCompression)
 {
 	assert(mesh.GetVertexCount() > 0 && mesh.GetPolygonCount() > 0);
 
@@ -204,12 +248,13 @@ void ECWorldConsumer::AddStaticMesh(engine::Entity entity, const cd::Mesh& mesh,
 	engine::StaticMeshComponent& staticMeshComponent = pWorld->CreateComponent<engine::StaticMeshComponent>(entity);
 	staticMeshComponent.SetMeshData(&mesh);
 	staticMeshComponent.SetRequiredVertexFormat(&vertexFormat);
+	staticMeshComponent.SetVertexCompression(vertexCompression);
 	staticMeshComponent.Build();
 }
 
-void ECWorldConsumer::AddSkinMesh(engine::Entity entity, const cd::Mesh& mesh, const cd::VertexFormat& vertexFormat)
+void ECWorldConsumer::AddSkinMesh(engine::Entity entity, const cd::Mesh& mesh, const cd::VertexFormat& vertexFormat, engine::VertexCompression vertexCompression)
 {
-	AddStaticMesh(entity, mesh, vertexFormat);
+	AddStaticMesh(entity, mesh, vertexFormat, vertexCompression);
 }
 
 void ECWorldConsumer::AddAnimation(engine::Entity entity, const cd::Animation& animation, const cd::SceneDatabase* pSceneDatabase)
@@ -5,6 +5,7 @@
 #include "Framework/IConsumer.h"
 #include "Material/ShaderSchema.h"
 #include "Math/Transform.hpp"
+#include "Rendering/VertexCompression.hpp"
 #include "Scene/MaterialTextureType.h"
 #include "Scene/ObjectID.h"
 
@@ -65,9 +66,11 @@ public:
 private:
 	void AddCamera(engine::Entity entity, const cd::Camera& camera);
 	void AddLight(engine::Entity entity, const cd::Light& light);
+	void AddNode(engine::Entity entity, const cd::Node& node);
+	void AddHierarchy(engine::Entity entity, engine::Entity parentEntity);
 	void AddTransform(engine::Entity entity, const cd::Transform& transform);
-	void AddStaticMesh(engine::Entity entity, const cd::Mesh& mesh, const cd::VertexFormat& vertexFormat);
-	void AddSkinMesh(engine::Entity entity, const cd::Mesh& mesh, const cd::VertexFormat& vertexFormat);
+	void AddStaticMesh(engine::Entity entity, const cd::Mesh& mesh, const cd::VertexFormat& vertexFormat, engine::VertexCompression vertexCompression);
+	void AddSkinMesh(engine::Entity entity, const cd::Mesh& mesh, const cd::VertexFormat& vertexFormat, engine::VertexCompression vertexCompression);
 	void AddAnimation(engine::Entity entity, const cd::Animation& animation, const cd::SceneDatabase* pSceneDatabase);
 	void AddMaterial(engine::Entity entity, const cd::Material* pMaterial, engine::MaterialType* pMaterialType, const cd::SceneDatabase* pSceneDatabase);
 
@@ -1,6 +1,7 @@
 ﻿#include "EditorApp.h"
 
 #include "Application/Engine.h"
+#include "Core/Threading/ThreadPool.hpp"
 #include "Display/FirstPersonCameraController.h"
 #include "ECWorld/SceneWorld.h"
 #include "ImGui/EditorImGuiViewport.h"
@@ -14,6 +15,7 @@
 #include "Rendering/PBRSkyRenderer.h"
 #include "Rendering/PostProcessRenderer.h"
 #include "Rendering/RenderContext.h"
+#include "Rendering/RenderGraph.hpp"
 #include "Rendering/SkyRenderer.h"
 #include "Rendering/TerrainRenderer.h"
 #include "Rendering/WorldRenderer.h"
@@ -61,7 +63,7 @@ void EditorApp::Init(engine::EngineInitArgs initArgs)
 
 	InitECWorld();
 
-	InitRenderContext();
+	InitRenderContext(initArgs.renderQuality);
 
 	// Init ImGuiContext in the editor side which used to draw editor ui.
 	InitEditorImGuiContext(initArgs.language);
@@ -79,6 +81,8 @@ void EditorApp::Init(engine::EngineInitArgs initArgs)
 
 void EditorApp::Shutdown()
 {
+	// Memory held by render targets in the selected render quality.
+	m_pRenderContext->LogRenderTargetMemory();
 }
 
 engine::Window* EditorApp::GetWindow(size_t index) const
@@ -189,6 +193,7 @@ void EditorApp::RegisterImGuiUserData(engine::ImGuiContextInstance* pImGuiContex
 
 void EditorApp::InitECWorld()
 {
+	m_pThreadPool = std::make_unique<engine::ThreadPool>();
 	m_pSceneWorld = std::make_unique<engine::SceneWorld>();
 
 	engine::World* pWorld = m_pSceneWorld->GetWorld();
@@ -219,10 +224,11 @@ void EditorApp::InitECWorld()
 		160.0f /* Movement Speed*/);
 }
 
-void EditorApp::InitRenderContext()
+void EditorApp::InitRenderContext(engine::RenderQuality renderQuality)
 {
 	m_pRenderContext = std::make_unique<engine::RenderContext>();
 	m_pRenderContext->Init();
+	m_pRenderContext->SetRenderQuality(renderQuality);
 
 	GetMainWindow()->OnResize.Bind<engine::RenderContext, &engine::RenderContext::OnResize>(m_pRenderContext.get());
 
@@ -230,55 +236,79 @@ void EditorApp::InitRenderContext()
 	engine::RenderTarget* pRenderTarget = m_pRenderContext->CreateRenderTarget(editorSwapChainName, GetMainWindow()->GetWidth(), GetMainWindow()->GetHeight(), GetMainWindow()->GetNativeHandle());
 	AddEditorRenderer(std::make_unique<engine::ImGuiRenderer>(m_pRenderContext.get(), m_pRenderContext->CreateView(), pRenderTarget));
 
-	constexpr engine::StringCrc sceneViewRenderTargetName("SceneRenderTarget");
+	// Scene shaders only write the first color attachment.
+	engine::RenderQualitySettings qualitySettings = m_pRenderContext->GetRenderQualitySettings();
 	std::vector<engine::AttachmentDescriptor> attachmentDesc = {
-		{ .textureFormat = engine::TextureFormat::RGBA32F },
-		{ .textureFormat = engine::TextureFormat::RGBA32F },
-		{ .textureFormat = engine::TextureFormat::D32F },
+		{ .textureFormat = qualitySettings.colorFormat, .sampleCount = qualitySettings.sampleCount },
+		{ .textureFormat = qualitySettings.depthFormat, .sampleCount = qualitySettings.sampleCount },
 	};
 
 	// The init size doesn't make sense. It will resize by SceneView.
-	engine::RenderTarget* pSceneRenderTarget = m_pRenderContext->CreateRenderTarget(sceneViewRenderTargetName, 1, 1, std::move(attachmentDesc));
+	engine::RenderTarget* pSceneRenderTarget = m_pRenderContext->CreateRenderTarget("SceneRenderTarget", 1, 1, std::move(attachmentDesc));
 	pSceneRenderTarget->OnResize.Bind<engine::SceneWorld, &engine::SceneWorld::OnResizeSceneView>(m_pSceneWorld.get());
 
+	// Engine renderers are executed in the order which they are added in. Passes which don't contribute to
+	// the scene render target are culled by the render graph.
+	m_pRenderGraph = std::make_unique<engine::RenderGraph>();
+	engine::RenderGraph::ResourceHandle sceneColor = m_pRenderGraph->ImportTexture("SceneRenderTarget");
+	m_sceneColorCopyResource = m_pRenderGraph->CreateTexture("SceneColorCopy", engine::RenderGraph::TextureDescriptor{ .format = qualitySettings.colorFormat });
+
 	auto pPBRSkyRenderer = std::make_unique<engine::PBRSkyRenderer>(m_pRenderContext.get(), m_pRenderContext->CreateView(), pSceneRenderTarget);
+	m_firstEngineViewID = pPBRSkyRenderer->GetViewID();
 	m_pPBRSkyRenderer = pPBRSkyRenderer.get();
-	AddEngineRenderer(cd::MoveTemp(pPBRSkyRenderer));
+	m_pRenderGraph->Write(AddEngineRenderer(cd::MoveTemp(pPBRSkyRenderer)), sceneColor);
 
 	auto pIBLSkyRenderer = std::make_unique<engine::SkyRenderer>(m_pRenderContext.get(), m_pRenderContext->CreateView(), pSceneRenderTarget);
 	pIBLSkyRenderer->Disable();
 	m_pIBLSkyRenderer = pIBLSkyRenderer.get();
-	AddEngineRenderer(cd::MoveTemp(pIBLSkyRenderer));
+	m_pRenderGraph->Write(AddEngineRenderer(cd::MoveTemp(pIBLSkyRenderer)), sceneColor);
 
 	auto pTerrainRenderer = std::make_unique<engine::TerrainRenderer>(m_pRenderContext.get(), m_pRenderContext->CreateView(), pSceneRenderTarget);
 	pTerrainRenderer->SetSceneWorld(m_pSceneWorld.get());
-	AddEngineRenderer(cd::MoveTemp(pTerrainRenderer));
+	uint32_t terrainPass = AddEngineRenderer(cd::MoveTemp(pTerrainRenderer));
+	m_pRenderGraph->Read(terrainPass, sceneColor);
+	m_pRenderGraph->Write(terrainPass, sceneColor);
 
 	auto pSceneRenderer = std::make_unique<engine::WorldRenderer>(m_pRenderContext.get(), m_pRenderContext->CreateView(), pSceneRenderTarget);
 	m_pSceneRenderer = pSceneRenderer.get();
 	pSceneRenderer->SetSceneWorld(m_pSceneWorld.get());
-	AddEngineRenderer(cd::MoveTemp(pSceneRenderer));
+	uint32_t scenePass = AddEngineRenderer(cd::MoveTemp(pSceneRenderer));
+	m_pRenderGraph->Read(scenePass, sceneColor);
+	m_pRenderGraph->Write(scenePass, sceneColor);
 
 	auto pAnimationRenderer = std::make_unique<engine::AnimationRenderer>(m_pRenderContext.get(), m_pRenderContext->CreateView(), pSceneRenderTarget);
 	pAnimationRenderer->SetSceneWorld(m_pSceneWorld.get());
-	AddEngineRenderer(cd::MoveTemp(pAnimationRenderer));
+	uint32_t animationPass = AddEngineRenderer(cd::MoveTemp(pAnimationRenderer));
+	m_pRenderGraph->Read(animationPass, sceneColor);
+	m_pRenderGraph->Write(animationPass, sceneColor);
 
 	auto pDebugRenderer = std::make_unique<engine::DebugRenderer>(m_pRenderContext.get(), m_pRenderContext->CreateView(), pSceneRenderTarget);
 	m_pDebugRenderer = pDebugRenderer.get();
 	pDebugRenderer->Disable();
 	pDebugRenderer->SetSceneWorld(m_pSceneWorld.get());
-	AddEngineRenderer(cd::MoveTemp(pDebugRenderer));
+	uint32_t debugPass = AddEngineRenderer(cd::MoveTemp(pDebugRenderer));
+	m_pRenderGraph->Read(debugPass, sceneColor);
+	m_pRenderGraph->Write(debugPass, sceneColor);
 
+	// The copy of scene color is only used by post processing. It is culled when nothing reads it.
 	auto pBlitRTRenderPass = std::make_unique<engine::BlitRenderTargetPass>(m_pRenderContext.get(), m_pRenderContext->CreateView(), pSceneRenderTarget);
-	AddEngineRenderer(cd::MoveTemp(pBlitRTRenderPass));
+	pBlitRTRenderPass->SetBlitTexture(m_pRenderGraph.get(), m_sceneColorCopyResource);
+	uint32_t blitPass = AddEngineRenderer(cd::MoveTemp(pBlitRTRenderPass));
+	m_pRenderGraph->Read(blitPass, sceneColor);
+	m_pRenderGraph->Write(blitPass, m_sceneColorCopyResource);
 
 	// We can debug vertex/material/texture information by just output that to screen as fragmentColor.
 	// But postprocess will bring unnecessary confusion.
 	// auto pPostProcessRenderer = std::make_unique<engine::PostProcessRenderer>(m_pRenderContext.get(), m_pRenderContext->CreateView(), pSceneRenderTarget);
-	// AddEngineRenderer(cd::MoveTemp(pPostProcessRenderer));
+	// pPostProcessRenderer->SetSceneColorCopy(m_pRenderGraph.get(), m_sceneColorCopyResource);
+	// uint32_t postProcessPass = AddEngineRenderer(cd::MoveTemp(pPostProcessRenderer));
+	// m_pRenderGraph->Read(postProcessPass, m_sceneColorCopyResource);
+	// m_pRenderGraph->Write(postProcessPass, sceneColor);
 
 	// Note that if you don't want to use ImGuiRenderer for engine, you should also disable EngineImGuiContext.
-	AddEngineRenderer(std::make_unique<engine::ImGuiRenderer>(m_pRenderContext.get(), m_pRenderContext->CreateView(), pSceneRenderTarget));
+	uint32_t imguiPass = AddEngineRenderer(std::make_unique<engine::ImGuiRenderer>(m_pRenderContext.get(), m_pRenderContext->CreateView(), pSceneRenderTarget));
+	m_pRenderGraph->Read(imguiPass, sceneColor);
+	m_pRenderGraph->Write(imguiPass, sceneColor);
 }
 
 void EditorApp::InitShaderPrograms() const
@@ -295,19 +325,34 @@ void EditorApp::AddEditorRenderer(std::unique_ptr<engine::Renderer> pRenderer)
 	m_pEditorRenderers.emplace_back(cd::MoveTemp(pRenderer));
 }
 
-void EditorApp::AddEngineRenderer(std::unique_ptr<engine::Renderer> pRenderer)
+uint32_t EditorApp::AddEngineRenderer(std::unique_ptr<engine::Renderer> pRenderer)
 {
+	pRenderer->SetThreadPool(m_pThreadPool.get());
 	pRenderer->Init();
+	uint32_t pass = m_pRenderGraph->AddPass(pRenderer->GetViewName());
+	assert(pass == m_pEngineRenderers.size());
 	m_pEngineRenderers.emplace_back(cd::MoveTemp(pRenderer));
+	return pass;
 }
 
 bool EditorApp::Update(float deltaTime)
 {
 	GetMainWindow()->Update();
 
+	// Components modified from now on are stamped with a new tick.
+	m_pSceneWorld->GetWorld()->IncrementChangeTick();
+
+	// Spread storage compaction over frames to avoid spikes after deleting lots of entities.
+	// Sorting makes TransformSystem rebuild its order every frame until it finishes, so storages are only sorted when they are quite shuffled.
+	constexpr size_t compactBudget = 4096;
+	constexpr float minUnsortedRatio = 0.25f;
+	m_pSceneWorld->GetWorld()->Compact(compactBudget, true, minUnsortedRatio);
+
+	// Build transforms, cameras, ... in parallel.
+	m_pSceneWorld->GetWorld()->UpdateSystems(deltaTime, m_pThreadPool.get());
+
 	engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
 	assert(pMainCameraComponent);
-	pMainCameraComponent->Build();
 
 	m_pCameraController->Update(deltaTime);
 	m_pEditorImGuiContext->Update(deltaTime);
@@ -328,18 +373,29 @@ bool EditorApp::Update(float deltaTime)
 
 	m_pEngineImGuiContext->SetWindowPosOffset(m_pSceneView->GetWindowPosX(), m_pSceneView->GetWindowPosY());
 	m_pEngineImGuiContext->Update(deltaTime);
-	for (std::unique_ptr<engine::Renderer>& pRenderer : m_pEngineRenderers)
+
+	// Pass handles are indexes of engine renderers. Compiled passes get views in the range reserved by engine renderers.
+	constexpr engine::StringCrc sceneRenderTarget("SceneRenderTarget");
+	const engine::RenderTarget* pSceneRenderTarget = m_pRenderContext->GetRenderTarget(sceneRenderTarget);
+	m_pRenderGraph->SetTextureDescriptor(m_sceneColorCopyResource, engine::RenderGraph::TextureDescriptor{
+		pSceneRenderTarget->GetWidth(), pSceneRenderTarget->GetHeight(), pSceneRenderTarget->GetAttachmentDescriptors()[0].textureFormat });
+	for (uint32_t pass = 0; pass < m_pEngineRenderers.size(); ++pass)
 	{
-		if (!pRenderer->IsEnable())
-		{
-			continue;
-		}
+		m_pRenderGraph->SetPassEnabled(pass, m_pEngineRenderers[pass]->IsEnable());
+	}
+	m_pRenderGraph->Compile(m_firstEngineViewID);
+
+	// Transient textures are acquired from the render target pool only during passes which use them.
+	m_pRenderGraph->Execute(m_pRenderContext->GetRenderTargetPool(), [this, pMainCameraComponent, deltaTime](engine::RenderGraph::PassHandle pass)
+	{
+		engine::Renderer* pRenderer = m_pEngineRenderers[pass].get();
+		pRenderer->SetViewID(m_pRenderGraph->GetPassViewID(pass));
 
 		const float* pViewMatrix = pMainCameraComponent->GetViewMatrix().Begin();
 		const float* pProjectionMatrix = pMainCameraComponent->GetProjectionMatrix().Begin();
 		pRenderer->UpdateView(pViewMatrix, pProjectionMatrix);
 		pRenderer->Render(deltaTime);
-	}
+	});
 
 	m_pRenderContext->EndFrame();
 
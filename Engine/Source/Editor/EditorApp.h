@@ -14,8 +14,10 @@ class ImGuiBaseLayer;
 class ImGuiContextInstance;
 class Window;
 class RenderContext;
+class RenderGraph;
 class Renderer;
 class SceneWorld;
+class ThreadPool;
 
 }
 
@@ -45,10 +47,11 @@ public:
 	engine::Window* GetMainWindow() const;
 	size_t AddWindow(std::unique_ptr<engine::Window> pWindow);
 
-	void InitRenderContext();
+	void InitRenderContext(engine::RenderQuality renderQuality);
 	void InitShaderPrograms() const;
 	void AddEditorRenderer(std::unique_ptr<engine::Renderer> pRenderer);
-	void AddEngineRenderer(std::unique_ptr<engine::Renderer> pRenderer);
+	// Engine renderers are passes of the render graph. Returns the pass handle to declare resources which it reads and writes.
+	uint32_t AddEngineRenderer(std::unique_ptr<engine::Renderer> pRenderer);
 
 	void InitEditorImGuiContext(engine::Language language);
 	void InitEngineImGuiContext(engine::Language language);
@@ -78,9 +81,15 @@ private:
 	std::unique_ptr<engine::RenderContext> m_pRenderContext;
 	std::vector<std::unique_ptr<engine::Renderer>> m_pEditorRenderers;
 	std::vector<std::unique_ptr<engine::Renderer>> m_pEngineRenderers;
+	std::unique_ptr<engine::RenderGraph> m_pRenderGraph;
+	uint32_t m_sceneColorCopyResource;
+	uint16_t m_firstEngineViewID;
 
 	// Controllers for processing input events.
 	std::unique_ptr<engine::FirstPersonCameraController> m_pCameraController;
+
+	// Workers to run ECWorld systems concurrently.
+	std::unique_ptr<engine::ThreadPool> m_pThreadPool;
 };
 
 }
\ No newline at end of file
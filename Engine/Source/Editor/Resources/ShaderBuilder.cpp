@@ -18,6 +18,14 @@ void ShaderBuilder::BuildUberShader(engine::MaterialType* pMaterialType)
 	ResourceBuilder::Get().AddShaderBuildTask(ShaderType::Vertex,
 		shaderSchema.GetVertexShaderPath(), outputVSFilePath.c_str());
 
+	std::string outputInstanceVSFilePath;
+	if (shaderSchema.HasInstanceVertexShader())
+	{
+		outputInstanceVSFilePath = engine::Path::GetShaderOutputPath(shaderSchema.GetInstanceVertexShaderPath());
+		ResourceBuilder::Get().AddShaderBuildTask(ShaderType::Vertex,
+			shaderSchema.GetInstanceVertexShaderPath(), outputInstanceVSFilePath.c_str());
+	}
+
 	// Compile fragment shaders with uber options.
 	for (const auto& combine : shaderSchema.GetUberCombines())
 	{
@@ -47,6 +55,14 @@ void ShaderBuilder::BuildUberShader(engine::MaterialType* pMaterialType)
 	const auto& VSBlob = shaderSchema.GetVSBlob();
 	bgfx::ShaderHandle vsHandle = bgfx::createShader(bgfx::makeRef(VSBlob.data(), static_cast<uint32_t>(VSBlob.size())));
 
+	bgfx::ShaderHandle instanceVSHandle = BGFX_INVALID_HANDLE;
+	if (shaderSchema.HasInstanceVertexShader())
+	{
+		shaderSchema.AddInstanceVSBlob(ResourceLoader::LoadShader(outputInstanceVSFilePath.c_str()));
+		const auto& instanceVSBlob = shaderSchema.GetInstanceVSBlob();
+		instanceVSHandle = bgfx::createShader(bgfx::makeRef(instanceVSBlob.data(), static_cast<uint32_t>(instanceVSBlob.size())));
+	}
+
 	// Fragment shader.
 	for (const auto& [outputFSFilePath, uberOptionCrc] : outputFSPathToUberOption)
 	{
@@ -58,6 +74,13 @@ void ShaderBuilder::BuildUberShader(engine::MaterialType* pMaterialType)
 		// Program.
 		bgfx::ProgramHandle uberProgramHandle = bgfx::createProgram(vsHandle, fsHandle);
 		shaderSchema.SetCompiledProgram(uberOptionCrc, uberProgramHandle.idx);
+
+		// Instance program shares the fragment shader with the uber program.
+		if (bgfx::isValid(instanceVSHandle))
+		{
+			bgfx::ProgramHandle instanceProgramHandle = bgfx::createProgram(instanceVSHandle, fsHandle);
+			shaderSchema.SetCompiledInstanceProgram(uberOptionCrc, instanceProgramHandle.idx);
+		}
 	}
 }
 
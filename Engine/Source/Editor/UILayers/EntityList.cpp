@@ -46,6 +46,7 @@ void EntityList::AddEntity(engine::SceneWorld* pSceneWorld)
         auto& meshComponent = pWorld->CreateComponent<engine::StaticMeshComponent>(entity);
         meshComponent.SetMeshData(&optMesh.value());
         meshComponent.SetRequiredVertexFormat(&pPBRMaterialType->GetRequiredVertexFormat());
+        meshComponent.SetVertexCompression(pPBRMaterialType->GetVertexCompression());
         meshComponent.Build();
 
         auto& materialComponent = pWorld->CreateComponent<engine::MaterialComponent>(entity);
@@ -178,7 +179,15 @@ void EntityList::DrawEntity(engine::SceneWorld* pSceneWorld, engine::Entity enti
 
         if (ImGui::Selectable(CD_TEXT("Delete")))
         {
-            pSceneWorld->DeleteEntity(entity);
+            // Deleting removes the entity from the list which is being iterated, so it is applied after drawing all entities.
+            m_deletingEntity = entity;
+            ImGui::EndPopup();
+            if (isNodeOpen)
+            {
+                ImGui::TreePop();
+            }
+            ImGui::PopID();
+            return;
         }
 
         // Operation list only for camera entites.
@@ -309,6 +318,12 @@ void EntityList::Update()
         DrawEntity(pSceneWorld, entity);
     }
 
+    if (engine::INVALID_ENTITY != m_deletingEntity)
+    {
+        pSceneWorld->DeleteEntity(m_deletingEntity);
+        m_deletingEntity = engine::INVALID_ENTITY;
+    }
+
     ImGui::Indent();
 
     ImGui::EndChild();
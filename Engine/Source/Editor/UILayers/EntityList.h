@@ -28,6 +28,7 @@ public:
 
 private:
 	ImGuiTextFilter m_entityFilter;
+	engine::Entity m_deletingEntity = engine::INVALID_ENTITY;
 	//bool m_editingEntityName = false;
 };
 
@@ -55,25 +55,26 @@ void ImGuizmoView::Update()
 
 	if (ImGuizmo::IsUsing())
 	{
+		// ImGuizmo edits the world matrix. Convert it into the parent's space as the transform is local.
+		const cd::Matrix4x4 parentWorldMatrix = pSceneWorld->GetParentWorldMatrix(selectedEntity);
+		const cd::Matrix4x4 localMatrix = parentWorldMatrix.Inverse() * worldMatrix;
 		if (ImGuizmo::OPERATION::TRANSLATE & operation)
 		{
-			pTransformComponent->GetTransform().SetTranslation(worldMatrix.GetTranslation());
-			pTransformComponent->Dirty();
+			pTransformComponent->GetTransform().SetTranslation(localMatrix.GetTranslation());
 		}
 		
 		if (ImGuizmo::OPERATION::ROTATE & operation)
 		{
-			pTransformComponent->GetTransform().SetRotation(cd::Quaternion::FromMatrix(worldMatrix.GetRotation()));
-			pTransformComponent->Dirty();
+			pTransformComponent->GetTransform().SetRotation(cd::Quaternion::FromMatrix(localMatrix.GetRotation()));
 		}
 
 		if (ImGuizmo::OPERATION::SCALE & operation)
 		{
-			pTransformComponent->GetTransform().SetScale(worldMatrix.GetScale());
-			pTransformComponent->Dirty();
+			pTransformComponent->GetTransform().SetScale(localMatrix.GetScale());
 		}
 
-		pTransformComponent->Build();
+		pTransformComponent->Build(parentWorldMatrix);
+		pSceneWorld->MarkComponentChanged<engine::TransformComponent>(selectedEntity);
 	}
 }
 
@@ -141,8 +141,8 @@ void UpdateComponentWidget<engine::TransformComponent>(engine::SceneWorld* pScen
 	{
 		if (ImGuiProperty<cd::Transform>("Transform", pTransformComponent->GetTransform()))
 		{
-			pTransformComponent->Dirty();
-			pTransformComponent->Build();
+			pTransformComponent->Build(pSceneWorld->GetParentWorldMatrix(entity));
+			pSceneWorld->MarkComponentChanged<engine::TransformComponent>(entity);
 		}
 	}
 
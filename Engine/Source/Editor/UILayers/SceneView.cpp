@@ -243,14 +243,10 @@ void SceneView::UpdateToolMenuButtons()
 		engine::RenderContext* pRenderContext = reinterpret_cast<engine::RenderContext*>(io.BackendRendererUserData);
 		engine::ImGuiContextInstance* pImGuiContextInstance = reinterpret_cast<engine::ImGuiContextInstance*>(io.UserData);
 
-		if (cd::SceneDatabase* pSceneDatabase = pImGuiContextInstance->GetSceneWorld()->GetSceneDatabase())
-		{
-			pSceneDatabase->UpdateAABB();
-
-			engine::SceneWorld* pSceneWorld = pImGuiContextInstance->GetSceneWorld();
-			engine::CameraComponent* pCameraComponent = pSceneWorld->GetCameraComponent(pSceneWorld->GetMainCameraEntity());
-			pCameraComponent->FrameAll(pSceneDatabase->GetAABB());
-		}
+		// Bounds of the tree's root enclose all static meshes in world space.
+		engine::SceneWorld* pSceneWorld = pImGuiContextInstance->GetSceneWorld();
+		engine::CameraComponent* pCameraComponent = pSceneWorld->GetCameraComponent(pSceneWorld->GetMainCameraEntity());
+		pCameraComponent->FrameAll(pSceneWorld->GetBoundingVolumeHierarchy()->GetBounds());
 	}
 
 	ImGui::SameLine();
@@ -283,42 +279,14 @@ void SceneView::PickSceneMesh(float regionWidth, float regionHeight)
 		return;
 	}
 
-	// Loop through scene's all static meshes' AABB to test intersections with Ray.
+	// Find the nearest static mesh whose world AABB intersects with Ray in the bounding volume hierarchy.
 	engine::ImGuiContextInstance* pImGuiContextInstance = reinterpret_cast<engine::ImGuiContextInstance*>(ImGui::GetIO().UserData);
 	engine::SceneWorld* pSceneWorld = pImGuiContextInstance->GetSceneWorld();
 	engine::CameraComponent* pCameraComponent = pSceneWorld->GetCameraComponent(pSceneWorld->GetMainCameraEntity());
 	cd::Ray pickRay = pCameraComponent->EmitRay(screenX, screenY, screenWidth, screenHeight);
 
-	float minRayTime = FLT_MAX;
-	engine::Entity nearestEntity = engine::INVALID_ENTITY;
-	for (engine::Entity entity : pSceneWorld->GetStaticMeshEntities())
-	{
-		engine::TransformComponent* pTransformComponent = pSceneWorld->GetTransformComponent(entity);
-		if (!pTransformComponent)
-		{
-			continue;
-		}
-
-		engine::StaticMeshComponent* pMeshComponent = pSceneWorld->GetStaticMeshComponent(entity);
-		if (!pMeshComponent)
-		{
-			continue;
-		}
-
-		cd::AABB collisonMeshAABB = pMeshComponent->GetAABB();
-		collisonMeshAABB = collisonMeshAABB.Transform(pTransformComponent->GetWorldMatrix());
-
-		float rayTime;
-		if (collisonMeshAABB.Intersects(pickRay, rayTime))
-		{
-			if (rayTime < minRayTime)
-			{
-				minRayTime = rayTime;
-				nearestEntity = entity;
-			}
-		}
-	}
-
+	float rayTime;
+	engine::Entity nearestEntity = pSceneWorld->GetBoundingVolumeHierarchy()->Raycast(pickRay, rayTime);
 	pSceneWorld->SetSelectedEntity(nearestEntity);
 }
 
@@ -81,6 +81,7 @@ void TerrainEditor::Update()
 
 		Processor processor(&m_terrainProducer, m_pEcTerrainConsumer.get(), m_pSceneDatabase.get());
 		processor.Run();
+		pSceneWorld->SetTerrainElevationRange(static_cast<float>(m_terrainMetadata.minElevation), static_cast<float>(m_terrainMetadata.maxElevation));
 	}
 	// Terrain Metadata Group
 	ImGui::BeginGroup();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ImGui/Language.h"
+#include "Rendering/RenderQuality.h"
 
 #include <inttypes.h>
 
@@ -17,6 +18,7 @@ struct EngineInitArgs
 	uint16_t height = 600;
 
 	Language language = Language::English;
+	RenderQuality renderQuality = RenderQuality::High;
 };
 
 class IApplication
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CD_SIMD_X86
+#endif
+
+#ifdef CD_SIMD_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
+// MSVC emits any intrinsic without compiler flags. GCC and Clang need to enable the instruction set per function,
+// so that the binary still runs on CPUs without AVX2 when the kernel is not selected.
+#if defined(CD_SIMD_X86) && !defined(_MSC_VER)
+#define CD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CD_TARGET_AVX2
+#endif
+
+namespace engine
+{
+
+enum class SIMDLevel : uint8_t
+{
+	Scalar,
+	SSE2,
+	AVX2,
+};
+
+inline SIMDLevel DetectSIMDLevel()
+{
+#if !defined(CD_SIMD_X86)
+	return SIMDLevel::Scalar;
+#elif defined(_MSC_VER)
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 0);
+	int maxLeaf = cpuInfo[0];
+
+	__cpuid(cpuInfo, 1);
+	bool hasSSE2 = cpuInfo[3] & (1 << 26);
+	bool hasAVX = cpuInfo[2] & (1 << 28);
+	bool hasOSXSAVE = cpuInfo[2] & (1 << 27);
+
+	// The OS should also save YMM registers on context switches.
+	bool hasAVX2 = false;
+	if (hasAVX && hasOSXSAVE && (_xgetbv(0) & 0x6) == 0x6 && maxLeaf >= 7)
+	{
+		__cpuidex(cpuInfo, 7, 0);
+		hasAVX2 = cpuInfo[1] & (1 << 5);
+	}
+
+	return hasAVX2 ? SIMDLevel::AVX2 : (hasSSE2 ? SIMDLevel::SSE2 : SIMDLevel::Scalar);
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return SIMDLevel::AVX2;
+	}
+	return __builtin_cpu_supports("sse2") ? SIMDLevel::SSE2 : SIMDLevel::Scalar;
+#endif
+}
+
+// The best instruction set which both the CPU and the OS support. Detected once on first use.
+inline SIMDLevel GetSIMDLevel()
+{
+	static const SIMDLevel level = DetectSIMDLevel();
+	return level;
+}
+
+constexpr const char* GetSIMDLevelName(SIMDLevel level)
+{
+	switch (level)
+	{
+	case SIMDLevel::SSE2:
+		return "SSE2";
+	case SIMDLevel::AVX2:
+		return "AVX2";
+	default:
+		return "Scalar";
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine
+{
+
+// MappedFile maps a whole file into memory as read only. Pages are loaded by the OS on demand
+// so that large binary files can be used in place without reading them into a buffer first.
+class MappedFile final
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(const char* pFilePath) { Open(pFilePath); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&&) = delete;
+	MappedFile& operator=(MappedFile&&) = delete;
+	~MappedFile() { Close(); }
+
+	bool IsOpen() const { return m_pData != nullptr; }
+	const std::byte* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_size; }
+	std::span<const std::byte> GetBytes() const { return std::span<const std::byte>(m_pData, m_size); }
+
+	bool Open(const char* pFilePath)
+	{
+		Close();
+
+#ifdef _WIN32
+		m_fileHandle = ::CreateFileA(pFilePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (INVALID_HANDLE_VALUE == m_fileHandle)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!::GetFileSizeEx(m_fileHandle, &fileSize) || 0 == fileSize.QuadPart)
+		{
+			Close();
+			return false;
+		}
+
+		m_mappingHandle = ::CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_mappingHandle)
+		{
+			Close();
+			return false;
+		}
+
+		m_pData = static_cast<const std::byte*>(::MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+		m_fileDescriptor = ::open(pFilePath, O_RDONLY);
+		if (m_fileDescriptor < 0)
+		{
+			return false;
+		}
+
+		struct stat fileStat;
+		if (::fstat(m_fileDescriptor, &fileStat) != 0 || 0 == fileStat.st_size)
+		{
+			Close();
+			return false;
+		}
+
+		void* pMappedData = ::mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+		if (MAP_FAILED == pMappedData)
+		{
+			Close();
+			return false;
+		}
+
+		m_pData = static_cast<const std::byte*>(pMappedData);
+		m_size = static_cast<size_t>(fileStat.st_size);
+#endif
+
+		if (!m_pData)
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void Close()
+	{
+#ifdef _WIN32
+		if (m_pData)
+		{
+			::UnmapViewOfFile(m_pData);
+		}
+
+		if (m_mappingHandle)
+		{
+			::CloseHandle(m_mappingHandle);
+			m_mappingHandle = nullptr;
+		}
+
+		if (INVALID_HANDLE_VALUE != m_fileHandle)
+		{
+			::CloseHandle(m_fileHandle);
+			m_fileHandle = INVALID_HANDLE_VALUE;
+		}
+#else
+		if (m_pData)
+		{
+			::munmap(const_cast<std::byte*>(m_pData), m_size);
+		}
+
+		if (m_fileDescriptor >= 0)
+		{
+			::close(m_fileDescriptor);
+			m_fileDescriptor = -1;
+		}
+#endif
+
+		m_pData = nullptr;
+		m_size = 0;
+	}
+
+private:
+	const std::byte* m_pData = nullptr;
+	size_t m_size = 0;
+
+#ifdef _WIN32
+	HANDLE m_fileHandle = INVALID_HANDLE_VALUE;
+	HANDLE m_mappingHandle = nullptr;
+#else
+	int m_fileDescriptor = -1;
+#endif
+};
+
+}
\ No newline at end of file
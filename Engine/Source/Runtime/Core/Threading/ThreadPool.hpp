@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine
+{
+
+// ThreadPool runs tasks on worker threads. Every worker owns a task queue.
+// Tasks submitted from a worker are pushed to its own queue and idle workers steal from the others,
+// so that tasks spawning tasks don't contend on one global queue.
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	// Leave one core for the main thread which also helps to run tasks when it waits.
+	static uint32_t GetDefaultThreadCount() { return std::max(1U, std::thread::hardware_concurrency() - 1U); }
+
+public:
+	explicit ThreadPool(uint32_t threadCount = GetDefaultThreadCount())
+	{
+		// One extra queue for tasks submitted from non-worker threads.
+		for (uint32_t queueIndex = 0; queueIndex <= threadCount; ++queueIndex)
+		{
+			m_queues.emplace_back(std::make_unique<TaskQueue>());
+		}
+
+		for (uint32_t workerIndex = 0; workerIndex < threadCount; ++workerIndex)
+		{
+			m_workers.emplace_back([this, workerIndex]() { WorkerLoop(workerIndex); });
+		}
+	}
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_wakeMutex);
+			m_stop = true;
+		}
+		m_wakeCondition.notify_all();
+
+		for (std::thread& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+	void Submit(Task task)
+	{
+		// Count the task before it is published, so that a thread which pops it can't decrement the count below zero.
+		{
+			std::lock_guard<std::mutex> lock(m_wakeMutex);
+			++m_pendingTaskCount;
+		}
+
+		TaskQueue& queue = *m_queues[GetCurrentQueueIndex()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.emplace_back(std::move(task));
+		}
+		m_wakeCondition.notify_one();
+	}
+
+	// Run one pending task on the calling thread. Returns false if there is no task to run.
+	// Threads waiting for tasks to finish call it to help instead of blocking.
+	bool TryRunTask()
+	{
+		Task task;
+		if (!PopTask(GetCurrentQueueIndex(), task))
+		{
+			return false;
+		}
+
+		task();
+		return true;
+	}
+
+private:
+	struct TaskQueue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	size_t GetCurrentQueueIndex() const { return s_pCurrentPool == this ? s_currentQueueIndex : m_workers.size(); }
+
+	// Pop the newest task from the own queue first as it is still hot in cache, then steal the oldest task from others.
+	bool PopTask(size_t queueIndex, Task& outTask)
+	{
+		for (size_t offset = 0; offset < m_queues.size(); ++offset)
+		{
+			TaskQueue& queue = *m_queues[(queueIndex + offset) % m_queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.tasks.empty())
+			{
+				continue;
+			}
+
+			if (0 == offset)
+			{
+				outTask = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+			}
+			else
+			{
+				outTask = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+			}
+
+			--m_pendingTaskCount;
+			return true;
+		}
+
+		return false;
+	}
+
+	void WorkerLoop(uint32_t workerIndex)
+	{
+		s_pCurrentPool = this;
+		s_currentQueueIndex = workerIndex;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_wakeMutex);
+				m_wakeCondition.wait(lock, [this]() { return m_stop || m_pendingTaskCount > 0; });
+				if (m_stop)
+				{
+					return;
+				}
+			}
+
+			TryRunTask();
+		}
+	}
+
+private:
+	std::vector<std::unique_ptr<TaskQueue>> m_queues;
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+	std::atomic<uint32_t> m_pendingTaskCount = 0;
+	bool m_stop = false;
+
+	inline static thread_local const ThreadPool* s_pCurrentPool = nullptr;
+	inline static thread_local size_t s_currentQueueIndex = 0;
+};
+
+}
\ No newline at end of file
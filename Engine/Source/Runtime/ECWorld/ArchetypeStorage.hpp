@@ -0,0 +1,519 @@
+#pragma once
+
+#include "Entity.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <new>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace engine
+{
+
+// Type erased operations which are used to construct, move and destroy components inside chunks.
+struct ComponentTypeInfo
+{
+	uint32_t id;
+	uint32_t size;
+	uint32_t alignment;
+	void(*pConstruct)(void* pDest);
+	// Move constructs pDest from pSource and then destroys pSource.
+	void(*pRelocate)(void* pDest, void* pSource);
+	void(*pDestroy)(void* pData);
+
+	template<typename Component>
+	static ComponentTypeInfo Create()
+	{
+		static_assert(std::is_default_constructible_v<Component> && std::is_move_constructible_v<Component>);
+
+		ComponentTypeInfo typeInfo;
+		typeInfo.id = Component::GetClassName().Value();
+		typeInfo.size = static_cast<uint32_t>(sizeof(Component));
+		typeInfo.alignment = static_cast<uint32_t>(alignof(Component));
+		typeInfo.pConstruct = [](void* pDest) { new (pDest) Component(); };
+		typeInfo.pRelocate = [](void* pDest, void* pSource)
+		{
+			Component* pSourceComponent = static_cast<Component*>(pSource);
+			new (pDest) Component(std::move(*pSourceComponent));
+			pSourceComponent->~Component();
+		};
+		typeInfo.pDestroy = [](void* pData) { static_cast<Component*>(pData)->~Component(); };
+		return typeInfo;
+	}
+};
+
+// ArchetypeChunk is a fixed size memory block which stores rows of entities in the same archetype as SoA columns.
+// The entity column is at the front. Every component column starts at a cache line so that it is friendly to SIMD loads.
+class ArchetypeChunk
+{
+public:
+	static constexpr size_t ChunkSize = 16 * 1024;
+	static constexpr size_t ColumnAlignment = 64;
+
+public:
+	ArchetypeChunk() = default;
+	ArchetypeChunk(const ArchetypeChunk&) = delete;
+	ArchetypeChunk& operator=(const ArchetypeChunk&) = delete;
+	ArchetypeChunk(ArchetypeChunk&&) = delete;
+	ArchetypeChunk& operator=(ArchetypeChunk&&) = delete;
+	~ArchetypeChunk() = default;
+
+	uint32_t GetCount() const { return m_count; }
+	bool IsEmpty() const { return 0 == m_count; }
+
+	std::span<const Entity> GetEntities() const { return std::span<const Entity>(reinterpret_cast<const Entity*>(m_data), m_count); }
+
+	template<typename Component>
+	std::span<Component> GetColumn(size_t columnOffset) { return std::span<Component>(std::launder(reinterpret_cast<Component*>(m_data + columnOffset)), m_count); }
+
+private:
+	friend class Archetype;
+
+	alignas(ColumnAlignment) std::byte m_data[ChunkSize];
+	uint32_t m_count = 0;
+};
+
+// Archetype stores all entities which have exactly the same component set.
+// Rows are packed from the first chunk to the last one. Removing a row moves the last row into the hole.
+class Archetype
+{
+public:
+	static constexpr uint32_t INVALID_COLUMN = static_cast<uint32_t>(-1);
+
+	// Location of an entity row.
+	struct Row
+	{
+		uint32_t chunkIndex;
+		uint32_t rowIndex;
+	};
+
+public:
+	Archetype() = delete;
+	explicit Archetype(std::vector<ComponentTypeInfo> typeInfos)
+		: m_typeInfos(std::move(typeInfos))
+	{
+		assert(std::is_sorted(m_typeInfos.begin(), m_typeInfos.end(), [](const ComponentTypeInfo& lhs, const ComponentTypeInfo& rhs) { return lhs.id < rhs.id; }));
+
+		size_t rowSize = sizeof(Entity);
+		for (const ComponentTypeInfo& typeInfo : m_typeInfos)
+		{
+			m_componentIDs.push_back(typeInfo.id);
+			rowSize += typeInfo.size;
+			assert(typeInfo.alignment <= ArchetypeChunk::ColumnAlignment);
+		}
+
+		// Start from the upper bound and shrink until all aligned columns fit in one chunk.
+		m_chunkCapacity = static_cast<uint32_t>(ArchetypeChunk::ChunkSize / rowSize);
+		while (m_chunkCapacity > 0 && !ComputeColumnOffsets(m_chunkCapacity))
+		{
+			--m_chunkCapacity;
+		}
+		assert(m_chunkCapacity > 0 && "Components of the archetype are too large to fit in a chunk.");
+	}
+	Archetype(const Archetype&) = delete;
+	Archetype& operator=(const Archetype&) = delete;
+	Archetype(Archetype&&) = delete;
+	Archetype& operator=(Archetype&&) = delete;
+	~Archetype()
+	{
+		for (std::unique_ptr<ArchetypeChunk>& pChunk : m_chunks)
+		{
+			for (uint32_t rowIndex = 0; rowIndex < pChunk->m_count; ++rowIndex)
+			{
+				DestroyComponents(*pChunk, rowIndex);
+			}
+		}
+	}
+
+	const std::vector<uint32_t>& GetComponentIDs() const { return m_componentIDs; }
+	const std::vector<ComponentTypeInfo>& GetComponentTypeInfos() const { return m_typeInfos; }
+
+	uint32_t GetColumnIndex(uint32_t componentID) const
+	{
+		auto itID = std::lower_bound(m_componentIDs.begin(), m_componentIDs.end(), componentID);
+		return (itID != m_componentIDs.end() && *itID == componentID) ? static_cast<uint32_t>(itID - m_componentIDs.begin()) : INVALID_COLUMN;
+	}
+
+	bool Contains(uint32_t componentID) const { return INVALID_COLUMN != GetColumnIndex(componentID); }
+	size_t GetColumnOffset(uint32_t columnIndex) const { return m_columnOffsets[columnIndex]; }
+
+	uint32_t GetChunkCapacity() const { return m_chunkCapacity; }
+	size_t GetChunkCount() const { return m_chunks.size(); }
+	ArchetypeChunk& GetChunk(size_t chunkIndex) { return *m_chunks[chunkIndex]; }
+	const ArchetypeChunk& GetChunk(size_t chunkIndex) const { return *m_chunks[chunkIndex]; }
+	size_t GetEntityCount() const { return m_chunks.empty() ? 0 : (m_chunks.size() - 1) * m_chunkCapacity + m_chunks.back()->m_count; }
+
+	void* GetComponentData(Row row, uint32_t columnIndex)
+	{
+		return m_chunks[row.chunkIndex]->m_data + m_columnOffsets[columnIndex] + static_cast<size_t>(row.rowIndex) * m_typeInfos[columnIndex].size;
+	}
+
+	// Append a row for the entity. Components are not constructed.
+	Row AllocateRow(Entity entity)
+	{
+		if (m_chunks.empty() || m_chunks.back()->m_count == m_chunkCapacity)
+		{
+			m_chunks.emplace_back(std::make_unique<ArchetypeChunk>());
+		}
+
+		ArchetypeChunk& chunk = *m_chunks.back();
+		Row row{ static_cast<uint32_t>(m_chunks.size() - 1), chunk.m_count++ };
+		reinterpret_cast<Entity*>(chunk.m_data)[row.rowIndex] = entity;
+		return row;
+	}
+
+	// Components in the row should be already destroyed or relocated. The last row is relocated into the hole.
+	// Returns the entity which is moved to the row, or INVALID_ENTITY if the removed row is the last one.
+	Entity FreeRow(Row row)
+	{
+		ArchetypeChunk& lastChunk = *m_chunks.back();
+		Row lastRow{ static_cast<uint32_t>(m_chunks.size() - 1), lastChunk.m_count - 1 };
+
+		Entity movedEntity = INVALID_ENTITY;
+		if (row.chunkIndex != lastRow.chunkIndex || row.rowIndex != lastRow.rowIndex)
+		{
+			movedEntity = reinterpret_cast<Entity*>(lastChunk.m_data)[lastRow.rowIndex];
+			reinterpret_cast<Entity*>(m_chunks[row.chunkIndex]->m_data)[row.rowIndex] = movedEntity;
+			for (uint32_t columnIndex = 0; columnIndex < m_typeInfos.size(); ++columnIndex)
+			{
+				m_typeInfos[columnIndex].pRelocate(GetComponentData(row, columnIndex), GetComponentData(lastRow, columnIndex));
+			}
+		}
+
+		if (0 == --lastChunk.m_count)
+		{
+			m_chunks.pop_back();
+		}
+
+		return movedEntity;
+	}
+
+	void ConstructComponent(Row row, uint32_t columnIndex) { m_typeInfos[columnIndex].pConstruct(GetComponentData(row, columnIndex)); }
+	void DestroyComponent(Row row, uint32_t columnIndex) { m_typeInfos[columnIndex].pDestroy(GetComponentData(row, columnIndex)); }
+
+	// Cached transitions to the archetype which adds or removes one component.
+	Archetype* GetAddEdge(uint32_t componentID) const { auto itEdge = m_addEdges.find(componentID); return itEdge == m_addEdges.end() ? nullptr : itEdge->second; }
+	Archetype* GetRemoveEdge(uint32_t componentID) const { auto itEdge = m_removeEdges.find(componentID); return itEdge == m_removeEdges.end() ? nullptr : itEdge->second; }
+	void SetAddEdge(uint32_t componentID, Archetype* pArchetype) { m_addEdges[componentID] = pArchetype; }
+	void SetRemoveEdge(uint32_t componentID, Archetype* pArchetype) { m_removeEdges[componentID] = pArchetype; }
+
+private:
+	bool ComputeColumnOffsets(uint32_t capacity)
+	{
+		m_columnOffsets.clear();
+
+		size_t offset = sizeof(Entity) * capacity;
+		for (const ComponentTypeInfo& typeInfo : m_typeInfos)
+		{
+			offset = (offset + ArchetypeChunk::ColumnAlignment - 1) & ~(ArchetypeChunk::ColumnAlignment - 1);
+			m_columnOffsets.push_back(offset);
+			offset += static_cast<size_t>(typeInfo.size) * capacity;
+		}
+
+		return offset <= ArchetypeChunk::ChunkSize;
+	}
+
+	void DestroyComponents(ArchetypeChunk& chunk, uint32_t rowIndex)
+	{
+		for (uint32_t columnIndex = 0; columnIndex < m_typeInfos.size(); ++columnIndex)
+		{
+			m_typeInfos[columnIndex].pDestroy(chunk.m_data + m_columnOffsets[columnIndex] + static_cast<size_t>(rowIndex) * m_typeInfos[columnIndex].size);
+		}
+	}
+
+private:
+	std::vector<ComponentTypeInfo> m_typeInfos;
+	std::vector<uint32_t> m_componentIDs;
+	std::vector<size_t> m_columnOffsets;
+	uint32_t m_chunkCapacity = 0;
+
+	std::vector<std::unique_ptr<ArchetypeChunk>> m_chunks;
+	std::unordered_map<uint32_t, Archetype*> m_addEdges;
+	std::unordered_map<uint32_t, Archetype*> m_removeEdges;
+};
+
+// ArchetypeStorage is an optional storage mode for hot component combinations.
+// Entities in it are grouped by their component set and components are stored in SoA chunks,
+// so iterating a combination walks contiguous arrays in the same order.
+// Adding or removing a component moves the entity to another archetype.
+// It is independent of ComponentsStorage so one entity should live in only one of them for the same component type.
+class ArchetypeStorage
+{
+public:
+	ArchetypeStorage() = default;
+	ArchetypeStorage(const ArchetypeStorage&) = delete;
+	ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+	ArchetypeStorage(ArchetypeStorage&&) = default;
+	ArchetypeStorage& operator=(ArchetypeStorage&&) = default;
+	~ArchetypeStorage() = default;
+
+	bool Contains(Entity entity) const { return nullptr != GetLocation(entity); }
+	size_t GetEntityCount() const { return m_entityCount; }
+	size_t GetArchetypeCount() const { return m_archetypes.size(); }
+
+	template<typename Component>
+	bool HasComponent(Entity entity) const
+	{
+		const EntityLocation* pLocation = GetLocation(entity);
+		return pLocation && pLocation->pArchetype->Contains(Component::GetClassName().Value());
+	}
+
+	template<typename Component>
+	Component* GetComponent(Entity entity)
+	{
+		const EntityLocation* pLocation = GetLocation(entity);
+		if (!pLocation)
+		{
+			return nullptr;
+		}
+
+		uint32_t columnIndex = pLocation->pArchetype->GetColumnIndex(Component::GetClassName().Value());
+		return Archetype::INVALID_COLUMN == columnIndex ? nullptr :
+			std::launder(static_cast<Component*>(pLocation->pArchetype->GetComponentData(pLocation->row, columnIndex)));
+	}
+
+	// Add the entity with default constructed components.
+	template<typename... Components>
+	void AddEntity(Entity entity)
+	{
+		assert(entity != INVALID_ENTITY && !Contains(entity));
+
+		std::vector<ComponentTypeInfo> typeInfos{ ComponentTypeInfo::Create<Components>()... };
+		std::sort(typeInfos.begin(), typeInfos.end(), [](const ComponentTypeInfo& lhs, const ComponentTypeInfo& rhs) { return lhs.id < rhs.id; });
+		assert(std::adjacent_find(typeInfos.begin(), typeInfos.end(), [](const ComponentTypeInfo& lhs, const ComponentTypeInfo& rhs) { return lhs.id == rhs.id; }) == typeInfos.end());
+
+		Archetype* pArchetype = GetOrCreateArchetype(std::move(typeInfos));
+		Archetype::Row row = pArchetype->AllocateRow(entity);
+		for (uint32_t columnIndex = 0; columnIndex < pArchetype->GetComponentIDs().size(); ++columnIndex)
+		{
+			pArchetype->ConstructComponent(row, columnIndex);
+		}
+
+		SetLocation(entity, pArchetype, row);
+		++m_entityCount;
+	}
+
+	void RemoveEntity(Entity entity)
+	{
+		const EntityLocation* pLocation = GetLocation(entity);
+		if (!pLocation)
+		{
+			return;
+		}
+
+		Archetype* pArchetype = pLocation->pArchetype;
+		Archetype::Row row = pLocation->row;
+		for (uint32_t columnIndex = 0; columnIndex < pArchetype->GetComponentIDs().size(); ++columnIndex)
+		{
+			pArchetype->DestroyComponent(row, columnIndex);
+		}
+
+		FreeRow(pArchetype, row);
+		m_locations[GetEntityIndex(entity)] = EntityLocation();
+		--m_entityCount;
+	}
+
+	// Move the entity to the archetype with one more component. Returns the existing one if the entity already has it.
+	template<typename Component>
+	Component& AddComponent(Entity entity)
+	{
+		if (Component* pComponent = GetComponent<Component>(entity))
+		{
+			return *pComponent;
+		}
+
+		const EntityLocation* pLocation = GetLocation(entity);
+		assert(pLocation && "Call AddEntity before adding components.");
+
+		constexpr uint32_t componentID = Component::GetClassName().Value();
+		Archetype* pSourceArchetype = pLocation->pArchetype;
+		Archetype* pTargetArchetype = pSourceArchetype->GetAddEdge(componentID);
+		if (!pTargetArchetype)
+		{
+			std::vector<ComponentTypeInfo> typeInfos = pSourceArchetype->GetComponentTypeInfos();
+			ComponentTypeInfo typeInfo = ComponentTypeInfo::Create<Component>();
+			typeInfos.insert(std::upper_bound(typeInfos.begin(), typeInfos.end(), typeInfo,
+				[](const ComponentTypeInfo& lhs, const ComponentTypeInfo& rhs) { return lhs.id < rhs.id; }), typeInfo);
+			pTargetArchetype = GetOrCreateArchetype(std::move(typeInfos));
+			pSourceArchetype->SetAddEdge(componentID, pTargetArchetype);
+			pTargetArchetype->SetRemoveEdge(componentID, pSourceArchetype);
+		}
+
+		Archetype::Row row = MoveEntity(entity, pTargetArchetype);
+		return *std::launder(static_cast<Component*>(pTargetArchetype->GetComponentData(row, pTargetArchetype->GetColumnIndex(componentID))));
+	}
+
+	// Move the entity to the archetype without the component. The entity is kept even if it has no component then.
+	template<typename Component>
+	void RemoveComponent(Entity entity)
+	{
+		if (!HasComponent<Component>(entity))
+		{
+			return;
+		}
+
+		constexpr uint32_t componentID = Component::GetClassName().Value();
+		Archetype* pSourceArchetype = GetLocation(entity)->pArchetype;
+		Archetype* pTargetArchetype = pSourceArchetype->GetRemoveEdge(componentID);
+		if (!pTargetArchetype)
+		{
+			std::vector<ComponentTypeInfo> typeInfos = pSourceArchetype->GetComponentTypeInfos();
+			typeInfos.erase(typeInfos.begin() + pSourceArchetype->GetColumnIndex(componentID));
+			pTargetArchetype = GetOrCreateArchetype(std::move(typeInfos));
+			pSourceArchetype->SetRemoveEdge(componentID, pTargetArchetype);
+			pTargetArchetype->SetAddEdge(componentID, pSourceArchetype);
+		}
+
+		MoveEntity(entity, pTargetArchetype);
+	}
+
+	// Walk all chunks of archetypes which contain Components.
+	// func(std::span<const Entity>, std::span<Components>...) receives contiguous arrays in the same order.
+	template<typename... Components, typename Func>
+	void ForEachChunk(Func&& func)
+	{
+		static_assert(sizeof...(Components) > 0);
+
+		for (auto& [componentIDs, pArchetype] : m_archetypes)
+		{
+			uint32_t columnIndexes[] = { pArchetype->GetColumnIndex(Components::GetClassName().Value())... };
+			if (std::find(std::begin(columnIndexes), std::end(columnIndexes), Archetype::INVALID_COLUMN) != std::end(columnIndexes))
+			{
+				continue;
+			}
+
+			ForEachArchetypeChunk<Components...>(*pArchetype, columnIndexes, std::index_sequence_for<Components...>(), func);
+		}
+	}
+
+	// func(Entity, Components&...)
+	template<typename... Components, typename Func>
+	void Each(Func&& func)
+	{
+		ForEachChunk<Components...>([&func](std::span<const Entity> entities, std::span<Components>... components)
+		{
+			for (size_t rowIndex = 0; rowIndex < entities.size(); ++rowIndex)
+			{
+				func(entities[rowIndex], components[rowIndex]...);
+			}
+		});
+	}
+
+private:
+	struct EntityLocation
+	{
+		Entity entity = INVALID_ENTITY;
+		Archetype* pArchetype = nullptr;
+		Archetype::Row row{};
+	};
+
+	const EntityLocation* GetLocation(Entity entity) const
+	{
+		EntityIndex entityIndex = GetEntityIndex(entity);
+		if (entity == INVALID_ENTITY || entityIndex >= m_locations.size() || m_locations[entityIndex].entity != entity)
+		{
+			return nullptr;
+		}
+
+		return &m_locations[entityIndex];
+	}
+
+	void SetLocation(Entity entity, Archetype* pArchetype, Archetype::Row row)
+	{
+		EntityIndex entityIndex = GetEntityIndex(entity);
+		if (entityIndex >= m_locations.size())
+		{
+			m_locations.resize(entityIndex + 1);
+		}
+
+		m_locations[entityIndex] = EntityLocation{ entity, pArchetype, row };
+	}
+
+	void FreeRow(Archetype* pArchetype, Archetype::Row row)
+	{
+		Entity movedEntity = pArchetype->FreeRow(row);
+		if (INVALID_ENTITY != movedEntity)
+		{
+			m_locations[GetEntityIndex(movedEntity)].row = row;
+		}
+	}
+
+	// Relocate components which exist in both archetypes, construct new ones and destroy dropped ones.
+	Archetype::Row MoveEntity(Entity entity, Archetype* pTargetArchetype)
+	{
+		EntityLocation location = *GetLocation(entity);
+		Archetype* pSourceArchetype = location.pArchetype;
+
+		Archetype::Row targetRow = pTargetArchetype->AllocateRow(entity);
+		const std::vector<uint32_t>& targetIDs = pTargetArchetype->GetComponentIDs();
+		for (uint32_t targetColumn = 0; targetColumn < targetIDs.size(); ++targetColumn)
+		{
+			uint32_t sourceColumn = pSourceArchetype->GetColumnIndex(targetIDs[targetColumn]);
+			if (Archetype::INVALID_COLUMN == sourceColumn)
+			{
+				pTargetArchetype->ConstructComponent(targetRow, targetColumn);
+			}
+			else
+			{
+				pTargetArchetype->GetComponentTypeInfos()[targetColumn].pRelocate(
+					pTargetArchetype->GetComponentData(targetRow, targetColumn), pSourceArchetype->GetComponentData(location.row, sourceColumn));
+			}
+		}
+
+		const std::vector<uint32_t>& sourceIDs = pSourceArchetype->GetComponentIDs();
+		for (uint32_t sourceColumn = 0; sourceColumn < sourceIDs.size(); ++sourceColumn)
+		{
+			if (!pTargetArchetype->Contains(sourceIDs[sourceColumn]))
+			{
+				pSourceArchetype->DestroyComponent(location.row, sourceColumn);
+			}
+		}
+
+		FreeRow(pSourceArchetype, location.row);
+		SetLocation(entity, pTargetArchetype, targetRow);
+		return targetRow;
+	}
+
+	Archetype* GetOrCreateArchetype(std::vector<ComponentTypeInfo> typeInfos)
+	{
+		std::vector<uint32_t> componentIDs;
+		for (const ComponentTypeInfo& typeInfo : typeInfos)
+		{
+			componentIDs.push_back(typeInfo.id);
+		}
+
+		auto itArchetype = m_archetypes.find(componentIDs);
+		if (itArchetype == m_archetypes.end())
+		{
+			itArchetype = m_archetypes.emplace(std::move(componentIDs), std::make_unique<Archetype>(std::move(typeInfos))).first;
+		}
+
+		return itArchetype->second.get();
+	}
+
+	template<typename... Components, size_t... Indexes, typename Func>
+	static void ForEachArchetypeChunk(Archetype& archetype, const uint32_t* pColumnIndexes, std::index_sequence<Indexes...>, Func& func)
+	{
+		size_t columnOffsets[] = { archetype.GetColumnOffset(pColumnIndexes[Indexes])... };
+		for (size_t chunkIndex = 0; chunkIndex < archetype.GetChunkCount(); ++chunkIndex)
+		{
+			ArchetypeChunk& chunk = archetype.GetChunk(chunkIndex);
+			func(chunk.GetEntities(), chunk.template GetColumn<Components>(columnOffsets[Indexes])...);
+		}
+	}
+
+private:
+	// Indexed by entity index.
+	std::vector<EntityLocation> m_locations;
+	std::map<std::vector<uint32_t>, std::unique_ptr<Archetype>> m_archetypes;
+	size_t m_entityCount = 0;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,765 @@
+#pragma once
+
+#include "Entity.h"
+#include "Math/Box.hpp"
+#include "Math/Matrix.hpp"
+#include "Math/Ray.hpp"
+#include "Rendering/FrustumCuller.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace engine
+{
+
+// BoundingVolumeHierarchy is a dynamic AABB tree of entities' world bounds. Every leaf holds one entity.
+// Leaves are inserted next to the sibling which costs the least surface area, and moved leaves refit their ancestors.
+// Refitting keeps queries correct but the tree gets looser over time, so Rebuild builds it again by binned SAH.
+class BoundingVolumeHierarchy final
+{
+public:
+	using NodeIndex = uint32_t;
+	static constexpr NodeIndex INVALID_NODE_INDEX = static_cast<NodeIndex>(-1);
+
+	// NeedsRebuild returns true after the surface area of internal nodes grows over this ratio since the last Rebuild.
+	static constexpr float RebuildCostRatio = 2.0f;
+
+	// Bins per axis to evaluate SAH splits.
+	static constexpr uint32_t SAHBinCount = 16;
+
+public:
+	BoundingVolumeHierarchy() = default;
+	BoundingVolumeHierarchy(const BoundingVolumeHierarchy&) = default;
+	BoundingVolumeHierarchy& operator=(const BoundingVolumeHierarchy&) = default;
+	BoundingVolumeHierarchy(BoundingVolumeHierarchy&&) = default;
+	BoundingVolumeHierarchy& operator=(BoundingVolumeHierarchy&&) = default;
+	~BoundingVolumeHierarchy() = default;
+
+	// World bounds of a local AABB. Boxes without bounds become the point of the translation.
+	static cd::AABB TransformAABB(const cd::AABB& localAABB, const cd::Matrix4x4& worldMatrix)
+	{
+		const float* pMatrix = worldMatrix.Begin();
+		if (localAABB.IsEmpty())
+		{
+			cd::Point translation(pMatrix[12], pMatrix[13], pMatrix[14]);
+			return cd::AABB(translation, translation);
+		}
+
+		const cd::Point& localMin = localAABB.Min();
+		const cd::Point& localMax = localAABB.Max();
+		float localCenter[3] = { (localMin.x() + localMax.x()) * 0.5f, (localMin.y() + localMax.y()) * 0.5f, (localMin.z() + localMax.z()) * 0.5f };
+		float localExtents[3] = { (localMax.x() - localMin.x()) * 0.5f, (localMax.y() - localMin.y()) * 0.5f, (localMax.z() - localMin.z()) * 0.5f };
+		float center[3];
+		float extents[3];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			center[axis] = pMatrix[12 + axis];
+			extents[axis] = 0.0f;
+			for (int column = 0; column < 3; ++column)
+			{
+				center[axis] += pMatrix[column * 4 + axis] * localCenter[column];
+				extents[axis] += std::abs(pMatrix[column * 4 + axis]) * localExtents[column];
+			}
+		}
+
+		return cd::AABB(cd::Point(center[0] - extents[0], center[1] - extents[1], center[2] - extents[2]),
+			cd::Point(center[0] + extents[0], center[1] + extents[1], center[2] + extents[2]));
+	}
+
+	uint32_t GetLeafCount() const { return m_leafCount; }
+	bool IsEmpty() const { return INVALID_NODE_INDEX == m_rootIndex; }
+
+	// Bounds of all leaves. It is empty if there is no leaf.
+	cd::AABB GetBounds() const
+	{
+		return IsEmpty() ? cd::AABB() : m_nodes[m_rootIndex].bounds.ToAABB();
+	}
+
+	// Sum of internal nodes' surface areas. Lower cost means fewer nodes visited by queries.
+	float GetSurfaceAreaCost() const { return m_internalArea; }
+	bool NeedsRebuild() const { return m_internalArea > m_rebuiltInternalArea * RebuildCostRatio; }
+
+	uint32_t GetHeight() const
+	{
+		uint32_t height = 0;
+		std::vector<std::pair<NodeIndex, uint32_t>> stack;
+		if (!IsEmpty())
+		{
+			stack.emplace_back(m_rootIndex, 1);
+		}
+		while (!stack.empty())
+		{
+			auto [nodeIndex, depth] = stack.back();
+			stack.pop_back();
+			height = std::max(height, depth);
+			if (!m_nodes[nodeIndex].IsLeaf())
+			{
+				stack.emplace_back(m_nodes[nodeIndex].children[0], depth + 1);
+				stack.emplace_back(m_nodes[nodeIndex].children[1], depth + 1);
+			}
+		}
+		return height;
+	}
+
+	bool Contains(Entity entity) const { return INVALID_NODE_INDEX != GetLeafIndex(entity); }
+
+	void Clear()
+	{
+		m_nodes.clear();
+		m_entityLeafIndices.clear();
+		m_freeNodeIndex = INVALID_NODE_INDEX;
+		m_rootIndex = INVALID_NODE_INDEX;
+		m_leafCount = 0;
+		m_internalArea = 0.0f;
+		m_rebuiltInternalArea = 0.0f;
+	}
+
+	// Insert the entity or move it if it exists.
+	void Update(Entity entity, const cd::AABB& worldAABB)
+	{
+		NodeIndex leafIndex = GetLeafIndex(entity);
+		if (INVALID_NODE_INDEX == leafIndex)
+		{
+			Insert(entity, Bounds(worldAABB));
+			return;
+		}
+
+		// Ancestors stop refitting once their bounds stay the same.
+		m_nodes[leafIndex].bounds = Bounds(worldAABB);
+		Refit(m_nodes[leafIndex].parent);
+	}
+
+	void Remove(Entity entity)
+	{
+		NodeIndex leafIndex = GetLeafIndex(entity);
+		if (INVALID_NODE_INDEX == leafIndex)
+		{
+			return;
+		}
+
+		m_entityLeafIndices[GetEntityIndex(entity)] = INVALID_NODE_INDEX;
+		--m_leafCount;
+
+		NodeIndex parentIndex = m_nodes[leafIndex].parent;
+		FreeNode(leafIndex);
+		if (INVALID_NODE_INDEX == parentIndex)
+		{
+			m_rootIndex = INVALID_NODE_INDEX;
+			return;
+		}
+
+		// The sibling takes the place of the parent.
+		Node& parent = m_nodes[parentIndex];
+		NodeIndex siblingIndex = parent.children[0] == leafIndex ? parent.children[1] : parent.children[0];
+		NodeIndex grandParentIndex = parent.parent;
+		m_internalArea -= parent.bounds.GetSurfaceArea();
+		FreeNode(parentIndex);
+
+		m_nodes[siblingIndex].parent = grandParentIndex;
+		if (INVALID_NODE_INDEX == grandParentIndex)
+		{
+			m_rootIndex = siblingIndex;
+			return;
+		}
+
+		Node& grandParent = m_nodes[grandParentIndex];
+		grandParent.children[grandParent.children[0] == parentIndex ? 0 : 1] = siblingIndex;
+		Refit(grandParentIndex);
+	}
+
+	// Build the tree again top-down by binned SAH. Call it when NeedsRebuild returns true.
+	void Rebuild()
+	{
+		std::vector<BuildItem> items;
+		items.reserve(m_leafCount);
+		for (const Node& node : m_nodes)
+		{
+			if (node.IsLeaf() && INVALID_ENTITY != node.entity)
+			{
+				items.push_back(BuildItem{ node.bounds, node.bounds.GetCenter(), node.entity });
+			}
+		}
+
+		std::vector<NodeIndex> entityLeafIndices = std::move(m_entityLeafIndices);
+		Clear();
+		m_entityLeafIndices = std::move(entityLeafIndices);
+		std::fill(m_entityLeafIndices.begin(), m_entityLeafIndices.end(), INVALID_NODE_INDEX);
+
+		m_nodes.reserve(items.size() * 2);
+		if (!items.empty())
+		{
+			m_rootIndex = BuildNode(items, 0, static_cast<uint32_t>(items.size()), INVALID_NODE_INDEX);
+		}
+		m_leafCount = static_cast<uint32_t>(items.size());
+		m_rebuiltInternalArea = m_internalArea;
+	}
+
+	// func(Entity) for every leaf which overlaps the box.
+	template<typename Func>
+	void QueryBox(const cd::AABB& box, Func&& func) const
+	{
+		Bounds queryBounds(box);
+		Query([&queryBounds](const Bounds& bounds) { return bounds.Overlaps(queryBounds); }, func);
+	}
+
+	// func(Entity) for every leaf which overlaps the sphere.
+	template<typename Func>
+	void QuerySphere(const cd::Point& center, float radius, Func&& func) const
+	{
+		float sphereCenter[3] = { center.x(), center.y(), center.z() };
+		float squaredRadius = radius * radius;
+		Query([&sphereCenter, squaredRadius](const Bounds& bounds)
+		{
+			float squaredDistance = 0.0f;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				float nearest = std::clamp(sphereCenter[axis], bounds.min[axis], bounds.max[axis]);
+				squaredDistance += (sphereCenter[axis] - nearest) * (sphereCenter[axis] - nearest);
+			}
+			return squaredDistance <= squaredRadius;
+		}, func);
+	}
+
+	// func(Entity) for every leaf which intersects the frustum.
+	// Planes which contain a node fully are skipped by its subtree, and subtrees inside all planes are accepted without tests.
+	template<typename Func>
+	void QueryFrustum(const Frustum& frustum, Func&& func) const
+	{
+		constexpr uint32_t allPlanes = (1 << Frustum::PlaneCount) - 1;
+		std::vector<std::pair<NodeIndex, uint32_t>> stack;
+		if (!IsEmpty())
+		{
+			stack.emplace_back(m_rootIndex, allPlanes);
+		}
+
+		while (!stack.empty())
+		{
+			auto [nodeIndex, planeMask] = stack.back();
+			stack.pop_back();
+
+			const Node& node = m_nodes[nodeIndex];
+			bool isOutside = false;
+			for (uint32_t planeIndex = 0; planeIndex < Frustum::PlaneCount && !isOutside; ++planeIndex)
+			{
+				if (!(planeMask & (1 << planeIndex)))
+				{
+					continue;
+				}
+
+				const std::array<float, 4>& plane = frustum.GetPlane(planeIndex);
+				float distance = plane[3];
+				float radius = 0.0f;
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					distance += plane[axis] * (node.bounds.max[axis] + node.bounds.min[axis]) * 0.5f;
+					radius += std::abs(plane[axis]) * (node.bounds.max[axis] - node.bounds.min[axis]) * 0.5f;
+				}
+
+				if (distance + radius < 0.0f)
+				{
+					isOutside = true;
+				}
+				else if (distance - radius >= 0.0f)
+				{
+					planeMask &= ~(1 << planeIndex);
+				}
+			}
+
+			if (isOutside)
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				func(node.entity);
+			}
+			else if (0 == planeMask)
+			{
+				ForEachLeaf(nodeIndex, func);
+			}
+			else
+			{
+				stack.emplace_back(node.children[0], planeMask);
+				stack.emplace_back(node.children[1], planeMask);
+			}
+		}
+	}
+
+	// The entity whose bounds the ray hits first. rayTime is the distance to the hit along the ray direction.
+	// Nearer children are visited first so that farther subtrees are pruned by the closest hit so far.
+	Entity Raycast(const cd::Ray& ray, float& rayTime, float maxRayTime = std::numeric_limits<float>::max()) const
+	{
+		const cd::Point& origin = ray.Origin();
+		const cd::Direction& direction = ray.Direction();
+		float rayOrigin[3] = { origin.x(), origin.y(), origin.z() };
+		float inverseDirection[3] = { 1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z() };
+
+		Entity nearestEntity = INVALID_ENTITY;
+		float nearestTime = maxRayTime;
+		std::vector<std::pair<NodeIndex, float>> stack;
+		float rootTime;
+		if (!IsEmpty() && m_nodes[m_rootIndex].bounds.IntersectsRay(rayOrigin, inverseDirection, nearestTime, rootTime))
+		{
+			stack.emplace_back(m_rootIndex, rootTime);
+		}
+
+		while (!stack.empty())
+		{
+			auto [nodeIndex, nodeTime] = stack.back();
+			stack.pop_back();
+			if (nodeTime > nearestTime)
+			{
+				continue;
+			}
+
+			const Node& node = m_nodes[nodeIndex];
+			if (node.IsLeaf())
+			{
+				nearestTime = nodeTime;
+				nearestEntity = node.entity;
+				continue;
+			}
+
+			float childTimes[2];
+			bool isChildHit[2];
+			for (int childIndex = 0; childIndex < 2; ++childIndex)
+			{
+				isChildHit[childIndex] = m_nodes[node.children[childIndex]].bounds.IntersectsRay(rayOrigin, inverseDirection, nearestTime, childTimes[childIndex]);
+			}
+
+			// The nearer child is pushed last to be popped first.
+			int nearChildIndex = isChildHit[0] && (!isChildHit[1] || childTimes[0] <= childTimes[1]) ? 0 : 1;
+			int farChildIndex = 1 - nearChildIndex;
+			if (isChildHit[farChildIndex])
+			{
+				stack.emplace_back(node.children[farChildIndex], childTimes[farChildIndex]);
+			}
+			if (isChildHit[nearChildIndex])
+			{
+				stack.emplace_back(node.children[nearChildIndex], childTimes[nearChildIndex]);
+			}
+		}
+
+		rayTime = nearestTime;
+		return nearestEntity;
+	}
+
+private:
+	struct Bounds
+	{
+		Bounds() = default;
+		explicit Bounds(const cd::AABB& aabb) :
+			min{ aabb.Min().x(), aabb.Min().y(), aabb.Min().z() },
+			max{ aabb.Max().x(), aabb.Max().y(), aabb.Max().z() }
+		{
+		}
+
+		static Bounds Union(const Bounds& lhs, const Bounds& rhs)
+		{
+			Bounds bounds;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				bounds.min[axis] = std::min(lhs.min[axis], rhs.min[axis]);
+				bounds.max[axis] = std::max(lhs.max[axis], rhs.max[axis]);
+			}
+			return bounds;
+		}
+
+		cd::AABB ToAABB() const { return cd::AABB(cd::Point(min[0], min[1], min[2]), cd::Point(max[0], max[1], max[2])); }
+
+		std::array<float, 3> GetCenter() const
+		{
+			return { (min[0] + max[0]) * 0.5f, (min[1] + max[1]) * 0.5f, (min[2] + max[2]) * 0.5f };
+		}
+
+		float GetSurfaceArea() const
+		{
+			float x = max[0] - min[0];
+			float y = max[1] - min[1];
+			float z = max[2] - min[2];
+			return 2.0f * (x * y + y * z + z * x);
+		}
+
+		bool Overlaps(const Bounds& other) const
+		{
+			return min[0] <= other.max[0] && max[0] >= other.min[0] &&
+				min[1] <= other.max[1] && max[1] >= other.min[1] &&
+				min[2] <= other.max[2] && max[2] >= other.min[2];
+		}
+
+		bool operator==(const Bounds& other) const
+		{
+			return std::equal(min, min + 3, other.min) && std::equal(max, max + 3, other.max);
+		}
+
+		// Slab test. hitTime is the entry distance which is clamped to 0 if the origin is inside.
+		bool IntersectsRay(const float* pOrigin, const float* pInverseDirection, float maxTime, float& hitTime) const
+		{
+			float enterTime = 0.0f;
+			float exitTime = maxTime;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				float time0 = (min[axis] - pOrigin[axis]) * pInverseDirection[axis];
+				float time1 = (max[axis] - pOrigin[axis]) * pInverseDirection[axis];
+				enterTime = std::max(enterTime, std::min(time0, time1));
+				exitTime = std::min(exitTime, std::max(time0, time1));
+			}
+			hitTime = enterTime;
+			return enterTime <= exitTime;
+		}
+
+		float min[3] = {};
+		float max[3] = {};
+	};
+
+	struct Node
+	{
+		bool IsLeaf() const { return INVALID_NODE_INDEX == children[0]; }
+
+		Bounds bounds;
+		NodeIndex parent = INVALID_NODE_INDEX;
+		// The second child links free nodes when the node is not used. The first child stays invalid.
+		NodeIndex children[2] = { INVALID_NODE_INDEX, INVALID_NODE_INDEX };
+		Entity entity = INVALID_ENTITY;
+	};
+
+	struct BuildItem
+	{
+		Bounds bounds;
+		std::array<float, 3> center;
+		Entity entity;
+	};
+
+	NodeIndex GetLeafIndex(Entity entity) const
+	{
+		EntityIndex entityIndex = GetEntityIndex(entity);
+		if (entityIndex >= m_entityLeafIndices.size())
+		{
+			return INVALID_NODE_INDEX;
+		}
+
+		NodeIndex leafIndex = m_entityLeafIndices[entityIndex];
+		return INVALID_NODE_INDEX != leafIndex && m_nodes[leafIndex].entity == entity ? leafIndex : INVALID_NODE_INDEX;
+	}
+
+	NodeIndex AllocateNode()
+	{
+		NodeIndex nodeIndex = m_freeNodeIndex;
+		if (INVALID_NODE_INDEX == nodeIndex)
+		{
+			nodeIndex = static_cast<NodeIndex>(m_nodes.size());
+			m_nodes.emplace_back();
+		}
+		else
+		{
+			m_freeNodeIndex = m_nodes[nodeIndex].children[1];
+			m_nodes[nodeIndex] = Node();
+		}
+		return nodeIndex;
+	}
+
+	void FreeNode(NodeIndex nodeIndex)
+	{
+		Node& node = m_nodes[nodeIndex];
+		node.entity = INVALID_ENTITY;
+		node.parent = INVALID_NODE_INDEX;
+		node.children[0] = INVALID_NODE_INDEX;
+		node.children[1] = m_freeNodeIndex;
+		m_freeNodeIndex = nodeIndex;
+	}
+
+	NodeIndex AllocateLeaf(Entity entity, const Bounds& bounds, NodeIndex parentIndex)
+	{
+		NodeIndex leafIndex = AllocateNode();
+		Node& leaf = m_nodes[leafIndex];
+		leaf.bounds = bounds;
+		leaf.parent = parentIndex;
+		leaf.entity = entity;
+
+		EntityIndex entityIndex = GetEntityIndex(entity);
+		if (entityIndex >= m_entityLeafIndices.size())
+		{
+			m_entityLeafIndices.resize(entityIndex + 1, INVALID_NODE_INDEX);
+		}
+		m_entityLeafIndices[entityIndex] = leafIndex;
+		return leafIndex;
+	}
+
+	void Insert(Entity entity, const Bounds& bounds)
+	{
+		NodeIndex leafIndex = AllocateLeaf(entity, bounds, INVALID_NODE_INDEX);
+		++m_leafCount;
+		if (IsEmpty())
+		{
+			m_rootIndex = leafIndex;
+			return;
+		}
+
+		// Descend to the sibling which adds the least area to the tree. Ancestors grow by the same bounds whichever is chosen.
+		NodeIndex siblingIndex = m_rootIndex;
+		while (!m_nodes[siblingIndex].IsLeaf())
+		{
+			const Node& node = m_nodes[siblingIndex];
+			float area = node.bounds.GetSurfaceArea();
+			float combinedArea = Bounds::Union(node.bounds, bounds).GetSurfaceArea();
+
+			float siblingCost = 2.0f * combinedArea;
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			float childCosts[2];
+			for (int childIndex = 0; childIndex < 2; ++childIndex)
+			{
+				const Node& child = m_nodes[node.children[childIndex]];
+				float childCombinedArea = Bounds::Union(child.bounds, bounds).GetSurfaceArea();
+				childCosts[childIndex] = inheritanceCost + (child.IsLeaf() ? childCombinedArea : childCombinedArea - child.bounds.GetSurfaceArea());
+			}
+
+			if (siblingCost < childCosts[0] && siblingCost < childCosts[1])
+			{
+				break;
+			}
+			siblingIndex = node.children[childCosts[0] <= childCosts[1] ? 0 : 1];
+		}
+
+		NodeIndex oldParentIndex = m_nodes[siblingIndex].parent;
+		NodeIndex newParentIndex = AllocateNode();
+		Node& newParent = m_nodes[newParentIndex];
+		newParent.parent = oldParentIndex;
+		newParent.bounds = Bounds::Union(m_nodes[siblingIndex].bounds, bounds);
+		newParent.children[0] = siblingIndex;
+		newParent.children[1] = leafIndex;
+		m_internalArea += newParent.bounds.GetSurfaceArea();
+
+		m_nodes[siblingIndex].parent = newParentIndex;
+		m_nodes[leafIndex].parent = newParentIndex;
+		if (INVALID_NODE_INDEX == oldParentIndex)
+		{
+			m_rootIndex = newParentIndex;
+			return;
+		}
+
+		Node& oldParent = m_nodes[oldParentIndex];
+		oldParent.children[oldParent.children[0] == siblingIndex ? 0 : 1] = newParentIndex;
+		Refit(oldParentIndex);
+	}
+
+	void Refit(NodeIndex nodeIndex)
+	{
+		while (INVALID_NODE_INDEX != nodeIndex)
+		{
+			Node& node = m_nodes[nodeIndex];
+			Bounds bounds = Bounds::Union(m_nodes[node.children[0]].bounds, m_nodes[node.children[1]].bounds);
+			if (bounds == node.bounds)
+			{
+				return;
+			}
+
+			m_internalArea += bounds.GetSurfaceArea() - node.bounds.GetSurfaceArea();
+			node.bounds = bounds;
+			nodeIndex = node.parent;
+		}
+	}
+
+	NodeIndex BuildNode(std::vector<BuildItem>& items, uint32_t begin, uint32_t end, NodeIndex parentIndex)
+	{
+		if (end - begin == 1)
+		{
+			return AllocateLeaf(items[begin].entity, items[begin].bounds, parentIndex);
+		}
+
+		Bounds bounds = items[begin].bounds;
+		Bounds centerBounds;
+		std::copy(items[begin].center.begin(), items[begin].center.end(), centerBounds.min);
+		std::copy(items[begin].center.begin(), items[begin].center.end(), centerBounds.max);
+		for (uint32_t itemIndex = begin + 1; itemIndex < end; ++itemIndex)
+		{
+			bounds = Bounds::Union(bounds, items[itemIndex].bounds);
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				centerBounds.min[axis] = std::min(centerBounds.min[axis], items[itemIndex].center[axis]);
+				centerBounds.max[axis] = std::max(centerBounds.max[axis], items[itemIndex].center[axis]);
+			}
+		}
+
+		uint32_t middle = FindSAHSplit(items, begin, end, centerBounds);
+		if (middle == begin || middle == end)
+		{
+			// Centers are too close to be binned. Split by the median of the longest axis.
+			int axis = 0;
+			for (int otherAxis = 1; otherAxis < 3; ++otherAxis)
+			{
+				if (centerBounds.max[otherAxis] - centerBounds.min[otherAxis] > centerBounds.max[axis] - centerBounds.min[axis])
+				{
+					axis = otherAxis;
+				}
+			}
+			middle = begin + (end - begin) / 2;
+			std::nth_element(items.begin() + begin, items.begin() + middle, items.begin() + end,
+				[axis](const BuildItem& lhs, const BuildItem& rhs) { return lhs.center[axis] < rhs.center[axis]; });
+		}
+
+		NodeIndex nodeIndex = AllocateNode();
+		m_nodes[nodeIndex].bounds = bounds;
+		m_nodes[nodeIndex].parent = parentIndex;
+		m_internalArea += bounds.GetSurfaceArea();
+
+		NodeIndex leftIndex = BuildNode(items, begin, middle, nodeIndex);
+		NodeIndex rightIndex = BuildNode(items, middle, end, nodeIndex);
+		m_nodes[nodeIndex].children[0] = leftIndex;
+		m_nodes[nodeIndex].children[1] = rightIndex;
+		return nodeIndex;
+	}
+
+	// Partition items by the cheapest bin boundary of all axes. Returns begin or end if no split is found.
+	uint32_t FindSAHSplit(std::vector<BuildItem>& items, uint32_t begin, uint32_t end, const Bounds& centerBounds) const
+	{
+		struct Bin
+		{
+			Bounds bounds;
+			uint32_t count = 0;
+		};
+
+		float bestCost = std::numeric_limits<float>::max();
+		int bestAxis = -1;
+		uint32_t bestBinIndex = 0;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float axisMin = centerBounds.min[axis];
+			float axisLength = centerBounds.max[axis] - axisMin;
+			if (axisLength <= 0.0f)
+			{
+				continue;
+			}
+
+			float binScale = SAHBinCount / axisLength;
+			std::array<Bin, SAHBinCount> bins;
+			for (uint32_t itemIndex = begin; itemIndex < end; ++itemIndex)
+			{
+				uint32_t binIndex = std::min(SAHBinCount - 1, static_cast<uint32_t>((items[itemIndex].center[axis] - axisMin) * binScale));
+				Bin& bin = bins[binIndex];
+				bin.bounds = 0 == bin.count ? items[itemIndex].bounds : Bounds::Union(bin.bounds, items[itemIndex].bounds);
+				++bin.count;
+			}
+
+			// Sweep from the right to get areas of all right parts, then from the left to evaluate the splits.
+			std::array<float, SAHBinCount> rightAreas;
+			Bounds rightBounds;
+			uint32_t rightCount = 0;
+			for (uint32_t binIndex = SAHBinCount - 1; binIndex > 0; --binIndex)
+			{
+				if (bins[binIndex].count > 0)
+				{
+					rightBounds = 0 == rightCount ? bins[binIndex].bounds : Bounds::Union(rightBounds, bins[binIndex].bounds);
+					rightCount += bins[binIndex].count;
+				}
+				rightAreas[binIndex] = rightCount > 0 ? rightBounds.GetSurfaceArea() * rightCount : 0.0f;
+			}
+
+			Bounds leftBounds;
+			uint32_t leftCount = 0;
+			for (uint32_t binIndex = 0; binIndex < SAHBinCount - 1; ++binIndex)
+			{
+				if (bins[binIndex].count > 0)
+				{
+					leftBounds = 0 == leftCount ? bins[binIndex].bounds : Bounds::Union(leftBounds, bins[binIndex].bounds);
+					leftCount += bins[binIndex].count;
+				}
+
+				if (0 == leftCount || leftCount == end - begin)
+				{
+					continue;
+				}
+
+				float cost = leftBounds.GetSurfaceArea() * leftCount + rightAreas[binIndex + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBinIndex = binIndex;
+				}
+			}
+		}
+
+		if (bestAxis < 0)
+		{
+			return begin;
+		}
+
+		float axisMin = centerBounds.min[bestAxis];
+		float binScale = SAHBinCount / (centerBounds.max[bestAxis] - axisMin);
+		auto middle = std::partition(items.begin() + begin, items.begin() + end, [bestAxis, axisMin, binScale, bestBinIndex](const BuildItem& item)
+		{
+			return std::min(SAHBinCount - 1, static_cast<uint32_t>((item.center[bestAxis] - axisMin) * binScale)) <= bestBinIndex;
+		});
+		return static_cast<uint32_t>(middle - items.begin());
+	}
+
+	template<typename Func>
+	void ForEachLeaf(NodeIndex rootIndex, Func&& func) const
+	{
+		std::vector<NodeIndex> stack{ rootIndex };
+		while (!stack.empty())
+		{
+			const Node& node = m_nodes[stack.back()];
+			stack.pop_back();
+			if (node.IsLeaf())
+			{
+				func(node.entity);
+			}
+			else
+			{
+				stack.push_back(node.children[0]);
+				stack.push_back(node.children[1]);
+			}
+		}
+	}
+
+	template<typename Overlaps, typename Func>
+	void Query(Overlaps&& overlaps, Func&& func) const
+	{
+		std::vector<NodeIndex> stack;
+		if (!IsEmpty())
+		{
+			stack.push_back(m_rootIndex);
+		}
+
+		while (!stack.empty())
+		{
+			const Node& node = m_nodes[stack.back()];
+			stack.pop_back();
+			if (!overlaps(node.bounds))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				func(node.entity);
+			}
+			else
+			{
+				stack.push_back(node.children[0]);
+				stack.push_back(node.children[1]);
+			}
+		}
+	}
+
+private:
+	std::vector<Node> m_nodes;
+	std::vector<NodeIndex> m_entityLeafIndices;
+	NodeIndex m_freeNodeIndex = INVALID_NODE_INDEX;
+	NodeIndex m_rootIndex = INVALID_NODE_INDEX;
+	uint32_t m_leafCount = 0;
+
+	float m_internalArea = 0.0f;
+	float m_rebuiltInternalArea = 0.0f;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "ComponentTypeIndex.hpp"
+#include "Entity.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// One bit per component type index which is set if the entity has the component.
+using ComponentSignature = uint64_t;
+static constexpr TypeIndex MaxSignatureComponentCount = 64;
+
+template<typename... Components>
+ComponentSignature GetComponentSignature()
+{
+	return ((ComponentSignature(1) << GetComponentTypeIndex<Components>()) | ... | ComponentSignature(0));
+}
+
+// EntitySignatures stores component signatures of entities in a flat array keyed by entity index.
+// So membership tests of any component combination are one load and one bitwise test without probing storages.
+class EntitySignatures final
+{
+public:
+	EntitySignatures() = default;
+	EntitySignatures(const EntitySignatures&) = default;
+	EntitySignatures& operator=(const EntitySignatures&) = default;
+	EntitySignatures(EntitySignatures&&) = default;
+	EntitySignatures& operator=(EntitySignatures&&) = default;
+	~EntitySignatures() = default;
+
+	// The entity should be alive. Signatures of recycled indexes are cleared when their components are removed.
+	ComponentSignature Get(Entity entity) const
+	{
+		EntityIndex entityIndex = GetEntityIndex(entity);
+		return entityIndex < m_signatures.size() ? m_signatures[entityIndex] : 0;
+	}
+
+	bool Contains(Entity entity, ComponentSignature signature) const { return (Get(entity) & signature) == signature; }
+	bool ContainsAny(Entity entity, ComponentSignature signature) const { return (Get(entity) & signature) != 0; }
+
+	void Add(Entity entity, TypeIndex componentIndex)
+	{
+		EntityIndex entityIndex = GetEntityIndex(entity);
+		if (entityIndex >= m_signatures.size())
+		{
+			m_signatures.resize(entityIndex + 1, 0);
+		}
+		m_signatures[entityIndex] |= ComponentSignature(1) << componentIndex;
+	}
+
+	void Remove(Entity entity, TypeIndex componentIndex)
+	{
+		EntityIndex entityIndex = GetEntityIndex(entity);
+		if (entityIndex < m_signatures.size())
+		{
+			m_signatures[entityIndex] &= ~(ComponentSignature(1) << componentIndex);
+		}
+	}
+
+private:
+	std::vector<ComponentSignature> m_signatures;
+};
+
+}
\ No newline at end of file
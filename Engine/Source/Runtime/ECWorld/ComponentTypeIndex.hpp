@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace engine
+{
+
+using TypeIndex = uint32_t;
+
+// TypeIndexer assigns dense indices to types on first use, so that containers can be addressed by a plain array index
+// instead of hashing the type name. Indices are only unique inside the same Family and stable during the process.
+template<typename Family>
+class TypeIndexer final
+{
+public:
+	TypeIndexer() = delete;
+
+	template<typename T>
+	static TypeIndex Get()
+	{
+		static const TypeIndex index = s_nextIndex.fetch_add(1, std::memory_order_relaxed);
+		return index;
+	}
+
+	static TypeIndex GetCount() { return s_nextIndex.load(std::memory_order_relaxed); }
+
+private:
+	static inline std::atomic<TypeIndex> s_nextIndex = 0;
+};
+
+class IComponentsStorage;
+
+template<typename Component>
+TypeIndex GetComponentTypeIndex()
+{
+	return TypeIndexer<IComponentsStorage>::Get<Component>();
+}
+
+}
\ No newline at end of file
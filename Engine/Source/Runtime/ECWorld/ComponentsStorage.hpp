@@ -1,29 +1,89 @@
 #pragma once
 
+#include "Core/Delegates/MulticastDelegate.hpp"
 #include "Entity.h"
+#include "SparseEntitySet.hpp"
 
-#include <algorithm>
 #include <cassert>
-#include <map>
-#include <unordered_map>
+#include <span>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace engine
 {
 
+// World tick when a component was last created or modified. It increases every frame.
+using ChangeTick = uint32_t;
+
+// Fragmentation metrics of a storage to tune compaction budgets.
+struct ComponentsStorageStats
+{
+	// Active components.
+	size_t count = 0;
+
+	// Component slots which are allocated in memory.
+	size_t capacity = 0;
+
+	// Removed slots which are not compacted yet.
+	size_t holeCount = 0;
+
+	size_t sparsePageCount = 0;
+	size_t emptySparsePageCount = 0;
+
+	// Components are stored in the order of entity indices.
+	bool isSorted = true;
+
+	// Components which were moved out of the order since the storage was sorted.
+	size_t unsortedCount = 0;
+};
+
+// Raw columns of a storage which are saved to or loaded from World snapshots as memory blocks.
+struct ComponentsColumns
+{
+	uint32_t componentName = 0;
+	uint32_t componentSize = 0;
+	uint32_t componentAlignment = 0;
+	std::span<const Entity> entities;
+	const void* pComponents = nullptr;
+};
+
 class IComponentsStorage
 {
 public:
 	virtual ~IComponentsStorage() = default;
+
+	// World removes components of destroyed entities without knowing the component type.
+	virtual void RemoveComponent(Entity entity) = 0;
+
+	// World updates the tick of all storages when it advances.
+	virtual void SetCurrentTick(ChangeTick tick) = 0;
+
+	// Do at most budget steps of compaction so that it can be spread over frames. The budget is consumed.
+	// Returns true when there is nothing left to compact. It never allocates memory.
+	virtual bool Compact(size_t& budget, bool sortByEntity) = 0;
+
+	virtual ComponentsStorageStats GetStats() const = 0;
+
+	// Only storages of trivially copyable components support snapshots. Others return false with only the component name set.
+	virtual bool GetColumns(ComponentsColumns& outColumns) const = 0;
+
+	// Load columns to an empty storage. Returns false if the component layout doesn't match.
+	virtual bool LoadColumns(const ComponentsColumns& columns) = 0;
 };
 
 // ComponentsStorage stores an array of Components in the same type and the entity which contains the component.
+// It is a sparse set : a paged sparse table maps entity to the slot in the dense arrays of entities and components.
+// So looking up a component costs two array indexes and active components are always packed for iteration.
 template<typename Component>
 class ComponentsStorage : public IComponentsStorage
 {
 public:
 	static_assert(!std::is_pointer_v<Component> && !std::is_reference_v<Component>);
 
+	using DenseIndex = SparseEntitySet::DenseIndex;
+	static constexpr DenseIndex INVALID_DENSE_INDEX = SparseEntitySet::INVALID_DENSE_INDEX;
+
 public:
 	ComponentsStorage() = default;
 	ComponentsStorage(const ComponentsStorage&) = delete;
@@ -33,133 +93,250 @@ public:
 	virtual ~ComponentsStorage() = default;
 
 	// Returns if ComponentStorage stores component for entity.
-	bool Contains(Entity entity) const { return m_entityToIndex.contains(entity); }
+	bool Contains(Entity entity) const { return m_entitySet.Contains(entity); }
 
 	// Returns current active components count.
-	size_t GetCount() const { return m_entityToIndex.size(); }
+	size_t GetCount() const { return m_entitySet.GetCount(); }
 
 	// Returns current components capcity.
-	size_t GetCapcity() const { assert(m_entities.size() == m_components.size()); return m_entities.size(); }
+	size_t GetCapcity() const { assert(m_entitySet.GetCount() == m_components.size()); return m_components.size(); }
 
-	// Need to check if it is still active.
-	const std::vector<Entity>& GetEntities() const { return m_entities; }
+	// Returns sparse pages count which are allocated now.
+	size_t GetSparsePageCount() const { return m_entitySet.GetSparsePageCount(); }
 
-	// Get component by entity.
-	Component* GetComponent(Entity entity)
+	// Index of the entity's component in GetComponents(). It is only stable until the layout version changes.
+	DenseIndex GetDenseIndex(Entity entity) const { return m_entitySet.GetDenseIndex(entity); }
+
+	// Changes whenever a component is added, removed or moved in dense arrays, so that caches of dense indices know to rebuild.
+	uint32_t GetLayoutVersion() const { return m_layoutVersion; }
+
+	// Entities are packed so all of them are active. The order is the same as GetComponents().
+	const std::vector<Entity>& GetEntities() const { return m_entitySet.GetEntities(); }
+
+	// Components are packed so all of them are active. The order is the same as GetEntities().
+	std::vector<Component>& GetComponents() { return m_components; }
+	const std::vector<Component>& GetComponents() const { return m_components; }
+
+	// Stamp the component with the current tick after modifying it, so that change queries return it.
+	void MarkChanged(Entity entity)
 	{
-		auto itIndex = m_entityToIndex.find(entity);
-		return itIndex == m_entityToIndex.end() ? nullptr : &m_components[itIndex->second];
+		DenseIndex denseIndex = m_entitySet.GetDenseIndex(entity);
+		if (INVALID_DENSE_INDEX != denseIndex)
+		{
+			m_changeTicks[denseIndex] = m_currentTick;
+			m_lastChangeTick = m_currentTick;
+		}
 	}
 
-	// Create component for entity.
-	Component& CreateComponent(Entity entity)
+	// Get component by entity and mark it as changed.
+	Component* ModifyComponent(Entity entity)
 	{
-		assert(entity != INVALID_ENTITY && !Contains(entity));
+		MarkChanged(entity);
+		return GetComponent(entity);
+	}
 
-		// There was an entity/component removed so we can reuse it.
-		if (!m_unusedEntityIndexes.empty())
-		{
-			size_t reusedIndex = m_unusedEntityIndexes.back();
-			m_unusedEntityIndexes.pop_back();
+	ChangeTick GetCurrentTick() const { return m_currentTick; }
+	void SetCurrentTick(ChangeTick tick) override { m_currentTick = tick; }
+
+	// Returns the tick when the component was last created or modified. 0 if there is no such component.
+	ChangeTick GetChangeTick(Entity entity) const
+	{
+		DenseIndex denseIndex = m_entitySet.GetDenseIndex(entity);
+		return INVALID_DENSE_INDEX == denseIndex ? 0 : m_changeTicks[denseIndex];
+	}
 
-			m_entityToIndex[entity] = reusedIndex;
-			m_entities[reusedIndex] = entity;
-			return m_components[reusedIndex];
+	// Returns if any component was created, modified or removed at or after the tick.
+	// Consumers store the current tick after processing and pass it next time. Changes made later in the same tick
+	// are returned again next time, so processing should be idempotent. It is O(1) so static storages cost nothing.
+	bool HasChangedSince(ChangeTick tick) const { return m_lastChangeTick >= tick; }
+
+	// func(Entity, Component&) for components created or modified at or after the tick.
+	template<typename Func>
+	void ForEachChanged(ChangeTick tick, Func&& func)
+	{
+		if (m_lastChangeTick < tick)
+		{
+			return;
 		}
 
-		m_entityToIndex[entity] = m_components.size();
-		m_entities.emplace_back(entity);
-		m_components.emplace_back();
-		return m_components.back();
+		const std::vector<Entity>& entities = m_entitySet.GetEntities();
+		for (size_t denseIndex = 0; denseIndex < entities.size(); ++denseIndex)
+		{
+			if (m_changeTicks[denseIndex] >= tick)
+			{
+				func(entities[denseIndex], m_components[denseIndex]);
+			}
+		}
 	}
 
-	// Remove actvie component from storage.
-	void RemoveComponent(Entity entity)
+	// Collect entities whose components are created or modified at or after the tick.
+	void GetChangedEntities(ChangeTick tick, std::vector<Entity>& outEntities) const
 	{
-		auto itIndex = m_entityToIndex.find(entity);
-		if (itIndex == m_entityToIndex.end())
+		if (m_lastChangeTick < tick)
 		{
 			return;
 		}
 
-		// We don't want to change the array immediately as it will cause memory copy/movement.
-		// Instead, we mark it as it unused which will be removed in the future.
-		m_unusedEntityIndexes.push_back(itIndex->second);
-		m_entityToIndex.erase(entity);
+		const std::vector<Entity>& entities = m_entitySet.GetEntities();
+		for (size_t denseIndex = 0; denseIndex < entities.size(); ++denseIndex)
+		{
+			if (m_changeTicks[denseIndex] >= tick)
+			{
+				outEntities.push_back(entities[denseIndex]);
+			}
+		}
 	}
 
-	// Remove unused components.
-	void CleanUnused()
+	// Get component by entity.
+	Component* GetComponent(Entity entity)
+	{
+		DenseIndex denseIndex = m_entitySet.GetDenseIndex(entity);
+		return INVALID_DENSE_INDEX == denseIndex ? nullptr : &m_components[denseIndex];
+	}
+
+	const Component* GetComponent(Entity entity) const
+	{
+		DenseIndex denseIndex = m_entitySet.GetDenseIndex(entity);
+		return INVALID_DENSE_INDEX == denseIndex ? nullptr : &m_components[denseIndex];
+	}
+
+	// Create component for entity.
+	Component& CreateComponent(Entity entity)
+	{
+		m_entitySet.Add(entity);
+		Component& component = m_components.emplace_back();
+		m_changeTicks.emplace_back(m_currentTick);
+		m_lastChangeTick = m_currentTick;
+		++m_layoutVersion;
+		OnComponentCreated.Invoke(entity);
+		return component;
+	}
+
+	// Remove actvie component from storage.
+	void RemoveComponent(Entity entity) override
 	{
-		if (m_unusedEntityIndexes.empty())
+		DenseIndex removedIndex = m_entitySet.Remove(entity);
+		if (INVALID_DENSE_INDEX == removedIndex)
 		{
-			// Components are all used.
 			return;
 		}
 
-		if (m_entityToIndex.empty())
+		// SparseEntitySet swapped the last entity into the hole. Do the same for components to keep packed.
+		DenseIndex lastIndex = static_cast<DenseIndex>(m_components.size() - 1);
+		if (removedIndex != lastIndex)
 		{
-			// Components are all unused.
-			m_entities.clear();
-			m_components.clear();
-			m_entityToIndex.clear();
-			m_unusedEntityIndexes.clear();
-			return;
+			m_components[removedIndex] = std::move(m_components[lastIndex]);
+			m_changeTicks[removedIndex] = m_changeTicks[lastIndex];
 		}
+		m_components.pop_back();
+		m_changeTicks.pop_back();
+		m_lastChangeTick = m_currentTick;
+		++m_layoutVersion;
+
+		OnComponentRemoved.Invoke(entity);
+	}
 
-		std::sort(m_unusedEntityIndexes.begin(), m_unusedEntityIndexes.end(),
-			[](size_t lhs, size_t rhs) { return lhs < rhs; });
+	// Dense arrays are always packed. Release sparse pages which don't map any entity and the spare memory of dense arrays.
+	void CleanUnused()
+	{
+		m_entitySet.CleanUnused();
+		m_components.shrink_to_fit();
+		m_changeTicks.shrink_to_fit();
+	}
 
-		// Back iterate to find last n active entities for unused entities to overwrite memory.
-		int swapTimes = 0;
-		int skipTimes = 0;
-		std::map<Entity, size_t> tempEntityToIndex;
-		for (int entityIndex = static_cast<int>(m_entities.size()) - 1; entityIndex >= 0; --entityIndex)
+	// Dense arrays are always packed so compaction releases empty sparse pages.
+	// Sorting by entity restores the iteration locality with sparse lookups after heavy churn shuffled dense arrays.
+	bool Compact(size_t& budget, bool sortByEntity) override
+	{
+		bool isCompacted = m_entitySet.ReleaseEmptySparsePages(budget);
+		if (sortByEntity)
 		{
-			// Check if it is an active index.
-			Entity entity = m_entities[entityIndex];
-			if (m_entityToIndex.contains(entity))
+			isCompacted = m_entitySet.SortStep(budget, [this](DenseIndex lhs, DenseIndex rhs)
 			{
-				size_t unusedIndex = m_unusedEntityIndexes[swapTimes++];
-				m_entities[unusedIndex] = entity;
-				m_components[unusedIndex] = std::move(m_components[entityIndex]);
+				std::swap(m_components[lhs], m_components[rhs]);
+				std::swap(m_changeTicks[lhs], m_changeTicks[rhs]);
+				++m_layoutVersion;
+			}) && isCompacted;
+		}
 
-				// Don't modify m_entityToIndex immediately in the process.
-				// m_entityToIndex[entity] = unusedIndex;
+		return isCompacted;
+	}
 
-				tempEntityToIndex[entity] = unusedIndex;
-			}
-			else
+	ComponentsStorageStats GetStats() const override
+	{
+		ComponentsStorageStats stats;
+		stats.count = m_components.size();
+		stats.capacity = m_components.capacity();
+		stats.holeCount = 0;
+		stats.sparsePageCount = m_entitySet.GetSparsePageCount();
+		stats.emptySparsePageCount = m_entitySet.GetEmptySparsePageCount();
+		stats.isSorted = m_entitySet.IsSorted();
+		stats.unsortedCount = m_entitySet.GetUnsortedCount();
+		return stats;
+	}
+
+	bool GetColumns(ComponentsColumns& outColumns) const override
+	{
+		outColumns.componentName = Component::GetClassName().Value();
+		if constexpr (std::is_trivially_copyable_v<Component>)
+		{
+			outColumns.componentSize = sizeof(Component);
+			outColumns.componentAlignment = alignof(Component);
+			outColumns.entities = m_entitySet.GetEntities();
+			outColumns.pComponents = m_components.data();
+			return true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	// Components are copied as a whole block. Loaded components are stamped with the current tick as changed.
+	bool LoadColumns([[maybe_unused]] const ComponentsColumns& columns) override
+	{
+		if constexpr (std::is_trivially_copyable_v<Component>)
+		{
+			if (columns.componentName != Component::GetClassName().Value() ||
+				columns.componentSize != sizeof(Component) || columns.componentAlignment != alignof(Component))
 			{
-				// No need to swap. Already at the array back.
-				++skipTimes;
+				return false;
 			}
 
-			m_entities.pop_back();
-			m_components.pop_back();
+			assert(m_components.empty() && "Load columns to an empty storage.");
+			const Component* pComponents = static_cast<const Component*>(columns.pComponents);
+			m_components.assign(pComponents, pComponents + columns.entities.size());
+			m_changeTicks.assign(columns.entities.size(), m_currentTick);
+			m_lastChangeTick = m_currentTick;
+			++m_layoutVersion;
 
-			// Finish.
-			if (swapTimes + skipTimes == m_unusedEntityIndexes.size())
+			m_entitySet.Reserve(columns.entities.size());
+			for (Entity entity : columns.entities)
 			{
-				break;
+				m_entitySet.Add(entity);
+				OnComponentCreated.Invoke(entity);
 			}
+			return true;
 		}
-
-		// Modify
-		for (const auto& [entity, index] : tempEntityToIndex)
+		else
 		{
-			assert(m_entityToIndex.contains(entity));
-			m_entityToIndex[entity] = index;
+			return false;
 		}
-
-		m_unusedEntityIndexes.clear();
 	}
 
+public:
+	// Invoked after a component is created/removed for the entity. For example, World uses them to update cached views.
+	MulticastDelegate<void(Entity)> OnComponentCreated;
+	MulticastDelegate<void(Entity)> OnComponentRemoved;
+
 private:
-	std::vector<Entity> m_entities;
+	SparseEntitySet m_entitySet;
 	std::vector<Component> m_components;
-	std::unordered_map<Entity, size_t> m_entityToIndex;
-	std::vector<size_t> m_unusedEntityIndexes;
+	std::vector<ChangeTick> m_changeTicks;
+
+	ChangeTick m_currentTick = 1;
+	ChangeTick m_lastChangeTick = 0;
+	uint32_t m_layoutVersion = 0;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "ComponentSignature.hpp"
+#include "ComponentsStorage.hpp"
+#include "Entity.h"
+#include "SparseEntitySet.hpp"
+
+#include <tuple>
+#include <vector>
+
+namespace engine
+{
+
+// Tag to filter out entities which contain any of these components from a View.
+// For example, World::View<TransformComponent, StaticMeshComponent>(Without<AnimationComponent>()).
+template<typename... Components>
+struct Without
+{
+};
+
+class IEntityQuery
+{
+public:
+	virtual ~IEntityQuery() = default;
+};
+
+template<typename IncludeList, typename ExcludeList>
+class EntityQuery;
+
+// EntityQuery caches entities which contain all Includes components and none of Excludes components.
+// It listens to related storages so the matching set is updated incrementally when components are created or removed.
+// Candidates are matched by entity signatures which the World updates before notifying queries.
+template<typename... Includes, typename... Excludes>
+class EntityQuery<std::tuple<Includes...>, std::tuple<Excludes...>> final : public IEntityQuery
+{
+public:
+	static_assert(sizeof...(Includes) > 0, "EntityQuery needs at least one component to include.");
+
+public:
+	EntityQuery() = delete;
+	explicit EntityQuery(const EntitySignatures* pSignatures, ComponentsStorage<Includes>*... pIncludeStorages, ComponentsStorage<Excludes>*... pExcludeStorages)
+		: m_pSignatures(pSignatures)
+		, m_includeSignature(GetComponentSignature<Includes...>())
+		, m_excludeSignature(GetComponentSignature<Excludes...>())
+		, m_includeStorages(pIncludeStorages...)
+	{
+		(pIncludeStorages->OnComponentCreated.template Bind<EntityQuery, &EntityQuery::OnIncludeCreated>(this), ...);
+		(pIncludeStorages->OnComponentRemoved.template Bind<EntityQuery, &EntityQuery::OnIncludeRemoved>(this), ...);
+		(pExcludeStorages->OnComponentCreated.template Bind<EntityQuery, &EntityQuery::OnExcludeCreated>(this), ...);
+		(pExcludeStorages->OnComponentRemoved.template Bind<EntityQuery, &EntityQuery::OnExcludeRemoved>(this), ...);
+
+		// Only the smallest storage needs to be walked to build the initial matching set.
+		const std::vector<Entity>* pCandidates = nullptr;
+		((pCandidates = (!pCandidates || pIncludeStorages->GetCount() < pCandidates->size()) ? &pIncludeStorages->GetEntities() : pCandidates), ...);
+		for (Entity entity : *pCandidates)
+		{
+			if (Matches(entity))
+			{
+				m_matchedEntities.Add(entity);
+			}
+		}
+	}
+	EntityQuery(const EntityQuery&) = delete;
+	EntityQuery& operator=(const EntityQuery&) = delete;
+	EntityQuery(EntityQuery&&) = delete;
+	EntityQuery& operator=(EntityQuery&&) = delete;
+	virtual ~EntityQuery() = default;
+
+	bool Matches(Entity entity) const
+	{
+		ComponentSignature signature = m_pSignatures->Get(entity);
+		return (signature & m_includeSignature) == m_includeSignature && 0 == (signature & m_excludeSignature);
+	}
+
+	const std::vector<Entity>& GetEntities() const { return m_matchedEntities.GetEntities(); }
+	const std::tuple<ComponentsStorage<Includes>*...>& GetIncludeStorages() const { return m_includeStorages; }
+
+private:
+	void TryAdd(Entity entity)
+	{
+		if (!m_matchedEntities.Contains(entity) && Matches(entity))
+		{
+			m_matchedEntities.Add(entity);
+		}
+	}
+
+	void OnIncludeCreated(Entity entity) { TryAdd(entity); }
+	void OnIncludeRemoved(Entity entity) { m_matchedEntities.Remove(entity); }
+	void OnExcludeCreated(Entity entity) { m_matchedEntities.Remove(entity); }
+	void OnExcludeRemoved(Entity entity) { TryAdd(entity); }
+
+private:
+	const EntitySignatures* m_pSignatures;
+	ComponentSignature m_includeSignature;
+	ComponentSignature m_excludeSignature;
+	std::tuple<ComponentsStorage<Includes>*...> m_includeStorages;
+	SparseEntitySet m_matchedEntities;
+};
+
+// ComponentsView walks matched entities and yields the entity with references to its components.
+// Don't create or remove related components during the iteration as it changes the matched entities in place.
+template<typename... Components>
+class ComponentsView
+{
+public:
+	using StorageTuple = std::tuple<ComponentsStorage<Components>*...>;
+	using ValueType = std::tuple<Entity, Components&...>;
+
+	class Iterator
+	{
+	public:
+		Iterator(std::vector<Entity>::const_iterator itEntity, const StorageTuple* pStorages) : m_itEntity(itEntity), m_pStorages(pStorages) {}
+
+		ValueType operator*() const
+		{
+			Entity entity = *m_itEntity;
+			return ValueType(entity, *std::get<ComponentsStorage<Components>*>(*m_pStorages)->GetComponent(entity)...);
+		}
+
+		Iterator& operator++() { ++m_itEntity; return *this; }
+		bool operator==(const Iterator& other) const { return m_itEntity == other.m_itEntity; }
+		bool operator!=(const Iterator& other) const { return m_itEntity != other.m_itEntity; }
+
+	private:
+		std::vector<Entity>::const_iterator m_itEntity;
+		const StorageTuple* m_pStorages;
+	};
+
+public:
+	ComponentsView() = delete;
+	explicit ComponentsView(const std::vector<Entity>& entities, StorageTuple storages) : m_pEntities(&entities), m_storages(storages) {}
+	ComponentsView(const ComponentsView&) = default;
+	ComponentsView& operator=(const ComponentsView&) = default;
+	ComponentsView(ComponentsView&&) = default;
+	ComponentsView& operator=(ComponentsView&&) = default;
+	~ComponentsView() = default;
+
+	bool IsEmpty() const { return m_pEntities->empty(); }
+	size_t GetCount() const { return m_pEntities->size(); }
+	const std::vector<Entity>& GetEntities() const { return *m_pEntities; }
+
+	Iterator begin() const { return Iterator(m_pEntities->cbegin(), &m_storages); }
+	Iterator end() const { return Iterator(m_pEntities->cend(), &m_storages); }
+
+	// func(Entity, Components&...)
+	template<typename Func>
+	void Each(Func&& func) const
+	{
+		for (Entity entity : *m_pEntities)
+		{
+			func(entity, *std::get<ComponentsStorage<Components>*>(m_storages)->GetComponent(entity)...);
+		}
+	}
+
+private:
+	const std::vector<Entity>* m_pEntities;
+	StorageTuple m_storages;
+};
+
+}
\ No newline at end of file
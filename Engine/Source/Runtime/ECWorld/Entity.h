@@ -5,8 +5,25 @@
 namespace engine
 {
 
-// Entity is a global unique unsigned integer identifier [0, max - 1] in the engine runtime.
+// Entity is a generational handle in the engine runtime which packs an index and a version.
+// The index is recycled after the entity is destroyed so that ID lookups stay dense.
+// The version increases every time the index is recycled so that a stale handle can be detected in O(1).
 using Entity = uint32_t;
+using EntityIndex = uint32_t;
+using EntityVersion = uint32_t;
+
+static constexpr uint32_t ENTITY_INDEX_BITS = 22;
+static constexpr uint32_t ENTITY_VERSION_BITS = 32 - ENTITY_INDEX_BITS;
+static constexpr EntityIndex ENTITY_INDEX_MASK = (1U << ENTITY_INDEX_BITS) - 1;
+static constexpr EntityVersion ENTITY_VERSION_MASK = (1U << ENTITY_VERSION_BITS) - 1;
+
 static constexpr Entity INVALID_ENTITY = static_cast<uint32_t>(-1);
 
+// The max index is never allocated so that no version can make a valid entity equal to INVALID_ENTITY.
+static constexpr EntityIndex MAX_ENTITY_INDEX_COUNT = ENTITY_INDEX_MASK;
+
+constexpr EntityIndex GetEntityIndex(Entity entity) { return entity & ENTITY_INDEX_MASK; }
+constexpr EntityVersion GetEntityVersion(Entity entity) { return entity >> ENTITY_INDEX_BITS; }
+constexpr Entity MakeEntity(EntityIndex index, EntityVersion version) { return ((version & ENTITY_VERSION_MASK) << ENTITY_INDEX_BITS) | (index & ENTITY_INDEX_MASK); }
+
 }
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Entity.h"
+
+#include <cassert>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace engine
+{
+
+// EntityAllocator allocates generational entity handles for a World.
+// Destroyed indexes are pushed to a free list and reused with a bumped version.
+// Allocate/Free are thread safe. Allocate a batch at once to lock only once for thousands of entities.
+class EntityAllocator
+{
+public:
+	EntityAllocator() = default;
+	EntityAllocator(const EntityAllocator&) = delete;
+	EntityAllocator& operator=(const EntityAllocator&) = delete;
+	EntityAllocator(EntityAllocator&&) = delete;
+	EntityAllocator& operator=(EntityAllocator&&) = delete;
+	~EntityAllocator() = default;
+
+	Entity Allocate()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return AllocateUnlocked();
+	}
+
+	void Allocate(std::span<Entity> outEntities)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (outEntities.size() > m_freeIndexes.size())
+		{
+			m_versions.reserve(m_versions.size() + outEntities.size() - m_freeIndexes.size());
+		}
+
+		for (Entity& entity : outEntities)
+		{
+			entity = AllocateUnlocked();
+		}
+	}
+
+	// Returns false if the entity is already freed.
+	bool Free(Entity entity)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (!IsAlive(entity))
+		{
+			return false;
+		}
+
+		// Bump the version so that handles to the freed entity become stale.
+		EntityIndex index = GetEntityIndex(entity);
+		m_versions[index] = (m_versions[index] + 1) & ENTITY_VERSION_MASK;
+		m_freeIndexes.push_back(index);
+		return true;
+	}
+
+	// Checking is not synchronized with Allocate/Free from other threads.
+	bool IsAlive(Entity entity) const
+	{
+		EntityIndex index = GetEntityIndex(entity);
+		return entity != INVALID_ENTITY && index < m_versions.size() && m_versions[index] == GetEntityVersion(entity);
+	}
+
+	size_t GetAliveCount() const { return m_versions.size() - m_freeIndexes.size(); }
+	size_t GetFreeCount() const { return m_freeIndexes.size(); }
+
+	// Returns the count of indexes which were ever allocated. All sparse tables keyed by entity index are bounded by it.
+	size_t GetIndexCount() const { return m_versions.size(); }
+
+	// Allocator states to save or restore snapshots. They are not synchronized with Allocate/Free.
+	std::span<const EntityVersion> GetVersions() const { return m_versions; }
+	std::span<const EntityIndex> GetFreeIndexes() const { return m_freeIndexes; }
+
+	void Restore(std::span<const EntityVersion> versions, std::span<const EntityIndex> freeIndexes)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_versions.assign(versions.begin(), versions.end());
+		m_freeIndexes.assign(freeIndexes.begin(), freeIndexes.end());
+	}
+
+private:
+	Entity AllocateUnlocked()
+	{
+		// Reuse the most recently freed index as its sparse pages are still hot.
+		if (!m_freeIndexes.empty())
+		{
+			EntityIndex index = m_freeIndexes.back();
+			m_freeIndexes.pop_back();
+			return MakeEntity(index, m_versions[index]);
+		}
+
+		assert(m_versions.size() < MAX_ENTITY_INDEX_COUNT && "Overflow the max count of entities.");
+		EntityIndex index = static_cast<EntityIndex>(m_versions.size());
+		m_versions.push_back(0);
+		return MakeEntity(index, 0);
+	}
+
+private:
+	std::mutex m_mutex;
+
+	// Current version of every allocated index.
+	std::vector<EntityVersion> m_versions;
+	std::vector<EntityIndex> m_freeIndexes;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "ComponentsStorage.hpp"
+#include "ComponentTypeIndex.hpp"
+#include "Entity.h"
+#include "EntityAllocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace engine
+{
+
+// EntityCommandBuffer records structural changes to a World so that many threads can populate the world without locks.
+// Every thread or task should own one buffer. World::Flush applies all buffers at a sync point.
+// Entity handles are reserved from the World in batches so that they can be used right after CreateEntity.
+class EntityCommandBuffer
+{
+public:
+	// Entity handles reserved from the allocator at once.
+	static constexpr size_t EntityReserveCount = 256;
+
+	// Component payloads are placed in blocks which are never reallocated, so non-trivial components are safe to store.
+	static constexpr size_t PayloadBlockSize = 64 * 1024;
+
+	enum class CommandType : uint8_t
+	{
+		AddComponent,
+		RemoveComponent,
+		DestroyEntity,
+	};
+
+	struct Command
+	{
+		CommandType type;
+		Entity entity;
+		TypeIndex componentIndex;
+		void(*pApply)(IComponentsStorage* pStorage, Entity entity, void* pPayload);
+		void(*pDestroy)(void* pPayload);
+		void* pPayload;
+	};
+
+public:
+	EntityCommandBuffer() = delete;
+	explicit EntityCommandBuffer(EntityAllocator* pEntityAllocator) : m_pEntityAllocator(pEntityAllocator) {}
+	EntityCommandBuffer(const EntityCommandBuffer&) = delete;
+	EntityCommandBuffer& operator=(const EntityCommandBuffer&) = delete;
+	EntityCommandBuffer(EntityCommandBuffer&&) = default;
+	EntityCommandBuffer& operator=(EntityCommandBuffer&&) = default;
+	~EntityCommandBuffer()
+	{
+		Clear();
+		ReleaseReservedEntities();
+	}
+
+	bool IsEmpty() const { return m_commands.empty(); }
+	size_t GetCommandCount() const { return m_commands.size(); }
+	const std::vector<Command>& GetCommands() const { return m_commands; }
+
+	// The entity is alive immediately. Its components are created when the World is flushed.
+	Entity CreateEntity()
+	{
+		if (m_reservedEntities.empty())
+		{
+			m_reservedEntities.resize(EntityReserveCount);
+			m_pEntityAllocator->Allocate(m_reservedEntities);
+
+			// Hand out in the allocation order.
+			std::reverse(m_reservedEntities.begin(), m_reservedEntities.end());
+		}
+
+		Entity entity = m_reservedEntities.back();
+		m_reservedEntities.pop_back();
+		return entity;
+	}
+
+	// Returns the component which will be moved into the storage when the World is flushed.
+	template<typename Component>
+	Component& AddComponent(Entity entity)
+	{
+		Component* pComponent = new (AllocatePayload(sizeof(Component), alignof(Component))) Component();
+
+		Command& command = m_commands.emplace_back();
+		command.type = CommandType::AddComponent;
+		command.entity = entity;
+		command.componentIndex = GetComponentTypeIndex<Component>();
+		command.pApply = [](IComponentsStorage* pStorage, Entity entity, void* pPayload)
+		{
+			ComponentsStorage<Component>* pComponentsStorage = static_cast<ComponentsStorage<Component>*>(pStorage);
+			Component* pPayloadComponent = static_cast<Component*>(pPayload);
+			if (Component* pExistedComponent = pComponentsStorage->GetComponent(entity))
+			{
+				*pExistedComponent = std::move(*pPayloadComponent);
+			}
+			else
+			{
+				pComponentsStorage->CreateComponent(entity) = std::move(*pPayloadComponent);
+			}
+		};
+		command.pDestroy = [](void* pPayload) { static_cast<Component*>(pPayload)->~Component(); };
+		command.pPayload = pComponent;
+		return *pComponent;
+	}
+
+	template<typename Component>
+	void RemoveComponent(Entity entity)
+	{
+		Command& command = m_commands.emplace_back();
+		command.type = CommandType::RemoveComponent;
+		command.entity = entity;
+		command.componentIndex = GetComponentTypeIndex<Component>();
+		command.pApply = [](IComponentsStorage* pStorage, Entity entity, void*) { pStorage->RemoveComponent(entity); };
+		command.pDestroy = nullptr;
+		command.pPayload = nullptr;
+	}
+
+	void DestroyEntity(Entity entity)
+	{
+		Command& command = m_commands.emplace_back();
+		command.type = CommandType::DestroyEntity;
+		command.entity = entity;
+		command.componentIndex = 0;
+		command.pApply = nullptr;
+		command.pDestroy = nullptr;
+		command.pPayload = nullptr;
+	}
+
+	// Destroy pending payloads and drop all commands. Payload blocks are kept for reuse.
+	void Clear()
+	{
+		for (const Command& command : m_commands)
+		{
+			if (command.pDestroy)
+			{
+				command.pDestroy(command.pPayload);
+			}
+		}
+
+		m_commands.clear();
+		m_currentBlockIndex = 0;
+		m_currentBlockOffset = 0;
+	}
+
+	// Give unused reserved handles back to the allocator.
+	void ReleaseReservedEntities()
+	{
+		for (Entity entity : m_reservedEntities)
+		{
+			m_pEntityAllocator->Free(entity);
+		}
+		m_reservedEntities.clear();
+	}
+
+private:
+	void* AllocatePayload(size_t size, size_t alignment)
+	{
+		assert(alignment <= alignof(std::max_align_t));
+
+		// Oversized payloads get a dedicated block.
+		size_t blockSize = std::max(size, PayloadBlockSize);
+		while (true)
+		{
+			if (m_currentBlockIndex >= m_payloadBlocks.size())
+			{
+				m_payloadBlocks.emplace_back(std::make_unique<std::byte[]>(blockSize), blockSize);
+			}
+
+			auto& [pBlock, currentBlockSize] = m_payloadBlocks[m_currentBlockIndex];
+			size_t offset = (m_currentBlockOffset + alignment - 1) & ~(alignment - 1);
+			if (offset + size <= currentBlockSize)
+			{
+				m_currentBlockOffset = offset + size;
+				return pBlock.get() + offset;
+			}
+
+			++m_currentBlockIndex;
+			m_currentBlockOffset = 0;
+		}
+	}
+
+private:
+	EntityAllocator* m_pEntityAllocator;
+	std::vector<Entity> m_reservedEntities;
+
+	std::vector<Command> m_commands;
+	std::vector<std::pair<std::unique_ptr<std::byte[]>, size_t>> m_payloadBlocks;
+	size_t m_currentBlockIndex = 0;
+	size_t m_currentBlockOffset = 0;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "ComponentsStorage.hpp"
+#include "Entity.h"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+#include <vector>
+
+namespace engine
+{
+
+// HashMapComponentsStorage stores an array of Components in the same type and the entity which contains the component.
+// It indexes components by an unordered_map and marks removed slots as unused until CleanUnused.
+// ComponentsStorage replaced it in the World. Keep it here as the baseline to compare in the benchmarks.
+template<typename Component>
+class HashMapComponentsStorage : public IComponentsStorage
+{
+public:
+	static_assert(!std::is_pointer_v<Component> && !std::is_reference_v<Component>);
+
+public:
+	HashMapComponentsStorage() = default;
+	HashMapComponentsStorage(const HashMapComponentsStorage&) = delete;
+	HashMapComponentsStorage& operator=(const HashMapComponentsStorage&) = delete;
+	HashMapComponentsStorage(HashMapComponentsStorage&&) = default;
+	HashMapComponentsStorage& operator=(HashMapComponentsStorage&&) = default;
+	virtual ~HashMapComponentsStorage() = default;
+
+	// Returns if ComponentStorage stores component for entity.
+	bool Contains(Entity entity) const { return m_entityToIndex.contains(entity); }
+
+	// Returns current active components count.
+	size_t GetCount() const { return m_entityToIndex.size(); }
+
+	// Returns current components capcity.
+	size_t GetCapcity() const { assert(m_entities.size() == m_components.size()); return m_entities.size(); }
+
+	// Need to check if it is still active.
+	const std::vector<Entity>& GetEntities() const { return m_entities; }
+
+	// Get component by entity.
+	Component* GetComponent(Entity entity)
+	{
+		auto itIndex = m_entityToIndex.find(entity);
+		return itIndex == m_entityToIndex.end() ? nullptr : &m_components[itIndex->second];
+	}
+
+	// Create component for entity.
+	Component& CreateComponent(Entity entity)
+	{
+		assert(entity != INVALID_ENTITY && !Contains(entity));
+
+		// There was an entity/component removed so we can reuse it.
+		if (!m_unusedEntityIndexes.empty())
+		{
+			size_t reusedIndex = m_unusedEntityIndexes.back();
+			m_unusedEntityIndexes.pop_back();
+
+			m_entityToIndex[entity] = reusedIndex;
+			m_entities[reusedIndex] = entity;
+			return m_components[reusedIndex];
+		}
+
+		m_entityToIndex[entity] = m_components.size();
+		m_entities.emplace_back(entity);
+		m_components.emplace_back();
+		return m_components.back();
+	}
+
+	// Remove actvie component from storage.
+	void RemoveComponent(Entity entity) override
+	{
+		auto itIndex = m_entityToIndex.find(entity);
+		if (itIndex == m_entityToIndex.end())
+		{
+			return;
+		}
+
+		// We don't want to change the array immediately as it will cause memory copy/movement.
+		// Instead, we mark it as it unused which will be removed in the future.
+		if (!m_unusedEntityIndexes.empty() && itIndex->second < m_unusedEntityIndexes.back())
+		{
+			m_isUnusedSorted = false;
+		}
+		m_unusedEntityIndexes.push_back(itIndex->second);
+		m_entityToIndex.erase(entity);
+	}
+
+	// Change ticks are not tracked here.
+	void SetCurrentTick(ChangeTick) override {}
+
+	// Remove unused components.
+	void CleanUnused()
+	{
+		size_t budget = m_unusedEntityIndexes.size();
+		Compact(budget, false);
+	}
+
+	// Move active components from the back into the lowest unused slots, one slot per step.
+	// It doesn't support sorting by entity as slots are not in any order.
+	bool Compact(size_t& budget, bool) override
+	{
+		if (!m_isUnusedSorted)
+		{
+			// Sort in place so that there is no temporary container.
+			std::sort(m_unusedEntityIndexes.begin(), m_unusedEntityIndexes.end());
+			m_isUnusedSorted = true;
+		}
+
+		size_t filledCount = 0;
+		while (filledCount < m_unusedEntityIndexes.size() && budget > 0)
+		{
+			--budget;
+
+			size_t lastIndex = m_entities.size() - 1;
+			if (m_unusedEntityIndexes.back() == lastIndex)
+			{
+				// No need to swap. Already at the array back.
+				m_entities.pop_back();
+				m_components.pop_back();
+				m_unusedEntityIndexes.pop_back();
+				continue;
+			}
+
+			// The last slot is active as all unused indexes are less than it.
+			size_t unusedIndex = m_unusedEntityIndexes[filledCount++];
+			Entity entity = m_entities[lastIndex];
+			m_entities[unusedIndex] = entity;
+			m_components[unusedIndex] = std::move(m_components[lastIndex]);
+			m_entityToIndex[entity] = unusedIndex;
+
+			m_entities.pop_back();
+			m_components.pop_back();
+		}
+
+		m_unusedEntityIndexes.erase(m_unusedEntityIndexes.begin(), m_unusedEntityIndexes.begin() + filledCount);
+		return m_unusedEntityIndexes.empty();
+	}
+
+	ComponentsStorageStats GetStats() const override
+	{
+		ComponentsStorageStats stats;
+		stats.count = m_entityToIndex.size();
+		stats.capacity = m_components.capacity();
+		stats.holeCount = m_unusedEntityIndexes.size();
+		return stats;
+	}
+
+	// Snapshots are not supported.
+	bool GetColumns(ComponentsColumns& outColumns) const override
+	{
+		outColumns.componentName = Component::GetClassName().Value();
+		return false;
+	}
+
+	bool LoadColumns(const ComponentsColumns&) override { return false; }
+
+private:
+	std::vector<Entity> m_entities;
+	std::vector<Component> m_components;
+	std::unordered_map<Entity, size_t> m_entityToIndex;
+	std::vector<size_t> m_unusedEntityIndexes;
+	bool m_isUnusedSorted = true;
+};
+
+}
\ No newline at end of file
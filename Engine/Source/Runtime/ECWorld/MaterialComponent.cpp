@@ -8,6 +8,7 @@
 #include <bimg/decode.h>
 #include <bx/allocator.h>
 
+#include <algorithm>
 #include <cassert>
 #include <filesystem>
 
@@ -80,6 +81,11 @@ uint16_t MaterialComponent::GetShadingProgram() const
 	return m_pMaterialType->GetShaderSchema().GetCompiledProgram(m_uberShaderOption);
 }
 
+uint16_t MaterialComponent::GetInstanceShadingProgram() const
+{
+	return m_pMaterialType->GetShaderSchema().GetCompiledInstanceProgram(m_uberShaderOption);
+}
+
 void MaterialComponent::Reset()
 {
 	m_pMaterialData = nullptr;
@@ -87,6 +93,7 @@ void MaterialComponent::Reset()
 	m_textureTypeToFileBlob.clear();
 	m_uberShaderOption = ShaderSchema::DefaultUberOption;
 	m_textureResources.clear();
+	m_textureBindings.clear();
 }
 
 void MaterialComponent::AddTextureBlob(cd::MaterialTextureType textureType, cd::TextureFormat textureFormat, TextureBlob textureBlob, uint32_t width, uint32_t height, uint32_t depth /* = 1 */)
@@ -128,6 +135,8 @@ void MaterialComponent::AddTextureBlob(cd::MaterialTextureType textureType, cd::
 	std::string samplerUniformName = "s_textureSampler";
 	samplerUniformName += std::to_string(textureIndex++);
 	textureInfo.samplerHandle = bgfx::createUniform(samplerUniformName.c_str(), bgfx::UniformType::Sampler).idx;
+
+	UpdateTextureBindings();
 }
 
 void MaterialComponent::Build()
@@ -179,6 +188,27 @@ void MaterialComponent::Build()
 		samplerUniformName += std::to_string(textureIndex++);
 		textureInfo.samplerHandle = bgfx::createUniform(samplerUniformName.c_str(), bgfx::UniformType::Sampler).idx;
 	}
+
+	UpdateTextureBindings();
+}
+
+void MaterialComponent::UpdateTextureBindings()
+{
+	// Textures which share a slot overwrite the previous ones in the order of texture types.
+	m_textureBindings.clear();
+	for (const auto& [textureType, textureInfo] : m_textureResources)
+	{
+		auto itBinding = std::find_if(m_textureBindings.begin(), m_textureBindings.end(),
+			[&textureInfo](const TextureBinding& binding) { return binding.slot == textureInfo.slot; });
+		if (itBinding != m_textureBindings.end())
+		{
+			itBinding->samplerHandle = textureInfo.samplerHandle;
+			itBinding->textureHandle = textureInfo.textureHandle;
+			continue;
+		}
+
+		m_textureBindings.push_back(TextureBinding{ textureInfo.slot, textureInfo.samplerHandle, textureInfo.textureHandle });
+	}
 }
 
 }
\ No newline at end of file
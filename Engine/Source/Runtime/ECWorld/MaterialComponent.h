@@ -47,6 +47,14 @@ public:
 		cd::TextureFormat format;
 	};
 
+	// Raw handles of a texture binding which renderers set per draw without looking up texture resources.
+	struct TextureBinding
+	{
+		uint8_t slot;
+		uint16_t samplerHandle;
+		uint16_t textureHandle;
+	};
+
 public:
 	MaterialComponent() = default;
 	MaterialComponent(const MaterialComponent&) = default;
@@ -65,13 +73,20 @@ public:
 	void SetUberShaderOption(StringCrc uberOption);
 	StringCrc GetUberShaderOption() const;
 	uint16_t GetShadingProgram() const;
+	// Program which draws instances with the same uber option. It is invalid if the material type doesn't support instancing.
+	uint16_t GetInstanceShadingProgram() const;
 
 	std::optional<const TextureInfo> GetTextureInfo(cd::MaterialTextureType textureType) const;
 	const std::map<cd::MaterialTextureType, TextureInfo>& GetTextureResources() const { return m_textureResources; }
+	// One binding per texture slot. It is rebuilt when textures are added.
+	const std::vector<TextureBinding>& GetTextureBindings() const { return m_textureBindings; }
 
 	void Reset();
 	void Build();
 
+private:
+	void UpdateTextureBindings();
+
 private:
 	// Input
 	const cd::Material* m_pMaterialData = nullptr;
@@ -81,6 +96,7 @@ private:
 
 	// Output
 	std::map<cd::MaterialTextureType, TextureInfo> m_textureResources;
+	std::vector<TextureBinding> m_textureBindings;
 };
 
 }
\ No newline at end of file
@@ -11,20 +11,66 @@ SceneWorld::SceneWorld()
 	m_pSceneDatabase = std::make_unique<cd::SceneDatabase>();
 
 	m_pWorld = std::make_unique<engine::World>();
-	m_pAnimationStorage = m_pWorld->Register<engine::AnimationComponent>();
-	m_pCameraStorage = m_pWorld->Register<engine::CameraComponent>();
-	m_pCollisionMeshStorage = m_pWorld->Register<engine::CollisionMeshComponent>();
-	m_pHierarchyStorage = m_pWorld->Register<engine::HierarchyComponent>();
-	m_pLightStorage = m_pWorld->Register<engine::LightComponent>();
-	m_pMaterialStorage = m_pWorld->Register<engine::MaterialComponent>();
-	m_pNameStorage = m_pWorld->Register<engine::NameComponent>();
-	m_pSkyStorage = m_pWorld->Register<engine::SkyComponent>();
-	m_pStaticMeshStorage = m_pWorld->Register<engine::StaticMeshComponent>();
-	m_pTransformStorage = m_pWorld->Register<engine::TransformComponent>();
+	RegisterComponents(m_componentsStorages);
 
 	CreatePBRMaterialType();
 	CreateAnimationMaterialType();
 	CreateTerrainMaterialType();
+
+	CreateSystems();
+}
+
+void SceneWorld::CreateSystems()
+{
+	// Transform and camera matrices don't depend on each other so they can be built concurrently.
+	// World matrices are propagated from parents to children. Only subtrees under changed transforms are rebuilt.
+	m_pTransformHierarchy = std::make_unique<TransformHierarchy<TransformComponent>>();
+	m_pWorld->AddSystem("TransformSystem", Reads<HierarchyComponent>(), Writes<TransformComponent>(), [pHierarchy = m_pTransformHierarchy.get()](World& world, float deltaTime)
+	{
+		pHierarchy->Update(*world.GetComponents<TransformComponent>(), *world.GetComponents<HierarchyComponent>(), world.GetSystemThreadPool());
+	});
+
+	// World bounds of meshes follow changed meshes and transforms updated by TransformSystem, including moved descendants.
+	// Removed meshes leave the tree immediately. The tree is rebuilt when refitting makes it too loose.
+	m_pBoundingVolumeHierarchy = std::make_unique<BoundingVolumeHierarchy>();
+	GetComponentsStorage<StaticMeshComponent>()->OnComponentRemoved.Bind<BoundingVolumeHierarchy, &BoundingVolumeHierarchy::Remove>(m_pBoundingVolumeHierarchy.get());
+	m_pWorld->AddSystem("BoundsSystem", Reads<TransformComponent, StaticMeshComponent>(), Writes<>(),
+		[pHierarchy = m_pTransformHierarchy.get(), pBVH = m_pBoundingVolumeHierarchy.get(), lastUpdateTick = ChangeTick(0)](World& world, float deltaTime) mutable
+	{
+		ComponentsStorage<TransformComponent>* pTransformStorage = world.GetComponents<TransformComponent>();
+		ComponentsStorage<StaticMeshComponent>* pMeshStorage = world.GetComponents<StaticMeshComponent>();
+		auto updateBounds = [pBVH, pTransformStorage](Entity entity, const StaticMeshComponent& meshComponent)
+		{
+			const TransformComponent* pTransformComponent = pTransformStorage->GetComponent(entity);
+			pBVH->Update(entity, BoundingVolumeHierarchy::TransformAABB(meshComponent.GetAABB(),
+				pTransformComponent ? pTransformComponent->GetWorldMatrix() : cd::Matrix4x4::Identity()));
+		};
+
+		pMeshStorage->ForEachChanged(lastUpdateTick, updateBounds);
+		lastUpdateTick = pMeshStorage->GetCurrentTick();
+
+		for (TransformHierarchy<TransformComponent>::NodeIndex nodeIndex : pHierarchy->GetUpdatedNodes())
+		{
+			Entity entity = pHierarchy->GetNodeEntity(nodeIndex);
+			if (const StaticMeshComponent* pMeshComponent = pMeshStorage->GetComponent(entity))
+			{
+				updateBounds(entity, *pMeshComponent);
+			}
+		}
+
+		if (pBVH->NeedsRebuild())
+		{
+			pBVH->Rebuild();
+		}
+	});
+
+	m_pWorld->AddSystem("CameraSystem", Reads<>(), Writes<CameraComponent>(), [](World& world, float deltaTime)
+	{
+		for (CameraComponent& cameraComponent : world.GetComponents<CameraComponent>()->GetComponents())
+		{
+			cameraComponent.Build();
+		}
+	});
 }
 
 void SceneWorld::CreatePBRMaterialType()
@@ -39,6 +85,8 @@ void SceneWorld::CreatePBRMaterialType()
 	shaderSchema.RegisterUberOption(Uber::ROUGHNESS);
 	shaderSchema.RegisterUberOption(Uber::METALLIC);
 	shaderSchema.RegisterUberOption(Uber::IBL);
+	// Meshes which share the same mesh and material are drawn in one instanced draw call.
+	shaderSchema.SetInstanceVertexShaderPath(Path::GetBuiltinShaderInputPath("vs_PBR_instance"));
 	// Technically, option LoadingStatus:: is an actual shader.
 	// We can use AddSingleUberOption to add it to shaderSchema,
 	// whithout combine with any other option.
@@ -53,7 +101,9 @@ void SceneWorld::CreatePBRMaterialType()
 	pbrVertexFormat.AddAttributeLayout(cd::VertexAttributeType::Normal, cd::GetAttributeValueType<cd::Direction::ValueType>(), cd::Direction::Size);
 	pbrVertexFormat.AddAttributeLayout(cd::VertexAttributeType::Tangent, cd::GetAttributeValueType<cd::Direction::ValueType>(), cd::Direction::Size);
 	pbrVertexFormat.AddAttributeLayout(cd::VertexAttributeType::UV, cd::GetAttributeValueType<cd::UV::ValueType>(), cd::UV::Size);
-	m_pPBRMaterialType->SetRequiredVertexFormat(cd::MoveTemp(pbrVertexFormat));
+	// vs_PBR and vs_PBR_instance decode packed attributes, so compression flags need to match them.
+	m_pPBRMaterialType->SetRequiredVertexFormat(cd::MoveTemp(pbrVertexFormat),
+		VertexCompression::Position | VertexCompression::NormalTangent | VertexCompression::UV);
 
 	// Slot index should align to shader codes.
 	// We want basic PBR materials to be flexible.
@@ -78,7 +128,7 @@ void SceneWorld::CreateAnimationMaterialType()
 	//animationVertexFormat.AddAttributeLayout(cd::VertexAttributeType::Normal, cd::GetAttributeValueType<cd::Direction::ValueType>(), cd::Direction::Size);
 	animationVertexFormat.AddAttributeLayout(cd::VertexAttributeType::BoneIndex, cd::AttributeValueType::Int16, 4U);
 	animationVertexFormat.AddAttributeLayout(cd::VertexAttributeType::BoneWeight, cd::AttributeValueType::Float, 4U);
-	m_pAnimationMaterialType->SetRequiredVertexFormat(cd::MoveTemp(animationVertexFormat));
+	m_pAnimationMaterialType->SetRequiredVertexFormat(cd::MoveTemp(animationVertexFormat), VertexCompression::Position | VertexCompression::BoneWeight);
 }
 
 void SceneWorld::CreateTerrainMaterialType()
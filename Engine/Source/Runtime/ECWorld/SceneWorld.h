@@ -1,18 +1,30 @@
 #pragma once
 
+#include "ECWorld/BoundingVolumeHierarchy.hpp"
+#include "ECWorld/TransformHierarchy.hpp"
 #include "ECWorld/World.h"
 #include "Log/Log.h"
 #include "Material/MaterialType.h"
 #include "Scene/SceneDatabase.h"
 
 #include <memory>
+#include <tuple>
 #include <vector>
 
+// Generate Get/Delete APIs of a component type which SceneWorld registers, such as GetTransformComponent.
+#define DEFINE_SCENE_COMPONENT_APIS(apiName) \
+	CD_FORCEINLINE engine::apiName##Component* Get##apiName##Component(engine::Entity entity) const { return GetComponent<engine::apiName##Component>(entity); } \
+	CD_FORCEINLINE const std::vector<engine::Entity>& Get##apiName##Entities() const { return GetEntities<engine::apiName##Component>(); } \
+	CD_FORCEINLINE void Delete##apiName##Component(engine::Entity entity) { DeleteComponent<engine::apiName##Component>(entity); }
+
 namespace engine
 {
 
 class MaterialType;
 
+template<typename... Components>
+using SceneComponentsStorages = std::tuple<engine::ComponentsStorage<Components>*...>;
+
 class SceneWorld
 {
 public:
@@ -44,29 +56,52 @@ public:
 	void CreateTerrainMaterialType();
 	CD_FORCEINLINE engine::MaterialType* GetTerrainMaterialType() const { return m_pTerrainMaterialType.get(); }
 
-	// It can save performance on addressing the actual ComponentStorage.
-	// TODO : write a help macro ? Though I hate macro...
-	CD_FORCEINLINE engine::AnimationComponent* GetAnimationComponent(engine::Entity entity) const { return m_pAnimationStorage->GetComponent(entity); }
-	CD_FORCEINLINE engine::CameraComponent* GetCameraComponent(engine::Entity entity) const { return m_pCameraStorage->GetComponent(entity); }
-	CD_FORCEINLINE engine::CollisionMeshComponent* GetCollisionMeshComponent(engine::Entity entity) const { return m_pCollisionMeshStorage->GetComponent(entity); }
-	CD_FORCEINLINE engine::HierarchyComponent* GetHierarchyComponent(engine::Entity entity) const { return m_pHierarchyStorage->GetComponent(entity); }
-	CD_FORCEINLINE engine::LightComponent* GetLightComponent(engine::Entity entity) const { return m_pLightStorage->GetComponent(entity); }
-	CD_FORCEINLINE engine::MaterialComponent* GetMaterialComponent(engine::Entity entity) const { return m_pMaterialStorage->GetComponent(entity); }
-	CD_FORCEINLINE engine::NameComponent* GetNameComponent(engine::Entity entity) const { return m_pNameStorage->GetComponent(entity); }
-	CD_FORCEINLINE engine::SkyComponent* GetSkyComponent(engine::Entity entity) const { return m_pSkyStorage->GetComponent(entity); }
-	CD_FORCEINLINE engine::StaticMeshComponent* GetStaticMeshComponent(engine::Entity entity) const { return m_pStaticMeshStorage->GetComponent(entity); }
-	CD_FORCEINLINE engine::TransformComponent* GetTransformComponent(engine::Entity entity) const { return m_pTransformStorage->GetComponent(entity); }
-
-	CD_FORCEINLINE const std::vector<engine::Entity>& GetAnimationEntities() const { return m_pAnimationStorage->GetEntities(); }
-	CD_FORCEINLINE const std::vector<engine::Entity>& GetCameraEntities() const { return m_pCameraStorage->GetEntities(); }
-	CD_FORCEINLINE const std::vector<engine::Entity>& GetCollisionMeshEntities() const { return m_pCollisionMeshStorage->GetEntities(); }
-	CD_FORCEINLINE const std::vector<engine::Entity>& GetHierarchyEntities() const { return m_pHierarchyStorage->GetEntities(); }
-	CD_FORCEINLINE const std::vector<engine::Entity>& GetLightEntities() const { return m_pLightStorage->GetEntities(); }
-	CD_FORCEINLINE const std::vector<engine::Entity>& GetMaterialEntities() const { return m_pMaterialStorage->GetEntities(); }
-	CD_FORCEINLINE const std::vector<engine::Entity>& GetNameEntities() const { return m_pNameStorage->GetEntities(); }
-	CD_FORCEINLINE const std::vector<engine::Entity>& GetSkyEntities() const { return m_pSkyStorage->GetEntities(); }
-	CD_FORCEINLINE const std::vector<engine::Entity>& GetStaticMeshEntities() const { return m_pStaticMeshStorage->GetEntities(); }
-	CD_FORCEINLINE const std::vector<engine::Entity>& GetTransformEntities() const { return m_pTransformStorage->GetEntities(); }
+	// Terrain vertex shaders replace heights of flat terrain meshes by the elevation map whose values are in this range.
+	void SetTerrainElevationRange(float minElevation, float maxElevation) { m_terrainMinElevation = minElevation; m_terrainMaxElevation = maxElevation; }
+	CD_FORCEINLINE float GetTerrainMinElevation() const { return m_terrainMinElevation; }
+	CD_FORCEINLINE float GetTerrainMaxElevation() const { return m_terrainMaxElevation; }
+
+	// Per-frame systems which are scheduled by World::UpdateSystems.
+	void CreateSystems();
+
+	// World bounds of static meshes which BoundsSystem keeps up to date. Use it for picking, culling and range queries.
+	CD_FORCEINLINE const engine::BoundingVolumeHierarchy* GetBoundingVolumeHierarchy() const { return m_pBoundingVolumeHierarchy.get(); }
+
+	// Access components through storages cached in a tuple, which is resolved at compile time.
+	template<typename Component>
+	CD_FORCEINLINE engine::ComponentsStorage<Component>* GetComponentsStorage() const { return std::get<engine::ComponentsStorage<Component>*>(m_componentsStorages); }
+
+	template<typename Component>
+	CD_FORCEINLINE Component* GetComponent(engine::Entity entity) const { return GetComponentsStorage<Component>()->GetComponent(entity); }
+
+	template<typename Component>
+	CD_FORCEINLINE const std::vector<engine::Entity>& GetEntities() const { return GetComponentsStorage<Component>()->GetEntities(); }
+
+	template<typename Component>
+	CD_FORCEINLINE void DeleteComponent(engine::Entity entity) { GetComponentsStorage<Component>()->RemoveComponent(entity); }
+
+	// Notify change queries after modifying the component in place.
+	template<typename Component>
+	CD_FORCEINLINE void MarkComponentChanged(engine::Entity entity) { GetComponentsStorage<Component>()->MarkChanged(entity); }
+
+	DEFINE_SCENE_COMPONENT_APIS(Animation);
+	DEFINE_SCENE_COMPONENT_APIS(Camera);
+	DEFINE_SCENE_COMPONENT_APIS(CollisionMesh);
+	DEFINE_SCENE_COMPONENT_APIS(Hierarchy);
+	DEFINE_SCENE_COMPONENT_APIS(Light);
+	DEFINE_SCENE_COMPONENT_APIS(Material);
+	DEFINE_SCENE_COMPONENT_APIS(Name);
+	DEFINE_SCENE_COMPONENT_APIS(Sky);
+	DEFINE_SCENE_COMPONENT_APIS(StaticMesh);
+	DEFINE_SCENE_COMPONENT_APIS(Transform);
+
+	// Local transforms are relative to the world matrix of the parent. Entities without parent transforms are in world space.
+	cd::Matrix4x4 GetParentWorldMatrix(engine::Entity entity) const
+	{
+		const engine::HierarchyComponent* pHierarchyComponent = GetHierarchyComponent(entity);
+		const engine::TransformComponent* pParentTransformComponent = pHierarchyComponent ? GetTransformComponent(pHierarchyComponent->GetParentEntity()) : nullptr;
+		return pParentTransformComponent ? pParentTransformComponent->GetWorldMatrix() : cd::Matrix4x4::Identity();
+	}
 
 	void DeleteEntity(engine::Entity entity)
 	{
@@ -81,28 +116,17 @@ public:
 			m_selectedEntity = engine::INVALID_ENTITY;
 		}
 
-		DeleteAnimationComponent(entity);
-		DeleteCameraComponent(entity);
-		DeleteCollisionMeshComponent(entity);
-		DeleteHierarchyComponent(entity);
-		DeleteLightComponent(entity);
-		DeleteMaterialComponent(entity);
-		DeleteNameComponent(entity);
-		DeleteSkyComponent(entity);
-		DeleteStaticMeshComponent(entity);
-		DeleteTransformComponent(entity);
+		// Remove all components and recycle the entity index.
+		m_pWorld->DestroyEntity(entity);
 	}
 
-	CD_FORCEINLINE void DeleteAnimationComponent(engine::Entity entity) { m_pAnimationStorage->RemoveComponent(entity); }
-	CD_FORCEINLINE void DeleteCameraComponent(engine::Entity entity) { m_pCameraStorage->RemoveComponent(entity); }
-	CD_FORCEINLINE void DeleteCollisionMeshComponent(engine::Entity entity) { m_pCollisionMeshStorage->RemoveComponent(entity); }
-	CD_FORCEINLINE void DeleteHierarchyComponent(engine::Entity entity) { m_pHierarchyStorage->RemoveComponent(entity); }
-	CD_FORCEINLINE void DeleteLightComponent(engine::Entity entity) { m_pLightStorage->RemoveComponent(entity); }
-	CD_FORCEINLINE void DeleteMaterialComponent(engine::Entity entity) { m_pMaterialStorage->RemoveComponent(entity); }
-	CD_FORCEINLINE void DeleteNameComponent(engine::Entity entity) { m_pNameStorage->RemoveComponent(entity); }
-	CD_FORCEINLINE void DeleteSkyComponent(engine::Entity entity) { m_pSkyStorage->RemoveComponent(entity); }
-	CD_FORCEINLINE void DeleteStaticMeshComponent(engine::Entity entity) { m_pStaticMeshStorage->RemoveComponent(entity); }
-	CD_FORCEINLINE void DeleteTransformComponent(engine::Entity entity) { m_pTransformStorage->RemoveComponent(entity); }
+private:
+	// Register storages of all component types in the tuple to the World.
+	template<typename... Components>
+	void RegisterComponents(SceneComponentsStorages<Components...>& componentsStorages)
+	{
+		((std::get<engine::ComponentsStorage<Components>*>(componentsStorages) = m_pWorld->Register<Components>()), ...);
+	}
 
 private:
 	std::unique_ptr<cd::SceneDatabase> m_pSceneDatabase;
@@ -111,17 +135,25 @@ private:
 	std::unique_ptr<engine::MaterialType> m_pPBRMaterialType;
 	std::unique_ptr<engine::MaterialType> m_pAnimationMaterialType;
 	std::unique_ptr<engine::MaterialType> m_pTerrainMaterialType;
-
-	engine::ComponentsStorage<engine::AnimationComponent>* m_pAnimationStorage;
-	engine::ComponentsStorage<engine::CameraComponent>* m_pCameraStorage;
-	engine::ComponentsStorage<engine::CollisionMeshComponent>* m_pCollisionMeshStorage;
-	engine::ComponentsStorage<engine::HierarchyComponent>* m_pHierarchyStorage;
-	engine::ComponentsStorage<engine::LightComponent>* m_pLightStorage;
-	engine::ComponentsStorage<engine::MaterialComponent>* m_pMaterialStorage;
-	engine::ComponentsStorage<engine::NameComponent>* m_pNameStorage;
-	engine::ComponentsStorage<engine::SkyComponent>* m_pSkyStorage;
-	engine::ComponentsStorage<engine::StaticMeshComponent>* m_pStaticMeshStorage;
-	engine::ComponentsStorage<engine::TransformComponent>* m_pTransformStorage;
+	float m_terrainMinElevation = 0.0f;
+	float m_terrainMaxElevation = 0.0f;
+
+	// Systems access them by pointers which stay valid if SceneWorld moves.
+	std::unique_ptr<engine::TransformHierarchy<engine::TransformComponent>> m_pTransformHierarchy;
+	std::unique_ptr<engine::BoundingVolumeHierarchy> m_pBoundingVolumeHierarchy;
+
+	// Component types registered by SceneWorld. Add a new type here and generate its APIs by DEFINE_SCENE_COMPONENT_APIS.
+	SceneComponentsStorages<
+		engine::AnimationComponent,
+		engine::CameraComponent,
+		engine::CollisionMeshComponent,
+		engine::HierarchyComponent,
+		engine::LightComponent,
+		engine::MaterialComponent,
+		engine::NameComponent,
+		engine::SkyComponent,
+		engine::StaticMeshComponent,
+		engine::TransformComponent> m_componentsStorages;
 
 	// TODO : wrap them into another class?
 	engine::Entity m_selectedEntity = engine::INVALID_ENTITY;
@@ -0,0 +1,305 @@
+#pragma once
+
+#include "Entity.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace engine
+{
+
+// SparseEntitySet stores a packed array of entities and a paged sparse table which maps entity index to its dense index.
+// Add/Remove/Contains are O(1) and removal swaps the last entity into the hole so entities keep packed.
+// The dense array stores full handles so that a stale handle with an old version is not contained.
+// Swap removal shuffles the dense order over time. SortStep restores the order of entity indices incrementally.
+class SparseEntitySet
+{
+public:
+	using DenseIndex = uint32_t;
+	static constexpr DenseIndex INVALID_DENSE_INDEX = static_cast<DenseIndex>(-1);
+
+	// Entity index count mapped by one sparse page. Pages are allocated on demand
+	// so that the sparse table only grows with the entity index ranges really in use.
+	static constexpr uint32_t SparsePageSize = 4096;
+
+public:
+	SparseEntitySet() = default;
+	SparseEntitySet(const SparseEntitySet&) = delete;
+	SparseEntitySet& operator=(const SparseEntitySet&) = delete;
+	SparseEntitySet(SparseEntitySet&&) = default;
+	SparseEntitySet& operator=(SparseEntitySet&&) = default;
+	~SparseEntitySet() = default;
+
+	bool Contains(Entity entity) const { return INVALID_DENSE_INDEX != GetDenseIndex(entity); }
+	bool IsEmpty() const { return m_entities.empty(); }
+	size_t GetCount() const { return m_entities.size(); }
+	const std::vector<Entity>& GetEntities() const { return m_entities; }
+
+	// Returns sparse pages count which are allocated now.
+	size_t GetSparsePageCount() const
+	{
+		return std::count_if(m_sparsePages.begin(), m_sparsePages.end(), [](const auto& pSparsePage) { return pSparsePage != nullptr; });
+	}
+
+	// Returns sparse pages count which are allocated but don't map any entity.
+	size_t GetEmptySparsePageCount() const
+	{
+		size_t emptyPageCount = 0;
+		for (size_t pageIndex = 0; pageIndex < m_sparsePages.size(); ++pageIndex)
+		{
+			if (m_sparsePages[pageIndex] && 0 == m_sparsePageCounts[pageIndex])
+			{
+				++emptyPageCount;
+			}
+		}
+		return emptyPageCount;
+	}
+
+	// Returns true if dense entities are in the order of entity indices.
+	bool IsSorted() const { return m_isSorted; }
+
+	// Entities which were moved out of the order of entity indices since the set was sorted. An entity may be counted more than once.
+	size_t GetUnsortedCount() const { return m_unsortedCount; }
+
+	DenseIndex GetDenseIndex(Entity entity) const
+	{
+		EntityIndex entityIndex = GetEntityIndex(entity);
+		size_t pageIndex = entityIndex / SparsePageSize;
+		if (pageIndex >= m_sparsePages.size() || !m_sparsePages[pageIndex])
+		{
+			return INVALID_DENSE_INDEX;
+		}
+
+		DenseIndex denseIndex = m_sparsePages[pageIndex][entityIndex % SparsePageSize];
+		return INVALID_DENSE_INDEX != denseIndex && m_entities[denseIndex] == entity ? denseIndex : INVALID_DENSE_INDEX;
+	}
+
+	// Returns the dense index of added entity which is always the back.
+	DenseIndex Add(Entity entity)
+	{
+		assert(entity != INVALID_ENTITY && !Contains(entity));
+		assert(m_entities.size() < INVALID_DENSE_INDEX && "Overflow the max count of entities.");
+
+		DenseIndex denseIndex = static_cast<DenseIndex>(m_entities.size());
+		if (!m_entities.empty() && GetEntityIndex(entity) < GetEntityIndex(m_entities.back()))
+		{
+			m_isSorted = false;
+			++m_unsortedCount;
+		}
+
+		// The sorting pass has walked past this entity index so it needs another pass.
+		if (GetEntityIndex(entity) < m_sortEntityIndex)
+		{
+			m_isSortPassDirty = true;
+		}
+
+		SetDenseIndex(entity, denseIndex);
+		m_entities.emplace_back(entity);
+		return denseIndex;
+	}
+
+	// Returns the dense index where the entity was. The last entity is moved to there.
+	// Callers who store data parallel to entities should do the same swap-and-pop.
+	DenseIndex Remove(Entity entity)
+	{
+		DenseIndex removedIndex = GetDenseIndex(entity);
+		if (INVALID_DENSE_INDEX == removedIndex)
+		{
+			return INVALID_DENSE_INDEX;
+		}
+
+		DenseIndex lastIndex = static_cast<DenseIndex>(m_entities.size() - 1);
+		if (removedIndex != lastIndex)
+		{
+			Entity lastEntity = m_entities[lastIndex];
+			m_entities[removedIndex] = lastEntity;
+			SetDenseIndex(lastEntity, removedIndex);
+			m_isSorted = false;
+			++m_unsortedCount;
+
+			// The sorted prefix is broken so the sorting pass starts over.
+			if (removedIndex < m_sortDenseIndex)
+			{
+				ResetSortPass();
+			}
+		}
+		else if (removedIndex < m_sortDenseIndex)
+		{
+			// Popped from the sorted prefix which keeps sorted.
+			m_sortDenseIndex = removedIndex;
+		}
+
+		SetDenseIndex(entity, INVALID_DENSE_INDEX);
+		m_entities.pop_back();
+		return removedIndex;
+	}
+
+	void Reserve(size_t count) { m_entities.reserve(count); }
+
+	// Swap two dense entities. Callers who store data parallel to entities should do the same swap.
+	void Swap(DenseIndex lhs, DenseIndex rhs)
+	{
+		Entity lhsEntity = m_entities[lhs];
+		Entity rhsEntity = m_entities[rhs];
+		m_entities[lhs] = rhsEntity;
+		m_entities[rhs] = lhsEntity;
+		SetDenseIndex(lhsEntity, rhs);
+		SetDenseIndex(rhsEntity, lhs);
+		m_isSorted = false;
+	}
+
+	void Clear()
+	{
+		m_entities.clear();
+		m_sparsePages.clear();
+		m_sparsePageCounts.clear();
+		m_isSorted = true;
+		m_unsortedCount = 0;
+		ResetSortPass();
+	}
+
+	// Release sparse pages which don't map any entity and the spare memory of the dense array.
+	void CleanUnused()
+	{
+		size_t budget = m_sparsePages.size();
+		ReleaseEmptySparsePages(budget);
+		m_entities.shrink_to_fit();
+	}
+
+	// Release empty sparse pages by visiting at most budget pages. The budget is consumed.
+	// Returns true when all pages are visited. It doesn't allocate memory.
+	bool ReleaseEmptySparsePages(size_t& budget)
+	{
+		while (m_releasePageIndex < m_sparsePages.size())
+		{
+			if (0 == budget)
+			{
+				return false;
+			}
+
+			if (m_sparsePages[m_releasePageIndex] && 0 == m_sparsePageCounts[m_releasePageIndex])
+			{
+				m_sparsePages[m_releasePageIndex].reset();
+			}
+			++m_releasePageIndex;
+			--budget;
+		}
+
+		while (!m_sparsePages.empty() && !m_sparsePages.back())
+		{
+			m_sparsePages.pop_back();
+			m_sparsePageCounts.pop_back();
+		}
+		m_releasePageIndex = 0;
+
+		return true;
+	}
+
+	// Move entities toward the order of entity indices by visiting at most budget sparse slots. The budget is consumed.
+	// swapFunc(DenseIndex, DenseIndex) is called before every swap so that parallel arrays can follow.
+	// Returns true when dense entities are sorted. The progress is kept so a large set can be sorted over many frames.
+	template<typename SwapFunc>
+	bool SortStep(size_t& budget, SwapFunc&& swapFunc)
+	{
+		while (!m_isSorted && budget > 0)
+		{
+			size_t pageIndex = m_sortEntityIndex / SparsePageSize;
+			if (pageIndex >= m_sparsePages.size())
+			{
+				// A pass is finished. It is sorted unless entities were added behind the pass.
+				m_isSorted = !m_isSortPassDirty;
+				if (m_isSorted)
+				{
+					m_unsortedCount = 0;
+				}
+				ResetSortPass();
+				break;
+			}
+
+			--budget;
+			if (!m_sparsePages[pageIndex])
+			{
+				m_sortEntityIndex = static_cast<EntityIndex>((pageIndex + 1) * SparsePageSize);
+				continue;
+			}
+
+			DenseIndex denseIndex = m_sparsePages[pageIndex][m_sortEntityIndex % SparsePageSize];
+			++m_sortEntityIndex;
+			if (INVALID_DENSE_INDEX == denseIndex)
+			{
+				continue;
+			}
+
+			assert(denseIndex >= m_sortDenseIndex);
+			if (denseIndex != m_sortDenseIndex)
+			{
+				swapFunc(m_sortDenseIndex, denseIndex);
+				Swap(m_sortDenseIndex, denseIndex);
+			}
+			++m_sortDenseIndex;
+		}
+
+		return m_isSorted;
+	}
+
+private:
+	void ResetSortPass()
+	{
+		m_sortEntityIndex = 0;
+		m_sortDenseIndex = 0;
+		m_isSortPassDirty = false;
+	}
+
+	void SetDenseIndex(Entity entity, DenseIndex denseIndex)
+	{
+		EntityIndex entityIndex = GetEntityIndex(entity);
+		size_t pageIndex = entityIndex / SparsePageSize;
+		if (pageIndex >= m_sparsePages.size())
+		{
+			m_sparsePages.resize(pageIndex + 1);
+			m_sparsePageCounts.resize(pageIndex + 1, 0);
+		}
+
+		std::unique_ptr<DenseIndex[]>& pSparsePage = m_sparsePages[pageIndex];
+		if (!pSparsePage)
+		{
+			if (INVALID_DENSE_INDEX == denseIndex)
+			{
+				return;
+			}
+
+			pSparsePage = std::make_unique<DenseIndex[]>(SparsePageSize);
+			std::fill(pSparsePage.get(), pSparsePage.get() + SparsePageSize, INVALID_DENSE_INDEX);
+		}
+
+		// Count mapped entities per page so that empty pages are found without scanning them.
+		DenseIndex& sparseIndex = pSparsePage[entityIndex % SparsePageSize];
+		if (INVALID_DENSE_INDEX == sparseIndex && INVALID_DENSE_INDEX != denseIndex)
+		{
+			++m_sparsePageCounts[pageIndex];
+		}
+		else if (INVALID_DENSE_INDEX != sparseIndex && INVALID_DENSE_INDEX == denseIndex)
+		{
+			--m_sparsePageCounts[pageIndex];
+		}
+		sparseIndex = denseIndex;
+	}
+
+private:
+	std::vector<Entity> m_entities;
+	std::vector<std::unique_ptr<DenseIndex[]>> m_sparsePages;
+	std::vector<uint32_t> m_sparsePageCounts;
+
+	// Progress of incremental work.
+	size_t m_releasePageIndex = 0;
+	EntityIndex m_sortEntityIndex = 0;
+	DenseIndex m_sortDenseIndex = 0;
+	bool m_isSortPassDirty = false;
+	bool m_isSorted = true;
+	size_t m_unsortedCount = 0;
+};
+
+}
\ No newline at end of file
@@ -3,11 +3,14 @@
 #include "ECWorld/World.h"
 #include "Log/Log.h"
 #include "Math/MeshGenerator.h"
+#include "Rendering/MeshOptimizer.hpp"
 #include "Rendering/Utility/VertexLayoutUtility.h"
 #include "Scene/VertexFormat.h"
 
 #include <bgfx/bgfx.h>
 
+#include <algorithm>
+#include <array>
 #include <optional>
 
 namespace engine
@@ -23,6 +26,8 @@ void StaticMeshComponent::Reset()
 
 	m_indexBuffer.clear();
 	m_indexBufferHandle = UINT16_MAX;
+	m_lods.clear();
+	m_positionDequantization = { cd::Vec4f(0.0f, 0.0f, 0.0f, 0.0f), cd::Vec4f(1.0f, 1.0f, 1.0f, 0.0f) };
 
 	// Debug
 	m_aabb.Clear();
@@ -101,10 +106,61 @@ void StaticMeshComponent::Build()
 	const bool containsBoneIndex = m_pRequiredVertexFormat->Contains(cd::VertexAttributeType::BoneIndex);
 	const bool containsBoneWeight = m_pRequiredVertexFormat->Contains(cd::VertexAttributeType::BoneWeight);
 
-	const uint32_t vertexCount = m_pMeshData->GetVertexCount();
+	// Indexes of simplified LODs follow the full mesh in the same buffer.
+	// Skinned meshes are drawn by AnimationRenderer which doesn't select LODs.
+	MeshLODBuilder::Settings lodSettings = m_lodSettings;
+	if (containsBoneIndex)
+	{
+		lodSettings.lodCount = 0;
+	}
+	const uint32_t meshVertexCount = m_pMeshData->GetVertexCount();
+	const cd::Point* pPositions = m_pMeshData->GetVertexPositions().data();
+	MeshLODBuilder lodBuilder(lodSettings);
+	lodBuilder.Build(pPositions, meshVertexCount, reinterpret_cast<const uint32_t*>(m_pMeshData->GetPolygons().data()),
+		static_cast<uint32_t>(m_pMeshData->GetPolygonCount() * cd::Polygon::Size));
+	m_lods = lodBuilder.GetLODs();
+
+	// Optimize triangle orders of every LOD for the vertex cache and overdraw,
+	// then renumber vertexes by their first use so that vertex fetches are sequential. Unused vertexes are dropped.
+	std::vector<uint32_t> indices = lodBuilder.GetIndices();
+	const uint32_t fullIndexCount = m_lods.front().indexCount;
+	const VertexCacheStats importedCacheStats = MeshOptimizer::AnalyzeVertexCache(indices.data(), fullIndexCount, meshVertexCount);
+	for (const MeshLOD& lod : m_lods)
+	{
+		std::vector<uint32_t> hardBoundaries;
+		MeshOptimizer::OptimizeVertexCache(&indices[lod.indexOffset], lod.indexCount, meshVertexCount, &hardBoundaries);
+		MeshOptimizer::OptimizeOverdraw(&indices[lod.indexOffset], lod.indexCount, pPositions, meshVertexCount, hardBoundaries);
+	}
+	const VertexCacheStats optimizedCacheStats = MeshOptimizer::AnalyzeVertexCache(indices.data(), fullIndexCount, meshVertexCount);
+	const std::vector<uint32_t> vertexOrder = MeshOptimizer::OptimizeVertexFetch(indices.data(), static_cast<uint32_t>(indices.size()), meshVertexCount);
+
+	// Packed attributes change the stride, so the layout is created before filling the vertex buffer.
+	// Shaders read half UVs as floats, so they fall back to floats if the device doesn't support them.
+	VertexCompression vertexCompression = m_vertexCompression;
+	if (HasVertexCompression(vertexCompression, VertexCompression::UV) && !(bgfx::getCaps()->supported & BGFX_CAPS_VERTEX_ATTRIB_HALF))
+	{
+		vertexCompression = vertexCompression & ~VertexCompression::UV;
+	}
+	const bool compressPosition = HasVertexCompression(vertexCompression, VertexCompression::Position);
+	const bool compressNormalTangent = HasVertexCompression(vertexCompression, VertexCompression::NormalTangent);
+	const bool compressUV = HasVertexCompression(vertexCompression, VertexCompression::UV);
+	const bool compressBoneWeight = HasVertexCompression(vertexCompression, VertexCompression::BoneWeight);
+
+	bgfx::VertexLayout vertexLayout;
+	VertexLayoutUtility::CreateVertexLayout(vertexLayout, m_pRequiredVertexFormat->GetVertexLayout(), vertexCompression);
+
+	PositionQuantization positionQuantization;
+	if (compressPosition)
+	{
+		positionQuantization = VertexQuantizer::MakePositionQuantization(pPositions, meshVertexCount);
+	}
+	m_positionDequantization[0] = cd::Vec4f(positionQuantization.offset.x(), positionQuantization.offset.y(), positionQuantization.offset.z(), 0.0f);
+	m_positionDequantization[1] = cd::Vec4f(positionQuantization.scale.x(), positionQuantization.scale.y(), positionQuantization.scale.z(), 0.0f);
+
+	const uint32_t vertexCount = static_cast<uint32_t>(vertexOrder.size());
 	const uint32_t vertexFormatStride = m_pRequiredVertexFormat->GetStride();
 
-	m_vertexBuffer.resize(vertexCount * vertexFormatStride);
+	m_vertexBuffer.resize(vertexCount * vertexLayout.getStride());
 
 	uint32_t currentDataSize = 0U;
 	auto currentDataPtr = m_vertexBuffer.data();
@@ -115,21 +171,33 @@ void StaticMeshComponent::Build()
 		currentDataSize += dataSize;
 	};
 
-	for (uint32_t vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex)
+	for (uint32_t vertexIndex : vertexOrder)
 	{
-		if (containsPosition)
+		if (containsPosition && compressPosition)
+		{
+			std::array<int16_t, 4> position = VertexQuantizer::QuantizePosition(m_pMeshData->GetVertexPosition(vertexIndex), positionQuantization);
+			FillVertexBuffer(position.data(), static_cast<uint32_t>(sizeof(position)));
+		}
+		else if (containsPosition)
 		{
 			constexpr uint32_t dataSize = cd::Point::Size * sizeof(cd::Point::ValueType);
 			FillVertexBuffer(m_pMeshData->GetVertexPosition(vertexIndex).Begin(), dataSize);
 		}
 
-		if (containsNormal)
+		if (containsNormal && compressNormalTangent)
+		{
+			std::array<uint8_t, 2> normal = VertexQuantizer::EncodeOctahedral(m_pMeshData->GetVertexNormal(vertexIndex));
+			std::array<uint8_t, 2> tangent = containsTangent ? VertexQuantizer::EncodeOctahedral(m_pMeshData->GetVertexTangent(vertexIndex)) : normal;
+			std::array<uint8_t, 4> normalTangent = { normal[0], normal[1], tangent[0], tangent[1] };
+			FillVertexBuffer(normalTangent.data(), static_cast<uint32_t>(sizeof(normalTangent)));
+		}
+		else if (containsNormal)
 		{
 			constexpr uint32_t dataSize = cd::Direction::Size * sizeof(cd::Direction::ValueType);
 			FillVertexBuffer(m_pMeshData->GetVertexNormal(vertexIndex).Begin(), dataSize);
 		}
 
-		if (containsTangent)
+		if (containsTangent && !compressNormalTangent)
 		{
 			constexpr uint32_t dataSize = cd::Direction::Size * sizeof(cd::Direction::ValueType);
 			FillVertexBuffer(m_pMeshData->GetVertexTangent(vertexIndex).Begin(), dataSize);
@@ -141,7 +209,13 @@ void StaticMeshComponent::Build()
 			FillVertexBuffer(m_pMeshData->GetVertexBiTangent(vertexIndex).Begin(), dataSize);
 		}
 		
-		if (containsUV)
+		if (containsUV && compressUV)
+		{
+			const cd::UV& uv = m_pMeshData->GetVertexUV(0)[vertexIndex];
+			std::array<uint16_t, 2> halfUV = { VertexQuantizer::FloatToHalf(uv.x()), VertexQuantizer::FloatToHalf(uv.y()) };
+			FillVertexBuffer(halfUV.data(), static_cast<uint32_t>(sizeof(halfUV)));
+		}
+		else if (containsUV)
 		{
 			constexpr uint32_t dataSize = cd::UV::Size * sizeof(cd::UV::ValueType);
 			FillVertexBuffer(m_pMeshData->GetVertexUV(0)[vertexIndex].Begin(), dataSize);
@@ -178,23 +252,51 @@ void StaticMeshComponent::Build()
 				}
 			}
 
-			// TODO : Change storage to a TVector<uint16_t, InfluenceCount> and TVector<float, InfluenceCount> ?
-			FillVertexBuffer(vertexBoneIDs.data(), static_cast<uint32_t>(vertexBoneIDs.size() * sizeof(uint16_t)));
-			FillVertexBuffer(vertexBoneWeights.data(), static_cast<uint32_t>(vertexBoneWeights.size() * sizeof(cd::VertexWeight)));
+			if (compressBoneWeight)
+			{
+				// Shaders support at most 128 bones, so their indexes fit into 8 bits.
+				std::array<uint8_t, 4> boneIDs;
+				std::transform(vertexBoneIDs.begin(), vertexBoneIDs.end(), boneIDs.begin(), [](uint16_t boneID) { return static_cast<uint8_t>(boneID); });
+				std::array<uint8_t, 4> boneWeights = VertexQuantizer::QuantizeBoneWeights({ vertexBoneWeights[0], vertexBoneWeights[1], vertexBoneWeights[2], vertexBoneWeights[3] });
+				FillVertexBuffer(boneIDs.data(), static_cast<uint32_t>(sizeof(boneIDs)));
+				FillVertexBuffer(boneWeights.data(), static_cast<uint32_t>(sizeof(boneWeights)));
+			}
+			else
+			{
+				// TODO : Change storage to a TVector<uint16_t, InfluenceCount> and TVector<float, InfluenceCount> ?
+				FillVertexBuffer(vertexBoneIDs.data(), static_cast<uint32_t>(vertexBoneIDs.size() * sizeof(uint16_t)));
+				FillVertexBuffer(vertexBoneWeights.data(), static_cast<uint32_t>(vertexBoneWeights.size() * sizeof(cd::VertexWeight)));
+			}
 		}
 	}
 
 	// Create vertex buffer.
-	bgfx::VertexLayout vertexLayout;
-	VertexLayoutUtility::CreateVertexLayout(vertexLayout, m_pRequiredVertexFormat->GetVertexLayout());
 	bgfx::VertexBufferHandle vertexBufferHandle = bgfx::createVertexBuffer(bgfx::makeRef(m_vertexBuffer.data(), static_cast<uint32_t>(m_vertexBuffer.size())), vertexLayout);
 	assert(bgfx::isValid(vertexBufferHandle));
 	m_vertexBufferHandle = vertexBufferHandle.idx;
 
-	// Create index buffer.
-	m_indexBuffer.resize(m_pMeshData->GetPolygonCount() * cd::Polygon::Size * sizeof(cd::Polygon::ValueType));
-	std::memcpy(m_indexBuffer.data(), m_pMeshData->GetPolygons().data(), m_indexBuffer.size());
-	bgfx::IndexBufferHandle indexBufferHandle = bgfx::createIndexBuffer(bgfx::makeRef(m_indexBuffer.data(), static_cast<uint32_t>(m_indexBuffer.size())), BGFX_BUFFER_INDEX32);
+	// Create index buffer. 16 bits indexes are used if they can address all vertexes, which halves the index memory.
+	const bool useIndex32 = vertexCount > UINT16_MAX;
+	if (useIndex32)
+	{
+		m_indexBuffer.resize(indices.size() * sizeof(uint32_t));
+		std::memcpy(m_indexBuffer.data(), indices.data(), m_indexBuffer.size());
+	}
+	else
+	{
+		m_indexBuffer.resize(indices.size() * sizeof(uint16_t));
+		uint16_t* pIndices = reinterpret_cast<uint16_t*>(m_indexBuffer.data());
+		std::transform(indices.begin(), indices.end(), pIndices, [](uint32_t index) { return static_cast<uint16_t>(index); });
+	}
+
+	// Imported sizes are of the full mesh with float attributes and 32 bits indexes. Optimized index buffers include LODs.
+	CD_ENGINE_INFO("Mesh {0} : ACMR {1:.3f} -> {2:.3f}, ATVR {3:.3f} -> {4:.3f}, vertex buffer {5} -> {6} bytes in stride {7} -> {8}, index buffer {9} -> {10} bytes of {11} LODs in {12} bits.",
+		m_pMeshData->GetName(), importedCacheStats.acmr, optimizedCacheStats.acmr, importedCacheStats.atvr, optimizedCacheStats.atvr,
+		meshVertexCount * vertexFormatStride, m_vertexBuffer.size(), vertexFormatStride, vertexLayout.getStride(),
+		fullIndexCount * sizeof(uint32_t), m_indexBuffer.size(), m_lods.size(), useIndex32 ? 32 : 16);
+
+	bgfx::IndexBufferHandle indexBufferHandle = bgfx::createIndexBuffer(bgfx::makeRef(m_indexBuffer.data(), static_cast<uint32_t>(m_indexBuffer.size())),
+		useIndex32 ? BGFX_BUFFER_INDEX32 : BGFX_BUFFER_NONE);
 	assert(bgfx::isValid(indexBufferHandle));
 	m_indexBufferHandle = indexBufferHandle.idx;
 
@@ -3,8 +3,11 @@
 #include "Core/StringCrc.h"
 #include "ECWorld/Entity.h"
 #include "Math/Box.hpp"
+#include "Rendering/MeshLODBuilder.hpp"
+#include "Rendering/VertexCompression.hpp"
 #include "Scene/Mesh.h"
 
+#include <array>
 #include <cstdint>
 #include <vector>
 
@@ -41,10 +44,19 @@ public:
 	const cd::Mesh* GetMeshData() const { return m_pMeshData; }
 	void SetMeshData(const cd::Mesh* pMeshData) { m_pMeshData = pMeshData; }
 	void SetRequiredVertexFormat(const cd::VertexFormat* pVertexFormat) { m_pRequiredVertexFormat = pVertexFormat; }
+	void SetLODSettings(const MeshLODBuilder::Settings& settings) { m_lodSettings = settings; }
+	void SetVertexCompression(VertexCompression vertexCompression) { m_vertexCompression = vertexCompression; }
 
 	const cd::AABB& GetAABB() const { return m_aabb; }
 	uint16_t GetVertexBuffer() const { return m_vertexBufferHandle; }
 	uint16_t GetIndexBuffer() const { return m_indexBufferHandle; }
+	// Uniform data of u_positionDequantize : offset and scale. Positions which aren't quantized use the identity.
+	const cd::Vec4f* GetPositionDequantization() const { return m_positionDequantization.data(); }
+
+	// Index ranges of LODs in the index buffer. LOD 0 is the full mesh.
+	const std::vector<MeshLOD>& GetLODs() const { return m_lods; }
+	const MeshLOD& GetLOD(uint32_t lodIndex) const { return m_lods[lodIndex]; }
+	uint32_t GetLODCount() const { return static_cast<uint32_t>(m_lods.size()); }
 	uint16_t GetAABBVertexBuffer() const { return m_aabbVBH; }
 	uint16_t GetAABBIndexBuffer() const { return m_aabbIBH; }
 
@@ -58,12 +70,16 @@ private:
 	// Input
 	const cd::Mesh* m_pMeshData = nullptr;
 	const cd::VertexFormat* m_pRequiredVertexFormat = nullptr;
+	MeshLODBuilder::Settings m_lodSettings;
+	VertexCompression m_vertexCompression = VertexCompression::None;
 
 	// Output
 	std::vector<std::byte> m_vertexBuffer;
 	std::vector<std::byte> m_indexBuffer;
 	uint16_t m_vertexBufferHandle = UINT16_MAX;
 	uint16_t m_indexBufferHandle = UINT16_MAX;
+	std::vector<MeshLOD> m_lods;
+	std::array<cd::Vec4f, 2> m_positionDequantization = { cd::Vec4f(0.0f, 0.0f, 0.0f, 0.0f), cd::Vec4f(1.0f, 1.0f, 1.0f, 0.0f) };
 
 	// For debug use
 	cd::AABB m_aabb;
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "Core/Threading/ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace engine
+{
+
+class World;
+
+// Tags to declare component types which a system reads or writes.
+// For example, World::AddSystem("CameraSystem", Reads<TransformComponent>(), Writes<CameraComponent>(), func).
+template<typename... Components>
+struct Reads
+{
+};
+
+template<typename... Components>
+struct Writes
+{
+};
+
+// SystemScheduler runs systems registered to a World every frame.
+// Two systems conflict if one writes a component type which the other one reads or writes.
+// A conflicting system always runs after the one registered before it. Others run concurrently on a ThreadPool.
+class SystemScheduler
+{
+public:
+	using SystemFunction = std::function<void(World&, float)>;
+
+public:
+	SystemScheduler() = default;
+	SystemScheduler(const SystemScheduler&) = delete;
+	SystemScheduler& operator=(const SystemScheduler&) = delete;
+	SystemScheduler(SystemScheduler&&) = default;
+	SystemScheduler& operator=(SystemScheduler&&) = default;
+	~SystemScheduler() = default;
+
+	void AddSystem(std::string name, std::vector<uint32_t> reads, std::vector<uint32_t> writes, SystemFunction function)
+	{
+		std::sort(reads.begin(), reads.end());
+		std::sort(writes.begin(), writes.end());
+
+		System& system = m_systems.emplace_back();
+		system.name = std::move(name);
+		system.reads = std::move(reads);
+		system.writes = std::move(writes);
+		system.function = std::move(function);
+	}
+
+	void SetSystemEnabled(const std::string& name, bool enabled)
+	{
+		for (System& system : m_systems)
+		{
+			if (system.name == name)
+			{
+				system.enabled = enabled;
+			}
+		}
+	}
+
+	size_t GetSystemCount() const { return m_systems.size(); }
+
+	// Run all enabled systems. Without a ThreadPool, they run one by one in the registration order.
+	void Run(World& world, float deltaTime, ThreadPool* pThreadPool = nullptr)
+	{
+		BuildGraph();
+		if (m_activeSystems.empty())
+		{
+			return;
+		}
+
+		if (!pThreadPool)
+		{
+			for (size_t systemIndex : m_activeSystems)
+			{
+				m_systems[systemIndex].function(world, deltaTime);
+			}
+			return;
+		}
+
+		FrameContext context{ world, deltaTime, *pThreadPool, std::make_unique<std::atomic<uint32_t>[]>(m_systems.size()) };
+		for (size_t systemIndex : m_activeSystems)
+		{
+			context.remainingDependencies[systemIndex] = m_systems[systemIndex].dependencyCount;
+		}
+
+		for (size_t systemIndex : m_activeSystems)
+		{
+			if (0 == m_systems[systemIndex].dependencyCount)
+			{
+				ScheduleSystem(context, systemIndex);
+			}
+		}
+
+		// Help workers instead of blocking the calling thread.
+		while (context.finishedCount.load(std::memory_order_acquire) < m_activeSystems.size())
+		{
+			if (!pThreadPool->TryRunTask())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+private:
+	struct System
+	{
+		std::string name;
+		std::vector<uint32_t> reads;
+		std::vector<uint32_t> writes;
+		SystemFunction function;
+		bool enabled = true;
+
+		// Built every frame.
+		std::vector<size_t> successors;
+		uint32_t dependencyCount = 0;
+	};
+
+	struct FrameContext
+	{
+		World& world;
+		float deltaTime;
+		ThreadPool& threadPool;
+		std::unique_ptr<std::atomic<uint32_t>[]> remainingDependencies;
+		std::atomic<size_t> finishedCount = 0;
+	};
+
+	static bool Intersects(const std::vector<uint32_t>& lhs, const std::vector<uint32_t>& rhs)
+	{
+		auto itLhs = lhs.begin();
+		auto itRhs = rhs.begin();
+		while (itLhs != lhs.end() && itRhs != rhs.end())
+		{
+			if (*itLhs == *itRhs)
+			{
+				return true;
+			}
+
+			if (*itLhs < *itRhs)
+			{
+				++itLhs;
+			}
+			else
+			{
+				++itRhs;
+			}
+		}
+
+		return false;
+	}
+
+	static bool Conflicts(const System& lhs, const System& rhs)
+	{
+		return Intersects(lhs.writes, rhs.writes) || Intersects(lhs.writes, rhs.reads) || Intersects(lhs.reads, rhs.writes);
+	}
+
+	// Build the dependency DAG of enabled systems. Edges always point to the system registered later so there is no cycle.
+	void BuildGraph()
+	{
+		m_activeSystems.clear();
+		for (size_t systemIndex = 0; systemIndex < m_systems.size(); ++systemIndex)
+		{
+			System& system = m_systems[systemIndex];
+			system.successors.clear();
+			system.dependencyCount = 0;
+			if (!system.enabled)
+			{
+				continue;
+			}
+
+			for (size_t previousIndex : m_activeSystems)
+			{
+				System& previousSystem = m_systems[previousIndex];
+				if (Conflicts(previousSystem, system))
+				{
+					previousSystem.successors.push_back(systemIndex);
+					++system.dependencyCount;
+				}
+			}
+
+			m_activeSystems.push_back(systemIndex);
+		}
+	}
+
+	void ScheduleSystem(FrameContext& context, size_t systemIndex)
+	{
+		context.threadPool.Submit([this, &context, systemIndex]()
+		{
+			const System& system = m_systems[systemIndex];
+			system.function(context.world, context.deltaTime);
+
+			for (size_t successorIndex : system.successors)
+			{
+				if (1 == context.remainingDependencies[successorIndex].fetch_sub(1, std::memory_order_acq_rel))
+				{
+					ScheduleSystem(context, successorIndex);
+				}
+			}
+
+			context.finishedCount.fetch_add(1, std::memory_order_release);
+		});
+	}
+
+private:
+	std::vector<System> m_systems;
+	std::vector<size_t> m_activeSystems;
+};
+
+}
\ No newline at end of file
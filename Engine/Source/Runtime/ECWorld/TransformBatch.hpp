@@ -0,0 +1,276 @@
+#pragma once
+
+#include "Core/CPUFeatures.hpp"
+#include "Math/Matrix.hpp"
+#include "Math/Transform.hpp"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace engine
+{
+
+// TransformBatch stores translations, rotations and scales of transforms in SoA form,
+// so that SIMD kernels build local to world matrices of 4 (SSE2) or 8 (AVX2) transforms at once.
+// Matrices are column-major with translation in the last column, which is the same as cd::Transform::GetMatrix().
+class TransformBatch final
+{
+public:
+	static_assert(sizeof(cd::Matrix4x4) == 16 * sizeof(float), "Kernels write matrices as 16 packed floats.");
+
+public:
+	TransformBatch() = default;
+	TransformBatch(const TransformBatch&) = default;
+	TransformBatch& operator=(const TransformBatch&) = default;
+	TransformBatch(TransformBatch&&) = default;
+	TransformBatch& operator=(TransformBatch&&) = default;
+	~TransformBatch() = default;
+
+	size_t GetCount() const { return m_translationX.size(); }
+
+	void Clear()
+	{
+		for (std::vector<float>* pChannel : GetChannels())
+		{
+			pChannel->clear();
+		}
+	}
+
+	void Reserve(size_t count)
+	{
+		for (std::vector<float>* pChannel : GetChannels())
+		{
+			pChannel->reserve(count);
+		}
+	}
+
+	void Add(const cd::Transform& transform)
+	{
+		const cd::Vec3f& translation = transform.GetTranslation();
+		const cd::Quaternion& rotation = transform.GetRotation();
+		const cd::Vec3f& scale = transform.GetScale();
+		m_translationX.push_back(translation.x());
+		m_translationY.push_back(translation.y());
+		m_translationZ.push_back(translation.z());
+		m_rotationX.push_back(rotation.x());
+		m_rotationY.push_back(rotation.y());
+		m_rotationZ.push_back(rotation.z());
+		m_rotationW.push_back(rotation.w());
+		m_scaleX.push_back(scale.x());
+		m_scaleY.push_back(scale.y());
+		m_scaleZ.push_back(scale.z());
+	}
+
+	// Write matrices to a packed array.
+	void Build(cd::Matrix4x4* pMatrices, SIMDLevel level = GetSIMDLevel()) const
+	{
+		Build([pMatrices](size_t index) { return pMatrices[index].Begin(); }, level);
+	}
+
+	// Write matrices to scattered addresses, such as components in a storage.
+	void Build(float* const* ppMatrices, SIMDLevel level = GetSIMDLevel()) const
+	{
+		Build([ppMatrices](size_t index) { return ppMatrices[index]; }, level);
+	}
+
+private:
+	template<typename GetMatrix>
+	void Build(GetMatrix getMatrix, SIMDLevel level) const
+	{
+		size_t index = 0;
+#ifdef CD_SIMD_X86
+		if (SIMDLevel::AVX2 == level)
+		{
+			index = BuildAVX2(getMatrix);
+		}
+		else if (SIMDLevel::SSE2 == level)
+		{
+			index = BuildSSE2(getMatrix);
+		}
+#endif
+		for (; index < GetCount(); ++index)
+		{
+			BuildScalar(index, getMatrix(index));
+		}
+	}
+
+	// Columns of the matrix are
+	// ((1 - 2(yy + zz)) sx, 2(xy + wz) sx, 2(xz - wy) sx, 0)
+	// (2(xy - wz) sy, (1 - 2(xx + zz)) sy, 2(yz + wx) sy, 0)
+	// (2(xz + wy) sz, 2(yz - wx) sz, (1 - 2(xx + yy)) sz, 0)
+	// (tx, ty, tz, 1)
+	void BuildScalar(size_t index, float* pMatrix) const
+	{
+		float x = m_rotationX[index];
+		float y = m_rotationY[index];
+		float z = m_rotationZ[index];
+		float w = m_rotationW[index];
+		float sx = m_scaleX[index];
+		float sy = m_scaleY[index];
+		float sz = m_scaleZ[index];
+
+		pMatrix[0] = (1.0f - 2.0f * (y * y + z * z)) * sx;
+		pMatrix[1] = 2.0f * (x * y + w * z) * sx;
+		pMatrix[2] = 2.0f * (x * z - w * y) * sx;
+		pMatrix[3] = 0.0f;
+		pMatrix[4] = 2.0f * (x * y - w * z) * sy;
+		pMatrix[5] = (1.0f - 2.0f * (x * x + z * z)) * sy;
+		pMatrix[6] = 2.0f * (y * z + w * x) * sy;
+		pMatrix[7] = 0.0f;
+		pMatrix[8] = 2.0f * (x * z + w * y) * sz;
+		pMatrix[9] = 2.0f * (y * z - w * x) * sz;
+		pMatrix[10] = (1.0f - 2.0f * (x * x + y * y)) * sz;
+		pMatrix[11] = 0.0f;
+		pMatrix[12] = m_translationX[index];
+		pMatrix[13] = m_translationY[index];
+		pMatrix[14] = m_translationZ[index];
+		pMatrix[15] = 1.0f;
+	}
+
+#ifdef CD_SIMD_X86
+	// Transpose 4 lanes of 4 channels to 4 columns of 4 matrices.
+	template<typename GetMatrix>
+	static void StoreColumns(GetMatrix& getMatrix, size_t index, size_t columnIndex, __m128 c0, __m128 c1, __m128 c2, __m128 c3)
+	{
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_storeu_ps(getMatrix(index + 0) + columnIndex * 4, c0);
+		_mm_storeu_ps(getMatrix(index + 1) + columnIndex * 4, c1);
+		_mm_storeu_ps(getMatrix(index + 2) + columnIndex * 4, c2);
+		_mm_storeu_ps(getMatrix(index + 3) + columnIndex * 4, c3);
+	}
+
+	template<typename GetMatrix>
+	size_t BuildSSE2(GetMatrix& getMatrix) const
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 zero = _mm_setzero_ps();
+
+		size_t index = 0;
+		for (; index + 4 <= GetCount(); index += 4)
+		{
+			__m128 x = _mm_loadu_ps(&m_rotationX[index]);
+			__m128 y = _mm_loadu_ps(&m_rotationY[index]);
+			__m128 z = _mm_loadu_ps(&m_rotationZ[index]);
+			__m128 w = _mm_loadu_ps(&m_rotationW[index]);
+			__m128 sx = _mm_loadu_ps(&m_scaleX[index]);
+			__m128 sy = _mm_loadu_ps(&m_scaleY[index]);
+			__m128 sz = _mm_loadu_ps(&m_scaleZ[index]);
+
+			__m128 xx = _mm_mul_ps(x, x);
+			__m128 yy = _mm_mul_ps(y, y);
+			__m128 zz = _mm_mul_ps(z, z);
+			__m128 xy = _mm_mul_ps(x, y);
+			__m128 xz = _mm_mul_ps(x, z);
+			__m128 yz = _mm_mul_ps(y, z);
+			__m128 wx = _mm_mul_ps(w, x);
+			__m128 wy = _mm_mul_ps(w, y);
+			__m128 wz = _mm_mul_ps(w, z);
+
+			StoreColumns(getMatrix, index, 0,
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+				zero);
+			StoreColumns(getMatrix, index, 1,
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+				zero);
+			StoreColumns(getMatrix, index, 2,
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+				zero);
+			StoreColumns(getMatrix, index, 3,
+				_mm_loadu_ps(&m_translationX[index]),
+				_mm_loadu_ps(&m_translationY[index]),
+				_mm_loadu_ps(&m_translationZ[index]),
+				one);
+		}
+
+		return index;
+	}
+
+	// Same math as BuildSSE2 on 8 lanes. Columns are stored by two 4-lane transposes.
+	template<typename GetMatrix>
+	CD_TARGET_AVX2 static void StoreColumns(GetMatrix& getMatrix, size_t index, size_t columnIndex, __m256 c0, __m256 c1, __m256 c2, __m256 c3)
+	{
+		StoreColumns(getMatrix, index, columnIndex, _mm256_castps256_ps128(c0), _mm256_castps256_ps128(c1), _mm256_castps256_ps128(c2), _mm256_castps256_ps128(c3));
+		StoreColumns(getMatrix, index + 4, columnIndex, _mm256_extractf128_ps(c0, 1), _mm256_extractf128_ps(c1, 1), _mm256_extractf128_ps(c2, 1), _mm256_extractf128_ps(c3, 1));
+	}
+
+	template<typename GetMatrix>
+	CD_TARGET_AVX2 size_t BuildAVX2(GetMatrix& getMatrix) const
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+		const __m256 zero = _mm256_setzero_ps();
+
+		size_t index = 0;
+		for (; index + 8 <= GetCount(); index += 8)
+		{
+			__m256 x = _mm256_loadu_ps(&m_rotationX[index]);
+			__m256 y = _mm256_loadu_ps(&m_rotationY[index]);
+			__m256 z = _mm256_loadu_ps(&m_rotationZ[index]);
+			__m256 w = _mm256_loadu_ps(&m_rotationW[index]);
+			__m256 sx = _mm256_loadu_ps(&m_scaleX[index]);
+			__m256 sy = _mm256_loadu_ps(&m_scaleY[index]);
+			__m256 sz = _mm256_loadu_ps(&m_scaleZ[index]);
+
+			__m256 xx = _mm256_mul_ps(x, x);
+			__m256 yy = _mm256_mul_ps(y, y);
+			__m256 zz = _mm256_mul_ps(z, z);
+			__m256 xy = _mm256_mul_ps(x, y);
+			__m256 xz = _mm256_mul_ps(x, z);
+			__m256 yz = _mm256_mul_ps(y, z);
+			__m256 wx = _mm256_mul_ps(w, x);
+			__m256 wy = _mm256_mul_ps(w, y);
+			__m256 wz = _mm256_mul_ps(w, z);
+
+			StoreColumns(getMatrix, index, 0,
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx),
+				zero);
+			StoreColumns(getMatrix, index, 1,
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+				zero);
+			StoreColumns(getMatrix, index, 2,
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz),
+				zero);
+			StoreColumns(getMatrix, index, 3,
+				_mm256_loadu_ps(&m_translationX[index]),
+				_mm256_loadu_ps(&m_translationY[index]),
+				_mm256_loadu_ps(&m_translationZ[index]),
+				one);
+		}
+
+		return index;
+	}
+#endif
+
+	std::array<std::vector<float>*, 10> GetChannels()
+	{
+		return { &m_translationX, &m_translationY, &m_translationZ, &m_rotationX, &m_rotationY, &m_rotationZ, &m_rotationW, &m_scaleX, &m_scaleY, &m_scaleZ };
+	}
+
+private:
+	std::vector<float> m_translationX;
+	std::vector<float> m_translationY;
+	std::vector<float> m_translationZ;
+	std::vector<float> m_rotationX;
+	std::vector<float> m_rotationY;
+	std::vector<float> m_rotationZ;
+	std::vector<float> m_rotationW;
+	std::vector<float> m_scaleX;
+	std::vector<float> m_scaleY;
+	std::vector<float> m_scaleZ;
+};
+
+}
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "TransformComponent.h"
 
+#include "ECWorld/TransformBatch.hpp"
+
+#include <vector>
+
 namespace engine
 {
 
@@ -19,4 +23,27 @@ void TransformComponent::Build()
 	}
 }
 
+void TransformComponent::Build(const cd::Matrix4x4& parentWorldMatrix)
+{
+	m_localToWorldMatrix = parentWorldMatrix * m_transform.GetMatrix();
+	m_isMatrixDirty = false;
+}
+
+void TransformComponent::BuildBatch(std::span<TransformComponent* const> transforms)
+{
+	// Scratch buffers per thread as batches are built by tasks concurrently.
+	thread_local TransformBatch batch;
+	thread_local std::vector<float*> worldMatrices;
+	batch.Clear();
+	worldMatrices.clear();
+	for (TransformComponent* pTransform : transforms)
+	{
+		batch.Add(pTransform->m_transform);
+		worldMatrices.push_back(pTransform->m_localToWorldMatrix.Begin());
+		pTransform->m_isMatrixDirty = false;
+	}
+
+	batch.Build(worldMatrices.data());
+}
+
 }
\ No newline at end of file
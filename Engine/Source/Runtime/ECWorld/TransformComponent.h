@@ -3,6 +3,8 @@
 #include "Core/StringCrc.h"
 #include "Math/Transform.hpp"
 
+#include <span>
+
 namespace engine
 {
 
@@ -34,6 +36,12 @@ public:
 	void Reset();
 	void Build();
 
+	// Compose the local transform with the parent's world matrix. It always rebuilds as the parent may have moved.
+	void Build(const cd::Matrix4x4& parentWorldMatrix);
+
+	// Rebuild world matrices of root transforms by SIMD kernels. Dirty flags are ignored.
+	static void BuildBatch(std::span<TransformComponent* const> transforms);
+
 private:
 	// Input
 	cd::Transform m_transform;
@@ -0,0 +1,327 @@
+#pragma once
+
+#include "ComponentsStorage.hpp"
+#include "Core/Threading/ThreadPool.hpp"
+#include "Entity.h"
+#include "HierarchyComponent.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace engine
+{
+
+// TransformHierarchy propagates world matrices from parents to children which are linked by HierarchyComponent.
+// Nodes are kept in breadth-first order, so every level is a contiguous range and children of a node are adjacent.
+// Levels are updated one by one. Nodes in the same level don't depend on each other so a large level is split into tasks.
+// Only subtrees under transforms which changed since the last update are touched.
+// Transform needs Dirty(), Build() for roots, and Build(parentWorldMatrix) with GetWorldMatrix() for children.
+// Roots are built by Transform::BuildBatch(std::span<Transform* const>) instead if it exists.
+// Children's world matrices are rewritten in place without stamping change ticks.
+template<typename Transform>
+class TransformHierarchy final
+{
+public:
+	using NodeIndex = uint32_t;
+	static constexpr NodeIndex INVALID_NODE_INDEX = static_cast<NodeIndex>(-1);
+
+	// Nodes updated by one task. Smaller levels run on the calling thread.
+	static constexpr size_t TaskNodeCount = 1024;
+
+public:
+	TransformHierarchy() = default;
+	TransformHierarchy(const TransformHierarchy&) = default;
+	TransformHierarchy& operator=(const TransformHierarchy&) = default;
+	TransformHierarchy(TransformHierarchy&&) = default;
+	TransformHierarchy& operator=(TransformHierarchy&&) = default;
+	~TransformHierarchy() = default;
+
+	size_t GetNodeCount() const { return m_nodeEntities.size(); }
+	size_t GetLevelCount() const { return m_levelOffsets.empty() ? 0 : m_levelOffsets.size() - 1; }
+
+	// Nodes which the last Update built, including descendants of changed transforms.
+	size_t GetUpdatedNodeCount() const { return m_updatedNodes.size(); }
+	std::span<const NodeIndex> GetUpdatedNodes() const { return m_updatedNodes; }
+
+	NodeIndex GetNodeIndex(Entity entity) const
+	{
+		EntityIndex entityIndex = GetEntityIndex(entity);
+		if (entityIndex >= m_entityNodeIndices.size())
+		{
+			return INVALID_NODE_INDEX;
+		}
+
+		NodeIndex nodeIndex = m_entityNodeIndices[entityIndex];
+		return INVALID_NODE_INDEX != nodeIndex && m_nodeEntities[nodeIndex] == entity ? nodeIndex : INVALID_NODE_INDEX;
+	}
+
+	Entity GetNodeEntity(NodeIndex nodeIndex) const { return m_nodeEntities[nodeIndex]; }
+	NodeIndex GetParentNodeIndex(NodeIndex nodeIndex) const { return m_parentNodeIndices[nodeIndex]; }
+
+	// Build world matrices of changed transforms and their descendants. Call it at a sync point per frame.
+	// Tasks are submitted to the ThreadPool if there is one and the calling thread helps to run them.
+	void Update(ComponentsStorage<Transform>& transformStorage, const ComponentsStorage<HierarchyComponent>& hierarchyStorage, ThreadPool* pThreadPool = nullptr)
+	{
+		m_updatedNodes.clear();
+
+		// The order caches dense indices so it is rebuilt after any transform moves in the storage or any parent changes.
+		m_changedNodes.clear();
+		if (m_transformLayoutVersion != transformStorage.GetLayoutVersion() || hierarchyStorage.HasChangedSince(m_lastUpdateTick))
+		{
+			Rebuild(transformStorage, hierarchyStorage);
+			m_changedNodes.resize(GetNodeCount());
+			std::iota(m_changedNodes.begin(), m_changedNodes.end(), 0);
+		}
+		else
+		{
+			transformStorage.ForEachChanged(m_lastUpdateTick, [this](Entity entity, Transform&)
+			{
+				NodeIndex nodeIndex = GetNodeIndex(entity);
+				if (INVALID_NODE_INDEX != nodeIndex)
+				{
+					m_changedNodes.push_back(nodeIndex);
+				}
+			});
+			std::sort(m_changedNodes.begin(), m_changedNodes.end());
+		}
+		m_lastUpdateTick = std::max(transformStorage.GetCurrentTick(), hierarchyStorage.GetCurrentTick());
+
+		// Dirty nodes of a level are the children of dirty nodes in the previous level and nodes changed by themselves.
+		std::vector<Transform>& transforms = transformStorage.GetComponents();
+		m_levelNodes.clear();
+		size_t changedNodeIndex = 0;
+		for (size_t levelIndex = 0; levelIndex < GetLevelCount(); ++levelIndex)
+		{
+			size_t inheritedNodeCount = m_levelNodes.size();
+			NodeIndex levelEnd = m_levelOffsets[levelIndex + 1];
+			for (; changedNodeIndex < m_changedNodes.size() && m_changedNodes[changedNodeIndex] < levelEnd; ++changedNodeIndex)
+			{
+				NodeIndex nodeIndex = m_changedNodes[changedNodeIndex];
+				if (!m_isNodeDirty[nodeIndex])
+				{
+					m_levelNodes.push_back(nodeIndex);
+				}
+			}
+
+			if (m_levelNodes.empty())
+			{
+				if (changedNodeIndex == m_changedNodes.size())
+				{
+					break;
+				}
+				continue;
+			}
+
+			// Both parts are sorted. Keep the level in memory order.
+			std::inplace_merge(m_levelNodes.begin(), m_levelNodes.begin() + inheritedNodeCount, m_levelNodes.end());
+			UpdateLevel(m_levelNodes, transforms, pThreadPool);
+			m_updatedNodes.insert(m_updatedNodes.end(), m_levelNodes.begin(), m_levelNodes.end());
+
+			m_nextLevelNodes.clear();
+			for (NodeIndex nodeIndex : m_levelNodes)
+			{
+				m_isNodeDirty[nodeIndex] = 0;
+				for (NodeIndex childIndex = m_firstChildIndices[nodeIndex]; childIndex < m_firstChildIndices[nodeIndex + 1]; ++childIndex)
+				{
+					m_isNodeDirty[childIndex] = 1;
+					m_nextLevelNodes.push_back(childIndex);
+				}
+			}
+			std::swap(m_levelNodes, m_nextLevelNodes);
+		}
+	}
+
+private:
+	void Rebuild(const ComponentsStorage<Transform>& transformStorage, const ComponentsStorage<HierarchyComponent>& hierarchyStorage)
+	{
+		using DenseIndex = typename ComponentsStorage<Transform>::DenseIndex;
+		constexpr DenseIndex INVALID_DENSE_INDEX = ComponentsStorage<Transform>::INVALID_DENSE_INDEX;
+
+		m_transformLayoutVersion = transformStorage.GetLayoutVersion();
+
+		// Group children by parent in dense order first. Parents without transforms make their children roots.
+		const std::vector<Entity>& entities = transformStorage.GetEntities();
+		DenseIndex transformCount = static_cast<DenseIndex>(entities.size());
+		m_parentDenseIndices.assign(transformCount, INVALID_DENSE_INDEX);
+		m_childOffsets.assign(transformCount + 1, 0);
+		for (DenseIndex denseIndex = 0; denseIndex < transformCount; ++denseIndex)
+		{
+			if (const HierarchyComponent* pHierarchyComponent = hierarchyStorage.GetComponent(entities[denseIndex]))
+			{
+				DenseIndex parentDenseIndex = transformStorage.GetDenseIndex(pHierarchyComponent->GetParentEntity());
+				if (INVALID_DENSE_INDEX != parentDenseIndex && parentDenseIndex != denseIndex)
+				{
+					m_parentDenseIndices[denseIndex] = parentDenseIndex;
+					++m_childOffsets[parentDenseIndex + 1];
+				}
+			}
+		}
+		std::partial_sum(m_childOffsets.begin(), m_childOffsets.end(), m_childOffsets.begin());
+
+		m_children.resize(transformCount);
+		m_childCursors.assign(m_childOffsets.begin(), m_childOffsets.end() - 1);
+		for (DenseIndex denseIndex = 0; denseIndex < transformCount; ++denseIndex)
+		{
+			DenseIndex parentDenseIndex = m_parentDenseIndices[denseIndex];
+			if (INVALID_DENSE_INDEX != parentDenseIndex)
+			{
+				m_children[m_childCursors[parentDenseIndex]++] = denseIndex;
+			}
+		}
+
+		// Breadth-first traversal from roots.
+		m_nodeDenseIndices.clear();
+		m_nodeEntities.clear();
+		m_parentNodeIndices.clear();
+		m_firstChildIndices.clear();
+		m_levelOffsets.assign(1, 0);
+		for (DenseIndex denseIndex = 0; denseIndex < transformCount; ++denseIndex)
+		{
+			if (INVALID_DENSE_INDEX == m_parentDenseIndices[denseIndex])
+			{
+				AddNode(denseIndex, entities[denseIndex], INVALID_NODE_INDEX);
+			}
+		}
+
+		NodeIndex levelBegin = 0;
+		while (levelBegin < m_nodeDenseIndices.size())
+		{
+			NodeIndex levelEnd = static_cast<NodeIndex>(m_nodeDenseIndices.size());
+			m_levelOffsets.push_back(levelEnd);
+			for (NodeIndex nodeIndex = levelBegin; nodeIndex < levelEnd; ++nodeIndex)
+			{
+				m_firstChildIndices.push_back(static_cast<NodeIndex>(m_nodeDenseIndices.size()));
+				DenseIndex denseIndex = m_nodeDenseIndices[nodeIndex];
+				for (uint32_t childIndex = m_childOffsets[denseIndex]; childIndex < m_childOffsets[denseIndex + 1]; ++childIndex)
+				{
+					DenseIndex childDenseIndex = m_children[childIndex];
+					AddNode(childDenseIndex, entities[childDenseIndex], nodeIndex);
+				}
+			}
+			levelBegin = levelEnd;
+		}
+		m_firstChildIndices.push_back(static_cast<NodeIndex>(m_nodeDenseIndices.size()));
+		assert(m_nodeDenseIndices.size() == transformCount && "Transforms in a parent cycle are not reachable from roots.");
+
+		m_isNodeDirty.assign(m_nodeDenseIndices.size(), 0);
+		m_entityNodeIndices.assign(m_entityNodeIndices.size(), INVALID_NODE_INDEX);
+		for (NodeIndex nodeIndex = 0; nodeIndex < m_nodeEntities.size(); ++nodeIndex)
+		{
+			EntityIndex entityIndex = GetEntityIndex(m_nodeEntities[nodeIndex]);
+			if (entityIndex >= m_entityNodeIndices.size())
+			{
+				m_entityNodeIndices.resize(entityIndex + 1, INVALID_NODE_INDEX);
+			}
+			m_entityNodeIndices[entityIndex] = nodeIndex;
+		}
+	}
+
+	void AddNode(uint32_t denseIndex, Entity entity, NodeIndex parentNodeIndex)
+	{
+		m_nodeDenseIndices.push_back(denseIndex);
+		m_nodeEntities.push_back(entity);
+		m_parentNodeIndices.push_back(parentNodeIndex);
+	}
+
+	void UpdateNodes(std::span<const NodeIndex> nodes, std::vector<Transform>& transforms) const
+	{
+		// The first level only has roots. Build them by the batch kernel if Transform provides one.
+		if constexpr (requires(std::span<Transform* const> batch) { Transform::BuildBatch(batch); })
+		{
+			if (INVALID_NODE_INDEX == m_parentNodeIndices[nodes.front()])
+			{
+				constexpr size_t BatchCount = 256;
+				Transform* batch[BatchCount];
+				for (size_t batchBegin = 0; batchBegin < nodes.size(); batchBegin += BatchCount)
+				{
+					size_t batchCount = std::min(BatchCount, nodes.size() - batchBegin);
+					for (size_t batchIndex = 0; batchIndex < batchCount; ++batchIndex)
+					{
+						batch[batchIndex] = &transforms[m_nodeDenseIndices[nodes[batchBegin + batchIndex]]];
+					}
+					Transform::BuildBatch(std::span<Transform* const>(batch, batchCount));
+				}
+				return;
+			}
+		}
+
+		for (NodeIndex nodeIndex : nodes)
+		{
+			Transform& transform = transforms[m_nodeDenseIndices[nodeIndex]];
+			NodeIndex parentNodeIndex = m_parentNodeIndices[nodeIndex];
+			if (INVALID_NODE_INDEX == parentNodeIndex)
+			{
+				// A root may have been a child before, so its world matrix is always rebuilt.
+				transform.Dirty();
+				transform.Build();
+			}
+			else
+			{
+				transform.Build(transforms[m_nodeDenseIndices[parentNodeIndex]].GetWorldMatrix());
+			}
+		}
+	}
+
+	void UpdateLevel(std::span<const NodeIndex> nodes, std::vector<Transform>& transforms, ThreadPool* pThreadPool) const
+	{
+		if (!pThreadPool || nodes.size() <= TaskNodeCount)
+		{
+			UpdateNodes(nodes, transforms);
+			return;
+		}
+
+		// The calling thread takes the first chunk and helps with the others until the level finishes.
+		size_t taskCount = (nodes.size() + TaskNodeCount - 1) / TaskNodeCount;
+		std::atomic<size_t> finishedTaskCount = 0;
+		for (size_t taskIndex = 1; taskIndex < taskCount; ++taskIndex)
+		{
+			pThreadPool->Submit([this, nodes, &transforms, &finishedTaskCount, taskIndex]()
+			{
+				UpdateNodes(nodes.subspan(taskIndex * TaskNodeCount, std::min(TaskNodeCount, nodes.size() - taskIndex * TaskNodeCount)), transforms);
+				finishedTaskCount.fetch_add(1, std::memory_order_release);
+			});
+		}
+
+		UpdateNodes(nodes.first(TaskNodeCount), transforms);
+		while (finishedTaskCount.load(std::memory_order_acquire) < taskCount - 1)
+		{
+			if (!pThreadPool->TryRunTask())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+private:
+	// Nodes in breadth-first order.
+	std::vector<uint32_t> m_nodeDenseIndices;
+	std::vector<Entity> m_nodeEntities;
+	std::vector<NodeIndex> m_parentNodeIndices;
+	// Children of node i are [m_firstChildIndices[i], m_firstChildIndices[i + 1]). The last element is the node count.
+	std::vector<NodeIndex> m_firstChildIndices;
+	// Level i is [m_levelOffsets[i], m_levelOffsets[i + 1]).
+	std::vector<NodeIndex> m_levelOffsets;
+	std::vector<NodeIndex> m_entityNodeIndices;
+
+	uint32_t m_transformLayoutVersion = static_cast<uint32_t>(-1);
+	ChangeTick m_lastUpdateTick = 0;
+	std::vector<NodeIndex> m_updatedNodes;
+
+	// Scratch buffers which are reused between updates.
+	std::vector<uint32_t> m_parentDenseIndices;
+	std::vector<uint32_t> m_childOffsets;
+	std::vector<uint32_t> m_childCursors;
+	std::vector<uint32_t> m_children;
+	std::vector<NodeIndex> m_changedNodes;
+	std::vector<NodeIndex> m_levelNodes;
+	std::vector<NodeIndex> m_nextLevelNodes;
+	std::vector<uint8_t> m_isNodeDirty;
+};
+
+}
\ No newline at end of file
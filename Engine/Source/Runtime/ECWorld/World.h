@@ -1,18 +1,30 @@
 #pragma once
 
 #include "AllComponentsHeader.h"
+#include "ArchetypeStorage.hpp"
+#include "ComponentSignature.hpp"
 #include "ComponentsStorage.hpp"
+#include "ComponentTypeIndex.hpp"
+#include "ComponentsView.hpp"
 #include "Entity.h"
+#include "EntityAllocator.hpp"
+#include "EntityCommandBuffer.hpp"
+#include "SystemScheduler.hpp"
 #include "Core/StringCrc.h"
 
-#include <atomic>
+#include <bit>
 #include <cassert>
 #include <memory>
+#include <mutex>
+#include <span>
+#include <string>
 #include <vector>
 
 namespace engine
 {
 
+class WorldSnapshot;
+
 // World is an area used to store and manage Entities, Components in the engine runtime.
 // Usually, there is only one world shared between multiple threads.
 class World
@@ -21,46 +33,286 @@ public:
 	World() = default;
 	World(const World&) = delete;
 	World& operator=(const World&) = delete;
-	World(World&&) = default;
-	World& operator=(World&&) = default;
+	World(World&&) = delete;
+	World& operator=(World&&) = delete;
 	~World() = default;
 
-	Entity CreateEntity()
+	// Entity handles are allocated per World. It is thread safe.
+	Entity CreateEntity() { return m_entityAllocator.Allocate(); }
+
+	// Allocate a batch of entities with only one lock. Prefer it when creating lots of entities in parallel.
+	std::vector<Entity> CreateEntities(size_t count)
+	{
+		std::vector<Entity> entities(count);
+		m_entityAllocator.Allocate(entities);
+		return entities;
+	}
+
+	void CreateEntities(std::span<Entity> outEntities) { m_entityAllocator.Allocate(outEntities); }
+
+	// Returns false if the entity is destroyed or the handle is stale.
+	bool IsValid(Entity entity) const { return m_entityAllocator.IsAlive(entity); }
+
+	size_t GetEntityCount() const { return m_entityAllocator.GetAliveCount(); }
+
+	// Remove all components of the entity and recycle its index. Handles to it become stale.
+	// Only storages in the entity's signature are visited.
+	void DestroyEntity(Entity entity)
+	{
+		if (!m_entityAllocator.IsAlive(entity))
+		{
+			return;
+		}
+
+		ComponentSignature signature = m_entitySignatures.Get(entity);
+		while (signature != 0)
+		{
+			TypeIndex componentIndex = static_cast<TypeIndex>(std::countr_zero(signature));
+			signature &= signature - 1;
+			m_componentsStorages[componentIndex]->RemoveComponent(entity);
+		}
+		assert(0 == m_entitySignatures.Get(entity));
+
+		m_archetypeStorage.RemoveEntity(entity);
+		m_entityAllocator.Free(entity);
+	}
+
+	void DestroyEntities(std::span<const Entity> entities)
 	{
-		// Overflow is expected as I want to use the max value of EntityID as invalid value.
-		// So I allocate entity id from 0.
-		static std::atomic<Entity> nextEntity = INVALID_ENTITY + 1;
-		return nextEntity.fetch_add(1);
+		for (Entity entity : entities)
+		{
+			DestroyEntity(entity);
+		}
+	}
+
+	// Returns true if the entity has all Components. It is one bitwise test of the entity signature.
+	template<typename... Components>
+	bool Has(Entity entity) const
+	{
+		return m_entityAllocator.IsAlive(entity) && m_entitySignatures.Contains(entity, GetComponentSignature<Components...>());
+	}
+
+	// Returns true if the entity has any of Components.
+	template<typename... Components>
+	bool HasAny(Entity entity) const
+	{
+		return m_entityAllocator.IsAlive(entity) && m_entitySignatures.ContainsAny(entity, GetComponentSignature<Components...>());
+	}
+
+	ComponentSignature GetSignature(Entity entity) const { return m_entityAllocator.IsAlive(entity) ? m_entitySignatures.Get(entity) : 0; }
+
+	// Components created or modified are stamped with the current tick. Advance it once per frame.
+	ChangeTick GetChangeTick() const { return m_changeTick; }
+	ChangeTick IncrementChangeTick()
+	{
+		++m_changeTick;
+		for (std::unique_ptr<IComponentsStorage>& pStorage : m_componentsStorages)
+		{
+			if (pStorage)
+			{
+				pStorage->SetCurrentTick(m_changeTick);
+			}
+		}
+		return m_changeTick;
+	}
+
+	// Compact storages by at most budget steps in total, such as every frame after destroying lots of entities.
+	// Storages are visited in turn so that the budget is shared fairly. Returns true when all storages are compacted.
+	// Sorting moves components which invalidates dense indices cached by others, such as TransformHierarchy.
+	// So only storages whose ratio of unsorted components reaches minUnsortedRatio are sorted, until they are sorted.
+	bool Compact(size_t budget, bool sortByEntity = false, float minUnsortedRatio = 0.0f)
+	{
+		size_t compactedCount = 0;
+		while (compactedCount < m_componentsStorages.size() && budget > 0)
+		{
+			m_compactStorageIndex = m_compactStorageIndex % m_componentsStorages.size();
+			std::unique_ptr<IComponentsStorage>& pStorage = m_componentsStorages[m_compactStorageIndex];
+			bool isSortNeeded = false;
+			if (pStorage && sortByEntity)
+			{
+				ComponentsStorageStats stats = pStorage->GetStats();
+				isSortNeeded = !stats.isSorted && static_cast<float>(stats.unsortedCount) >= minUnsortedRatio * static_cast<float>(stats.count);
+			}
+
+			if (!pStorage || pStorage->Compact(budget, isSortNeeded))
+			{
+				++compactedCount;
+				++m_compactStorageIndex;
+			}
+			else
+			{
+				compactedCount = 0;
+			}
+		}
+
+		return compactedCount == m_componentsStorages.size();
+	}
+
+	// Returns the command buffer in the slot, which is created on demand. It is thread safe.
+	// Use one slot per thread or task, such as the thread index, to record commands without locks.
+	EntityCommandBuffer& GetCommandBuffer(size_t slot)
+	{
+		std::lock_guard<std::mutex> lock(m_commandBuffersMutex);
+		while (slot >= m_commandBuffers.size())
+		{
+			m_commandBuffers.emplace_back(std::make_unique<EntityCommandBuffer>(&m_entityAllocator));
+		}
+		return *m_commandBuffers[slot];
+	}
+
+	// Apply all recorded commands at a sync point when no thread is recording.
+	// Buffers are applied in slot order and commands in recorded order, so the result is deterministic.
+	void Flush()
+	{
+		for (std::unique_ptr<EntityCommandBuffer>& pCommandBuffer : m_commandBuffers)
+		{
+			for (const EntityCommandBuffer::Command& command : pCommandBuffer->GetCommands())
+			{
+				if (!m_entityAllocator.IsAlive(command.entity))
+				{
+					continue;
+				}
+
+				if (EntityCommandBuffer::CommandType::DestroyEntity == command.type)
+				{
+					DestroyEntity(command.entity);
+					continue;
+				}
+
+				assert(command.componentIndex < m_componentsStorages.size() && m_componentsStorages[command.componentIndex] && "Component storage is not registered.");
+				command.pApply(m_componentsStorages[command.componentIndex].get(), command.entity, command.pPayload);
+			}
+
+			pCommandBuffer->Clear();
+		}
 	}
 
+	// Optional storage mode which groups entities by component set in SoA chunks. Prefer it for hot component combinations
+	// iterated every frame. A component type of an entity should live in either ComponentsStorage or ArchetypeStorage.
+	ArchetypeStorage& GetArchetypeStorage() { return m_archetypeStorage; }
+	const ArchetypeStorage& GetArchetypeStorage() const { return m_archetypeStorage; }
+
+	// Storages are addressed by the component type index directly, so there is no hashing or probing per call.
+	// Create and remove components at sync points, or record them to command buffers, as entity signatures are shared by all storages.
 	template<typename Component>
 	ComponentsStorage<Component>* Register()
 	{
-		StringCrc componentName = Component::GetClassName();
-		assert(!m_componentsLib.contains(componentName.Value()));
-		m_componentsLib[componentName.Value()] = std::make_unique<ComponentsStorage<Component>>();
-		return static_cast<ComponentsStorage<Component>*>(m_componentsLib[componentName.Value()].get());
+		TypeIndex componentIndex = GetComponentTypeIndex<Component>();
+		assert(componentIndex < MaxSignatureComponentCount && "Too many component types for the signature.");
+		if (componentIndex >= m_componentsStorages.size())
+		{
+			m_componentsStorages.resize(componentIndex + 1);
+		}
+
+		assert(!m_componentsStorages[componentIndex]);
+		auto pStorage = std::make_unique<ComponentsStorage<Component>>();
+		pStorage->SetCurrentTick(m_changeTick);
+
+		// Bound before any query so that signatures are up to date when queries are notified.
+		pStorage->OnComponentCreated.template Bind<World, &World::OnComponentCreated<Component>>(this);
+		pStorage->OnComponentRemoved.template Bind<World, &World::OnComponentRemoved<Component>>(this);
+
+		m_componentsStorages[componentIndex] = std::move(pStorage);
+		return static_cast<ComponentsStorage<Component>*>(m_componentsStorages[componentIndex].get());
+	}
+
+	template<typename Component>
+	bool IsRegistered() const
+	{
+		TypeIndex componentIndex = GetComponentTypeIndex<Component>();
+		return componentIndex < m_componentsStorages.size() && m_componentsStorages[componentIndex];
 	}
 
 	template<typename Component>
 	ComponentsStorage<Component>* GetComponents()
 	{
-		StringCrc componentName = Component::GetClassName();
-		assert(m_componentsLib.contains(componentName.Value()));
-		return static_cast<ComponentsStorage<Component>*>(m_componentsLib[componentName.Value()].get());
+		assert(IsRegistered<Component>());
+		return static_cast<ComponentsStorage<Component>*>(m_componentsStorages[GetComponentTypeIndex<Component>()].get());
+	}
+
+	template<typename Component>
+	const ComponentsStorage<Component>* GetComponents() const
+	{
+		assert(IsRegistered<Component>());
+		return static_cast<const ComponentsStorage<Component>*>(m_componentsStorages[GetComponentTypeIndex<Component>()].get());
 	}
 
 	template<typename Component>
 	Component& CreateComponent(Entity entity)
 	{
-		StringCrc componentName = Component::GetClassName();
-		assert(m_componentsLib.contains(componentName.Value()));
-		ComponentsStorage<Component>* pStorage = static_cast<ComponentsStorage<Component>*>(m_componentsLib[componentName.Value()].get());
-		return pStorage->CreateComponent(entity);
+		return GetComponents<Component>()->CreateComponent(entity);
 	}
 
+	// Query entities which contain all Components and none of Excludes components. Component storages should be registered.
+	// The matching set is cached in the World and updated incrementally when related components are created or removed.
+	// So walking a view each frame is linear in the count of matched entities.
+	template<typename... Components, typename... Excludes>
+	ComponentsView<Components...> View(Without<Excludes...> = {})
+	{
+		using Query = EntityQuery<std::tuple<Components...>, std::tuple<Excludes...>>;
+
+		// Every query type has its own index too.
+		TypeIndex queryIndex = TypeIndexer<IEntityQuery>::Get<Query>();
+		if (queryIndex >= m_entityQueries.size())
+		{
+			m_entityQueries.resize(queryIndex + 1);
+		}
+
+		std::unique_ptr<IEntityQuery>& pEntityQuery = m_entityQueries[queryIndex];
+		if (!pEntityQuery)
+		{
+			pEntityQuery = std::make_unique<Query>(&m_entitySignatures, GetComponents<Components>()..., GetComponents<Excludes>()...);
+		}
+
+		const Query* pQuery = static_cast<const Query*>(pEntityQuery.get());
+		return ComponentsView<Components...>(pQuery->GetEntities(), pQuery->GetIncludeStorages());
+	}
+
+	// Register a system which is called every frame by UpdateSystems. Declare all component types it accesses
+	// so that systems which don't conflict can run concurrently. Storages of these components should be registered.
+	template<typename... ReadComponents, typename... WriteComponents>
+	void AddSystem(std::string name, Reads<ReadComponents...>, Writes<WriteComponents...>, SystemScheduler::SystemFunction function)
+	{
+		assert((IsRegistered<ReadComponents>() && ...));
+		assert((IsRegistered<WriteComponents>() && ...));
+		m_systemScheduler.AddSystem(std::move(name), { GetComponentTypeIndex<ReadComponents>()... }, { GetComponentTypeIndex<WriteComponents>()... }, std::move(function));
+	}
+
+	void SetSystemEnabled(const std::string& name, bool enabled) { m_systemScheduler.SetSystemEnabled(name, enabled); }
+
+	// Run all enabled systems. They run on the calling thread one by one if there is no ThreadPool.
+	void UpdateSystems(float deltaTime, ThreadPool* pThreadPool = nullptr)
+	{
+		m_pSystemThreadPool = pThreadPool;
+		m_systemScheduler.Run(*this, deltaTime, pThreadPool);
+		m_pSystemThreadPool = nullptr;
+	}
+
+	// The ThreadPool which runs systems now. Systems can split their own work into tasks on it. Null outside UpdateSystems.
+	ThreadPool* GetSystemThreadPool() const { return m_pSystemThreadPool; }
+
+private:
+	friend class WorldSnapshot;
+
+	template<typename Component>
+	void OnComponentCreated(Entity entity) { m_entitySignatures.Add(entity, GetComponentTypeIndex<Component>()); }
+
+	template<typename Component>
+	void OnComponentRemoved(Entity entity) { m_entitySignatures.Remove(entity, GetComponentTypeIndex<Component>()); }
+
 private:
-	std::unordered_map<size_t, std::unique_ptr<IComponentsStorage>> m_componentsLib;
+	EntityAllocator m_entityAllocator;
+	ArchetypeStorage m_archetypeStorage;
+	std::vector<std::unique_ptr<IComponentsStorage>> m_componentsStorages;
+	EntitySignatures m_entitySignatures;
+	std::vector<std::unique_ptr<IEntityQuery>> m_entityQueries;
+	SystemScheduler m_systemScheduler;
+	ThreadPool* m_pSystemThreadPool = nullptr;
+	ChangeTick m_changeTick = 1;
+	size_t m_compactStorageIndex = 0;
+
+	std::mutex m_commandBuffersMutex;
+	std::vector<std::unique_ptr<EntityCommandBuffer>> m_commandBuffers;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,305 @@
+#pragma once
+
+#include "ComponentsStorage.hpp"
+#include "Core/IO/MappedFile.hpp"
+#include "Entity.h"
+#include "World.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace engine
+{
+
+// WorldSnapshot saves entities and components of a World to a binary file and loads them back without parsing.
+// Only storages of trivially copyable components are written, as raw column blocks. Storages of other components,
+// such as meshes and materials which own GPU resources, are skipped and stay empty after loading. Their producers need to rebuild them.
+// Save and Load fail if any storage is skipped, unless the caller passes pSkippedComponentNames to receive names of skipped storages.
+// Layout : Header | StorageHeader * storageCount | blocks aligned to BlockAlignment. Values are in native little endian.
+class WorldSnapshot final
+{
+public:
+	static constexpr uint32_t Magic = 0x53574443; // "CDWS"
+	static constexpr uint32_t Version = 1;
+	static constexpr uint64_t BlockAlignment = 64;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t storageCount;
+		uint32_t entityVersionCount;
+		uint32_t freeIndexCount;
+		uint32_t reserved;
+		uint64_t entityVersionsOffset;
+		uint64_t freeIndexesOffset;
+	};
+
+	// The schema of a component storage. Loading fails if a registered component has a different layout now.
+	struct StorageHeader
+	{
+		uint32_t componentName;
+		uint32_t componentSize;
+		uint32_t componentAlignment;
+		uint32_t count;
+		uint64_t entitiesOffset;
+		uint64_t componentsOffset;
+	};
+
+public:
+	WorldSnapshot() = delete;
+
+	// Save at a sync point when no thread is modifying the World.
+	static bool Save(const World& world, const char* pFilePath, std::vector<uint32_t>* pSkippedComponentNames = nullptr)
+	{
+		std::vector<ComponentsColumns> allColumns;
+		std::vector<uint32_t> skippedComponentNames;
+		for (const std::unique_ptr<IComponentsStorage>& pStorage : world.m_componentsStorages)
+		{
+			ComponentsColumns columns;
+			if (!pStorage)
+			{
+				continue;
+			}
+
+			if (pStorage->GetColumns(columns))
+			{
+				allColumns.push_back(columns);
+			}
+			else
+			{
+				skippedComponentNames.push_back(columns.componentName);
+			}
+		}
+
+		if (!ReportSkippedStorages(skippedComponentNames, pSkippedComponentNames))
+		{
+			return false;
+		}
+
+		std::span<const EntityVersion> entityVersions = world.m_entityAllocator.GetVersions();
+		std::span<const EntityIndex> freeIndexes = world.m_entityAllocator.GetFreeIndexes();
+
+		// Lay out all blocks first so that the file is written in one pass.
+		Header header{};
+		header.magic = Magic;
+		header.version = Version;
+		header.storageCount = static_cast<uint32_t>(allColumns.size());
+		header.entityVersionCount = static_cast<uint32_t>(entityVersions.size());
+		header.freeIndexCount = static_cast<uint32_t>(freeIndexes.size());
+
+		uint64_t fileSize = sizeof(Header) + sizeof(StorageHeader) * allColumns.size();
+		header.entityVersionsOffset = AllocateBlock(fileSize, entityVersions.size_bytes());
+		header.freeIndexesOffset = AllocateBlock(fileSize, freeIndexes.size_bytes());
+
+		std::vector<StorageHeader> storageHeaders(allColumns.size());
+		for (size_t storageIndex = 0; storageIndex < allColumns.size(); ++storageIndex)
+		{
+			const ComponentsColumns& columns = allColumns[storageIndex];
+			StorageHeader& storageHeader = storageHeaders[storageIndex];
+			storageHeader.componentName = columns.componentName;
+			storageHeader.componentSize = columns.componentSize;
+			storageHeader.componentAlignment = columns.componentAlignment;
+			storageHeader.count = static_cast<uint32_t>(columns.entities.size());
+			storageHeader.entitiesOffset = AllocateBlock(fileSize, columns.entities.size_bytes());
+			storageHeader.componentsOffset = AllocateBlock(fileSize, static_cast<uint64_t>(columns.componentSize) * columns.entities.size());
+		}
+
+		std::ofstream fout(pFilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!fout.is_open())
+		{
+			return false;
+		}
+
+		uint64_t writeOffset = 0;
+		WriteBlock(fout, writeOffset, 0, &header, sizeof(Header));
+		WriteBlock(fout, writeOffset, writeOffset, storageHeaders.data(), sizeof(StorageHeader) * storageHeaders.size());
+		WriteBlock(fout, writeOffset, header.entityVersionsOffset, entityVersions.data(), entityVersions.size_bytes());
+		WriteBlock(fout, writeOffset, header.freeIndexesOffset, freeIndexes.data(), freeIndexes.size_bytes());
+		for (size_t storageIndex = 0; storageIndex < allColumns.size(); ++storageIndex)
+		{
+			const ComponentsColumns& columns = allColumns[storageIndex];
+			const StorageHeader& storageHeader = storageHeaders[storageIndex];
+			WriteBlock(fout, writeOffset, storageHeader.entitiesOffset, columns.entities.data(), columns.entities.size_bytes());
+			WriteBlock(fout, writeOffset, storageHeader.componentsOffset, columns.pComponents, static_cast<size_t>(storageHeader.componentSize) * storageHeader.count);
+		}
+
+		return fout.good();
+	}
+
+	// Map the file and copy column blocks into storages directly.
+	static bool Load(World& world, const char* pFilePath, std::vector<uint32_t>* pSkippedComponentNames = nullptr)
+	{
+		MappedFile mappedFile;
+		if (!mappedFile.Open(pFilePath))
+		{
+			return false;
+		}
+
+		return Load(world, mappedFile.GetBytes(), pSkippedComponentNames);
+	}
+
+	// The World should be empty with component storages registered.
+	// Skipped storages are registered storages which don't support snapshots and saved storages which are not registered now.
+	// Nothing is changed if the snapshot is invalid, its schema doesn't match or storages are skipped without pSkippedComponentNames.
+	static bool Load(World& world, std::span<const std::byte> bytes, std::vector<uint32_t>* pSkippedComponentNames = nullptr)
+	{
+		if (world.m_entityAllocator.GetIndexCount() > 0 || bytes.size() < sizeof(Header))
+		{
+			return false;
+		}
+
+		Header header;
+		std::memcpy(&header, bytes.data(), sizeof(Header));
+		if (header.magic != Magic || header.version != Version ||
+			!IsValidBlock(bytes, sizeof(Header), sizeof(StorageHeader) * static_cast<uint64_t>(header.storageCount), alignof(StorageHeader)) ||
+			!IsValidBlock(bytes, header.entityVersionsOffset, sizeof(EntityVersion) * static_cast<uint64_t>(header.entityVersionCount), alignof(EntityVersion)) ||
+			!IsValidBlock(bytes, header.freeIndexesOffset, sizeof(EntityIndex) * static_cast<uint64_t>(header.freeIndexCount), alignof(EntityIndex)))
+		{
+			return false;
+		}
+
+		std::span<const StorageHeader> storageHeaders(reinterpret_cast<const StorageHeader*>(bytes.data() + sizeof(Header)), header.storageCount);
+		std::span<const EntityVersion> entityVersions(reinterpret_cast<const EntityVersion*>(bytes.data() + header.entityVersionsOffset), header.entityVersionCount);
+		std::span<const EntityIndex> freeIndexes(reinterpret_cast<const EntityIndex*>(bytes.data() + header.freeIndexesOffset), header.freeIndexCount);
+
+		// Validate all blocks before changing the World.
+		// Free indexes should be in range and unique. Every index is marked as free or by the last storage which lists it.
+		constexpr uint32_t FreeIndexMark = UINT32_MAX;
+		std::vector<uint32_t> indexMarks(entityVersions.size(), 0);
+		for (EntityIndex freeIndex : freeIndexes)
+		{
+			if (freeIndex >= indexMarks.size() || FreeIndexMark == indexMarks[freeIndex])
+			{
+				return false;
+			}
+			indexMarks[freeIndex] = FreeIndexMark;
+		}
+
+		std::vector<IComponentsStorage*> targetStorages(storageHeaders.size(), nullptr);
+		std::vector<uint32_t> skippedComponentNames;
+		for (const std::unique_ptr<IComponentsStorage>& pStorage : world.m_componentsStorages)
+		{
+			ComponentsColumns columns;
+			if (pStorage && !pStorage->GetColumns(columns))
+			{
+				skippedComponentNames.push_back(columns.componentName);
+			}
+		}
+
+		for (size_t storageIndex = 0; storageIndex < storageHeaders.size(); ++storageIndex)
+		{
+			const StorageHeader& storageHeader = storageHeaders[storageIndex];
+			if (!IsValidBlock(bytes, storageHeader.entitiesOffset, sizeof(Entity) * static_cast<uint64_t>(storageHeader.count), alignof(Entity)) ||
+				!IsValidBlock(bytes, storageHeader.componentsOffset, static_cast<uint64_t>(storageHeader.componentSize) * storageHeader.count, storageHeader.componentAlignment))
+			{
+				return false;
+			}
+
+			// Every entity with components should be alive in the saved allocator and listed once by a storage.
+			const uint32_t storageMark = static_cast<uint32_t>(storageIndex) + 1;
+			const Entity* pEntities = reinterpret_cast<const Entity*>(bytes.data() + storageHeader.entitiesOffset);
+			for (uint32_t entityIndex = 0; entityIndex < storageHeader.count; ++entityIndex)
+			{
+				Entity entity = pEntities[entityIndex];
+				EntityIndex index = GetEntityIndex(entity);
+				if (index >= entityVersions.size() || entityVersions[index] != GetEntityVersion(entity) ||
+					FreeIndexMark == indexMarks[index] || storageMark == indexMarks[index])
+				{
+					return false;
+				}
+				indexMarks[index] = storageMark;
+			}
+
+			for (const std::unique_ptr<IComponentsStorage>& pStorage : world.m_componentsStorages)
+			{
+				ComponentsColumns columns;
+				if (!pStorage || !pStorage->GetColumns(columns) || columns.componentName != storageHeader.componentName)
+				{
+					continue;
+				}
+
+				if (columns.componentSize != storageHeader.componentSize || columns.componentAlignment != storageHeader.componentAlignment ||
+					!columns.entities.empty())
+				{
+					return false;
+				}
+
+				targetStorages[storageIndex] = pStorage.get();
+				break;
+			}
+
+			if (!targetStorages[storageIndex])
+			{
+				skippedComponentNames.push_back(storageHeader.componentName);
+			}
+		}
+
+		if (!ReportSkippedStorages(skippedComponentNames, pSkippedComponentNames))
+		{
+			return false;
+		}
+
+		world.m_entityAllocator.Restore(entityVersions, freeIndexes);
+
+		for (size_t storageIndex = 0; storageIndex < storageHeaders.size(); ++storageIndex)
+		{
+			IComponentsStorage* pStorage = targetStorages[storageIndex];
+			if (!pStorage)
+			{
+				continue;
+			}
+
+			const StorageHeader& storageHeader = storageHeaders[storageIndex];
+			ComponentsColumns columns;
+			columns.componentName = storageHeader.componentName;
+			columns.componentSize = storageHeader.componentSize;
+			columns.componentAlignment = storageHeader.componentAlignment;
+			columns.entities = std::span<const Entity>(reinterpret_cast<const Entity*>(bytes.data() + storageHeader.entitiesOffset), storageHeader.count);
+			columns.pComponents = bytes.data() + storageHeader.componentsOffset;
+			pStorage->LoadColumns(columns);
+		}
+
+		return true;
+	}
+
+private:
+	static bool ReportSkippedStorages(std::vector<uint32_t>& skippedComponentNames, std::vector<uint32_t>* pSkippedComponentNames)
+	{
+		if (!pSkippedComponentNames)
+		{
+			return skippedComponentNames.empty();
+		}
+
+		*pSkippedComponentNames = std::move(skippedComponentNames);
+		return true;
+	}
+
+	static uint64_t AllocateBlock(uint64_t& fileSize, uint64_t blockSize)
+	{
+		uint64_t offset = (fileSize + BlockAlignment - 1) & ~(BlockAlignment - 1);
+		fileSize = offset + blockSize;
+		return offset;
+	}
+
+	static void WriteBlock(std::ofstream& fout, uint64_t& writeOffset, uint64_t blockOffset, const void* pData, size_t size)
+	{
+		// Zero padding to the aligned offset.
+		constexpr char padding[BlockAlignment] = {};
+		fout.write(padding, static_cast<std::streamsize>(blockOffset - writeOffset));
+		fout.write(static_cast<const char*>(pData), static_cast<std::streamsize>(size));
+		writeOffset = blockOffset + size;
+	}
+
+	static bool IsValidBlock(std::span<const std::byte> bytes, uint64_t offset, uint64_t size, uint64_t alignment)
+	{
+		return alignment > 0 && offset % alignment == 0 && offset <= bytes.size() && size <= bytes.size() - offset;
+	}
+};
+
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Core/StringCrc.h"
 #include "Material/ShaderSchema.h"
+#include "Rendering/VertexCompression.hpp"
 #include "Scene/VertexFormat.h"
 #include "Scene/MaterialTextureType.h"
 
@@ -32,8 +33,14 @@ public:
 	const ShaderSchema& GetShaderSchema() const { return m_shaderSchema; }
 	void SetShaderSchema(ShaderSchema shaderSchema) { m_shaderSchema = cd::MoveTemp(shaderSchema); }
 
-	void SetRequiredVertexFormat(cd::VertexFormat vertexFormat) { m_requiredVertexFormat = cd::MoveTemp(vertexFormat); }
+	// Vertex format lists attributes which shaders read. Compression tells which of them are stored in packed formats.
+	void SetRequiredVertexFormat(cd::VertexFormat vertexFormat, VertexCompression vertexCompression = VertexCompression::None)
+	{
+		m_requiredVertexFormat = cd::MoveTemp(vertexFormat);
+		m_vertexCompression = vertexCompression;
+	}
 	const cd::VertexFormat& GetRequiredVertexFormat() const { return m_requiredVertexFormat; }
+	VertexCompression GetVertexCompression() const { return m_vertexCompression; }
 
 	void AddOptionalTextureType(cd::MaterialTextureType textureType, uint8_t slot);
 	const std::set<cd::MaterialTextureType>& GetOptionalTextureTypes() const { return m_optionalTextureTypes; }
@@ -48,6 +55,7 @@ private:
 	ShaderSchema m_shaderSchema;
 
 	cd::VertexFormat m_requiredVertexFormat;
+	VertexCompression m_vertexCompression = VertexCompression::None;
 	std::set<cd::MaterialTextureType> m_optionalTextureTypes;
 	std::set<cd::MaterialTextureType> m_requiredTextureTypes;
 	std::map<cd::MaterialTextureType, uint8_t> m_textureTypeSlots;
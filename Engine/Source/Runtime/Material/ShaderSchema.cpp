@@ -129,6 +129,18 @@ uint16_t ShaderSchema::GetCompiledProgram(StringCrc uberOption) const
 	return programHandle;
 }
 
+void ShaderSchema::SetCompiledInstanceProgram(StringCrc uberOption, uint16_t programHandle)
+{
+	assert(IsUberOptionValid(uberOption));
+	m_compiledInstanceProgramHandles[uberOption.Value()] = programHandle;
+}
+
+uint16_t ShaderSchema::GetCompiledInstanceProgram(StringCrc uberOption) const
+{
+	auto itProgram = m_compiledInstanceProgramHandles.find(uberOption.Value());
+	return itProgram != m_compiledInstanceProgramHandles.end() ? itProgram->second : InvalidProgramHandle;
+}
+
 StringCrc ShaderSchema::GetProgramCrc(const std::vector<Uber>& options) const
 {
 	if (options.empty())
@@ -164,6 +176,16 @@ void ShaderSchema::AddUberOptionVSBlob(ShaderBlob shaderBlob)
 	m_pVSBlob = std::make_unique<ShaderBlob>(cd::MoveTemp(shaderBlob));
 }
 
+void ShaderSchema::AddInstanceVSBlob(ShaderBlob shaderBlob)
+{
+	if (m_pInstanceVSBlob)
+	{
+		return;
+	}
+
+	m_pInstanceVSBlob = std::make_unique<ShaderBlob>(cd::MoveTemp(shaderBlob));
+}
+
 void ShaderSchema::AddUberOptionFSBlob(StringCrc uberOption, ShaderBlob shaderBlob)
 {
 	if (m_uberOptionToFSBlobs.contains(uberOption.Value()))
@@ -69,6 +69,15 @@ public:
 	void SetCompiledProgram(StringCrc uberOption, uint16_t programHandle);
 	uint16_t GetCompiledProgram(StringCrc uberOption) const;
 
+	// Optional vertex shader which reads world matrices from instance data. It is linked with fragment shaders of all options.
+	void SetInstanceVertexShaderPath(std::string vsPath) { m_instanceVertexShaderPath = cd::MoveTemp(vsPath); }
+	const char* GetInstanceVertexShaderPath() const { return m_instanceVertexShaderPath.c_str(); }
+	bool HasInstanceVertexShader() const { return !m_instanceVertexShaderPath.empty(); }
+
+	void SetCompiledInstanceProgram(StringCrc uberOption, uint16_t programHandle);
+	// Returns InvalidProgramHandle if the option doesn't have a compiled instance program.
+	uint16_t GetCompiledInstanceProgram(StringCrc uberOption) const;
+
 	const std::vector<Uber>& GetUberOptions() const { return m_uberOptions; }
 	const std::vector<std::string>& GetUberCombines() const { return m_uberCombines; }
 	const std::map<uint32_t, uint16_t>& GetUberPrograms() const { return m_compiledProgramHandles; }
@@ -78,11 +87,14 @@ public:
 	void AddUberOptionVSBlob(ShaderBlob shaderBlob);
 	void AddUberOptionFSBlob(StringCrc uberOption, ShaderBlob shaderBlob);
 	const ShaderBlob& GetVSBlob() const { return *m_pVSBlob.get(); }
+	void AddInstanceVSBlob(ShaderBlob shaderBlob);
+	const ShaderBlob& GetInstanceVSBlob() const { return *m_pInstanceVSBlob.get(); }
 	const ShaderBlob& GetFSBlob(StringCrc uberOption) const;
 
 private:
 	std::string m_vertexShaderPath;
 	std::string m_fragmentShaderPath;
+	std::string m_instanceVertexShaderPath;
 
 	// Registration order of options. 
 	std::vector<Uber> m_uberOptions;
@@ -90,10 +102,13 @@ private:
 	std::vector<std::string> m_uberCombines;
 	// Key: StringCrc(option combine), Value: shader handle.
 	std::map<uint32_t, uint16_t> m_compiledProgramHandles;
+	// Key: StringCrc(option combine), Value: instance shader handle.
+	std::map<uint32_t, uint16_t> m_compiledInstanceProgramHandles;
 	// Key: LoadingStatus, Value: fragment shader path.
 	std::map<LoadingStatus, std::string> m_loadingStatusFSPath;
 
 	std::unique_ptr<ShaderBlob> m_pVSBlob;
+	std::unique_ptr<ShaderBlob> m_pInstanceVSBlob;
 	std::map<uint32_t, std::unique_ptr<ShaderBlob>> m_uberOptionToFSBlobs;
 };
 
@@ -1,6 +1,7 @@
 #include "AnimationRenderer.h"
 
 #include "Core/StringCrc.h"
+#include "ECWorld/AnimationComponent.h"
 #include "ECWorld/SceneWorld.h"
 #include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/TransformComponent.h"
@@ -121,8 +122,9 @@ void AnimationRenderer::Init()
 #else
 	m_pRenderContext->CreateProgram("AnimationProgram", "vs_animation.bin", "fs_animation.bin");
 #endif
+	m_pRenderContext->CreateUniform("u_positionDequantize", bgfx::UniformType::Vec4, 2);
 
-	bgfx::setViewName(GetViewID(), "AnimationRenderer");
+	SetViewName("AnimationRenderer");
 }
 
 void AnimationRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
@@ -130,6 +132,8 @@ void AnimationRenderer::UpdateView(const float* pViewMatrix, const float* pProje
 	bgfx::setViewFrameBuffer(GetViewID(), *GetRenderTarget()->GetFrameBufferHandle());
 	bgfx::setViewRect(GetViewID(), 0, 0, GetRenderTarget()->GetWidth(), GetRenderTarget()->GetHeight());
 	bgfx::setViewTransform(GetViewID(), pViewMatrix, pProjectionMatrix);
+
+	m_frustum = Frustum::FromViewProjection(pViewMatrix, pProjectionMatrix, bgfx::getCaps()->homogeneousDepth);
 }
 
 void AnimationRenderer::Render(float deltaTime)
@@ -150,55 +154,73 @@ void AnimationRenderer::Render(float deltaTime)
 	}
 
 	constexpr StringCrc boneIndexUniform("u_debugBoneIndex");
-	bgfx::setUniform(m_pRenderContext->GetUniform(boneIndexUniform), selectedBoneIndex, 1);
+	const bgfx::UniformHandle boneIndexHandle = m_pRenderContext->GetUniform(boneIndexUniform);
 #endif
 
 	static float animationRunningTime = 0.0f;
 	animationRunningTime += deltaTime;
 
 	const cd::SceneDatabase* pSceneDatabase = m_pCurrentSceneWorld->GetSceneDatabase();
-	for (Entity entity : m_pCurrentSceneWorld->GetAnimationEntities())
+	// Bounds are in bind pose, so that skinned meshes are culled by their rest shape.
+	m_frustumCuller.Clear();
+	for (auto [entity, animationComponent, meshComponent] : m_pCurrentSceneWorld->GetWorld()->View<AnimationComponent, StaticMeshComponent>())
+	{
+		const TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity);
+		m_frustumCuller.Add(entity, meshComponent.GetAABB(), pTransformComponent ? pTransformComponent->GetWorldMatrix() : cd::Matrix4x4::Identity());
+	}
+	m_frustumCuller.Cull(m_frustum, GetThreadPool());
+
+	// Bone matrices are calculated and submitted by chunks of visible meshes on worker threads.
+	constexpr StringCrc animationProgram("AnimationProgram");
+	const bgfx::ProgramHandle programHandle = m_pRenderContext->GetProgram(animationProgram);
+	constexpr StringCrc positionDequantizeUniform("u_positionDequantize");
+	const bgfx::UniformHandle positionDequantizeHandle = m_pRenderContext->GetUniform(positionDequantizeUniform);
+	const std::vector<Entity>& visibleEntities = m_frustumCuller.GetVisibleEntities();
+	SubmitDraws(static_cast<uint32_t>(visibleEntities.size()), [&](bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex)
 	{
-		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-		if (!pMeshComponent)
+		std::vector<cd::Matrix4x4> boneMatrices;
+		for (uint32_t visibleIndex = beginIndex; visibleIndex < endIndex; ++visibleIndex)
 		{
-			continue;
-		}
+			Entity entity = visibleEntities[visibleIndex];
+			const StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
 
-		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
-		{
-			pTransformComponent->Build();
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
-		}
+			if (const TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
+			{
+				// World matrices are built in batches by TransformSystem before rendering.
+				pEncoder->setTransform(pTransformComponent->GetWorldMatrix().Begin());
+			}
 
-		AnimationComponent* pAnimationComponent = m_pCurrentSceneWorld->GetAnimationComponent(entity);
+			const AnimationComponent* pAnimationComponent = m_pCurrentSceneWorld->GetAnimationComponent(entity);
 
-		const cd::Animation* pAnimation = pAnimationComponent->GetAnimationData();
-		float ticksPerSecond = pAnimation->GetTicksPerSecnod();
-		assert(ticksPerSecond > 1.0f);
-		float animationTime = std::fmodf(animationRunningTime * ticksPerSecond, pAnimation->GetDuration());
+			const cd::Animation* pAnimation = pAnimationComponent->GetAnimationData();
+			float ticksPerSecond = pAnimation->GetTicksPerSecnod();
+			assert(ticksPerSecond > 1.0f);
+			float animationTime = std::fmodf(animationRunningTime * ticksPerSecond, pAnimation->GetDuration());
 
-		static std::vector<cd::Matrix4x4> boneMatrices;
-		boneMatrices.clear();
-		for (uint16_t boneIndex = 0; boneIndex < 128; ++boneIndex)
-		{
-			boneMatrices.push_back(cd::Matrix4x4::Identity());
-		}
+			boneMatrices.clear();
+			for (uint16_t boneIndex = 0; boneIndex < 128; ++boneIndex)
+			{
+				boneMatrices.push_back(cd::Matrix4x4::Identity());
+			}
 
-		const cd::Node& rootNode = pSceneDatabase->GetNode(0);
-		const cd::Bone& rootBone = pSceneDatabase->GetBone(0);
-		detail::CalculateBoneTransform(boneMatrices, pSceneDatabase, animationTime, rootBone,
-			cd::Matrix4x4::Identity(), rootNode.GetTransform().GetMatrix().Inverse());
-		bgfx::setUniform(bgfx::UniformHandle(pAnimationComponent->GetBoneMatrixsUniform()), boneMatrices.data(), static_cast<uint16_t>(boneMatrices.size()));
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle(pMeshComponent->GetVertexBuffer()));
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle(pMeshComponent->GetIndexBuffer()));
+			const cd::Node& rootNode = pSceneDatabase->GetNode(0);
+			const cd::Bone& rootBone = pSceneDatabase->GetBone(0);
+			detail::CalculateBoneTransform(boneMatrices, pSceneDatabase, animationTime, rootBone,
+				cd::Matrix4x4::Identity(), rootNode.GetTransform().GetMatrix().Inverse());
+			pEncoder->setUniform(bgfx::UniformHandle(pAnimationComponent->GetBoneMatrixsUniform()), boneMatrices.data(), static_cast<uint16_t>(boneMatrices.size()));
+#ifdef VISUALIZE_BONE_WEIGHTS
+			pEncoder->setUniform(boneIndexHandle, selectedBoneIndex, 1);
+#endif
+			pEncoder->setVertexBuffer(0, bgfx::VertexBufferHandle(pMeshComponent->GetVertexBuffer()));
+			pEncoder->setIndexBuffer(bgfx::IndexBufferHandle(pMeshComponent->GetIndexBuffer()));
+			pEncoder->setUniform(positionDequantizeHandle, pMeshComponent->GetPositionDequantization(), 2);
 
-		constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_CULL_CCW | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
-		bgfx::setState(state);
+			constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_CULL_CCW | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
+			pEncoder->setState(state);
 
-		constexpr StringCrc animationProgram("AnimationProgram");
-		bgfx::submit(GetViewID(), m_pRenderContext->GetProgram(animationProgram));
-	}
+			pEncoder->submit(GetViewID(), programHandle);
+		}
+	});
 }
 
 }
\ No newline at end of file
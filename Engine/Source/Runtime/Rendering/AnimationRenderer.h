@@ -1,5 +1,6 @@
 #pragma once
 
+#include "FrustumCuller.hpp"
 #include "Renderer.h"
 
 #include <vector>
@@ -20,8 +21,13 @@ public:
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 
+	const CullingStats& GetCullingStats() const { return m_frustumCuller.GetStats(); }
+
 private:
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
+
+	Frustum m_frustum;
+	FrustumCuller m_frustumCuller;
 };
 
 }
\ No newline at end of file
@@ -7,7 +7,7 @@ namespace engine
 
 void BlitRenderTargetPass::Init()
 {
-	bgfx::setViewName(GetViewID(), "BlitRenderTargetPass");
+	SetViewName("BlitRenderTargetPass");
 }
 
 BlitRenderTargetPass::~BlitRenderTargetPass()
@@ -24,33 +24,14 @@ void BlitRenderTargetPass::Render(float deltaTime)
 	const RenderTarget* pSceneRT = m_pRenderContext->GetRenderTarget(sceneRenderTarget);
 	bgfx::TextureHandle sceneColorTextureHandle = pSceneRT->GetTextureHandle(0);
 
-	constexpr StringCrc sceneRenderTargetBlitSRV("SceneRenderTargetBlitSRV");
-	bgfx::TextureHandle blitTargetSRVHandle = m_pRenderContext->GetTexture(sceneRenderTargetBlitSRV);
-	bool buildSRV = false;
-	if (bgfx::isValid(blitTargetSRVHandle))
+	// The render graph acquires the copy from the render target pool only for passes which use it.
+	bgfx::TextureHandle blitTextureHandle{ m_pRenderGraph->GetTexture(m_blitTexture) };
+	if (!bgfx::isValid(blitTextureHandle))
 	{
-		if (pSceneRT->GetWidth() != m_blitTextureWidth ||
-			pSceneRT->GetHeight() != m_blitTextureHeight)
-		{
-			bgfx::destroy(blitTargetSRVHandle);
-			buildSRV = true;
-		}
-	}
-	else
-	{
-		buildSRV = true;
-	}
-
-	if (buildSRV)
-	{
-		m_blitTextureWidth = pSceneRT->GetWidth();
-		m_blitTextureHeight = pSceneRT->GetHeight();
-		blitTargetSRVHandle = bgfx::createTexture2D(m_blitTextureWidth, m_blitTextureHeight, false, 1, bgfx::TextureFormat::RGBA32F,
-			BGFX_TEXTURE_BLIT_DST | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP);
-		m_pRenderContext->SetTexture(sceneRenderTargetBlitSRV, blitTargetSRVHandle);
+		return;
 	}
 
-	bgfx::blit(GetViewID(), blitTargetSRVHandle, 0, 0, sceneColorTextureHandle);
+	bgfx::blit(GetViewID(), blitTextureHandle, 0, 0, sceneColorTextureHandle);
 }
 
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Renderer.h"
+#include "RenderGraph.hpp"
 
 namespace engine
 {
@@ -15,9 +16,12 @@ public:
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
 	virtual void Render(float deltaTime) override;
 
+	// The copy of scene color is a transient texture of the render graph with the same size and format as the scene color.
+	void SetBlitTexture(const RenderGraph* pRenderGraph, RenderGraph::ResourceHandle blitTexture) { m_pRenderGraph = pRenderGraph; m_blitTexture = blitTexture; }
+
 private:
-	uint16_t m_blitTextureWidth;
-	uint16_t m_blitTextureHeight;
+	const RenderGraph* m_pRenderGraph = nullptr;
+	RenderGraph::ResourceHandle m_blitTexture = RenderGraph::InvalidHandle;
 };
 
 }
\ No newline at end of file
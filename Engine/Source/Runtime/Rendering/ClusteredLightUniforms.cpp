@@ -0,0 +1,200 @@
+#include "ClusteredLightUniforms.h"
+
+#include "Light.h"
+#include "Log/Log.h"
+#include "RenderContext.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+cd::Vec3f TransformPoint(const float* pMatrix, float x, float y, float z)
+{
+	return cd::Vec3f(pMatrix[0] * x + pMatrix[4] * y + pMatrix[8] * z + pMatrix[12],
+		pMatrix[1] * x + pMatrix[5] * y + pMatrix[9] * z + pMatrix[13],
+		pMatrix[2] * x + pMatrix[6] * y + pMatrix[10] * z + pMatrix[14]);
+}
+
+cd::Vec3f TransformDirection(const float* pMatrix, float x, float y, float z)
+{
+	return cd::Vec3f(pMatrix[0] * x + pMatrix[4] * y + pMatrix[8] * z,
+		pMatrix[1] * x + pMatrix[5] * y + pMatrix[9] * z,
+		pMatrix[2] * x + pMatrix[6] * y + pMatrix[10] * z);
+}
+
+}
+
+ClusteredLightUniform::ClusteredLightUniform(RenderContext* pRenderContext) :
+	m_pRenderContext(pRenderContext)
+{
+	m_pRenderContext->CreateUniform("s_lightData", bgfx::UniformType::Sampler);
+	m_pRenderContext->CreateUniform("s_lightGrid", bgfx::UniformType::Sampler);
+	m_pRenderContext->CreateUniform("s_lightIndices", bgfx::UniformType::Sampler);
+	m_pRenderContext->CreateUniform("u_clusterParams", bgfx::UniformType::Vec4, 2);
+}
+
+ClusteredLightUniform::~ClusteredLightUniform()
+{
+	for (DataTexture* pTexture : { &m_lightDataTexture, &m_lightGridTexture, &m_lightIndexTexture })
+	{
+		if (bgfx::isValid(pTexture->handle))
+		{
+			bgfx::destroy(pTexture->handle);
+		}
+	}
+}
+
+void ClusteredLightUniform::Build(const ComponentsStorage<LightComponent>& lightStorage, const float* pViewMatrix, const float* pProjectionMatrix, float nearPlane, float farPlane)
+{
+	// Repack lights only when any LightComponent was created, modified or removed since the last build.
+	// The layout is the same as u_lightParams, see light.sh.
+	if (lightStorage.HasChangedSince(m_lastUpdateTick))
+	{
+		m_lastUpdateTick = lightStorage.GetCurrentTick();
+		m_isLightDataDirty = true;
+
+		// Every light is a row of the light data texture, so lights beyond the max texture size are dropped.
+		const std::vector<LightComponent>& lightComponents = lightStorage.GetComponents();
+		const uint32_t maxLightCount = bgfx::getCaps()->limits.maxTextureSize;
+		m_lightCount = std::min(static_cast<uint32_t>(lightComponents.size()), maxLightCount);
+		if (m_lightCount < lightComponents.size())
+		{
+			CD_ENGINE_WARN("Clustered lighting supports {0} lights at most, {1} lights are dropped.", maxLightCount, lightComponents.size() - m_lightCount);
+		}
+
+		m_lightData.resize(m_lightCount * LightStride * 4);
+		float* pLightData = m_lightData.data();
+		for (uint32_t lightIndex = 0; lightIndex < m_lightCount; ++lightIndex)
+		{
+			const LightComponent& light = lightComponents[lightIndex];
+			const float lightParams[LightStride * 4] = {
+				static_cast<float>(light.GetType()), light.GetPosition().x(), light.GetPosition().y(), light.GetPosition().z(),
+				light.GetIntensity(), light.GetColor().x(), light.GetColor().y(), light.GetColor().z(),
+				light.GetRange(), light.GetDirection().x(), light.GetDirection().y(), light.GetDirection().z(),
+				light.GetRadius(), light.GetUp().x(), light.GetUp().y(), light.GetUp().z(),
+				light.GetWidth(), light.GetHeight(), light.GetAngleScale(), light.GetAngleOffset(),
+			};
+			std::memcpy(pLightData, lightParams, sizeof(lightParams));
+			pLightData += LightStride * 4;
+		}
+	}
+
+	// Bounds of lights follow the camera, so they are rebuilt every frame.
+	m_lightBounds.clear();
+	for (uint32_t lightIndex = 0; lightIndex < m_lightCount; ++lightIndex)
+	{
+		const float* pLight = &m_lightData[lightIndex * LightStride * 4];
+		cd::Vec3f viewPosition = TransformPoint(pViewMatrix, pLight[1], pLight[2], pLight[3]);
+		float range = pLight[8];
+		switch (static_cast<int>(pLight[0]))
+		{
+		case POINT_LIGHT:
+			m_lightBounds.push_back(LightClusterGrid::MakeSphereBounds(viewPosition, range));
+			break;
+		case SPOT_LIGHT:
+		{
+			// lightAngleScale = 1 / (cosInner - cosOuter), lightAngleOffset = -cosOuter * lightAngleScale.
+			float angleScale = pLight[18];
+			float cosOuter = 0.0f != angleScale ? -pLight[19] / angleScale : 0.0f;
+			cd::Vec3f viewDirection = TransformDirection(pViewMatrix, pLight[9], pLight[10], pLight[11]);
+			m_lightBounds.push_back(LightClusterGrid::MakeConeBounds(viewPosition, viewDirection, range, cosOuter));
+			break;
+		}
+		case SPHERE_LIGHT:
+		case DISK_LIGHT:
+		case RECTANGLE_LIGHT:
+		case TUBE_LIGHT:
+		{
+			// Attenuation of area lights is measured from their surfaces.
+			float halfDiagonal = 0.5f * std::sqrt(pLight[16] * pLight[16] + pLight[17] * pLight[17]);
+			m_lightBounds.push_back(LightClusterGrid::MakeSphereBounds(viewPosition, range + pLight[12] + halfDiagonal));
+			break;
+		}
+		case DIRECTIONAL_LIGHT:
+		default:
+			m_lightBounds.push_back(LightClusterGrid::MakeUnboundedBounds());
+			break;
+		}
+	}
+
+	m_clusterGrid.SetProjection(pProjectionMatrix[0], pProjectionMatrix[5], nearPlane, farPlane);
+	m_clusterGrid.Build(m_lightBounds);
+
+	// Light indices fill rows of the light index texture, so indices beyond the max texture size are dropped.
+	// Clusters only keep their lights which are still in the texture.
+	const std::vector<uint32_t>& lightIndices = m_clusterGrid.GetLightIndices();
+	const uint32_t maxLightIndexCount = static_cast<uint32_t>(bgfx::getCaps()->limits.maxTextureSize) * LightIndexTextureWidth;
+	const uint32_t lightIndexCount = std::min(static_cast<uint32_t>(lightIndices.size()), maxLightIndexCount);
+	const bool isLightIndexDataTruncated = lightIndexCount < lightIndices.size();
+	if (isLightIndexDataTruncated && !m_isLightIndexDataTruncated)
+	{
+		CD_ENGINE_WARN("Clustered lighting supports {0} light indices at most, {1} light indices are dropped.", maxLightIndexCount, lightIndices.size() - lightIndexCount);
+	}
+	m_isLightIndexDataTruncated = isLightIndexDataTruncated;
+
+	m_lightIndexData.resize(lightIndexCount);
+	std::transform(lightIndices.begin(), lightIndices.begin() + lightIndexCount, m_lightIndexData.begin(), [](uint32_t lightIndex) { return static_cast<float>(lightIndex); });
+
+	const std::vector<LightClusterGrid::ClusterRange>& clusterRanges = m_clusterGrid.GetClusterRanges();
+	m_lightGridData.resize(clusterRanges.size() * 2);
+	for (size_t clusterIndex = 0; clusterIndex < clusterRanges.size(); ++clusterIndex)
+	{
+		const uint32_t offset = clusterRanges[clusterIndex].offset;
+		const uint32_t count = offset < lightIndexCount ? std::min<uint32_t>(clusterRanges[clusterIndex].count, lightIndexCount - offset) : 0;
+		m_lightGridData[clusterIndex * 2] = static_cast<float>(offset);
+		m_lightGridData[clusterIndex * 2 + 1] = static_cast<float>(count);
+	}
+}
+
+void ClusteredLightUniform::Submit(ViewBindings& viewBindings)
+{
+	if (m_isLightDataDirty || !bgfx::isValid(m_lightDataTexture.handle))
+	{
+		UpdateDataTexture(m_lightDataTexture, LightStride, static_cast<uint16_t>(std::max(m_lightCount, 1U)), bgfx::TextureFormat::RGBA32F, m_lightData, 4);
+		m_isLightDataDirty = false;
+	}
+
+	uint16_t clusterTileCount = static_cast<uint16_t>(m_clusterGrid.GetTileCountX() * m_clusterGrid.GetTileCountY());
+	UpdateDataTexture(m_lightGridTexture, clusterTileCount, m_clusterGrid.GetSliceCount(), bgfx::TextureFormat::RG32F, m_lightGridData, 2);
+
+	uint32_t lightIndexRowCount = (static_cast<uint32_t>(m_lightIndexData.size()) + LightIndexTextureWidth - 1) / LightIndexTextureWidth;
+	UpdateDataTexture(m_lightIndexTexture, LightIndexTextureWidth, static_cast<uint16_t>(std::max(lightIndexRowCount, 1U)), bgfx::TextureFormat::R32F, m_lightIndexData, 1);
+
+	const float clusterParams[8] = {
+		static_cast<float>(m_clusterGrid.GetTileCountX()), static_cast<float>(m_clusterGrid.GetTileCountY()), static_cast<float>(m_clusterGrid.GetSliceCount()), static_cast<float>(LightIndexTextureWidth),
+		m_clusterGrid.GetSliceScale(), m_clusterGrid.GetSliceBias(), static_cast<float>(m_lightCount), 0.0f,
+	};
+	viewBindings.SetUniform(m_pRenderContext->GetUniform(StringCrc("u_clusterParams")), clusterParams, 2);
+	viewBindings.SetTexture(LightDataSlot, m_pRenderContext->GetUniform(StringCrc("s_lightData")), m_lightDataTexture.handle);
+	viewBindings.SetTexture(LightGridSlot, m_pRenderContext->GetUniform(StringCrc("s_lightGrid")), m_lightGridTexture.handle);
+	viewBindings.SetTexture(LightIndexSlot, m_pRenderContext->GetUniform(StringCrc("s_lightIndices")), m_lightIndexTexture.handle);
+}
+
+void ClusteredLightUniform::UpdateDataTexture(DataTexture& texture, uint16_t width, uint16_t height, bgfx::TextureFormat::Enum format, std::vector<float>& data, uint32_t channelCount)
+{
+	if (!bgfx::isValid(texture.handle) || texture.width != width || texture.height < height)
+	{
+		if (bgfx::isValid(texture.handle))
+		{
+			bgfx::destroy(texture.handle);
+		}
+
+		// Grow by half to avoid recreating textures every frame when the count of lights increases.
+		// Callers keep heights in the max texture size, which the growth must not exceed either.
+		const uint32_t grownHeight = std::max<uint32_t>(height, texture.height + texture.height / 2);
+		texture.width = width;
+		texture.height = static_cast<uint16_t>(std::min<uint32_t>({ grownHeight, bgfx::getCaps()->limits.maxTextureSize, UINT16_MAX }));
+		texture.handle = bgfx::createTexture2D(texture.width, texture.height, false, 1, format, BGFX_SAMPLER_POINT | BGFX_SAMPLER_UVW_CLAMP);
+	}
+
+	data.resize(static_cast<size_t>(width) * height * channelCount);
+	bgfx::updateTexture2D(texture.handle, 0, 0, 0, 0, width, height, bgfx::copy(data.data(), static_cast<uint32_t>(data.size() * sizeof(float))));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ECWorld/ComponentsStorage.hpp"
+#include "ECWorld/LightComponent.h"
+#include "LightClusterGrid.hpp"
+
+#include <bgfx/bgfx.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+class RenderContext;
+class ViewBindings;
+
+// ClusteredLightUniform feeds the clustered lighting path of PBR shaders, which is not limited by the size of u_lightParams.
+// Lights are packed into a texture with the same layout as u_lightParams. Every frame, lights are binned into the
+// froxels of the camera and the per-cluster light lists are uploaded as textures too.
+class ClusteredLightUniform final
+{
+public:
+	static constexpr uint8_t LightDataSlot = 6;
+	static constexpr uint8_t LightGridSlot = 7;
+	static constexpr uint8_t LightIndexSlot = 8;
+	static constexpr uint16_t LightStride = 5;
+	static constexpr uint16_t LightIndexTextureWidth = 1024;
+
+public:
+	ClusteredLightUniform() = delete;
+	explicit ClusteredLightUniform(RenderContext* pRenderContext);
+	ClusteredLightUniform(const ClusteredLightUniform&) = delete;
+	ClusteredLightUniform& operator=(const ClusteredLightUniform&) = delete;
+	ClusteredLightUniform(ClusteredLightUniform&&) = delete;
+	ClusteredLightUniform& operator=(ClusteredLightUniform&&) = delete;
+	~ClusteredLightUniform();
+
+	// Packs changed lights and bins them with column-major view and projection matrices of the camera.
+	// It doesn't call bgfx, so it can run as a job on a worker thread.
+	void Build(const ComponentsStorage<LightComponent>& lightStorage, const float* pViewMatrix, const float* pProjectionMatrix, float nearPlane, float farPlane);
+
+	// Uploads textures of the last build and sets them to the view's bindings. It runs on the thread which calls bgfx::frame.
+	void Submit(ViewBindings& viewBindings);
+
+	uint32_t GetLightCount() const { return m_lightCount; }
+	const LightClusterGrid& GetClusterGrid() const { return m_clusterGrid; }
+
+private:
+	// Textures are recreated only when their sizes grow.
+	struct DataTexture
+	{
+		bgfx::TextureHandle handle = BGFX_INVALID_HANDLE;
+		uint16_t width = 0;
+		uint16_t height = 0;
+	};
+
+	// Uploads rows of data. Data is padded to fill the rows.
+	static void UpdateDataTexture(DataTexture& texture, uint16_t width, uint16_t height, bgfx::TextureFormat::Enum format, std::vector<float>& data, uint32_t channelCount);
+
+private:
+	RenderContext* m_pRenderContext = nullptr;
+	ChangeTick m_lastUpdateTick = 0;
+	bool m_isLightDataDirty = true;
+
+	uint32_t m_lightCount = 0;
+	std::vector<float> m_lightData;
+	std::vector<LightClusterGrid::LightBounds> m_lightBounds;
+	LightClusterGrid m_clusterGrid;
+	std::vector<float> m_lightGridData;
+	std::vector<float> m_lightIndexData;
+	bool m_isLightIndexDataTruncated = false;
+
+	DataTexture m_lightDataTexture;
+	DataTexture m_lightGridTexture;
+	DataTexture m_lightIndexTexture;
+};
+
+}
\ No newline at end of file
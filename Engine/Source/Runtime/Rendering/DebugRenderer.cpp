@@ -15,7 +15,7 @@ namespace engine
 void DebugRenderer::Init()
 {
 	m_pRenderContext->CreateProgram("WireFrameProgram", "vs_wireframe.bin", "fs_wireframe.bin");
-	bgfx::setViewName(GetViewID(), "DebugRenderer");
+	SetViewName("DebugRenderer");
 }
 
 void DebugRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
@@ -37,7 +37,7 @@ void DebugRenderer::Render(float deltaTime)
 
 		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
 		{
-			pTransformComponent->Build();
+			// World matrices are built in batches by TransformSystem before rendering.
 			bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
 		}
 
@@ -0,0 +1,419 @@
+#pragma once
+
+#include "Core/CPUFeatures.hpp"
+#include "Core/Threading/ThreadPool.hpp"
+#include "ECWorld/Entity.h"
+#include "Math/Box.hpp"
+#include "Math/Matrix.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace engine
+{
+
+// Frustum stores six planes (nx, ny, nz, d) in world space. A point p is inside a plane if dot(n, p) + d >= 0.
+class Frustum final
+{
+public:
+	static constexpr size_t PlaneCount = 6;
+
+public:
+	Frustum() = default;
+	Frustum(const Frustum&) = default;
+	Frustum& operator=(const Frustum&) = default;
+	Frustum(Frustum&&) = default;
+	Frustum& operator=(Frustum&&) = default;
+	~Frustum() = default;
+
+	// Extract planes from column-major view and projection matrices, which are the same as bgfx::setViewTransform accepts.
+	// homogeneousDepth is true if NDC depth is in [-1, 1], otherwise [0, 1].
+	static Frustum FromViewProjection(const float* pViewMatrix, const float* pProjectionMatrix, bool homogeneousDepth)
+	{
+		// Row i of the clip matrix is (m[i], m[4 + i], m[8 + i], m[12 + i]).
+		float viewProjection[16];
+		for (int column = 0; column < 4; ++column)
+		{
+			for (int row = 0; row < 4; ++row)
+			{
+				float value = 0.0f;
+				for (int k = 0; k < 4; ++k)
+				{
+					value += pProjectionMatrix[k * 4 + row] * pViewMatrix[column * 4 + k];
+				}
+				viewProjection[column * 4 + row] = value;
+			}
+		}
+
+		auto getRow = [&viewProjection](int row)
+		{
+			return std::array<float, 4>{ viewProjection[row], viewProjection[4 + row], viewProjection[8 + row], viewProjection[12 + row] };
+		};
+		std::array<float, 4> row0 = getRow(0);
+		std::array<float, 4> row1 = getRow(1);
+		std::array<float, 4> row2 = getRow(2);
+		std::array<float, 4> row3 = getRow(3);
+
+		Frustum frustum;
+		for (int component = 0; component < 4; ++component)
+		{
+			frustum.m_planes[0][component] = row3[component] + row0[component]; // Left
+			frustum.m_planes[1][component] = row3[component] - row0[component]; // Right
+			frustum.m_planes[2][component] = row3[component] + row1[component]; // Bottom
+			frustum.m_planes[3][component] = row3[component] - row1[component]; // Top
+			frustum.m_planes[4][component] = homogeneousDepth ? row3[component] + row2[component] : row2[component]; // Near
+			frustum.m_planes[5][component] = row3[component] - row2[component]; // Far
+		}
+
+		for (std::array<float, 4>& plane : frustum.m_planes)
+		{
+			float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+			if (length > 0.0f)
+			{
+				for (float& component : plane)
+				{
+					component /= length;
+				}
+			}
+		}
+
+		return frustum;
+	}
+
+	const std::array<float, 4>& GetPlane(size_t planeIndex) const { return m_planes[planeIndex]; }
+
+	// Test a world space box by its center and half extents.
+	bool Intersects(const cd::Vec3f& center, const cd::Vec3f& extents) const
+	{
+		for (const std::array<float, 4>& plane : m_planes)
+		{
+			float distance = plane[0] * center.x() + plane[1] * center.y() + plane[2] * center.z() + plane[3];
+			float radius = std::abs(plane[0]) * extents.x() + std::abs(plane[1]) * extents.y() + std::abs(plane[2]) * extents.z();
+			if (distance + radius < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	std::array<std::array<float, 4>, PlaneCount> m_planes = {};
+};
+
+struct CullingStats
+{
+	uint32_t candidateCount = 0;
+	uint32_t visibleCount = 0;
+	uint32_t culledCount = 0;
+};
+
+// FrustumCuller tests local AABBs of candidates against a Frustum and outputs a compact list of visible entities.
+// Candidates are gathered in SoA form. Kernels transform 4 (SSE2) or 8 (AVX2) AABBs to world space at once,
+// then test them against six planes. Chunks of candidates run in parallel on a ThreadPool.
+class FrustumCuller final
+{
+public:
+	// Candidates culled by one task. It is a multiple of all kernel widths.
+	static constexpr uint32_t ChunkSize = 4096;
+
+	// Boxes without bounds are always visible.
+	static constexpr float UnboundedExtent = 1e30f;
+
+public:
+	FrustumCuller() = default;
+	FrustumCuller(const FrustumCuller&) = default;
+	FrustumCuller& operator=(const FrustumCuller&) = default;
+	FrustumCuller(FrustumCuller&&) = default;
+	FrustumCuller& operator=(FrustumCuller&&) = default;
+	~FrustumCuller() = default;
+
+	uint32_t GetCandidateCount() const { return static_cast<uint32_t>(m_entities.size()); }
+
+	void Clear()
+	{
+		m_entities.clear();
+		for (std::vector<float>& channel : m_channels)
+		{
+			channel.clear();
+		}
+	}
+
+	void Reserve(size_t count)
+	{
+		m_entities.reserve(count);
+		for (std::vector<float>& channel : m_channels)
+		{
+			channel.reserve(count);
+		}
+	}
+
+	void Add(Entity entity, const cd::AABB& localAABB, const cd::Matrix4x4& worldMatrix)
+	{
+		m_entities.push_back(entity);
+
+		if (localAABB.IsEmpty())
+		{
+			Push(CenterX, 0.0f, 0.0f, 0.0f);
+			Push(ExtentX, UnboundedExtent, UnboundedExtent, UnboundedExtent);
+		}
+		else
+		{
+			const cd::Vec3f& min = localAABB.Min();
+			const cd::Vec3f& max = localAABB.Max();
+			Push(CenterX, (min.x() + max.x()) * 0.5f, (min.y() + max.y()) * 0.5f, (min.z() + max.z()) * 0.5f);
+			Push(ExtentX, (max.x() - min.x()) * 0.5f, (max.y() - min.y()) * 0.5f, (max.z() - min.z()) * 0.5f);
+		}
+
+		const float* pMatrix = worldMatrix.Begin();
+		Push(Column0X, pMatrix[0], pMatrix[1], pMatrix[2]);
+		Push(Column1X, pMatrix[4], pMatrix[5], pMatrix[6]);
+		Push(Column2X, pMatrix[8], pMatrix[9], pMatrix[10]);
+		Push(TranslationX, pMatrix[12], pMatrix[13], pMatrix[14]);
+	}
+
+	// Visible entities keep the order which they were added in.
+	void Cull(const Frustum& frustum, ThreadPool* pThreadPool = nullptr, SIMDLevel level = GetSIMDLevel())
+	{
+		uint32_t candidateCount = GetCandidateCount();
+		m_visibilities.resize(candidateCount);
+
+		uint32_t chunkCount = (candidateCount + ChunkSize - 1) / ChunkSize;
+		if (!pThreadPool || chunkCount <= 1)
+		{
+			for (uint32_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+			{
+				CullChunk(frustum, chunkIndex, level);
+			}
+		}
+		else
+		{
+			// The calling thread takes the first chunk and helps with the others.
+			std::atomic<uint32_t> finishedChunkCount = 0;
+			for (uint32_t chunkIndex = 1; chunkIndex < chunkCount; ++chunkIndex)
+			{
+				pThreadPool->Submit([this, &frustum, &finishedChunkCount, chunkIndex, level]()
+				{
+					CullChunk(frustum, chunkIndex, level);
+					finishedChunkCount.fetch_add(1, std::memory_order_release);
+				});
+			}
+
+			CullChunk(frustum, 0, level);
+			while (finishedChunkCount.load(std::memory_order_acquire) < chunkCount - 1)
+			{
+				if (!pThreadPool->TryRunTask())
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		m_visibleEntities.clear();
+		for (uint32_t candidateIndex = 0; candidateIndex < candidateCount; ++candidateIndex)
+		{
+			if (m_visibilities[candidateIndex])
+			{
+				m_visibleEntities.push_back(m_entities[candidateIndex]);
+			}
+		}
+
+		m_stats.candidateCount = candidateCount;
+		m_stats.visibleCount = static_cast<uint32_t>(m_visibleEntities.size());
+		m_stats.culledCount = candidateCount - m_stats.visibleCount;
+	}
+
+	const std::vector<Entity>& GetVisibleEntities() const { return m_visibleEntities; }
+	const CullingStats& GetStats() const { return m_stats; }
+
+private:
+	// SoA channels. X, Y and Z of a vector are adjacent channels.
+	enum Channel
+	{
+		CenterX, CenterY, CenterZ,
+		ExtentX, ExtentY, ExtentZ,
+		Column0X, Column0Y, Column0Z,
+		Column1X, Column1Y, Column1Z,
+		Column2X, Column2Y, Column2Z,
+		TranslationX, TranslationY, TranslationZ,
+		ChannelCount,
+	};
+
+	void Push(Channel firstChannel, float x, float y, float z)
+	{
+		m_channels[firstChannel].push_back(x);
+		m_channels[firstChannel + 1].push_back(y);
+		m_channels[firstChannel + 2].push_back(z);
+	}
+
+	const float* GetChannel(Channel channel, uint32_t index) const { return &m_channels[channel][index]; }
+
+	void CullChunk(const Frustum& frustum, uint32_t chunkIndex, SIMDLevel level)
+	{
+		uint32_t begin = chunkIndex * ChunkSize;
+		uint32_t end = std::min(begin + ChunkSize, GetCandidateCount());
+#ifdef CD_SIMD_X86
+		if (SIMDLevel::AVX2 == level)
+		{
+			begin = CullAVX2(frustum, begin, end);
+		}
+		else if (SIMDLevel::SSE2 == level)
+		{
+			begin = CullSSE2(frustum, begin, end);
+		}
+#endif
+		for (uint32_t index = begin; index < end; ++index)
+		{
+			m_visibilities[index] = CullScalar(frustum, index);
+		}
+	}
+
+	uint8_t CullScalar(const Frustum& frustum, uint32_t index) const
+	{
+		auto at = [this, index](Channel channel) { return m_channels[channel][index]; };
+		float cx = at(CenterX);
+		float cy = at(CenterY);
+		float cz = at(CenterZ);
+		float ex = at(ExtentX);
+		float ey = at(ExtentY);
+		float ez = at(ExtentZ);
+
+		cd::Vec3f center(
+			at(Column0X) * cx + at(Column1X) * cy + at(Column2X) * cz + at(TranslationX),
+			at(Column0Y) * cx + at(Column1Y) * cy + at(Column2Y) * cz + at(TranslationY),
+			at(Column0Z) * cx + at(Column1Z) * cy + at(Column2Z) * cz + at(TranslationZ));
+		cd::Vec3f extents(
+			std::abs(at(Column0X)) * ex + std::abs(at(Column1X)) * ey + std::abs(at(Column2X)) * ez,
+			std::abs(at(Column0Y)) * ex + std::abs(at(Column1Y)) * ey + std::abs(at(Column2Y)) * ez,
+			std::abs(at(Column0Z)) * ex + std::abs(at(Column1Z)) * ey + std::abs(at(Column2Z)) * ez);
+		return frustum.Intersects(center, extents) ? 1 : 0;
+	}
+
+#ifdef CD_SIMD_X86
+	uint32_t CullSSE2(const Frustum& frustum, uint32_t begin, uint32_t end)
+	{
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 zero = _mm_setzero_ps();
+		auto load = [this](Channel channel, uint32_t index) { return _mm_loadu_ps(GetChannel(channel, index)); };
+		auto abs = [&signMask](__m128 value) { return _mm_andnot_ps(signMask, value); };
+		auto dot = [](__m128 x0, __m128 y0, __m128 z0, __m128 x1, __m128 y1, __m128 z1)
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, x1), _mm_mul_ps(y0, y1)), _mm_mul_ps(z0, z1));
+		};
+
+		uint32_t index = begin;
+		for (; index + 4 <= end; index += 4)
+		{
+			__m128 cx = load(CenterX, index);
+			__m128 cy = load(CenterY, index);
+			__m128 cz = load(CenterZ, index);
+			__m128 ex = load(ExtentX, index);
+			__m128 ey = load(ExtentY, index);
+			__m128 ez = load(ExtentZ, index);
+			__m128 m0x = load(Column0X, index);
+			__m128 m0y = load(Column0Y, index);
+			__m128 m0z = load(Column0Z, index);
+			__m128 m1x = load(Column1X, index);
+			__m128 m1y = load(Column1Y, index);
+			__m128 m1z = load(Column1Z, index);
+			__m128 m2x = load(Column2X, index);
+			__m128 m2y = load(Column2Y, index);
+			__m128 m2z = load(Column2Z, index);
+
+			__m128 wcx = _mm_add_ps(dot(m0x, m1x, m2x, cx, cy, cz), load(TranslationX, index));
+			__m128 wcy = _mm_add_ps(dot(m0y, m1y, m2y, cx, cy, cz), load(TranslationY, index));
+			__m128 wcz = _mm_add_ps(dot(m0z, m1z, m2z, cx, cy, cz), load(TranslationZ, index));
+			__m128 wex = dot(abs(m0x), abs(m1x), abs(m2x), ex, ey, ez);
+			__m128 wey = dot(abs(m0y), abs(m1y), abs(m2y), ex, ey, ez);
+			__m128 wez = dot(abs(m0z), abs(m1z), abs(m2z), ex, ey, ez);
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (size_t planeIndex = 0; planeIndex < Frustum::PlaneCount; ++planeIndex)
+			{
+				const std::array<float, 4>& plane = frustum.GetPlane(planeIndex);
+				__m128 nx = _mm_set1_ps(plane[0]);
+				__m128 ny = _mm_set1_ps(plane[1]);
+				__m128 nz = _mm_set1_ps(plane[2]);
+				__m128 distance = _mm_add_ps(dot(nx, ny, nz, wcx, wcy, wcz), _mm_set1_ps(plane[3]));
+				__m128 radius = dot(abs(nx), abs(ny), abs(nz), wex, wey, wez);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				m_visibilities[index + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+			}
+		}
+
+		return index;
+	}
+
+	CD_TARGET_AVX2 uint32_t CullAVX2(const Frustum& frustum, uint32_t begin, uint32_t end)
+	{
+		const __m256 signMask = _mm256_set1_ps(-0.0f);
+		const __m256 zero = _mm256_setzero_ps();
+
+		uint32_t index = begin;
+		for (; index + 8 <= end; index += 8)
+		{
+			__m256 cx = _mm256_loadu_ps(GetChannel(CenterX, index));
+			__m256 cy = _mm256_loadu_ps(GetChannel(CenterY, index));
+			__m256 cz = _mm256_loadu_ps(GetChannel(CenterZ, index));
+			__m256 ex = _mm256_loadu_ps(GetChannel(ExtentX, index));
+			__m256 ey = _mm256_loadu_ps(GetChannel(ExtentY, index));
+			__m256 ez = _mm256_loadu_ps(GetChannel(ExtentZ, index));
+			__m256 m0x = _mm256_loadu_ps(GetChannel(Column0X, index));
+			__m256 m0y = _mm256_loadu_ps(GetChannel(Column0Y, index));
+			__m256 m0z = _mm256_loadu_ps(GetChannel(Column0Z, index));
+			__m256 m1x = _mm256_loadu_ps(GetChannel(Column1X, index));
+			__m256 m1y = _mm256_loadu_ps(GetChannel(Column1Y, index));
+			__m256 m1z = _mm256_loadu_ps(GetChannel(Column1Z, index));
+			__m256 m2x = _mm256_loadu_ps(GetChannel(Column2X, index));
+			__m256 m2y = _mm256_loadu_ps(GetChannel(Column2Y, index));
+			__m256 m2z = _mm256_loadu_ps(GetChannel(Column2Z, index));
+
+			__m256 wcx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0x, cx), _mm256_mul_ps(m1x, cy)), _mm256_mul_ps(m2x, cz)), _mm256_loadu_ps(GetChannel(TranslationX, index)));
+			__m256 wcy = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0y, cx), _mm256_mul_ps(m1y, cy)), _mm256_mul_ps(m2y, cz)), _mm256_loadu_ps(GetChannel(TranslationY, index)));
+			__m256 wcz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0z, cx), _mm256_mul_ps(m1z, cy)), _mm256_mul_ps(m2z, cz)), _mm256_loadu_ps(GetChannel(TranslationZ, index)));
+			__m256 wex = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signMask, m0x), ex), _mm256_mul_ps(_mm256_andnot_ps(signMask, m1x), ey)), _mm256_mul_ps(_mm256_andnot_ps(signMask, m2x), ez));
+			__m256 wey = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signMask, m0y), ex), _mm256_mul_ps(_mm256_andnot_ps(signMask, m1y), ey)), _mm256_mul_ps(_mm256_andnot_ps(signMask, m2y), ez));
+			__m256 wez = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signMask, m0z), ex), _mm256_mul_ps(_mm256_andnot_ps(signMask, m1z), ey)), _mm256_mul_ps(_mm256_andnot_ps(signMask, m2z), ez));
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (size_t planeIndex = 0; planeIndex < Frustum::PlaneCount; ++planeIndex)
+			{
+				const std::array<float, 4>& plane = frustum.GetPlane(planeIndex);
+				__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane[0]), wcx),
+					_mm256_mul_ps(_mm256_set1_ps(plane[1]), wcy)), _mm256_mul_ps(_mm256_set1_ps(plane[2]), wcz)), _mm256_set1_ps(plane[3]));
+				__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(std::abs(plane[0])), wex),
+					_mm256_mul_ps(_mm256_set1_ps(std::abs(plane[1])), wey)), _mm256_mul_ps(_mm256_set1_ps(std::abs(plane[2])), wez));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+			}
+
+			int mask = _mm256_movemask_ps(inside);
+			for (uint32_t lane = 0; lane < 8; ++lane)
+			{
+				m_visibilities[index + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+			}
+		}
+
+		return index;
+	}
+#endif
+
+private:
+	std::vector<Entity> m_entities;
+	std::array<std::vector<float>, ChannelCount> m_channels;
+
+	std::vector<uint8_t> m_visibilities;
+	std::vector<Entity> m_visibleEntities;
+	CullingStats m_stats;
+};
+
+}
\ No newline at end of file
@@ -24,7 +24,7 @@ void ImGuiRenderer::Init()
 	m_pRenderContext->CreateUniform("s_tex", bgfx::UniformType::Sampler);
 	m_pRenderContext->CreateProgram("ImGuiProgram", "vs_imgui.bin", "fs_imgui.bin");
 
-	bgfx::setViewName(GetViewID(), "ImGuiRenderer");
+	SetViewName("ImGuiRenderer");
 }
 
 ImGuiRenderer::~ImGuiRenderer()
@@ -56,7 +56,7 @@ void ImGuiRenderer::UpdateView(const float* pViewMatrix, const float* pProjectio
 	ImGui::UpdatePlatformWindows();
 	ImGui::RenderPlatformWindowsDefault();
 
-	bgfx::setViewMode(GetViewID(), bgfx::ViewMode::Sequential);
+	SetViewSequential();
 	bgfx::setViewFrameBuffer(GetViewID(), *GetRenderTarget()->GetFrameBufferHandle());
 
 	const ImDrawData* pImGuiDrawData = ImGui::GetDrawData();
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "RenderQueue.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// InstanceBatcher groups draws which share the same mesh, program and material so that they can be drawn in one instanced draw.
+// Batch key is | vertex buffer 16 | index buffer 12 | LOD 4 | program 16 | material 16 |.
+// Index buffer handles fit into 12 bits as bgfx allows 4096 index buffers by default.
+// Material bits are a hash, so draws with equal keys are also compared by the caller before they are put into one batch.
+class InstanceBatcher final
+{
+public:
+	struct Batch
+	{
+		uint32_t firstInstance;
+		uint32_t instanceCount;
+	};
+
+public:
+	InstanceBatcher() = default;
+	InstanceBatcher(const InstanceBatcher&) = default;
+	InstanceBatcher& operator=(const InstanceBatcher&) = default;
+	InstanceBatcher(InstanceBatcher&&) = default;
+	InstanceBatcher& operator=(InstanceBatcher&&) = default;
+	~InstanceBatcher() = default;
+
+	static constexpr uint64_t MakeBatchKey(uint16_t vertexBuffer, uint16_t indexBuffer, uint16_t program, uint16_t material, uint8_t lod = 0)
+	{
+		return static_cast<uint64_t>(vertexBuffer) << 48 | static_cast<uint64_t>(indexBuffer & 0xFFF) << 36 | static_cast<uint64_t>(lod & 0xF) << 32 |
+			static_cast<uint64_t>(program) << 16 | static_cast<uint64_t>(material);
+	}
+
+	void Clear()
+	{
+		m_queue.Clear();
+		m_instances.clear();
+		m_batches.clear();
+	}
+
+	void Add(uint64_t batchKey, uint32_t payload) { m_queue.Push(batchKey, payload); }
+
+	// Sorts draws by batch keys and splits them into batches of adjacent draws.
+	// isSameBatch(lhsPayload, rhsPayload) tells if two draws with the same key can really be instanced together.
+	template<typename Compare>
+	void Build(Compare&& isSameBatch)
+	{
+		m_queue.Sort();
+
+		m_instances.clear();
+		m_batches.clear();
+		const std::vector<RenderQueue::Item>& items = m_queue.GetItems();
+		for (uint32_t itemIndex = 0; itemIndex < items.size(); ++itemIndex)
+		{
+			const RenderQueue::Item& item = items[itemIndex];
+			if (m_batches.empty() || items[itemIndex - 1].key != item.key || !isSameBatch(m_instances[itemIndex - 1], item.payload))
+			{
+				m_batches.push_back(Batch{ itemIndex, 0 });
+			}
+			m_instances.push_back(item.payload);
+			++m_batches.back().instanceCount;
+		}
+	}
+
+	// Payloads of all draws. Instances of a batch are contiguous.
+	const std::vector<uint32_t>& GetInstances() const { return m_instances; }
+	const std::vector<Batch>& GetBatches() const { return m_batches; }
+
+private:
+	RenderQueue m_queue;
+	std::vector<uint32_t> m_instances;
+	std::vector<Batch> m_batches;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "Math/Vector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// LightClusterGrid bins lights into froxels, which are clusters of a view-space grid of screen tiles and depth slices.
+// Depth slices are exponential between near and far planes, so that clusters keep a similar shape at all distances.
+// Lights of a cluster are stored as a compact list of light indexes, so a pixel only shades lights which touch its cluster.
+// View space is left-handed with +z forward, which is the same as CameraComponent.
+class LightClusterGrid final
+{
+public:
+	// Bounding sphere of a light in view space. A negative radius means that the light reaches every cluster, such as directional lights.
+	struct LightBounds
+	{
+		cd::Vec3f center;
+		float radius;
+
+		bool IsUnbounded() const { return radius < 0.0f; }
+	};
+
+	// Range of the cluster in the light index list.
+	struct ClusterRange
+	{
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	struct ClusterAABB
+	{
+		cd::Vec3f min;
+		cd::Vec3f max;
+	};
+
+public:
+	LightClusterGrid() = default;
+	LightClusterGrid(const LightClusterGrid&) = default;
+	LightClusterGrid& operator=(const LightClusterGrid&) = default;
+	LightClusterGrid(LightClusterGrid&&) = default;
+	LightClusterGrid& operator=(LightClusterGrid&&) = default;
+	~LightClusterGrid() = default;
+
+	static LightBounds MakeSphereBounds(const cd::Vec3f& center, float radius) { return LightBounds{ center, radius }; }
+	static LightBounds MakeUnboundedBounds() { return LightBounds{ cd::Vec3f(0.0f, 0.0f, 0.0f), -1.0f }; }
+
+	// Bounding sphere of a cone from apex along direction, cosHalfAngle is the cosine of the outer angle.
+	// Wide cones are bounded by the sphere around their cap, narrow cones by the sphere through the apex and the cap edge.
+	static LightBounds MakeConeBounds(const cd::Vec3f& apex, const cd::Vec3f& direction, float range, float cosHalfAngle)
+	{
+		cosHalfAngle = std::clamp(cosHalfAngle, 0.0f, 1.0f);
+		if (cosHalfAngle < 0.70710678f)
+		{
+			float sinHalfAngle = std::sqrt(1.0f - cosHalfAngle * cosHalfAngle);
+			return LightBounds{ apex + direction * (range * cosHalfAngle), range * sinHalfAngle };
+		}
+
+		float radius = range / (2.0f * cosHalfAngle);
+		return LightBounds{ apex + direction * radius, radius };
+	}
+
+	void SetGridSize(uint16_t tileCountX, uint16_t tileCountY, uint16_t sliceCount)
+	{
+		m_tileCountX = tileCountX;
+		m_tileCountY = tileCountY;
+		m_sliceCount = sliceCount;
+		m_isGridDirty = true;
+	}
+
+	// xScale and yScale are the first two diagonal elements of the projection matrix, which map view x / z and y / z to NDC.
+	void SetProjection(float xScale, float yScale, float nearPlane, float farPlane)
+	{
+		if (xScale == m_xScale && yScale == m_yScale && nearPlane == m_nearPlane && farPlane == m_farPlane)
+		{
+			return;
+		}
+
+		m_xScale = xScale;
+		m_yScale = yScale;
+		m_nearPlane = nearPlane;
+		m_farPlane = farPlane;
+		m_isGridDirty = true;
+	}
+
+	uint16_t GetTileCountX() const { return m_tileCountX; }
+	uint16_t GetTileCountY() const { return m_tileCountY; }
+	uint16_t GetSliceCount() const { return m_sliceCount; }
+	uint32_t GetClusterCount() const { return static_cast<uint32_t>(m_tileCountX) * m_tileCountY * m_sliceCount; }
+	uint32_t GetClusterIndex(uint32_t tileX, uint32_t tileY, uint32_t slice) const { return (slice * m_tileCountY + tileY) * m_tileCountX + tileX; }
+
+	// Shaders find the slice by slice = log(viewDepth) * scale + bias.
+	float GetSliceScale() const { return m_sliceCount / std::log(m_farPlane / m_nearPlane); }
+	float GetSliceBias() const { return -std::log(m_nearPlane) * GetSliceScale(); }
+
+	uint32_t GetSliceIndex(float viewDepth) const
+	{
+		float slice = std::floor(std::log(std::max(viewDepth, m_nearPlane)) * GetSliceScale() + GetSliceBias());
+		return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(m_sliceCount - 1)));
+	}
+
+	float GetSliceDepth(uint32_t slice) const
+	{
+		return m_nearPlane * std::pow(m_farPlane / m_nearPlane, static_cast<float>(slice) / m_sliceCount);
+	}
+
+	const ClusterAABB& GetClusterAABB(uint32_t clusterIndex)
+	{
+		UpdateClusterAABBs();
+		return m_clusterAABBs[clusterIndex];
+	}
+
+	void Build(const std::vector<LightBounds>& lights)
+	{
+		UpdateClusterAABBs();
+
+		// Collect pairs of clusters and lights at first, then sort lights into lists by counting.
+		// Lights are visited in order, so indexes are ascending in every list.
+		m_clusterLightPairs.clear();
+		m_clusterRanges.assign(GetClusterCount(), ClusterRange{ 0, 0 });
+		for (uint32_t lightIndex = 0; lightIndex < lights.size(); ++lightIndex)
+		{
+			AddLight(lightIndex, lights[lightIndex]);
+		}
+
+		uint32_t offset = 0;
+		m_maxLightCountPerCluster = 0;
+		for (ClusterRange& clusterRange : m_clusterRanges)
+		{
+			clusterRange.offset = offset;
+			offset += clusterRange.count;
+			m_maxLightCountPerCluster = std::max(m_maxLightCountPerCluster, clusterRange.count);
+			clusterRange.count = 0;
+		}
+
+		m_lightIndices.resize(m_clusterLightPairs.size());
+		for (const ClusterLightPair& pair : m_clusterLightPairs)
+		{
+			ClusterRange& clusterRange = m_clusterRanges[pair.clusterIndex];
+			m_lightIndices[clusterRange.offset + clusterRange.count++] = pair.lightIndex;
+		}
+	}
+
+	const std::vector<ClusterRange>& GetClusterRanges() const { return m_clusterRanges; }
+	const std::vector<uint32_t>& GetLightIndices() const { return m_lightIndices; }
+	uint32_t GetMaxLightCountPerCluster() const { return m_maxLightCountPerCluster; }
+
+private:
+	struct ClusterLightPair
+	{
+		uint32_t clusterIndex;
+		uint32_t lightIndex;
+	};
+
+	void AddLight(uint32_t lightIndex, const LightBounds& bounds)
+	{
+		if (bounds.IsUnbounded())
+		{
+			for (uint32_t clusterIndex = 0; clusterIndex < GetClusterCount(); ++clusterIndex)
+			{
+				AddPair(clusterIndex, lightIndex);
+			}
+			return;
+		}
+
+		const cd::Vec3f& center = bounds.center;
+		float minDepth = std::max(center.z() - bounds.radius, m_nearPlane);
+		float maxDepth = std::min(center.z() + bounds.radius, m_farPlane);
+		if (minDepth > maxDepth)
+		{
+			return;
+		}
+
+		uint32_t firstSlice = GetSliceIndex(minDepth);
+		uint32_t lastSlice = GetSliceIndex(maxDepth);
+		for (uint32_t slice = firstSlice; slice <= lastSlice; ++slice)
+		{
+			// NDC of the sphere's bounding box is extreme at the nearest or farthest depth of the slice which the sphere covers.
+			float nearDepth = std::max(GetSliceDepth(slice), minDepth);
+			float farDepth = std::min(GetSliceDepth(slice + 1), maxDepth);
+			auto getTileRange = [nearDepth, farDepth](float minView, float maxView, float scale, uint32_t tileCount, uint32_t& firstTile, uint32_t& lastTile)
+			{
+				float minNDC = std::min(minView * scale / nearDepth, minView * scale / farDepth);
+				float maxNDC = std::max(maxView * scale / nearDepth, maxView * scale / farDepth);
+				float minTile = std::floor((minNDC * 0.5f + 0.5f) * tileCount);
+				float maxTile = std::floor((maxNDC * 0.5f + 0.5f) * tileCount);
+				if (maxTile < 0.0f || minTile >= tileCount)
+				{
+					return false;
+				}
+
+				firstTile = static_cast<uint32_t>(std::max(minTile, 0.0f));
+				lastTile = static_cast<uint32_t>(std::min(maxTile, static_cast<float>(tileCount - 1)));
+				return true;
+			};
+
+			uint32_t firstTileX, lastTileX, firstTileY, lastTileY;
+			if (!getTileRange(center.x() - bounds.radius, center.x() + bounds.radius, m_xScale, m_tileCountX, firstTileX, lastTileX) ||
+				!getTileRange(center.y() - bounds.radius, center.y() + bounds.radius, m_yScale, m_tileCountY, firstTileY, lastTileY))
+			{
+				continue;
+			}
+
+			for (uint32_t tileY = firstTileY; tileY <= lastTileY; ++tileY)
+			{
+				for (uint32_t tileX = firstTileX; tileX <= lastTileX; ++tileX)
+				{
+					uint32_t clusterIndex = GetClusterIndex(tileX, tileY, slice);
+					if (IntersectSphereAABB(bounds, m_clusterAABBs[clusterIndex]))
+					{
+						AddPair(clusterIndex, lightIndex);
+					}
+				}
+			}
+		}
+	}
+
+	void AddPair(uint32_t clusterIndex, uint32_t lightIndex)
+	{
+		m_clusterLightPairs.push_back(ClusterLightPair{ clusterIndex, lightIndex });
+		++m_clusterRanges[clusterIndex].count;
+	}
+
+	static bool IntersectSphereAABB(const LightBounds& bounds, const ClusterAABB& aabb)
+	{
+		float squaredDistance = 0.0f;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float distance = std::max({ aabb.min[axis] - bounds.center[axis], 0.0f, bounds.center[axis] - aabb.max[axis] });
+			squaredDistance += distance * distance;
+		}
+		return squaredDistance <= bounds.radius * bounds.radius;
+	}
+
+	// A cluster is bounded by its tile's side planes between the near and far depths of its slice.
+	void UpdateClusterAABBs()
+	{
+		if (!m_isGridDirty)
+		{
+			return;
+		}
+		m_isGridDirty = false;
+
+		m_clusterAABBs.resize(GetClusterCount());
+		for (uint32_t slice = 0; slice < m_sliceCount; ++slice)
+		{
+			float nearDepth = GetSliceDepth(slice);
+			float farDepth = GetSliceDepth(slice + 1);
+			for (uint32_t tileY = 0; tileY < m_tileCountY; ++tileY)
+			{
+				float minNDCY = -1.0f + 2.0f * tileY / m_tileCountY;
+				float maxNDCY = -1.0f + 2.0f * (tileY + 1) / m_tileCountY;
+				for (uint32_t tileX = 0; tileX < m_tileCountX; ++tileX)
+				{
+					float minNDCX = -1.0f + 2.0f * tileX / m_tileCountX;
+					float maxNDCX = -1.0f + 2.0f * (tileX + 1) / m_tileCountX;
+
+					ClusterAABB& aabb = m_clusterAABBs[GetClusterIndex(tileX, tileY, slice)];
+					aabb.min = cd::Vec3f(std::min(minNDCX * nearDepth, minNDCX * farDepth) / m_xScale, std::min(minNDCY * nearDepth, minNDCY * farDepth) / m_yScale, nearDepth);
+					aabb.max = cd::Vec3f(std::max(maxNDCX * nearDepth, maxNDCX * farDepth) / m_xScale, std::max(maxNDCY * nearDepth, maxNDCY * farDepth) / m_yScale, farDepth);
+				}
+			}
+		}
+	}
+
+private:
+	uint16_t m_tileCountX = 16;
+	uint16_t m_tileCountY = 9;
+	uint16_t m_sliceCount = 24;
+	float m_xScale = 1.0f;
+	float m_yScale = 1.0f;
+	float m_nearPlane = 0.1f;
+	float m_farPlane = 1000.0f;
+	bool m_isGridDirty = true;
+
+	std::vector<ClusterAABB> m_clusterAABBs;
+	std::vector<ClusterLightPair> m_clusterLightPairs;
+	std::vector<ClusterRange> m_clusterRanges;
+	std::vector<uint32_t> m_lightIndices;
+	uint32_t m_maxLightCountPerCluster = 0;
+};
+
+}
\ No newline at end of file
@@ -27,6 +27,34 @@ void LightUniform::Update(std::vector<U_Light> &lights) {
 	}
 }
 
+void LightUniform::Update(const ComponentsStorage<LightComponent> &lightStorage) {
+	if (!lightStorage.HasChangedSince(m_lastUpdateTick)) {
+		return;
+	}
+	m_lastUpdateTick = lightStorage.GetCurrentTick();
+
+	const std::vector<LightComponent> &lightComponents = lightStorage.GetComponents();
+	m_lightCount = static_cast<uint16_t>(lightComponents.size());
+	assert(m_lightCount <= MAX_LIGHT_COUNT && "Light count overflow.");
+
+	for (size_t index = 0; index < m_lightCount; ++index) {
+		const LightComponent &source = lightComponents[index];
+		auto &target = m_light[index];
+		target.type = static_cast<float>(source.GetType());
+		target.position = source.GetPosition();
+		target.intensity = source.GetIntensity();
+		target.color = source.GetColor();
+		target.range = source.GetRange();
+		target.direction = source.GetDirection();
+		target.radius = source.GetRadius();
+		target.up = source.GetUp();
+		target.width = source.GetWidth();
+		target.height = source.GetHeight();
+		target.lightAngleScale = source.GetAngleScale();
+		target.lightAngleOffeset = source.GetAngleOffset();
+	}
+}
+
 void LightUniform::Submit(const uint16_t lightNum) {
 	assert(lightNum <= MAX_LIGHT_COUNT && "Light count overflow.");
 	m_pRenderContext->FillUniform(StringCrc("u_lightParams"), m_lightParams, lightNum * LIGHT_STRIDE);
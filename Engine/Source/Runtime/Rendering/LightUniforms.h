@@ -1,5 +1,7 @@
 #pragma once
 
+#include "ECWorld/ComponentsStorage.hpp"
+#include "ECWorld/LightComponent.h"
 #include "Light.h"
 #include "RenderContext.h"
 
@@ -37,6 +39,8 @@ public:
 	LightUniform &operator=(LightUniform &&) = delete;
 
 	void Update(std::vector<U_Light> &lights);
+	// Repack lights only when any LightComponent was created, modified or removed since the last update.
+	void Update(const ComponentsStorage<LightComponent> &lightStorage);
 	void Submit(const uint16_t lightNum);
 	void Submit();
 
@@ -54,6 +58,7 @@ private:
 
 	RenderContext *m_pRenderContext = nullptr;
 	uint16_t m_lightCount = 0;
+	ChangeTick m_lastUpdateTick = 0;
 };
 
 } // namespace engine
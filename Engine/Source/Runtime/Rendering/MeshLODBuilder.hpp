@@ -0,0 +1,415 @@
+#pragma once
+
+#include "Math/Vector.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace engine
+{
+
+// Range of a LOD in the index buffer of a mesh.
+// Error is the distance in object space which the LOD may deviate from the full mesh. It is 0 for LOD 0.
+struct MeshLOD
+{
+	uint32_t indexOffset = 0;
+	uint32_t indexCount = 0;
+	float error = 0.0f;
+};
+
+// Returns the coarsest LOD whose error projected to the screen is within maxPixelError.
+// errorScale converts an object space error at view depth 1 to pixels, which is worldScale * viewportHeight * 0.5 * projection[5].
+// LODs are sorted by increasing errors. The full mesh is used when the mesh is not in front of the camera.
+inline uint32_t SelectMeshLOD(const std::vector<MeshLOD>& lods, float errorScale, float viewDepth, float maxPixelError)
+{
+	uint32_t lodIndex = 0;
+	if (viewDepth <= 0.0f)
+	{
+		return lodIndex;
+	}
+
+	while (lodIndex + 1 < lods.size() && lods[lodIndex + 1].error * errorScale <= maxPixelError * viewDepth)
+	{
+		++lodIndex;
+	}
+	return lodIndex;
+}
+
+// MeshLODBuilder simplifies a triangle list into a chain of LODs by quadric error edge collapses.
+// A vertex is collapsed onto one of its neighbors, so LODs are index lists which share the vertex buffer of the full mesh.
+// Quadrics sum squared distances to planes of original triangles without weights. So the square root of a collapse cost
+// bounds the distance between the kept vertex and every plane of triangles which are merged into it.
+// Vertices on open borders and attribute seams are locked, which keeps outlines of open meshes and UV charts.
+class MeshLODBuilder final
+{
+public:
+	struct Settings
+	{
+		// Count of LODs after the full mesh. 0 disables simplification.
+		uint32_t lodCount = 3;
+		// Triangle count of a LOD compared to the previous LOD.
+		float triangleRatio = 0.5f;
+		// Simplification stops at this error relative to the radius of mesh bounds.
+		float maxRelativeError = 0.02f;
+		// Meshes with fewer triangles are cheap enough without LODs.
+		uint32_t minTriangleCount = 256;
+	};
+
+public:
+	MeshLODBuilder() = default;
+	explicit MeshLODBuilder(const Settings& settings) : m_settings(settings) {}
+	MeshLODBuilder(const MeshLODBuilder&) = default;
+	MeshLODBuilder& operator=(const MeshLODBuilder&) = default;
+	MeshLODBuilder(MeshLODBuilder&&) = default;
+	MeshLODBuilder& operator=(MeshLODBuilder&&) = default;
+	~MeshLODBuilder() = default;
+
+	const Settings& GetSettings() const { return m_settings; }
+	void SetSettings(const Settings& settings) { m_settings = settings; }
+
+	void Build(const cd::Vec3f* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount)
+	{
+		m_indices.assign(pIndices, pIndices + indexCount);
+		m_lods.clear();
+		m_lods.push_back(MeshLOD{ 0, indexCount, 0.0f });
+
+		const uint32_t triangleCount = indexCount / 3;
+		if (0 == m_settings.lodCount || triangleCount < m_settings.minTriangleCount)
+		{
+			return;
+		}
+
+		Init(pPositions, vertexCount);
+
+		cd::Vec3f minPosition(FLT_MAX, FLT_MAX, FLT_MAX);
+		cd::Vec3f maxPosition(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (uint32_t vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				minPosition[axis] = std::min(minPosition[axis], pPositions[vertexIndex][axis]);
+				maxPosition[axis] = std::max(maxPosition[axis], pPositions[vertexIndex][axis]);
+			}
+		}
+		const double maxError = m_settings.maxRelativeError * 0.5 * (maxPosition - minPosition).Length();
+		const double maxCost = maxError * maxError;
+
+		// Collapses are applied in the order of costs until the triangle count of a LOD is reached.
+		// LODs continue from the previous one, so errors and triangle counts are monotonic along the chain.
+		double lodCost = 0.0;
+		uint32_t aliveTriangleCount = triangleCount;
+		for (uint32_t lodIndex = 1; lodIndex <= m_settings.lodCount; ++lodIndex)
+		{
+			const uint32_t targetTriangleCount = static_cast<uint32_t>(aliveTriangleCount * m_settings.triangleRatio);
+			while (aliveTriangleCount > targetTriangleCount && !m_collapses.empty())
+			{
+				Collapse collapse = m_collapses.top();
+				if (collapse.cost > maxCost)
+				{
+					break;
+				}
+
+				m_collapses.pop();
+				if (IsCollapseValid(collapse))
+				{
+					aliveTriangleCount -= ApplyCollapse(collapse);
+					lodCost = std::max(lodCost, collapse.cost);
+				}
+			}
+
+			if (aliveTriangleCount * 3 >= m_lods.back().indexCount)
+			{
+				break;
+			}
+
+			MeshLOD& lod = m_lods.emplace_back();
+			lod.indexOffset = static_cast<uint32_t>(m_indices.size());
+			lod.indexCount = aliveTriangleCount * 3;
+			lod.error = static_cast<float>(std::sqrt(lodCost));
+			for (uint32_t triangleIndex = 0; triangleIndex < triangleCount; ++triangleIndex)
+			{
+				if (!m_isTriangleRemoved[triangleIndex])
+				{
+					m_indices.insert(m_indices.end(), &m_triangles[triangleIndex * 3], &m_triangles[triangleIndex * 3] + 3);
+				}
+			}
+		}
+
+		Reset();
+	}
+
+	// Indexes of all LODs, starting with the full mesh.
+	const std::vector<uint32_t>& GetIndices() const { return m_indices; }
+	const std::vector<MeshLOD>& GetLODs() const { return m_lods; }
+
+private:
+	// Symmetric 4x4 matrix of plane equations. Evaluate returns the sum of squared distances to the planes.
+	struct Quadric
+	{
+		double aa = 0.0, ab = 0.0, ac = 0.0, ad = 0.0, bb = 0.0, bc = 0.0, bd = 0.0, cc = 0.0, cd = 0.0, dd = 0.0;
+
+		void AddPlane(double a, double b, double c, double d)
+		{
+			aa += a * a; ab += a * b; ac += a * c; ad += a * d;
+			bb += b * b; bc += b * c; bd += b * d;
+			cc += c * c; cd += c * d;
+			dd += d * d;
+		}
+
+		void Add(const Quadric& other)
+		{
+			aa += other.aa; ab += other.ab; ac += other.ac; ad += other.ad;
+			bb += other.bb; bc += other.bc; bd += other.bd;
+			cc += other.cc; cd += other.cd;
+			dd += other.dd;
+		}
+
+		double Evaluate(const cd::Vec3f& point) const
+		{
+			double x = point.x(), y = point.y(), z = point.z();
+			double error = aa * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+				bb * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+				cc * z * z + 2.0 * cd * z + dd;
+			return std::max(error, 0.0);
+		}
+	};
+
+	// Collapse of vertex from onto vertex to. Versions detect collapses which are out of date.
+	struct Collapse
+	{
+		double cost;
+		uint32_t from;
+		uint32_t to;
+		uint32_t fromVersion;
+		uint32_t toVersion;
+
+		bool operator>(const Collapse& other) const { return cost > other.cost; }
+	};
+
+	void Init(const cd::Vec3f* pPositions, uint32_t vertexCount)
+	{
+		m_pPositions = pPositions;
+		m_triangles = m_indices;
+		const uint32_t triangleCount = static_cast<uint32_t>(m_triangles.size() / 3);
+		m_isTriangleRemoved.assign(triangleCount, false);
+		m_vertexTriangles.assign(vertexCount, {});
+		m_quadrics.assign(vertexCount, Quadric());
+		m_isVertexLocked.assign(vertexCount, false);
+		m_isVertexRemoved.assign(vertexCount, false);
+		m_vertexVersions.assign(vertexCount, 0);
+
+		// Edges which are not shared by exactly two triangles are on borders, seams or non-manifold.
+		std::unordered_map<uint64_t, uint32_t> edgeTriangleCounts;
+		for (uint32_t triangleIndex = 0; triangleIndex < triangleCount; ++triangleIndex)
+		{
+			const uint32_t* pTriangle = &m_triangles[triangleIndex * 3];
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				m_vertexTriangles[pTriangle[corner]].push_back(triangleIndex);
+
+				uint32_t v0 = pTriangle[corner];
+				uint32_t v1 = pTriangle[(corner + 1) % 3];
+				++edgeTriangleCounts[static_cast<uint64_t>(std::min(v0, v1)) << 32 | std::max(v0, v1)];
+			}
+
+			cd::Vec3f normal = GetTriangleNormal(pTriangle[0], pTriangle[1], pTriangle[2]);
+			double length = normal.Length();
+			if (length > 0.0)
+			{
+				double a = normal.x() / length, b = normal.y() / length, c = normal.z() / length;
+				const cd::Vec3f& point = m_pPositions[pTriangle[0]];
+				double d = -(a * point.x() + b * point.y() + c * point.z());
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					m_quadrics[pTriangle[corner]].AddPlane(a, b, c, d);
+				}
+			}
+		}
+
+		for (const auto& [edge, edgeTriangleCount] : edgeTriangleCounts)
+		{
+			if (edgeTriangleCount != 2)
+			{
+				m_isVertexLocked[static_cast<uint32_t>(edge >> 32)] = true;
+				m_isVertexLocked[static_cast<uint32_t>(edge)] = true;
+			}
+		}
+
+		m_collapses = {};
+		for (uint32_t vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex)
+		{
+			PushCollapses(vertexIndex);
+		}
+	}
+
+	void Reset()
+	{
+		m_pPositions = nullptr;
+		m_triangles.clear();
+		m_isTriangleRemoved.clear();
+		m_vertexTriangles.clear();
+		m_quadrics.clear();
+		m_isVertexLocked.clear();
+		m_isVertexRemoved.clear();
+		m_vertexVersions.clear();
+		m_collapses = {};
+	}
+
+	cd::Vec3f GetTriangleNormal(uint32_t v0, uint32_t v1, uint32_t v2) const
+	{
+		return (m_pPositions[v1] - m_pPositions[v0]).Cross(m_pPositions[v2] - m_pPositions[v0]);
+	}
+
+	// Pushes collapses of the vertex onto its neighbors and of its neighbors onto the vertex.
+	void PushCollapses(uint32_t vertex)
+	{
+		for (uint32_t triangleIndex : m_vertexTriangles[vertex])
+		{
+			const uint32_t* pTriangle = &m_triangles[triangleIndex * 3];
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				uint32_t neighbor = pTriangle[corner];
+				if (neighbor == vertex)
+				{
+					continue;
+				}
+
+				PushCollapse(vertex, neighbor);
+				PushCollapse(neighbor, vertex);
+			}
+		}
+	}
+
+	void PushCollapse(uint32_t from, uint32_t to)
+	{
+		if (m_isVertexLocked[from])
+		{
+			return;
+		}
+
+		Quadric quadric = m_quadrics[from];
+		quadric.Add(m_quadrics[to]);
+		m_collapses.push(Collapse{ quadric.Evaluate(m_pPositions[to]), from, to, m_vertexVersions[from], m_vertexVersions[to] });
+	}
+
+	bool IsCollapseValid(const Collapse& collapse) const
+	{
+		if (m_isVertexRemoved[collapse.from] || m_isVertexRemoved[collapse.to] ||
+			collapse.fromVersion != m_vertexVersions[collapse.from] || collapse.toVersion != m_vertexVersions[collapse.to])
+		{
+			return false;
+		}
+
+		// Link condition. Vertices of an interior edge share exactly the two opposite vertices,
+		// more shared neighbors would make the mesh non-manifold after the collapse.
+		std::vector<uint32_t> fromNeighbors = GetNeighbors(collapse.from);
+		std::vector<uint32_t> toNeighbors = GetNeighbors(collapse.to);
+		std::vector<uint32_t> sharedNeighbors;
+		std::set_intersection(fromNeighbors.begin(), fromNeighbors.end(), toNeighbors.begin(), toNeighbors.end(), std::back_inserter(sharedNeighbors));
+		if (sharedNeighbors.size() > 2)
+		{
+			return false;
+		}
+
+		// Triangles which move with the vertex must not flip, degenerate or turn steeply, which also prevents slivers.
+		for (uint32_t triangleIndex : m_vertexTriangles[collapse.from])
+		{
+			const uint32_t* pTriangle = &m_triangles[triangleIndex * 3];
+			if (pTriangle[0] == collapse.to || pTriangle[1] == collapse.to || pTriangle[2] == collapse.to)
+			{
+				continue;
+			}
+
+			cd::Vec3f oldNormal = GetTriangleNormal(pTriangle[0], pTriangle[1], pTriangle[2]);
+			cd::Vec3f newNormal = GetTriangleNormal(pTriangle[0] == collapse.from ? collapse.to : pTriangle[0],
+				pTriangle[1] == collapse.from ? collapse.to : pTriangle[1], pTriangle[2] == collapse.from ? collapse.to : pTriangle[2]);
+			if (newNormal.Dot(oldNormal) <= 0.25f * newNormal.Length() * oldNormal.Length())
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	std::vector<uint32_t> GetNeighbors(uint32_t vertex) const
+	{
+		std::vector<uint32_t> neighbors;
+		for (uint32_t triangleIndex : m_vertexTriangles[vertex])
+		{
+			const uint32_t* pTriangle = &m_triangles[triangleIndex * 3];
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				if (pTriangle[corner] != vertex)
+				{
+					neighbors.push_back(pTriangle[corner]);
+				}
+			}
+		}
+		std::sort(neighbors.begin(), neighbors.end());
+		neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+		return neighbors;
+	}
+
+	// Returns the count of removed triangles.
+	uint32_t ApplyCollapse(const Collapse& collapse)
+	{
+		uint32_t removedTriangleCount = 0;
+		std::vector<uint32_t>& toTriangles = m_vertexTriangles[collapse.to];
+		for (uint32_t triangleIndex : m_vertexTriangles[collapse.from])
+		{
+			uint32_t* pTriangle = &m_triangles[triangleIndex * 3];
+			if (pTriangle[0] == collapse.to || pTriangle[1] == collapse.to || pTriangle[2] == collapse.to)
+			{
+				m_isTriangleRemoved[triangleIndex] = true;
+				++removedTriangleCount;
+				continue;
+			}
+
+			std::replace(pTriangle, pTriangle + 3, collapse.from, collapse.to);
+			toTriangles.push_back(triangleIndex);
+		}
+		std::erase_if(toTriangles, [this](uint32_t triangleIndex) { return m_isTriangleRemoved[triangleIndex]; });
+
+		// Removed triangles are also referenced by the third vertices. Costs of other collapses of neighbors don't change.
+		for (uint32_t neighbor : GetNeighbors(collapse.to))
+		{
+			std::erase_if(m_vertexTriangles[neighbor], [this](uint32_t triangleIndex) { return m_isTriangleRemoved[triangleIndex]; });
+		}
+
+		m_quadrics[collapse.to].Add(m_quadrics[collapse.from]);
+		m_vertexTriangles[collapse.from].clear();
+		m_isVertexRemoved[collapse.from] = true;
+		++m_vertexVersions[collapse.to];
+		PushCollapses(collapse.to);
+
+		return removedTriangleCount;
+	}
+
+private:
+	Settings m_settings;
+
+	// Outputs.
+	std::vector<uint32_t> m_indices;
+	std::vector<MeshLOD> m_lods;
+
+	// States of the simplification.
+	const cd::Vec3f* m_pPositions = nullptr;
+	std::vector<uint32_t> m_triangles;
+	std::vector<bool> m_isTriangleRemoved;
+	std::vector<std::vector<uint32_t>> m_vertexTriangles;
+	std::vector<Quadric> m_quadrics;
+	std::vector<bool> m_isVertexLocked;
+	std::vector<bool> m_isVertexRemoved;
+	std::vector<uint32_t> m_vertexVersions;
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> m_collapses;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,312 @@
+#pragma once
+
+#include "Math/Vector.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace engine
+{
+
+// Efficiency of the post-transform vertex cache which is simulated as a FIFO.
+// ACMR is the average count of cache misses per triangle, 0.5 is the best case of a large regular grid and 3 is the worst.
+// ATVR is the average count of transforms per referenced vertex, 1 is the best case.
+struct VertexCacheStats
+{
+	float acmr = 0.0f;
+	float atvr = 0.0f;
+};
+
+// MeshOptimizer reorders triangle lists before they are uploaded:
+// - OptimizeVertexCache orders triangles by Tipsify, which fans around vertices while their neighbors are still in the cache.
+// - OptimizeOverdraw splits the cache friendly order into clusters and draws outward facing clusters on the outside first,
+//   so that they occlude inner surfaces from most views.
+// - OptimizeVertexFetch renumbers vertices in the order of first use, so that vertex buffer reads are sequential.
+class MeshOptimizer final
+{
+public:
+	static constexpr uint32_t DefaultCacheSize = 16;
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+public:
+	MeshOptimizer() = delete;
+
+	static VertexCacheStats AnalyzeVertexCache(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = DefaultCacheSize)
+	{
+		VertexCacheStats stats;
+		if (0 == indexCount)
+		{
+			return stats;
+		}
+
+		// Timestamps of vertices entering the cache. A vertex is in the FIFO if it entered less than cacheSize misses ago.
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		std::vector<bool> isReferenced(vertexCount, false);
+		uint32_t missCount = 0;
+		uint32_t referencedCount = 0;
+		for (uint32_t index = 0; index < indexCount; ++index)
+		{
+			uint32_t vertex = pIndices[index];
+			if (0 == cacheTimestamps[vertex] || missCount + 1 - cacheTimestamps[vertex] > cacheSize)
+			{
+				++missCount;
+				cacheTimestamps[vertex] = missCount;
+			}
+
+			if (!isReferenced[vertex])
+			{
+				isReferenced[vertex] = true;
+				++referencedCount;
+			}
+		}
+
+		stats.acmr = static_cast<float>(missCount) / static_cast<float>(indexCount / 3);
+		stats.atvr = static_cast<float>(missCount) / static_cast<float>(referencedCount);
+		return stats;
+	}
+
+	// Reorders triangles in place. Triangle indexes where the order jumps to a vertex out of the cache are appended to
+	// pHardBoundaries if it is not null, which are the places where OptimizeOverdraw can split clusters cheaply.
+	static void OptimizeVertexCache(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint32_t>* pHardBoundaries = nullptr,
+		uint32_t cacheSize = DefaultCacheSize)
+	{
+		const uint32_t triangleCount = indexCount / 3;
+		if (0 == triangleCount)
+		{
+			return;
+		}
+
+		// Triangles of every vertex are stored in a compact list.
+		std::vector<uint32_t> liveTriangleCounts(vertexCount, 0);
+		for (uint32_t index = 0; index < indexCount; ++index)
+		{
+			++liveTriangleCounts[pIndices[index]];
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		std::inclusive_scan(liveTriangleCounts.begin(), liveTriangleCounts.end(), adjacencyOffsets.begin() + 1);
+		std::vector<uint32_t> adjacency(indexCount);
+		std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t index = 0; index < indexCount; ++index)
+		{
+			adjacency[adjacencyFill[pIndices[index]]++] = index / 3;
+		}
+
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		std::vector<bool> isTriangleEmitted(triangleCount, false);
+		std::vector<uint32_t> deadEndStack;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> outputIndices;
+		outputIndices.reserve(indexCount);
+
+		uint32_t timestamp = cacheSize + 1;
+		uint32_t cursor = 0;
+		uint32_t fanningVertex = 0;
+		while (fanningVertex < vertexCount && 0 == liveTriangleCounts[fanningVertex])
+		{
+			++fanningVertex;
+		}
+
+		while (fanningVertex != InvalidIndex)
+		{
+			candidates.clear();
+			for (uint32_t adjacencyIndex = adjacencyOffsets[fanningVertex]; adjacencyIndex < adjacencyOffsets[fanningVertex + 1]; ++adjacencyIndex)
+			{
+				uint32_t triangle = adjacency[adjacencyIndex];
+				if (isTriangleEmitted[triangle])
+				{
+					continue;
+				}
+
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					uint32_t vertex = pIndices[triangle * 3 + corner];
+					outputIndices.push_back(vertex);
+					deadEndStack.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveTriangleCounts[vertex];
+					if (timestamp - cacheTimestamps[vertex] > cacheSize)
+					{
+						cacheTimestamps[vertex] = timestamp++;
+					}
+				}
+				isTriangleEmitted[triangle] = true;
+			}
+
+			// Prefer the candidate which stays longest in the cache while all of its remaining triangles are emitted.
+			uint32_t nextVertex = InvalidIndex;
+			uint32_t bestPriority = 0;
+			for (uint32_t vertex : candidates)
+			{
+				if (0 == liveTriangleCounts[vertex])
+				{
+					continue;
+				}
+
+				uint32_t priority = 0;
+				if (timestamp - cacheTimestamps[vertex] + 2 * liveTriangleCounts[vertex] <= cacheSize)
+				{
+					priority = timestamp - cacheTimestamps[vertex];
+				}
+
+				if (InvalidIndex == nextVertex || priority > bestPriority)
+				{
+					nextVertex = vertex;
+					bestPriority = priority;
+				}
+			}
+
+			if (InvalidIndex == nextVertex)
+			{
+				nextVertex = SkipDeadEnd(liveTriangleCounts, deadEndStack, cursor);
+				if (pHardBoundaries && nextVertex != InvalidIndex)
+				{
+					pHardBoundaries->push_back(static_cast<uint32_t>(outputIndices.size() / 3));
+				}
+			}
+			fanningVertex = nextVertex;
+		}
+
+		std::copy(outputIndices.begin(), outputIndices.end(), pIndices);
+	}
+
+	// Reorders clusters of triangles in place. Clusters end at hard boundaries after their ACMR drops to the threshold,
+	// so small clusters don't restart the cache too often. Clusters are sorted by how far they face out from the mesh center.
+	static void OptimizeOverdraw(uint32_t* pIndices, uint32_t indexCount, const cd::Vec3f* pPositions, uint32_t vertexCount,
+		const std::vector<uint32_t>& hardBoundaries, float acmrThreshold = 1.05f, uint32_t cacheSize = DefaultCacheSize)
+	{
+		const uint32_t triangleCount = indexCount / 3;
+		if (0 == triangleCount)
+		{
+			return;
+		}
+
+		// Timestamps are counts of misses when vertices enter the cache. A new cluster starts with an empty cache,
+		// so vertices which entered before the cluster are misses too.
+		std::vector<uint32_t> clusterStarts = { 0 };
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t missCount = 0;
+		uint32_t clusterMissStart = 0;
+		auto boundaryIt = hardBoundaries.begin();
+		for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+		{
+			while (boundaryIt != hardBoundaries.end() && *boundaryIt < triangle)
+			{
+				++boundaryIt;
+			}
+
+			uint32_t clusterTriangleCount = triangle - clusterStarts.back();
+			bool isHardBoundary = boundaryIt != hardBoundaries.end() && *boundaryIt == triangle;
+			if (isHardBoundary && clusterTriangleCount > 0 && static_cast<float>(missCount - clusterMissStart) <= acmrThreshold * clusterTriangleCount)
+			{
+				clusterStarts.push_back(triangle);
+				clusterMissStart = missCount;
+			}
+
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				uint32_t& vertexTimestamp = cacheTimestamps[pIndices[triangle * 3 + corner]];
+				if (vertexTimestamp <= clusterMissStart || missCount - vertexTimestamp >= cacheSize)
+				{
+					++missCount;
+					vertexTimestamp = missCount;
+				}
+			}
+		}
+		clusterStarts.push_back(triangleCount);
+
+		// Area weighted centroids and normals of clusters and the mesh.
+		const uint32_t clusterCount = static_cast<uint32_t>(clusterStarts.size() - 1);
+		std::vector<cd::Vec3f> clusterCentroids(clusterCount, cd::Vec3f(0.0f, 0.0f, 0.0f));
+		std::vector<cd::Vec3f> clusterNormals(clusterCount, cd::Vec3f(0.0f, 0.0f, 0.0f));
+		cd::Vec3f meshCentroid(0.0f, 0.0f, 0.0f);
+		float meshArea = 0.0f;
+		for (uint32_t cluster = 0; cluster < clusterCount; ++cluster)
+		{
+			float clusterArea = 0.0f;
+			for (uint32_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; ++triangle)
+			{
+				const cd::Vec3f& p0 = pPositions[pIndices[triangle * 3]];
+				const cd::Vec3f& p1 = pPositions[pIndices[triangle * 3 + 1]];
+				const cd::Vec3f& p2 = pPositions[pIndices[triangle * 3 + 2]];
+				cd::Vec3f normal = (p1 - p0).Cross(p2 - p0);
+				float area = normal.Length();
+				clusterCentroids[cluster] = clusterCentroids[cluster] + (p0 + p1 + p2) * (area / 3.0f);
+				clusterNormals[cluster] = clusterNormals[cluster] + normal;
+				clusterArea += area;
+			}
+
+			meshCentroid = meshCentroid + clusterCentroids[cluster];
+			meshArea += clusterArea;
+			clusterCentroids[cluster] = clusterArea > 0.0f ? clusterCentroids[cluster] * (1.0f / clusterArea) : pPositions[pIndices[clusterStarts[cluster] * 3]];
+		}
+		meshCentroid = meshArea > 0.0f ? meshCentroid * (1.0f / meshArea) : clusterCentroids[0];
+
+		std::vector<float> sortKeys(clusterCount);
+		for (uint32_t cluster = 0; cluster < clusterCount; ++cluster)
+		{
+			float normalLength = clusterNormals[cluster].Length();
+			sortKeys[cluster] = normalLength > 0.0f ? (clusterCentroids[cluster] - meshCentroid).Dot(clusterNormals[cluster]) / normalLength : 0.0f;
+		}
+
+		std::vector<uint32_t> clusterOrder(clusterCount);
+		std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32_t lhs, uint32_t rhs) { return sortKeys[lhs] > sortKeys[rhs]; });
+
+		std::vector<uint32_t> outputIndices;
+		outputIndices.reserve(indexCount);
+		for (uint32_t cluster : clusterOrder)
+		{
+			outputIndices.insert(outputIndices.end(), pIndices + clusterStarts[cluster] * 3, pIndices + clusterStarts[cluster + 1] * 3);
+		}
+		std::copy(outputIndices.begin(), outputIndices.end(), pIndices);
+	}
+
+	// Renumbers vertices in place by their first use and returns the old vertex of every new vertex.
+	// Vertices which are not referenced are dropped.
+	static std::vector<uint32_t> OptimizeVertexFetch(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount)
+	{
+		std::vector<uint32_t> remap(vertexCount, InvalidIndex);
+		std::vector<uint32_t> vertexOrder;
+		for (uint32_t index = 0; index < indexCount; ++index)
+		{
+			uint32_t& newVertex = remap[pIndices[index]];
+			if (InvalidIndex == newVertex)
+			{
+				newVertex = static_cast<uint32_t>(vertexOrder.size());
+				vertexOrder.push_back(pIndices[index]);
+			}
+			pIndices[index] = newVertex;
+		}
+		return vertexOrder;
+	}
+
+private:
+	// Returns a recently used vertex which still has triangles, or the next one by the cursor if there is none.
+	static uint32_t SkipDeadEnd(const std::vector<uint32_t>& liveTriangleCounts, std::vector<uint32_t>& deadEndStack, uint32_t& cursor)
+	{
+		while (!deadEndStack.empty())
+		{
+			uint32_t vertex = deadEndStack.back();
+			deadEndStack.pop_back();
+			if (liveTriangleCounts[vertex] > 0)
+			{
+				return vertex;
+			}
+		}
+
+		for (; cursor < liveTriangleCounts.size(); ++cursor)
+		{
+			if (liveTriangleCounts[cursor] > 0)
+			{
+				return cursor;
+			}
+		}
+
+		return InvalidIndex;
+	}
+};
+
+}
\ No newline at end of file
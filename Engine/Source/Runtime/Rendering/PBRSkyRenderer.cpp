@@ -76,7 +76,7 @@ void PBRSkyRenderer::Init() {
 	m_vbhSkybox = bgfx::createVertexBuffer(bgfx::makeRef(m_vertexBufferSkybox.data(), static_cast<uint32_t>(m_vertexBufferSkybox.size() * sizeof(cd::Point))), m_pRenderContext->GetVertexLayout(positionVertexLayout));
 	m_ibhSkybox = bgfx::createIndexBuffer(bgfx::makeRef(m_indexBufferSkybox.data(), static_cast<uint32_t>(m_indexBufferSkybox.size() * sizeof(uint32_t) * 3)), BGFX_BUFFER_INDEX32);
 
-	bgfx::setViewName(GetViewID(), "PBRSkyRenderer");
+	SetViewName("PBRSkyRenderer");
 }
 
 void PBRSkyRenderer::UpdateView(const float *pViewMatrix, const float *pProjectionMatrix) {
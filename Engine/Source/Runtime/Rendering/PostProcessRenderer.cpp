@@ -10,7 +10,7 @@ void PostProcessRenderer::Init()
 	m_pRenderContext->CreateUniform("s_lightingColor", bgfx::UniformType::Sampler);
 	m_pRenderContext->CreateProgram("PostProcessProgram", "vs_fullscreen.bin", "fs_PBR_postProcessing.bin");
 
-	bgfx::setViewName(GetViewID(), "PostProcessRenderer");
+	SetViewName("PostProcessRenderer");
 }
 
 PostProcessRenderer::~PostProcessRenderer()
@@ -37,8 +37,7 @@ void PostProcessRenderer::Render(float deltaTime)
 	bgfx::TextureHandle screenTextureHandle;
 	if (pInputRT == pOutputRT)
 	{
-		constexpr StringCrc sceneRenderTargetBlitSRV("SceneRenderTargetBlitSRV");
-		screenTextureHandle = m_pRenderContext->GetTexture(sceneRenderTargetBlitSRV);
+		screenTextureHandle = bgfx::TextureHandle{ m_pRenderGraph->GetTexture(m_sceneColorCopy) };
 	}
 	else
 	{
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Renderer.h"
+#include "RenderGraph.hpp"
 
 namespace engine
 {
@@ -14,6 +15,13 @@ public:
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
 	virtual void Render(float deltaTime) override;
+
+	// Post processing reads the copy of scene color when it writes back to the scene color.
+	void SetSceneColorCopy(const RenderGraph* pRenderGraph, RenderGraph::ResourceHandle sceneColorCopy) { m_pRenderGraph = pRenderGraph; m_sceneColorCopy = sceneColorCopy; }
+
+private:
+	const RenderGraph* m_pRenderGraph = nullptr;
+	RenderGraph::ResourceHandle m_sceneColorCopy = RenderGraph::InvalidHandle;
 };
 
 }
\ No newline at end of file
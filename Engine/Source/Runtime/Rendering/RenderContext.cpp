@@ -1,5 +1,6 @@
 #include "RenderContext.h"
 
+#include "Log/Log.h"
 #include "Renderer.h"
 #include "Rendering/Utility/VertexLayoutUtility.h"
 
@@ -7,9 +8,13 @@
 #include <bimg/decode.h>
 #include <bx/allocator.h>
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cstring>
 #include <format>
 #include <fstream>
+#include <iterator>
 #include <memory>
 
 namespace
@@ -28,11 +33,110 @@ static void imageReleaseCb(void* _ptr, void* _userData)
 	bimg::imageFree(imageContainer);
 }
 
+static bgfx::TextureFormat::Enum ToBgfxTextureFormat(engine::TextureFormat textureFormat)
+{
+	switch (textureFormat)
+	{
+	case engine::TextureFormat::RGBA16F:
+		return bgfx::TextureFormat::RGBA16F;
+	case engine::TextureFormat::R11G11B10F:
+		return bgfx::TextureFormat::RG11B10F;
+	case engine::TextureFormat::D32F:
+		return bgfx::TextureFormat::D32F;
+	case engine::TextureFormat::D24S8:
+		return bgfx::TextureFormat::D24S8;
+	case engine::TextureFormat::RGBA32F:
+	default:
+		return bgfx::TextureFormat::RGBA32F;
+	}
+}
+
+// MSAA flags of bgfx count samples by powers of two, such as BGFX_TEXTURE_RT_MSAA_X4 and BGFX_RESET_MSAA_X4.
+static uint32_t GetMSAALevel(uint8_t sampleCount)
+{
+	return static_cast<uint32_t>(std::countr_zero(std::bit_floor(std::max<uint32_t>(sampleCount, 1))));
+}
+
+static bgfx::TextureHandle CreateRenderTargetTexture(const engine::TextureDescriptor& descriptor)
+{
+	// Single sampled color textures can be blit destinations, such as copies of the scene color for post processing.
+	// Multisampled depth is never resolved, so it doesn't need to be readable.
+	uint64_t flags = (static_cast<uint64_t>(GetMSAALevel(descriptor.sampleCount) + 1) << BGFX_TEXTURE_RT_MSAA_SHIFT) | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+	if (engine::IsDepthTextureFormat(descriptor.format))
+	{
+		flags |= descriptor.sampleCount > 1 ? BGFX_TEXTURE_RT_WRITE_ONLY : 0;
+	}
+	else if (descriptor.sampleCount <= 1)
+	{
+		flags |= BGFX_TEXTURE_BLIT_DST;
+	}
+
+	return bgfx::createTexture2D(descriptor.width, descriptor.height, false, 1, ToBgfxTextureFormat(descriptor.format), flags);
+}
+
 }
 
 namespace engine
 {
 
+void ViewBindings::Clear()
+{
+	m_uniforms.clear();
+	m_uniformData.clear();
+	m_textures.clear();
+}
+
+void ViewBindings::SetUniform(bgfx::UniformHandle uniformHandle, const void* pData, uint16_t vec4Count)
+{
+	auto itUniform = std::find_if(m_uniforms.begin(), m_uniforms.end(),
+		[uniformHandle](const UniformBinding& binding) { return binding.uniformHandle.idx == uniformHandle.idx; });
+	if (itUniform == m_uniforms.end() || itUniform->vec4Count < vec4Count)
+	{
+		if (itUniform != m_uniforms.end())
+		{
+			m_uniforms.erase(itUniform);
+		}
+		m_uniforms.push_back(UniformBinding{ uniformHandle, vec4Count, static_cast<uint32_t>(m_uniformData.size()) });
+		m_uniformData.resize(m_uniformData.size() + vec4Count * 4);
+		itUniform = std::prev(m_uniforms.end());
+	}
+
+	itUniform->vec4Count = vec4Count;
+	std::memcpy(&m_uniformData[itUniform->dataOffset], pData, vec4Count * 4 * sizeof(float));
+}
+
+void ViewBindings::SetTexture(uint8_t slot, bgfx::UniformHandle samplerHandle, bgfx::TextureHandle textureHandle)
+{
+	auto itTexture = std::find_if(m_textures.begin(), m_textures.end(),
+		[slot](const TextureBinding& binding) { return binding.slot == slot; });
+	if (itTexture != m_textures.end())
+	{
+		itTexture->samplerHandle = samplerHandle;
+		itTexture->textureHandle = textureHandle;
+		return;
+	}
+
+	m_textures.push_back(TextureBinding{ slot, samplerHandle, textureHandle });
+}
+
+void ViewBindings::Apply(bgfx::Encoder* pEncoder) const
+{
+	ApplyUniforms(pEncoder);
+
+	for (const TextureBinding& texture : m_textures)
+	{
+		pEncoder->setTexture(texture.slot, texture.samplerHandle, texture.textureHandle);
+	}
+}
+
+void ViewBindings::ApplyUniforms(bgfx::Encoder* pEncoder) const
+{
+	for (const UniformBinding& uniform : m_uniforms)
+	{
+		pEncoder->setUniform(uniform.uniformHandle, &m_uniformData[uniform.dataOffset], uniform.vec4Count);
+	}
+}
+
 RenderContext::~RenderContext()
 {
 	bgfx::shutdown();
@@ -45,6 +149,10 @@ void RenderContext::Init()
 	bgfx::init(initDesc);
 
 	bgfx::setDebug(BGFX_DEBUG_NONE);
+
+	m_renderTargetPool.Init(
+		[](const TextureDescriptor& descriptor) { return CreateRenderTargetTexture(descriptor).idx; },
+		[](RenderTargetPool::TextureHandle texture) { bgfx::destroy(bgfx::TextureHandle{ texture }); });
 }
 
 void RenderContext::Shutdown()
@@ -68,6 +176,10 @@ void RenderContext::Shutdown()
 	{
 		bgfx::destroy(it.second);
 	}
+
+	// Render targets release their attachments to the pool, then the pool destroys all textures.
+	m_renderTargetCaches.clear();
+	m_renderTargetPool.Clear();
 }
 
 void RenderContext::BeginFrame()
@@ -79,11 +191,24 @@ void RenderContext::EndFrame()
 	// Advance to next frame. Rendering thread will be kicked to
 	// process submitted rendering primitives.
 	bgfx::frame();
+
+	m_renderTargetPool.Update();
 }
 
 void RenderContext::OnResize(uint16_t width, uint16_t height)
 {
-	bgfx::reset(width, height, BGFX_RESET_MSAA_X16 | BGFX_RESET_VSYNC);
+	uint32_t msaaFlags = GetMSAALevel(GetRenderQualitySettings().sampleCount) << BGFX_RESET_MSAA_SHIFT;
+	bgfx::reset(width, height, msaaFlags | BGFX_RESET_VSYNC);
+}
+
+void RenderContext::LogRenderTargetMemory() const
+{
+	for (const RenderTargetPool::MemoryReportEntry& entry : m_renderTargetPool.GetMemoryReport())
+	{
+		CD_ENGINE_INFO("RenderTarget {0} : {1}x{2} {3} x{4} samples, {5} bytes", entry.owner.empty() ? "(free)" : entry.owner.c_str(),
+			entry.descriptor.width, entry.descriptor.height, GetTextureFormatName(entry.descriptor.format), entry.descriptor.sampleCount, entry.size);
+	}
+	CD_ENGINE_INFO("RenderTarget memory in total : {0} bytes", m_renderTargetPool.GetMemorySize());
 }
 
 uint16_t RenderContext::CreateView()
@@ -92,9 +217,9 @@ uint16_t RenderContext::CreateView()
 	return m_currentViewCount++;
 }
 
-RenderTarget* RenderContext::CreateRenderTarget(StringCrc resourceCrc, uint16_t width, uint16_t height, std::vector<AttachmentDescriptor> attachmentDescs)
+RenderTarget* RenderContext::CreateRenderTarget(const char* pName, uint16_t width, uint16_t height, std::vector<AttachmentDescriptor> attachmentDescs)
 {
-	return CreateRenderTarget(resourceCrc, std::make_unique<RenderTarget>(width, height, std::move(attachmentDescs)));
+	return CreateRenderTarget(StringCrc(pName), std::make_unique<RenderTarget>(width, height, std::move(attachmentDescs), &m_renderTargetPool, pName));
 }
 
 RenderTarget* RenderContext::CreateRenderTarget(StringCrc resourceCrc, uint16_t width, uint16_t height, void* pWindowHandle)
@@ -381,6 +506,16 @@ void RenderContext::FillUniform(StringCrc resourceCrc, const void *pData, uint16
 	bgfx::setUniform(GetUniform(resourceCrc), pData, vec4Count);
 }
 
+void RenderContext::SetViewUniform(uint16_t viewID, StringCrc uniformCrc, const void* pData, uint16_t vec4Count)
+{
+	m_viewBindings[viewID].SetUniform(GetUniform(uniformCrc), pData, vec4Count);
+}
+
+void RenderContext::SetViewTexture(uint16_t viewID, uint8_t slot, StringCrc samplerCrc, StringCrc textureCrc)
+{
+	m_viewBindings[viewID].SetTexture(slot, GetUniform(samplerCrc), GetTexture(textureCrc));
+}
+
 RenderTarget* RenderContext::GetRenderTarget(StringCrc resourceCrc) const
 {
 	auto itResource = m_renderTargetCaches.find(resourceCrc.Value());
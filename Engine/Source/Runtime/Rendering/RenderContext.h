@@ -2,7 +2,9 @@
 
 #include "Core/StringCrc.h"
 #include "Math/Matrix.hpp"
+#include "RenderQuality.h"
 #include "RenderTarget.h"
+#include "RenderTargetPool.hpp"
 #include "Scene/VertexAttribute.h"
 #include "Scene/VertexFormat.h"
 
@@ -11,6 +13,7 @@
 #include <cstdint>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace engine
 {
@@ -21,6 +24,48 @@ class Renderer;
 static constexpr uint8_t MaxViewCount = 255;
 static constexpr uint8_t MaxRenderTargetCount = 255;
 
+// ViewBindings stores uniforms and textures which are shared by all draws of a view, such as camera and IBL resources.
+// Handles are resolved when bindings are set once per view, so applying them to encoders doesn't look up any map.
+class ViewBindings
+{
+public:
+	ViewBindings() = default;
+	ViewBindings(const ViewBindings&) = default;
+	ViewBindings& operator=(const ViewBindings&) = default;
+	ViewBindings(ViewBindings&&) = default;
+	ViewBindings& operator=(ViewBindings&&) = default;
+	~ViewBindings() = default;
+
+	void Clear();
+	// Uniform data is copied. Setting the same uniform again replaces its data.
+	void SetUniform(bgfx::UniformHandle uniformHandle, const void* pData, uint16_t vec4Count = 1);
+	void SetTexture(uint8_t slot, bgfx::UniformHandle samplerHandle, bgfx::TextureHandle textureHandle);
+
+	// Encoders keep bindings per thread, so every encoder recording draws of the view applies them.
+	void Apply(bgfx::Encoder* pEncoder) const;
+	// Uniforms are discarded with the state, textures are kept.
+	void ApplyUniforms(bgfx::Encoder* pEncoder) const;
+
+private:
+	struct UniformBinding
+	{
+		bgfx::UniformHandle uniformHandle;
+		uint16_t vec4Count;
+		uint32_t dataOffset;
+	};
+
+	struct TextureBinding
+	{
+		uint8_t slot;
+		bgfx::UniformHandle samplerHandle;
+		bgfx::TextureHandle textureHandle;
+	};
+
+	std::vector<UniformBinding> m_uniforms;
+	std::vector<float> m_uniformData;
+	std::vector<TextureBinding> m_textures;
+};
+
 // In current design, RenderContext needs to be a singleton.
 // The reason is that it binds to bgfx graphics initialization which should only happen once.
 class RenderContext
@@ -41,10 +86,21 @@ public:
 
 	uint16_t CreateView();
 
+	// Quality tier decides formats and sample counts of scene render targets and MSAA of the back buffer.
+	// It should be set before render targets are created.
+	void SetRenderQuality(RenderQuality renderQuality) { m_renderQuality = renderQuality; }
+	RenderQuality GetRenderQuality() const { return m_renderQuality; }
+	RenderQualitySettings GetRenderQualitySettings() const { return engine::GetRenderQualitySettings(m_renderQuality); }
+
+	RenderTargetPool& GetRenderTargetPool() { return m_renderTargetPool; }
+	const RenderTargetPool& GetRenderTargetPool() const { return m_renderTargetPool; }
+	// Logs bytes of every texture held by the render target pool.
+	void LogRenderTargetMemory() const;
+
 	/////////////////////////////////////////////////////////////////////
 	// Resource related apis
 	/////////////////////////////////////////////////////////////////////
-	RenderTarget* CreateRenderTarget(StringCrc resourceCrc, uint16_t width, uint16_t height, std::vector<AttachmentDescriptor> attachmentDescs);
+	RenderTarget* CreateRenderTarget(const char* pName, uint16_t width, uint16_t height, std::vector<AttachmentDescriptor> attachmentDescs);
 	RenderTarget* CreateRenderTarget(StringCrc resourceCrc, uint16_t width, uint16_t height, void* pWindowHandle);
 	RenderTarget* CreateRenderTarget(StringCrc resourceCrc, std::unique_ptr<RenderTarget> pRenderTarget);
 	bgfx::ShaderHandle CreateShader(const char* filePath);
@@ -65,6 +121,12 @@ public:
 
 	void FillUniform(StringCrc resourceCrc, const void *pData, uint16_t vec4Count = 1) const;
 
+	// Per-view bindings which renderers set once per frame and apply to encoders instead of binding them per draw.
+	ViewBindings& GetViewBindings(uint16_t viewID) { return m_viewBindings[viewID]; }
+	const ViewBindings& GetViewBindings(uint16_t viewID) const { return m_viewBindings[viewID]; }
+	void SetViewUniform(uint16_t viewID, StringCrc uniformCrc, const void* pData, uint16_t vec4Count = 1);
+	void SetViewTexture(uint16_t viewID, uint8_t slot, StringCrc samplerCrc, StringCrc textureCrc);
+
 	RenderTarget* GetRenderTarget(StringCrc resourceCrc) const;
 	const bgfx::VertexLayout& GetVertexLayout(StringCrc resourceCrc) const;
 	bgfx::ShaderHandle GetShader(StringCrc resourceCrc) const;
@@ -74,6 +136,10 @@ public:
 
 private:
 	uint8_t m_currentViewCount = 0;
+	RenderQuality m_renderQuality = RenderQuality::High;
+	ViewBindings m_viewBindings[MaxViewCount];
+	// Render targets release attachments to the pool when they are destroyed, so the pool is declared before them.
+	RenderTargetPool m_renderTargetPool;
 	std::unordered_map<size_t, std::unique_ptr<RenderTarget>> m_renderTargetCaches;
 	std::unordered_map<size_t, bgfx::VertexLayout> m_vertexLayoutCaches;
 	std::unordered_map<size_t, bgfx::ShaderHandle> m_shaderHandleCaches;
@@ -0,0 +1,300 @@
+#pragma once
+
+#include "RenderTargetPool.hpp"
+#include "TextureFormat.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+// RenderGraph describes render passes by resources which they read and write.
+// Passes and resources are declared once, then the graph is compiled every frame:
+// - Passes are kept in the declared order. Disabled passes and passes whose outputs are never used are culled.
+// - Compiled passes get continuous view IDs, so that views don't depend on the order of RenderContext::CreateView.
+// - Transient textures whose lifetimes don't overlap are aliased to the same physical texture.
+// Execute runs compiled passes and holds every physical texture from a RenderTargetPool only from its first to its last pass.
+// Passes get the texture which their transient resource is aliased to by GetTexture.
+// Imported textures are owned outside of the graph, such as render targets displayed by UI. They are always used.
+class RenderGraph final
+{
+public:
+	using PassHandle = uint32_t;
+	using ResourceHandle = uint32_t;
+	static constexpr uint32_t InvalidHandle = UINT32_MAX;
+	static constexpr uint16_t InvalidViewID = UINT16_MAX;
+
+	using TextureDescriptor = engine::TextureDescriptor;
+	using TextureHandle = RenderTargetPool::TextureHandle;
+	using ExecuteFunction = std::function<void(PassHandle)>;
+
+	// Range of compiled pass indexes which use a resource. Unused resources have invalid indexes.
+	struct Lifetime
+	{
+		uint32_t firstPass = InvalidHandle;
+		uint32_t lastPass = InvalidHandle;
+
+		bool IsValid() const { return firstPass != InvalidHandle; }
+	};
+
+public:
+	RenderGraph() = default;
+	RenderGraph(const RenderGraph&) = default;
+	RenderGraph& operator=(const RenderGraph&) = default;
+	RenderGraph(RenderGraph&&) = default;
+	RenderGraph& operator=(RenderGraph&&) = default;
+	~RenderGraph() = default;
+
+	ResourceHandle ImportTexture(const char* pName)
+	{
+		Resource& resource = m_resources.emplace_back();
+		resource.name = pName;
+		resource.isImported = true;
+		return static_cast<ResourceHandle>(m_resources.size() - 1);
+	}
+
+	ResourceHandle CreateTexture(const char* pName, const TextureDescriptor& descriptor)
+	{
+		Resource& resource = m_resources.emplace_back();
+		resource.name = pName;
+		resource.descriptor = descriptor;
+		return static_cast<ResourceHandle>(m_resources.size() - 1);
+	}
+
+	// Sizes of transient textures usually follow the target which they are derived from.
+	void SetTextureDescriptor(ResourceHandle resource, const TextureDescriptor& descriptor) { m_resources[resource].descriptor = descriptor; }
+	const TextureDescriptor& GetTextureDescriptor(ResourceHandle resource) const { return m_resources[resource].descriptor; }
+
+	// Pass handles are indexes in the order which passes are added in.
+	PassHandle AddPass(const char* pName)
+	{
+		m_passes.emplace_back().name = pName;
+		return static_cast<PassHandle>(m_passes.size() - 1);
+	}
+
+	void Read(PassHandle pass, ResourceHandle resource) { m_passes[pass].reads.push_back(resource); }
+	void Write(PassHandle pass, ResourceHandle resource) { m_passes[pass].writes.push_back(resource); }
+	void SetPassEnabled(PassHandle pass, bool isEnabled) { m_passes[pass].isEnabled = isEnabled; }
+
+	uint32_t GetPassCount() const { return static_cast<uint32_t>(m_passes.size()); }
+	uint32_t GetResourceCount() const { return static_cast<uint32_t>(m_resources.size()); }
+	const char* GetPassName(PassHandle pass) const { return m_passes[pass].name.c_str(); }
+	const char* GetResourceName(ResourceHandle resource) const { return m_resources[resource].name.c_str(); }
+
+	void Compile(uint16_t firstViewID = 0)
+	{
+		// Walk passes backward and keep a pass if it writes a resource which is read later or is imported.
+		// A pass which writes a resource without reading it overwrites the content, so earlier writers are not needed by later readers.
+		std::vector<bool> isResourceNeeded(m_resources.size(), false);
+		for (size_t resourceIndex = 0; resourceIndex < m_resources.size(); ++resourceIndex)
+		{
+			isResourceNeeded[resourceIndex] = m_resources[resourceIndex].isImported;
+		}
+
+		for (size_t passIndex = m_passes.size(); passIndex-- > 0;)
+		{
+			Pass& pass = m_passes[passIndex];
+			pass.isCulled = !pass.isEnabled || std::none_of(pass.writes.begin(), pass.writes.end(),
+				[&isResourceNeeded](ResourceHandle resource) { return isResourceNeeded[resource]; });
+			if (pass.isCulled)
+			{
+				continue;
+			}
+
+			for (ResourceHandle resource : pass.writes)
+			{
+				if (!m_resources[resource].isImported && std::find(pass.reads.begin(), pass.reads.end(), resource) == pass.reads.end())
+				{
+					isResourceNeeded[resource] = false;
+				}
+			}
+
+			for (ResourceHandle resource : pass.reads)
+			{
+				isResourceNeeded[resource] = true;
+			}
+		}
+
+		// Assign views and lifetimes in the execution order.
+		m_compiledPasses.clear();
+		for (Resource& resource : m_resources)
+		{
+			resource.lifetime = Lifetime();
+			resource.physicalTexture = InvalidHandle;
+		}
+
+		for (PassHandle passHandle = 0; passHandle < m_passes.size(); ++passHandle)
+		{
+			Pass& pass = m_passes[passHandle];
+			pass.viewID = InvalidViewID;
+			if (pass.isCulled)
+			{
+				continue;
+			}
+
+			uint32_t compiledIndex = static_cast<uint32_t>(m_compiledPasses.size());
+			pass.viewID = static_cast<uint16_t>(firstViewID + compiledIndex);
+			m_compiledPasses.push_back(passHandle);
+
+			// Compiled indexes increase, so the first use sets the beginning and every use moves the end.
+			auto extendLifetime = [this, compiledIndex](ResourceHandle resource)
+			{
+				Lifetime& lifetime = m_resources[resource].lifetime;
+				if (!lifetime.IsValid())
+				{
+					lifetime.firstPass = compiledIndex;
+				}
+				lifetime.lastPass = compiledIndex;
+			};
+			std::for_each(pass.reads.begin(), pass.reads.end(), extendLifetime);
+			std::for_each(pass.writes.begin(), pass.writes.end(), extendLifetime);
+		}
+
+		// Alias transient textures in the order of their first use. A physical texture is reused
+		// if its descriptor matches and its last user runs before the first user of the new texture.
+		m_physicalTextures.clear();
+		std::vector<ResourceHandle> transientTextures;
+		for (ResourceHandle resource = 0; resource < m_resources.size(); ++resource)
+		{
+			if (!m_resources[resource].isImported && m_resources[resource].lifetime.IsValid())
+			{
+				transientTextures.push_back(resource);
+			}
+		}
+		std::stable_sort(transientTextures.begin(), transientTextures.end(), [this](ResourceHandle lhs, ResourceHandle rhs)
+		{
+			return m_resources[lhs].lifetime.firstPass < m_resources[rhs].lifetime.firstPass;
+		});
+
+		for (ResourceHandle resource : transientTextures)
+		{
+			Resource& texture = m_resources[resource];
+			for (uint32_t physicalIndex = 0; physicalIndex < m_physicalTextures.size(); ++physicalIndex)
+			{
+				if (m_physicalTextures[physicalIndex].descriptor == texture.descriptor && m_physicalTextures[physicalIndex].lastPass < texture.lifetime.firstPass)
+				{
+					texture.physicalTexture = physicalIndex;
+					break;
+				}
+			}
+
+			if (InvalidHandle == texture.physicalTexture)
+			{
+				texture.physicalTexture = static_cast<uint32_t>(m_physicalTextures.size());
+				PhysicalTexture& physicalTexture = m_physicalTextures.emplace_back();
+				physicalTexture.descriptor = texture.descriptor;
+				physicalTexture.firstPass = texture.lifetime.firstPass;
+				physicalTexture.firstResource = resource;
+			}
+			m_physicalTextures[texture.physicalTexture].lastPass = texture.lifetime.lastPass;
+		}
+	}
+
+	// Run compiled passes in order. Physical textures are acquired before their first passes and released after their last passes,
+	// so that the pool reuses them for other physical textures and targets in the same frame.
+	void Execute(RenderTargetPool& renderTargetPool, const ExecuteFunction& executePass)
+	{
+		for (uint32_t compiledIndex = 0; compiledIndex < m_compiledPasses.size(); ++compiledIndex)
+		{
+			for (PhysicalTexture& physicalTexture : m_physicalTextures)
+			{
+				if (physicalTexture.firstPass == compiledIndex)
+				{
+					physicalTexture.texture = renderTargetPool.Acquire(physicalTexture.descriptor, m_resources[physicalTexture.firstResource].name.c_str());
+				}
+			}
+
+			executePass(m_compiledPasses[compiledIndex]);
+
+			for (PhysicalTexture& physicalTexture : m_physicalTextures)
+			{
+				if (physicalTexture.lastPass == compiledIndex && RenderTargetPool::InvalidTexture != physicalTexture.texture)
+				{
+					renderTargetPool.Release(physicalTexture.texture);
+					physicalTexture.texture = RenderTargetPool::InvalidTexture;
+				}
+			}
+		}
+	}
+
+	// Results of the last compilation.
+	const std::vector<PassHandle>& GetCompiledPasses() const { return m_compiledPasses; }
+	bool IsPassCulled(PassHandle pass) const { return m_passes[pass].isCulled; }
+	uint16_t GetPassViewID(PassHandle pass) const { return m_passes[pass].viewID; }
+	const Lifetime& GetResourceLifetime(ResourceHandle resource) const { return m_resources[resource].lifetime; }
+
+	// Index of the physical texture which a transient texture is aliased to. Imported and unused textures don't have one.
+	uint32_t GetPhysicalTexture(ResourceHandle resource) const { return m_resources[resource].physicalTexture; }
+	uint32_t GetPhysicalTextureCount() const { return static_cast<uint32_t>(m_physicalTextures.size()); }
+
+	// Texture of a transient resource which is only valid in passes of its lifetime during Execute.
+	TextureHandle GetTexture(ResourceHandle resource) const
+	{
+		uint32_t physicalIndex = m_resources[resource].physicalTexture;
+		return InvalidHandle != physicalIndex ? m_physicalTextures[physicalIndex].texture : RenderTargetPool::InvalidTexture;
+	}
+
+	// Memory of physical textures which Execute acquires, compared to allocating every used transient texture separately.
+	uint64_t GetTransientMemorySize() const
+	{
+		uint64_t size = 0;
+		for (const PhysicalTexture& physicalTexture : m_physicalTextures)
+		{
+			size += physicalTexture.descriptor.GetSize();
+		}
+		return size;
+	}
+
+	uint64_t GetUnaliasedMemorySize() const
+	{
+		uint64_t size = 0;
+		for (const Resource& resource : m_resources)
+		{
+			size += !resource.isImported && resource.lifetime.IsValid() ? resource.descriptor.GetSize() : 0;
+		}
+		return size;
+	}
+
+private:
+	struct Pass
+	{
+		std::string name;
+		std::vector<ResourceHandle> reads;
+		std::vector<ResourceHandle> writes;
+		bool isEnabled = true;
+		bool isCulled = false;
+		uint16_t viewID = InvalidViewID;
+	};
+
+	struct Resource
+	{
+		std::string name;
+		bool isImported = false;
+		TextureDescriptor descriptor;
+		Lifetime lifetime;
+		uint32_t physicalTexture = InvalidHandle;
+	};
+
+	// Compiled pass indexes of the first and the last resources aliased to the texture.
+	struct PhysicalTexture
+	{
+		TextureDescriptor descriptor;
+		uint32_t firstPass = InvalidHandle;
+		uint32_t lastPass = InvalidHandle;
+		ResourceHandle firstResource = InvalidHandle;
+		TextureHandle texture = RenderTargetPool::InvalidTexture;
+	};
+
+private:
+	std::vector<Pass> m_passes;
+	std::vector<Resource> m_resources;
+
+	std::vector<PassHandle> m_compiledPasses;
+	std::vector<PhysicalTexture> m_physicalTextures;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "TextureFormat.h"
+
+#include <cstdint>
+
+namespace engine
+{
+
+// Quality tiers trade the precision and multisampling of scene render targets for memory and bandwidth.
+enum class RenderQuality
+{
+	Low,
+	Medium,
+	High,
+	Ultra
+};
+
+struct RenderQualitySettings
+{
+	TextureFormat colorFormat;
+	TextureFormat depthFormat;
+	uint8_t sampleCount;
+};
+
+constexpr RenderQualitySettings GetRenderQualitySettings(RenderQuality renderQuality)
+{
+	switch (renderQuality)
+	{
+	case RenderQuality::Low:
+		return RenderQualitySettings{ TextureFormat::R11G11B10F, TextureFormat::D24S8, 1 };
+	case RenderQuality::Medium:
+		return RenderQualitySettings{ TextureFormat::RGBA16F, TextureFormat::D24S8, 2 };
+	case RenderQuality::Ultra:
+		return RenderQualitySettings{ TextureFormat::RGBA32F, TextureFormat::D32F, 8 };
+	case RenderQuality::High:
+	default:
+		return RenderQualitySettings{ TextureFormat::RGBA16F, TextureFormat::D32F, 4 };
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// 64 bits sort key of a draw. Higher bits are sorted first:
+// | view 8 | layer 4 | program 12 | material 16 | depth 24 |
+// So that draws are grouped by view, then by program to minimize program switches, then by material to reuse bindings.
+// Draws with the same state are sorted front to back.
+using SortKey = uint64_t;
+
+struct RenderQueueStats
+{
+	uint32_t drawCount = 0;
+
+	// Counted in the order which draws are added in, as if they are submitted without sorting.
+	uint32_t unsortedProgramSwitches = 0;
+	uint32_t unsortedTextureBinds = 0;
+
+	// Counted by submission after sorting and skipping redundant bindings.
+	uint32_t programSwitches = 0;
+	uint32_t textureBinds = 0;
+	uint32_t stateChanges = 0;
+
+	// Instanced draws are counted in drawCount too. instanceCount is the number of objects drawn by them.
+	uint32_t instancedDrawCount = 0;
+	uint32_t instanceCount = 0;
+
+	// Triangles of selected LODs, compared to drawing every object with its full mesh.
+	uint32_t triangleCount = 0;
+	uint32_t fullDetailTriangleCount = 0;
+};
+
+// RenderQueue collects draw items with sort keys and radix sorts them before submission.
+// Payload is an index or handle which the renderer uses to find data of the draw.
+class RenderQueue final
+{
+public:
+	static constexpr uint32_t ViewBits = 8;
+	static constexpr uint32_t LayerBits = 4;
+	static constexpr uint32_t ProgramBits = 12;
+	static constexpr uint32_t MaterialBits = 16;
+	static constexpr uint32_t DepthBits = 24;
+
+	static constexpr uint32_t DepthShift = 0;
+	static constexpr uint32_t MaterialShift = DepthShift + DepthBits;
+	static constexpr uint32_t ProgramShift = MaterialShift + MaterialBits;
+	static constexpr uint32_t LayerShift = ProgramShift + ProgramBits;
+	static constexpr uint32_t ViewShift = LayerShift + LayerBits;
+	static_assert(ViewShift + ViewBits == 64);
+
+	struct Item
+	{
+		SortKey key;
+		uint32_t payload;
+	};
+
+public:
+	RenderQueue() = default;
+	RenderQueue(const RenderQueue&) = default;
+	RenderQueue& operator=(const RenderQueue&) = default;
+	RenderQueue(RenderQueue&&) = default;
+	RenderQueue& operator=(RenderQueue&&) = default;
+	~RenderQueue() = default;
+
+	static constexpr SortKey MakeSortKey(uint16_t viewID, uint8_t layer, uint16_t program, uint16_t material, uint32_t depth)
+	{
+		return (static_cast<SortKey>(viewID & Mask(ViewBits)) << ViewShift) |
+			(static_cast<SortKey>(layer & Mask(LayerBits)) << LayerShift) |
+			(static_cast<SortKey>(program & Mask(ProgramBits)) << ProgramShift) |
+			(static_cast<SortKey>(material & Mask(MaterialBits)) << MaterialShift) |
+			(static_cast<SortKey>(depth & Mask(DepthBits)) << DepthShift);
+	}
+
+	static constexpr uint16_t GetViewID(SortKey key) { return static_cast<uint16_t>((key >> ViewShift) & Mask(ViewBits)); }
+	static constexpr uint8_t GetLayer(SortKey key) { return static_cast<uint8_t>((key >> LayerShift) & Mask(LayerBits)); }
+	static constexpr uint16_t GetProgram(SortKey key) { return static_cast<uint16_t>((key >> ProgramShift) & Mask(ProgramBits)); }
+	static constexpr uint16_t GetMaterial(SortKey key) { return static_cast<uint16_t>((key >> MaterialShift) & Mask(MaterialBits)); }
+	static constexpr uint32_t GetDepth(SortKey key) { return static_cast<uint32_t>((key >> DepthShift) & Mask(DepthBits)); }
+
+	// Bits of a positive float increase with its value, so the highest bits keep the order of view depths.
+	// Negative depths which are behind the camera are clamped to 0.
+	static uint32_t QuantizeDepth(float viewDepth)
+	{
+		return viewDepth > 0.0f ? std::bit_cast<uint32_t>(viewDepth) >> (32 - DepthBits) : 0;
+	}
+
+	// Chunks of sorted items are recorded by concurrent encoders whose draws interleave.
+	// The view sorts draws by depth in DepthAscending mode, so items submit their sorted indexes as depths to keep the order.
+	static constexpr uint32_t GetSubmitDepth(uint32_t itemIndex) { return itemIndex; }
+
+	size_t GetItemCount() const { return m_items.size(); }
+	bool IsEmpty() const { return m_items.empty(); }
+	const std::vector<Item>& GetItems() const { return m_items; }
+
+	void Clear() { m_items.clear(); }
+	void Reserve(size_t count) { m_items.reserve(count); }
+	void Push(SortKey key, uint32_t payload) { m_items.push_back(Item{ key, payload }); }
+
+	// LSD radix sort by 8 bits digits. It is stable, and digits which all keys share are skipped.
+	void Sort()
+	{
+		constexpr uint32_t DigitBits = 8;
+		constexpr uint32_t DigitCount = 64 / DigitBits;
+		constexpr uint32_t BucketCount = 1 << DigitBits;
+
+		std::array<std::array<uint32_t, BucketCount>, DigitCount> histograms = {};
+		for (const Item& item : m_items)
+		{
+			for (uint32_t digitIndex = 0; digitIndex < DigitCount; ++digitIndex)
+			{
+				++histograms[digitIndex][(item.key >> (digitIndex * DigitBits)) & (BucketCount - 1)];
+			}
+		}
+
+		m_sortBuffer.resize(m_items.size());
+		for (uint32_t digitIndex = 0; digitIndex < DigitCount; ++digitIndex)
+		{
+			std::array<uint32_t, BucketCount>& histogram = histograms[digitIndex];
+			uint32_t shift = digitIndex * DigitBits;
+			if (m_items.empty() || histogram[(m_items.front().key >> shift) & (BucketCount - 1)] == m_items.size())
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t& count : histogram)
+			{
+				uint32_t bucketCount = count;
+				count = offset;
+				offset += bucketCount;
+			}
+
+			for (const Item& item : m_items)
+			{
+				m_sortBuffer[histogram[(item.key >> shift) & (BucketCount - 1)]++] = item;
+			}
+			std::swap(m_items, m_sortBuffer);
+		}
+	}
+
+private:
+	static constexpr uint64_t Mask(uint32_t bits) { return (uint64_t(1) << bits) - 1; }
+
+private:
+	std::vector<Item> m_items;
+	std::vector<Item> m_sortBuffer;
+};
+
+}
\ No newline at end of file
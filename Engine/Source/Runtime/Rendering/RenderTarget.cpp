@@ -1,5 +1,7 @@
 #include "RenderTarget.h"
 
+#include "RenderTargetPool.hpp"
+
 #include <bgfx/bgfx.h>
 
 namespace engine
@@ -11,12 +13,28 @@ RenderTarget::RenderTarget(uint16_t width, uint16_t height, void* hwnd) :
 	Resize(width, height);
 }
 
-RenderTarget::RenderTarget(uint16_t width, uint16_t height, std::vector<AttachmentDescriptor> attachmentDescs) :
-	m_attachmentDescriptors(std::move(attachmentDescs))
+RenderTarget::RenderTarget(uint16_t width, uint16_t height, std::vector<AttachmentDescriptor> attachmentDescs, RenderTargetPool* pPool, const char* pName) :
+	m_attachmentDescriptors(std::move(attachmentDescs)),
+	m_pPool(pPool),
+	m_name(pName)
 {
 	Resize(width, height);
 }
 
+RenderTarget::~RenderTarget()
+{
+	ReleaseAttachments();
+}
+
+void RenderTarget::ReleaseAttachments()
+{
+	for (bgfx::TextureHandle textureHandle : m_attachmentTextureHandles)
+	{
+		m_pPool->Release(textureHandle.idx);
+	}
+	m_attachmentTextureHandles.clear();
+}
+
 bgfx::TextureHandle RenderTarget::GetTextureHandle(int index) const
 {
 	return bgfx::getTexture(*m_pFrameBufferHandle.get(), index);
@@ -38,8 +56,9 @@ void RenderTarget::Resize(uint16_t width, uint16_t height)
 	}
 	else
 	{
-		// When creating the frame buffer, we specified the flag to auto release textures.
+		// Attachments are owned by the pool, so the frame buffer doesn't destroy them.
 		bgfx::destroy(*m_pFrameBufferHandle.get());
+		ReleaseAttachments();
 	}
 
 	if (IsSwapChainTarget())
@@ -48,25 +67,13 @@ void RenderTarget::Resize(uint16_t width, uint16_t height)
 	}
 	else
 	{
-		std::vector<bgfx::TextureHandle> textureHandles;
-		textureHandles.reserve(m_attachmentDescriptors.size());
+		m_attachmentTextureHandles.reserve(m_attachmentDescriptors.size());
 		for (const auto& attachmentDescriptor : m_attachmentDescriptors)
 		{
-			const uint64_t tsFlags = BGFX_TEXTURE_RT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
-			bgfx::TextureFormat::Enum textureFormat;
-			switch (attachmentDescriptor.textureFormat)
-			{
-			case TextureFormat::D32F:
-				textureFormat = bgfx::TextureFormat::D32F;
-				break;
-			case TextureFormat::RGBA32F:
-			default:
-				textureFormat = bgfx::TextureFormat::RGBA32F;
-				break;
-			};
-			textureHandles.push_back(bgfx::createTexture2D(width, height, false, 1, textureFormat, tsFlags));
+			TextureDescriptor textureDescriptor{ width, height, attachmentDescriptor.textureFormat, attachmentDescriptor.sampleCount };
+			m_attachmentTextureHandles.push_back(bgfx::TextureHandle{ m_pPool->Acquire(textureDescriptor, m_name.c_str()) });
 		}
-		*m_pFrameBufferHandle = bgfx::createFrameBuffer(static_cast<uint8_t>(textureHandles.size()), textureHandles.data(), true);
+		*m_pFrameBufferHandle = bgfx::createFrameBuffer(static_cast<uint8_t>(m_attachmentTextureHandles.size()), m_attachmentTextureHandles.data(), false);
 	}
 
 	OnResize.Invoke(m_width, m_height);
@@ -1,11 +1,13 @@
 #pragma once
 
 #include "Core/Delegates/MulticastDelegate.hpp"
+#include "TextureFormat.h"
 
 #include <bgfx/bgfx.h>
 
 #include <inttypes.h>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace bgfx
@@ -18,15 +20,12 @@ struct FrameBufferHandle;
 namespace engine
 {
 
-enum class TextureFormat
-{
-	RGBA32F,
-	D32F
-};
+class RenderTargetPool;
 
 struct AttachmentDescriptor
 {
 	TextureFormat textureFormat;
+	uint8_t sampleCount = 1;
 };
 
 class RenderTarget
@@ -34,12 +33,13 @@ class RenderTarget
 public:
 	RenderTarget() = delete;
 	explicit RenderTarget(uint16_t width, uint16_t height, void* hwnd);
-	explicit RenderTarget(uint16_t width, uint16_t height, std::vector<AttachmentDescriptor> attachmentDescs);
+	// Attachments are acquired from the pool and released back to it when the render target is resized or destroyed.
+	explicit RenderTarget(uint16_t width, uint16_t height, std::vector<AttachmentDescriptor> attachmentDescs, RenderTargetPool* pPool, const char* pName);
 	RenderTarget(const RenderTarget&) = delete;
 	RenderTarget& operator=(const RenderTarget&) = delete;
 	RenderTarget(RenderTarget&&) = delete;
 	RenderTarget& operator=(RenderTarget&&) = delete;
-	~RenderTarget() = default;
+	~RenderTarget();
 
 	bool IsSwapChainTarget() const { return m_hwnd != nullptr && m_attachmentDescriptors.empty(); }
 	uint16_t GetWidth() const { return m_width; }
@@ -49,15 +49,23 @@ public:
 
 	const bgfx::FrameBufferHandle* GetFrameBufferHandle() const { return m_pFrameBufferHandle.get(); }
 	bgfx::TextureHandle GetTextureHandle(int index) const;
+	const std::vector<AttachmentDescriptor>& GetAttachmentDescriptors() const { return m_attachmentDescriptors; }
+	const char* GetName() const { return m_name.c_str(); }
 
 public:
 	MulticastDelegate<void(uint16_t, uint16_t)> OnResize;
 
+private:
+	void ReleaseAttachments();
+
 private:
 	uint16_t m_width = 1;
 	uint16_t m_height = 1;
 	void* m_hwnd = nullptr;
 	std::vector<AttachmentDescriptor> m_attachmentDescriptors;
+	std::vector<bgfx::TextureHandle> m_attachmentTextureHandles;
+	RenderTargetPool* m_pPool = nullptr;
+	std::string m_name;
 
 	std::unique_ptr<bgfx::FrameBufferHandle> m_pFrameBufferHandle;
 };
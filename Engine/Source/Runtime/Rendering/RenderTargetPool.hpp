@@ -0,0 +1,161 @@
+#pragma once
+
+#include "TextureFormat.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+// RenderTargetPool hands out render target textures by descriptor and keeps released textures for reuse,
+// so that passes and targets which need the same kind of texture share it across frames instead of recreating it.
+// Textures are created and destroyed by callbacks which wrap the graphics API. Texture handles are bgfx handle indexes.
+class RenderTargetPool final
+{
+public:
+	using TextureHandle = uint16_t;
+	using CreateFunction = std::function<TextureHandle(const TextureDescriptor&)>;
+	using DestroyFunction = std::function<void(TextureHandle)>;
+	static constexpr TextureHandle InvalidTexture = UINT16_MAX;
+
+	struct MemoryReportEntry
+	{
+		// Empty if the texture is released and waits for reuse.
+		std::string owner;
+		TextureDescriptor descriptor;
+		uint64_t size;
+	};
+
+public:
+	RenderTargetPool() = default;
+	RenderTargetPool(const RenderTargetPool&) = delete;
+	RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+	RenderTargetPool(RenderTargetPool&&) = default;
+	RenderTargetPool& operator=(RenderTargetPool&&) = default;
+	~RenderTargetPool() = default;
+
+	void Init(CreateFunction createTexture, DestroyFunction destroyTexture)
+	{
+		m_createTexture = std::move(createTexture);
+		m_destroyTexture = std::move(destroyTexture);
+	}
+
+	// Released textures which are not acquired again in these frames are destroyed.
+	void SetMaxUnusedFrames(uint32_t frameCount) { m_maxUnusedFrames = frameCount; }
+	uint32_t GetMaxUnusedFrames() const { return m_maxUnusedFrames; }
+
+	TextureHandle Acquire(const TextureDescriptor& descriptor, const char* pOwner)
+	{
+		auto itEntry = std::find_if(m_entries.begin(), m_entries.end(),
+			[&descriptor](const Entry& entry) { return !entry.isInUse && entry.descriptor == descriptor; });
+		if (itEntry == m_entries.end())
+		{
+			TextureHandle texture = m_createTexture(descriptor);
+			if (InvalidTexture == texture)
+			{
+				return InvalidTexture;
+			}
+
+			++m_createdTextureCount;
+			Entry& entry = m_entries.emplace_back();
+			entry.texture = texture;
+			entry.descriptor = descriptor;
+			itEntry = std::prev(m_entries.end());
+		}
+
+		itEntry->owner = pOwner;
+		itEntry->isInUse = true;
+		itEntry->lastUsedFrame = m_frameIndex;
+		return itEntry->texture;
+	}
+
+	void Release(TextureHandle texture)
+	{
+		auto itEntry = std::find_if(m_entries.begin(), m_entries.end(),
+			[texture](const Entry& entry) { return entry.texture == texture; });
+		if (itEntry != m_entries.end())
+		{
+			itEntry->owner.clear();
+			itEntry->isInUse = false;
+			itEntry->lastUsedFrame = m_frameIndex;
+		}
+	}
+
+	// Called once per frame after submission to evict textures which are not reused.
+	void Update()
+	{
+		++m_frameIndex;
+		std::erase_if(m_entries, [this](const Entry& entry)
+		{
+			if (entry.isInUse || m_frameIndex - entry.lastUsedFrame <= m_maxUnusedFrames)
+			{
+				return false;
+			}
+
+			m_destroyTexture(entry.texture);
+			return true;
+		});
+	}
+
+	// Destroys all textures including the ones which are still acquired.
+	void Clear()
+	{
+		for (const Entry& entry : m_entries)
+		{
+			m_destroyTexture(entry.texture);
+		}
+		m_entries.clear();
+	}
+
+	uint32_t GetTextureCount() const { return static_cast<uint32_t>(m_entries.size()); }
+	uint32_t GetFreeTextureCount() const { return static_cast<uint32_t>(std::count_if(m_entries.begin(), m_entries.end(), [](const Entry& entry) { return !entry.isInUse; })); }
+	// Number of textures created since the pool was initialized. Acquires served by reuse don't count.
+	uint32_t GetCreatedTextureCount() const { return m_createdTextureCount; }
+
+	uint64_t GetMemorySize() const
+	{
+		uint64_t size = 0;
+		for (const Entry& entry : m_entries)
+		{
+			size += entry.descriptor.GetSize();
+		}
+		return size;
+	}
+
+	// One entry per texture held by the pool in the order which they are created in.
+	std::vector<MemoryReportEntry> GetMemoryReport() const
+	{
+		std::vector<MemoryReportEntry> report;
+		report.reserve(m_entries.size());
+		for (const Entry& entry : m_entries)
+		{
+			report.push_back(MemoryReportEntry{ entry.owner, entry.descriptor, entry.descriptor.GetSize() });
+		}
+		return report;
+	}
+
+private:
+	struct Entry
+	{
+		TextureHandle texture = InvalidTexture;
+		TextureDescriptor descriptor;
+		std::string owner;
+		bool isInUse = false;
+		uint64_t lastUsedFrame = 0;
+	};
+
+private:
+	CreateFunction m_createTexture;
+	DestroyFunction m_destroyTexture;
+	std::vector<Entry> m_entries;
+	uint64_t m_frameIndex = 0;
+	uint32_t m_maxUnusedFrames = 3;
+	uint32_t m_createdTextureCount = 0;
+};
+
+}
\ No newline at end of file
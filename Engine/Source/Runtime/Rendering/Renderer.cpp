@@ -1,10 +1,16 @@
 #include "Renderer.h"
 
+#include "Core/Threading/ThreadPool.hpp"
 #include "RenderContext.h"
 #include "RenderTarget.h"
 
 #include <bgfx/bgfx.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
 namespace engine
 {
 
@@ -15,6 +21,104 @@ Renderer::Renderer(RenderContext* pRenderContext, uint16_t viewID, RenderTarget*
 {
 }
 
+void Renderer::SetViewID(uint16_t viewID)
+{
+	if (viewID == m_viewID)
+	{
+		return;
+	}
+
+	// Views keep state such as clear flags, so a view which was used by another renderer starts from the default state.
+	m_viewID = viewID;
+	bgfx::resetView(m_viewID);
+	bgfx::setViewName(m_viewID, m_viewName.c_str());
+	if (bgfx::ViewMode::Default != m_viewMode)
+	{
+		bgfx::setViewMode(m_viewID, static_cast<bgfx::ViewMode::Enum>(m_viewMode));
+	}
+}
+
+void Renderer::SetViewName(const char* pName)
+{
+	m_viewName = pName;
+	bgfx::setViewName(m_viewID, pName);
+}
+
+void Renderer::SetViewSequential()
+{
+	m_viewMode = bgfx::ViewMode::Sequential;
+	bgfx::setViewMode(m_viewID, bgfx::ViewMode::Sequential);
+}
+
+void Renderer::SetViewDepthAscending()
+{
+	m_viewMode = bgfx::ViewMode::DepthAscending;
+	bgfx::setViewMode(m_viewID, bgfx::ViewMode::DepthAscending);
+}
+
+void Renderer::SubmitDraws(uint32_t drawCount, const SubmitChunkFunction& submitChunk) const
+{
+	if (0 == drawCount)
+	{
+		return;
+	}
+
+	// One chunk per worker and the calling thread. Encoder count is limited by bgfx.
+	uint32_t chunkCount = 1;
+	if (m_pThreadPool)
+	{
+		uint32_t maxChunkCount = std::min<uint32_t>(m_pThreadPool->GetThreadCount() + 1, bgfx::getCaps()->limits.maxEncoders);
+		chunkCount = std::clamp<uint32_t>(drawCount / MinDrawsPerChunk, 1, maxChunkCount);
+	}
+	uint32_t chunkSize = (drawCount + chunkCount - 1) / chunkCount;
+
+	// The calling thread records the first chunk with its own encoder and helps with the others.
+	// bgfx::begin returns null if all encoders are in use, then the chunk is left to the calling thread.
+	std::atomic<uint32_t> finishedChunkCount = 0;
+	std::vector<uint8_t> isChunkDeferred(chunkCount, 0);
+	for (uint32_t chunkIndex = 1; chunkIndex < chunkCount; ++chunkIndex)
+	{
+		uint32_t beginIndex = std::min(chunkIndex * chunkSize, drawCount);
+		uint32_t endIndex = std::min(beginIndex + chunkSize, drawCount);
+		m_pThreadPool->Submit([&submitChunk, &finishedChunkCount, &isChunkDeferred, chunkIndex, beginIndex, endIndex]()
+		{
+			if (bgfx::Encoder* pEncoder = bgfx::begin(true))
+			{
+				submitChunk(pEncoder, beginIndex, endIndex);
+				bgfx::end(pEncoder);
+			}
+			else
+			{
+				isChunkDeferred[chunkIndex] = 1;
+			}
+			finishedChunkCount.fetch_add(1, std::memory_order_release);
+		});
+	}
+
+	bgfx::Encoder* pEncoder = bgfx::begin();
+	submitChunk(pEncoder, 0, std::min(chunkSize, drawCount));
+	bgfx::end(pEncoder);
+
+	while (finishedChunkCount.load(std::memory_order_acquire) < chunkCount - 1)
+	{
+		if (!m_pThreadPool->TryRunTask())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	for (uint32_t chunkIndex = 1; chunkIndex < chunkCount; ++chunkIndex)
+	{
+		if (isChunkDeferred[chunkIndex])
+		{
+			uint32_t beginIndex = std::min(chunkIndex * chunkSize, drawCount);
+			pEncoder = bgfx::begin();
+			submitChunk(pEncoder, beginIndex, std::min(beginIndex + chunkSize, drawCount));
+			bgfx::end(pEncoder);
+		}
+	}
+}
+
 struct PosColorTexCoord0Vertex
 {
 	float m_x;
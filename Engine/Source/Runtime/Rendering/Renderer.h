@@ -2,14 +2,23 @@
 
 //#include <bgfx/bgfx.h>
 
+#include <functional>
 #include <string>
 
+namespace bgfx
+{
+
+struct Encoder;
+
+}
+
 namespace engine
 {
 
 class Camera;
 class RenderContext;
 class RenderTarget;
+class ThreadPool;
 
 class Renderer
 {
@@ -27,20 +36,51 @@ public:
 	virtual void Render(float deltaTime) = 0;
 
 	uint16_t GetViewID() const { return m_viewID; }
+	// View ID can be reassigned by RenderGraph every frame. The new view is reset and gets the name and mode of the renderer.
+	void SetViewID(uint16_t viewID);
+	const char* GetViewName() const { return m_viewName.c_str(); }
 	const RenderTarget* GetRenderTarget() const { return m_pRenderTarget; }
 
 	void Enable() { m_isEnable = true; }
 	void Disable() { m_isEnable = false; }
 	bool IsEnable() const { return m_isEnable; }
 
+	// Renderers can split CPU work such as culling into tasks. It is optional.
+	void SetThreadPool(ThreadPool* pThreadPool) { m_pThreadPool = pThreadPool; }
+	ThreadPool* GetThreadPool() const { return m_pThreadPool; }
+
 public:
+	// Draws less than it are recorded on the calling thread as encoders are not worth their overhead.
+	static constexpr uint32_t MinDrawsPerChunk = 256;
+
 	static void ScreenSpaceQuad(float _textureWidth, float _textureHeight, bool _originBottomLeft = false, float _width = 1.0f, float _height = 1.0f);
 
+protected:
+	// Per-view settings which are kept by bgfx. They are applied again when the view ID changes.
+	void SetViewName(const char* pName);
+	void SetViewSequential();
+	// Draws are ordered by the depth argument of submit, so that the order doesn't depend on when encoders submit them.
+	void SetViewDepthAscending();
+
+	// Callback records draws in [beginIndex, endIndex) into the encoder.
+	using SubmitChunkFunction = std::function<void(bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex)>;
+
+	// Splits draws into chunks which are recorded into their own bgfx::Encoder on worker threads.
+	// Chunks run concurrently, so callback should only write to its encoder and to its local data.
+	// Draws of different chunks interleave in a Sequential view. Views which need an order use DepthAscending and submit draw indexes as depths.
+	// A chunk whose worker doesn't get an encoder is recorded on the calling thread after the others.
+	// Uniforms, textures and states are kept per encoder, so callback sets per-view bindings at the beginning of every chunk.
+	// Draws are recorded on the calling thread if there is no thread pool.
+	void SubmitDraws(uint32_t drawCount, const SubmitChunkFunction& submitChunk) const;
+
 protected:
 	uint16_t		m_viewID = 0;
 	RenderContext*	m_pRenderContext = nullptr;
 	RenderTarget*	m_pRenderTarget = nullptr;
+	ThreadPool*		m_pThreadPool = nullptr;
 	bool			m_isEnable = true;
+	uint8_t			m_viewMode = 0; // bgfx::ViewMode::Enum
+	std::string		m_viewName;
 };
 
 }
\ No newline at end of file
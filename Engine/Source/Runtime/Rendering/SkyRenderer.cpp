@@ -22,7 +22,7 @@ void SkyRenderer::Init()
 	bgfx::ShaderHandle fsh = m_pRenderContext->CreateShader("fs_PBR_skybox.bin");
 	m_programSky = m_pRenderContext->CreateProgram("skybox", vsh, fsh);
 
-	bgfx::setViewName(GetViewID(), "SkyRenderer");
+	SetViewName("SkyRenderer");
 }
 
 SkyRenderer::~SkyRenderer()
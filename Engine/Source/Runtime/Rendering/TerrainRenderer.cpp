@@ -7,6 +7,7 @@
 #include "Scene/Texture.h"
 #include "Core/StringCrc.h"
 
+#include <algorithm>
 #include <bgfx/bgfx.h>
 
 #include <optional>
@@ -26,8 +27,8 @@ namespace engine
 
 void TerrainRenderer::Init()
 {
-	bgfx::setViewName(GetViewID(), "TerrainRenderer");
-	m_updateUniforms = true;
+	SetViewName("TerrainRenderer");
+	m_lastUpdateTick = 0;
 
 	u_terrainOrigin = m_pRenderContext->CreateUniform(kUniformSectorOrigin, bgfx::UniformType::Enum::Vec4, 1);
 	u_terrainDimension = m_pRenderContext->CreateUniform(kUniformSectorDimension, bgfx::UniformType::Vec4, 1);
@@ -39,47 +40,75 @@ void TerrainRenderer::UpdateView(const float* pViewMatrix, const float* pProject
 	bgfx::setViewRect(GetViewID(), 0, 0, GetRenderTarget()->GetWidth(), GetRenderTarget()->GetHeight());
 	bgfx::setViewTransform(GetViewID(), pViewMatrix, pProjectionMatrix);
 
+	m_frustum = Frustum::FromViewProjection(pViewMatrix, pProjectionMatrix, bgfx::getCaps()->homogeneousDepth);
+
 	UpdateUniforms();
 }
 
 void TerrainRenderer::Render(float deltaTime)
 {
-	for (const Entity& entity : m_pCurrentSceneWorld->GetMaterialEntities())
+	// Terrain meshes are placed in world space without transforms.
+	// Their heights are displaced by the elevation map in the vertex shader, so bounds are extended to the elevation range.
+	const float minElevation = m_pCurrentSceneWorld->GetTerrainMinElevation();
+	const float maxElevation = m_pCurrentSceneWorld->GetTerrainMaxElevation();
+	m_frustumCuller.Clear();
+	for (auto [entity, materialComponent, meshComponent] : m_pCurrentSceneWorld->GetWorld()->View<MaterialComponent, StaticMeshComponent>())
 	{
 		if (!IsTerrainMesh(entity))
 		{
 			continue;
 		}
-		const MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
-		const StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
 
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle(pMeshComponent->GetVertexBuffer()));
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle(pMeshComponent->GetIndexBuffer()));
+		const cd::AABB& flatAABB = meshComponent.GetAABB();
+		cd::AABB elevatedAABB(cd::Point(flatAABB.Min().x(), std::min(flatAABB.Min().y(), minElevation), flatAABB.Min().z()),
+			cd::Point(flatAABB.Max().x(), std::max(flatAABB.Max().y(), maxElevation), flatAABB.Max().z()));
+		m_frustumCuller.Add(entity, elevatedAABB, cd::Matrix4x4::Identity());
+	}
+	m_frustumCuller.Cull(m_frustum, GetThreadPool());
 
-		for (const auto& [textureType, textureInfo] : pMaterialComponent->GetTextureResources())
-		{
-			std::optional<const MaterialComponent::TextureInfo> optTextureInfo = pMaterialComponent->GetTextureInfo(textureType);
-			if (optTextureInfo.has_value())
-			{
-				const MaterialComponent::TextureInfo& textureInfo = optTextureInfo.value();
-				bgfx::setTexture(textureInfo.slot, bgfx::UniformHandle(textureInfo.samplerHandle), bgfx::TextureHandle(textureInfo.textureHandle));
-			}
-		}
-		
+	// Render infos are filled before recording because chunks of draws read them concurrently.
+	const std::vector<Entity>& visibleEntities = m_frustumCuller.GetVisibleEntities();
+	for (Entity entity : visibleEntities)
+	{
 		if (m_entityToRenderInfo.find(entity) == m_entityToRenderInfo.cend())
 		{
-			m_updateUniforms = true;
-			UpdateUniforms();
+			UpdateRenderInfo(entity, *m_pCurrentSceneWorld->GetMaterialComponent(entity), *m_pCurrentSceneWorld->GetStaticMeshComponent(entity));
 		}
-		const TerrainRenderInfo& meshRenderInfo = m_entityToRenderInfo[entity];
-		bgfx::setUniform(u_terrainOrigin, static_cast<const void*>(meshRenderInfo.m_origin));
-		bgfx::setUniform(u_terrainDimension, static_cast<const void*>(meshRenderInfo.m_dimension));
+	}
 
-		constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_CULL_CCW | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
-		bgfx::setState(state);
+	SubmitDraws(static_cast<uint32_t>(visibleEntities.size()), [this, &visibleEntities](bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex)
+	{
+		for (uint32_t visibleIndex = beginIndex; visibleIndex < endIndex; ++visibleIndex)
+		{
+			Entity entity = visibleEntities[visibleIndex];
+			auto itRenderInfo = m_entityToRenderInfo.find(entity);
+			if (itRenderInfo == m_entityToRenderInfo.cend())
+			{
+				// Mesh data is missing.
+				continue;
+			}
 
-		bgfx::submit(GetViewID(), bgfx::ProgramHandle(pMaterialComponent->GetShadingProgram()));
-	}
+			const MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
+			const StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
+
+			pEncoder->setVertexBuffer(0, bgfx::VertexBufferHandle(pMeshComponent->GetVertexBuffer()));
+			pEncoder->setIndexBuffer(bgfx::IndexBufferHandle(pMeshComponent->GetIndexBuffer()));
+
+			for (const MaterialComponent::TextureBinding& textureBinding : pMaterialComponent->GetTextureBindings())
+			{
+				pEncoder->setTexture(textureBinding.slot, bgfx::UniformHandle(textureBinding.samplerHandle), bgfx::TextureHandle(textureBinding.textureHandle));
+			}
+
+			const TerrainRenderInfo& meshRenderInfo = itRenderInfo->second;
+			pEncoder->setUniform(u_terrainOrigin, static_cast<const void*>(meshRenderInfo.m_origin));
+			pEncoder->setUniform(u_terrainDimension, static_cast<const void*>(meshRenderInfo.m_dimension));
+
+			constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_CULL_CCW | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
+			pEncoder->setState(state);
+
+			pEncoder->submit(GetViewID(), bgfx::ProgramHandle(pMaterialComponent->GetShadingProgram()));
+		}
+	});
 }
 
 bool TerrainRenderer::IsTerrainMesh(Entity entity) const
@@ -101,45 +130,59 @@ bool TerrainRenderer::IsTerrainMesh(Entity entity) const
 
 void TerrainRenderer::UpdateUniforms()
 {
-	if (m_updateUniforms)
+	// Only entities whose mesh or material was created or modified since the last update need to refresh.
+	const ComponentsStorage<MaterialComponent>* pMaterialStorage = m_pCurrentSceneWorld->GetWorld()->GetComponents<MaterialComponent>();
+	const ComponentsStorage<StaticMeshComponent>* pMeshStorage = m_pCurrentSceneWorld->GetWorld()->GetComponents<StaticMeshComponent>();
+	if (!pMaterialStorage->HasChangedSince(m_lastUpdateTick) && !pMeshStorage->HasChangedSince(m_lastUpdateTick))
 	{
-		for (const Entity& entity : m_pCurrentSceneWorld->GetMaterialEntities())
+		return;
+	}
+
+	for (auto [entity, materialComponent, meshComponent] : m_pCurrentSceneWorld->GetWorld()->View<MaterialComponent, StaticMeshComponent>())
+	{
+		if (pMaterialStorage->GetChangeTick(entity) < m_lastUpdateTick && pMeshStorage->GetChangeTick(entity) < m_lastUpdateTick)
 		{
-			if (!IsTerrainMesh(entity))
-			{
-				continue;
-			}
-			if (m_entityToRenderInfo.find(entity) == m_entityToRenderInfo.cend())
-			{
-				m_entityToRenderInfo[entity] = TerrainRenderInfo();
-			}
-			TerrainRenderInfo& renderInfo = m_entityToRenderInfo[entity];
-			const StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-			const Mesh* terrainMesh = pMeshComponent->GetMeshData();
-			if (!terrainMesh)
-			{
-				CD_ENGINE_WARN("Entity: %u has null mesh data!", entity);
-				continue;
-			}
-			// Convention is determined by TerrainProducer that the origin is always the first vertex
-			const std::vector<Point>& vertices = terrainMesh->GetVertexPositions();
-			const Point& origin = vertices[0];
-			renderInfo.m_origin[0] = origin.x();
-			renderInfo.m_origin[1] = origin.y();
-			renderInfo.m_origin[2] = origin.z();
-			renderInfo.m_origin[3] = 0.0f;
+			continue;
+		}
 
-			const MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
-			std::optional<const MaterialComponent::TextureInfo> elevationTexture = pMaterialComponent->GetTextureInfo(MaterialTextureType::Roughness);
-			assert(elevationTexture.has_value());
-			renderInfo.m_dimension[0] = static_cast<float>(elevationTexture->width);
-			renderInfo.m_dimension[1] = static_cast<float>(elevationTexture->height);
-			renderInfo.m_dimension[2] = 0.0f;
-			renderInfo.m_dimension[3] = 0.0f;
+		if (!IsTerrainMesh(entity))
+		{
+			continue;
 		}
 
-		m_updateUniforms = false;
+		UpdateRenderInfo(entity, materialComponent, meshComponent);
+	}
+
+	m_lastUpdateTick = m_pCurrentSceneWorld->GetWorld()->GetChangeTick();
+}
+
+void TerrainRenderer::UpdateRenderInfo(Entity entity, const MaterialComponent& materialComponent, const StaticMeshComponent& meshComponent)
+{
+	const StaticMeshComponent* pMeshComponent = &meshComponent;
+	const Mesh* terrainMesh = pMeshComponent->GetMeshData();
+	if (!terrainMesh)
+	{
+		CD_ENGINE_WARN("Entity: %u has null mesh data!", entity);
+		return;
 	}
+
+	TerrainRenderInfo& renderInfo = m_entityToRenderInfo[entity];
+
+	// Convention is determined by TerrainProducer that the origin is always the first vertex
+	const std::vector<Point>& vertices = terrainMesh->GetVertexPositions();
+	const Point& origin = vertices[0];
+	renderInfo.m_origin[0] = origin.x();
+	renderInfo.m_origin[1] = origin.y();
+	renderInfo.m_origin[2] = origin.z();
+	renderInfo.m_origin[3] = 0.0f;
+
+	const MaterialComponent* pMaterialComponent = &materialComponent;
+	std::optional<const MaterialComponent::TextureInfo> elevationTexture = pMaterialComponent->GetTextureInfo(MaterialTextureType::Roughness);
+	assert(elevationTexture.has_value());
+	renderInfo.m_dimension[0] = static_cast<float>(elevationTexture->width);
+	renderInfo.m_dimension[1] = static_cast<float>(elevationTexture->height);
+	renderInfo.m_dimension[2] = 0.0f;
+	renderInfo.m_dimension[3] = 0.0f;
 }
 
 }
\ No newline at end of file
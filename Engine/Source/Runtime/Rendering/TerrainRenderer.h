@@ -2,6 +2,7 @@
 
 #include "ECWorld/SceneWorld.h"
 #include "MeshRenderData.h"
+#include "FrustumCuller.hpp"
 #include "Renderer.h"
 
 #include <unordered_map>
@@ -22,6 +23,8 @@ public:
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 
+	const CullingStats& GetCullingStats() const { return m_frustumCuller.GetStats(); }
+
 private:
 	struct TerrainRenderInfo
 	{
@@ -37,9 +40,13 @@ private:
 	bool IsTerrainMesh(Entity) const;
 
 	void UpdateUniforms();
+	void UpdateRenderInfo(Entity entity, const MaterialComponent& materialComponent, const StaticMeshComponent& meshComponent);
 
-	bool m_updateUniforms = true;
+	ChangeTick m_lastUpdateTick = 0;
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
+
+	Frustum m_frustum;
+	FrustumCuller m_frustumCuller;
 	std::unordered_map<Entity, TerrainRenderInfo> m_entityToRenderInfo;
 
 	bgfx::UniformHandle u_terrainOrigin;	// bottom left corner in world coord; vec2
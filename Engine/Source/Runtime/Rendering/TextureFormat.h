@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+namespace engine
+{
+
+// Formats of textures which are created by the engine for rendering, such as render target attachments.
+enum class TextureFormat
+{
+	RGBA32F,
+	RGBA16F,
+	R11G11B10F,
+	D32F,
+	D24S8
+};
+
+constexpr uint32_t GetTextureFormatBytesPerPixel(TextureFormat textureFormat)
+{
+	switch (textureFormat)
+	{
+	case TextureFormat::RGBA32F:
+		return 16;
+	case TextureFormat::RGBA16F:
+		return 8;
+	case TextureFormat::R11G11B10F:
+	case TextureFormat::D32F:
+	case TextureFormat::D24S8:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+constexpr const char* GetTextureFormatName(TextureFormat textureFormat)
+{
+	switch (textureFormat)
+	{
+	case TextureFormat::RGBA32F:
+		return "RGBA32F";
+	case TextureFormat::RGBA16F:
+		return "RGBA16F";
+	case TextureFormat::R11G11B10F:
+		return "R11G11B10F";
+	case TextureFormat::D32F:
+		return "D32F";
+	case TextureFormat::D24S8:
+		return "D24S8";
+	default:
+		return "Unknown";
+	}
+}
+
+constexpr bool IsDepthTextureFormat(TextureFormat textureFormat)
+{
+	return TextureFormat::D32F == textureFormat || TextureFormat::D24S8 == textureFormat;
+}
+
+// Describes a 2D texture which is rendered to. Multisampled color textures are resolved to a single sampled copy
+// when they are sampled, so they take memory for both. Multisampled depth textures are write only.
+struct TextureDescriptor
+{
+	uint16_t width = 1;
+	uint16_t height = 1;
+	TextureFormat format = TextureFormat::RGBA32F;
+	uint8_t sampleCount = 1;
+
+	bool operator==(const TextureDescriptor&) const = default;
+
+	uint64_t GetSize() const
+	{
+		uint64_t sampleSize = static_cast<uint64_t>(width) * height * GetTextureFormatBytesPerPixel(format);
+		uint64_t resolveSize = sampleCount > 1 && !IsDepthTextureFormat(format) ? sampleSize : 0;
+		return sampleSize * sampleCount + resolveSize;
+	}
+};
+
+}
\ No newline at end of file
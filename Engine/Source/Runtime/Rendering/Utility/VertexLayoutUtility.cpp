@@ -68,6 +68,64 @@ std::string AttributeValueTypeToString(const cd::AttributeValueType& attribValue
 	}
 }
 
+// Returns false if the attribute isn't compressed.
+bool ConvertCompressedVertexLayout(const cd::VertexAttributeLayout& vertexAttributeLayout, engine::VertexCompression vertexCompression, bgfx::VertexLayout& outVertexLayout)
+{
+	using engine::VertexCompression;
+
+	switch (vertexAttributeLayout.vertexAttributeType)
+	{
+	case cd::VertexAttributeType::Position:
+		if (engine::HasVertexCompression(vertexCompression, VertexCompression::Position))
+		{
+			outVertexLayout.add(bgfx::Attrib::Enum::Position, 4, bgfx::AttribType::Enum::Int16, true);
+			return true;
+		}
+		break;
+	case cd::VertexAttributeType::Normal:
+		if (engine::HasVertexCompression(vertexCompression, VertexCompression::NormalTangent))
+		{
+			outVertexLayout.add(bgfx::Attrib::Enum::Normal, 4, bgfx::AttribType::Enum::Uint8, true);
+			return true;
+		}
+		break;
+	case cd::VertexAttributeType::Tangent:
+		// Stored in zw of the normal.
+		return engine::HasVertexCompression(vertexCompression, VertexCompression::NormalTangent);
+	case cd::VertexAttributeType::UV:
+		if (engine::HasVertexCompression(vertexCompression, VertexCompression::UV))
+		{
+			for (const bgfx::Attrib::Enum& textCoord : AllAttribUVTypes)
+			{
+				if (!outVertexLayout.has(textCoord))
+				{
+					outVertexLayout.add(textCoord, 2, bgfx::AttribType::Enum::Half);
+					return true;
+				}
+			}
+		}
+		break;
+	case cd::VertexAttributeType::BoneIndex:
+		if (engine::HasVertexCompression(vertexCompression, VertexCompression::BoneWeight))
+		{
+			outVertexLayout.add(bgfx::Attrib::Enum::Indices, 4, bgfx::AttribType::Enum::Uint8);
+			return true;
+		}
+		break;
+	case cd::VertexAttributeType::BoneWeight:
+		if (engine::HasVertexCompression(vertexCompression, VertexCompression::BoneWeight))
+		{
+			outVertexLayout.add(bgfx::Attrib::Enum::Weight, 4, bgfx::AttribType::Enum::Uint8, true);
+			return true;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return false;
+}
+
 void ConvertVertexLayout(const cd::VertexAttributeLayout& vertexAttributeLayout, bgfx::VertexLayout& outVertexLayout)
 {
 	bgfx::Attrib::Enum vertexAttribute = bgfx::Attrib::Enum::Count;
@@ -168,6 +226,28 @@ void VertexLayoutUtility::CreateVertexLayout(bgfx::VertexLayout& outVertexLayout
 	outVertexLayout.end();
 }
 
+// static
+void VertexLayoutUtility::CreateVertexLayout(bgfx::VertexLayout& outVertexLayout, const std::vector<cd::VertexAttributeLayout>& vertexAttributes, VertexCompression vertexCompression, bool debugPrint /* = false */)
+{
+	outVertexLayout.begin();
+	for (const cd::VertexAttributeLayout& vertexAttributeLayout : vertexAttributes)
+	{
+		if (debugPrint)
+		{
+			CD_ENGINE_TRACE("\t\tVA: ({0}, {1}, {2}), compression {3}",
+				VertexAttributeTypeToString(vertexAttributeLayout.vertexAttributeType).c_str(),
+				AttributeValueTypeToString(vertexAttributeLayout.attributeValueType).c_str(),
+				vertexAttributeLayout.attributeCount, static_cast<uint32_t>(vertexCompression));
+		}
+
+		if (!ConvertCompressedVertexLayout(vertexAttributeLayout, vertexCompression, outVertexLayout))
+		{
+			ConvertVertexLayout(vertexAttributeLayout, outVertexLayout);
+		}
+	}
+	outVertexLayout.end();
+}
+
 // static
 void VertexLayoutUtility::CreateVertexLayout(bgfx::VertexLayout& outVertexLayout, const cd::VertexAttributeLayout& vertexAttribute, bool debugPrint /* = false */)
 {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Rendering/VertexCompression.hpp"
 #include "Scene/VertexAttribute.h"
 
 #include <bgfx/bgfx.h>
@@ -13,6 +14,8 @@ class VertexLayoutUtility
 {
 public:
 	static void CreateVertexLayout(bgfx::VertexLayout& outVertexLayout, const std::vector<cd::VertexAttributeLayout>& vertexAttributes, bool debugPrint = false);
+	// Compressed attributes are converted to packed layouts, tangents are packed into normals.
+	static void CreateVertexLayout(bgfx::VertexLayout& outVertexLayout, const std::vector<cd::VertexAttributeLayout>& vertexAttributes, VertexCompression vertexCompression, bool debugPrint = false);
 	static void CreateVertexLayout(bgfx::VertexLayout& outVertexLayout, const cd::VertexAttributeLayout& vertexAttribute, bool debugPrint = false);
 };
 
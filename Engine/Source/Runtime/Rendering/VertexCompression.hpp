@@ -0,0 +1,264 @@
+#pragma once
+
+#include "Math/Vector.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+namespace engine
+{
+
+// Packed storages of vertex attributes which a MaterialType can opt into. Vertex shaders of the material type decode them.
+// - Position : snorm16x4 relative to the bounding box of the mesh, dequantized by u_positionDequantize.
+// - NormalTangent : normal and tangent are octahedral encoded into unorm8x2 each, packed together as the normal attribute.
+// - UV : half2.
+// - BoneWeight : uint8x4 bone indexes and unorm8x4 weights which sum to 1.
+enum class VertexCompression : uint8_t
+{
+	None = 0,
+	Position = 1 << 0,
+	NormalTangent = 1 << 1,
+	UV = 1 << 2,
+	BoneWeight = 1 << 3,
+};
+
+constexpr VertexCompression operator|(VertexCompression lhs, VertexCompression rhs)
+{
+	return static_cast<VertexCompression>(static_cast<uint8_t>(lhs) | static_cast<uint8_t>(rhs));
+}
+
+constexpr VertexCompression operator&(VertexCompression lhs, VertexCompression rhs)
+{
+	return static_cast<VertexCompression>(static_cast<uint8_t>(lhs) & static_cast<uint8_t>(rhs));
+}
+
+constexpr VertexCompression operator~(VertexCompression compression)
+{
+	return static_cast<VertexCompression>(~static_cast<uint8_t>(compression));
+}
+
+constexpr bool HasVertexCompression(VertexCompression compression, VertexCompression flag)
+{
+	return (compression & flag) == flag;
+}
+
+// Quantized positions are decoded as offset + scale * snorm, so that the bounding box of the mesh is mapped to [-1, 1].
+struct PositionQuantization
+{
+	cd::Vec3f offset = cd::Vec3f(0.0f);
+	cd::Vec3f scale = cd::Vec3f(1.0f);
+};
+
+// VertexQuantizer encodes vertex attributes to packed storages. Decode functions mirror the vertex shaders,
+// so that errors of encoding can be measured on the CPU.
+class VertexQuantizer final
+{
+public:
+	VertexQuantizer() = delete;
+
+	static PositionQuantization MakePositionQuantization(const cd::Point* pPositions, uint32_t vertexCount)
+	{
+		PositionQuantization quantization;
+		if (0 == vertexCount)
+		{
+			return quantization;
+		}
+
+		cd::Vec3f minPosition = pPositions[0];
+		cd::Vec3f maxPosition = pPositions[0];
+		for (uint32_t vertexIndex = 1; vertexIndex < vertexCount; ++vertexIndex)
+		{
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				minPosition[axis] = std::min(minPosition[axis], pPositions[vertexIndex][axis]);
+				maxPosition[axis] = std::max(maxPosition[axis], pPositions[vertexIndex][axis]);
+			}
+		}
+
+		// Flat axes have a single value at the offset, any scale decodes it.
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			float halfExtent = (maxPosition[axis] - minPosition[axis]) * 0.5f;
+			quantization.offset[axis] = (maxPosition[axis] + minPosition[axis]) * 0.5f;
+			quantization.scale[axis] = halfExtent > 0.0f ? halfExtent : 1.0f;
+		}
+
+		return quantization;
+	}
+
+	// The fourth component only pads the attribute to 8 bytes.
+	static std::array<int16_t, 4> QuantizePosition(const cd::Point& position, const PositionQuantization& quantization)
+	{
+		std::array<int16_t, 4> quantized = {};
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			quantized[axis] = EncodeSnorm16((position[axis] - quantization.offset[axis]) / quantization.scale[axis]);
+		}
+		return quantized;
+	}
+
+	static cd::Point DequantizePosition(const std::array<int16_t, 4>& quantized, const PositionQuantization& quantization)
+	{
+		cd::Point position;
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			position[axis] = quantization.offset[axis] + quantization.scale[axis] * DecodeSnorm16(quantized[axis]);
+		}
+		return position;
+	}
+
+	// Octahedral encoding projects a unit direction onto the octahedron |x| + |y| + |z| = 1 and unfolds the lower half onto the corners.
+	// Rounding each component to the nearest value isn't the closest direction, so all four neighbors of the grid are compared.
+	static std::array<uint8_t, 2> EncodeOctahedral(const cd::Direction& direction)
+	{
+		float length = std::abs(direction.x()) + std::abs(direction.y()) + std::abs(direction.z());
+		if (length <= 0.0f)
+		{
+			return { 128, 128 };
+		}
+
+		float x = direction.x() / length;
+		float y = direction.y() / length;
+		if (direction.z() < 0.0f)
+		{
+			float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = foldedX;
+			y = foldedY;
+		}
+
+		cd::Direction unitDirection = direction;
+		unitDirection.Normalize();
+
+		float unormX = std::clamp((x * 0.5f + 0.5f) * 255.0f, 0.0f, 255.0f);
+		float unormY = std::clamp((y * 0.5f + 0.5f) * 255.0f, 0.0f, 255.0f);
+		std::array<uint8_t, 2> bestEncoded = {};
+		float bestCosine = -2.0f;
+		for (float candidateX : { std::floor(unormX), std::ceil(unormX) })
+		{
+			for (float candidateY : { std::floor(unormY), std::ceil(unormY) })
+			{
+				std::array<uint8_t, 2> encoded = { static_cast<uint8_t>(candidateX), static_cast<uint8_t>(candidateY) };
+				float cosine = DecodeOctahedral(encoded).Dot(unitDirection);
+				if (cosine > bestCosine)
+				{
+					bestCosine = cosine;
+					bestEncoded = encoded;
+				}
+			}
+		}
+
+		return bestEncoded;
+	}
+
+	static cd::Direction DecodeOctahedral(const std::array<uint8_t, 2>& encoded)
+	{
+		float x = encoded[0] / 255.0f * 2.0f - 1.0f;
+		float y = encoded[1] / 255.0f * 2.0f - 1.0f;
+		cd::Direction direction(x, y, 1.0f - std::abs(x) - std::abs(y));
+		float fold = std::max(-direction.z(), 0.0f);
+		direction.x() += direction.x() >= 0.0f ? -fold : fold;
+		direction.y() += direction.y() >= 0.0f ? -fold : fold;
+		direction.Normalize();
+		return direction;
+	}
+
+	// IEEE 754 binary16 with round to nearest even. Values out of range become infinities.
+	static uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits = std::bit_cast<uint32_t>(value);
+		uint32_t sign = (bits >> 16) & 0x8000;
+		uint32_t magnitude = bits & 0x7FFFFFFF;
+		if (magnitude > 0x7F800000)
+		{
+			return static_cast<uint16_t>(sign | 0x7E00);
+		}
+
+		// 65520 is the half way between the largest half 65504 and the next power of two.
+		if (magnitude >= 0x477FF000)
+		{
+			return static_cast<uint16_t>(sign | 0x7C00);
+		}
+
+		// Subnormal halves are multiples of 2^-24.
+		if (magnitude < 0x38800000)
+		{
+			return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::nearbyint(std::bit_cast<float>(magnitude) * 16777216.0f)));
+		}
+
+		uint32_t rounded = magnitude + 0xFFF + ((magnitude >> 13) & 1);
+		return static_cast<uint16_t>(sign | ((rounded - 0x38000000) >> 13));
+	}
+
+	static float HalfToFloat(uint16_t half)
+	{
+		uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+		uint32_t exponent = (half >> 10) & 0x1F;
+		uint32_t mantissa = half & 0x3FF;
+		if (0 == exponent)
+		{
+			float subnormal = std::ldexp(static_cast<float>(mantissa), -24);
+			return sign ? -subnormal : subnormal;
+		}
+
+		if (0x1F == exponent)
+		{
+			return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+		}
+
+		return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+	}
+
+	// Weights are normalized and rounded by largest remainders, so that they always sum to 255 and each one is off by less than 1/255.
+	// Vertexes without influences keep zero weights.
+	static std::array<uint8_t, 4> QuantizeBoneWeights(const std::array<float, 4>& weights)
+	{
+		std::array<uint8_t, 4> quantized = {};
+		float totalWeight = 0.0f;
+		for (float weight : weights)
+		{
+			totalWeight += std::max(weight, 0.0f);
+		}
+
+		if (totalWeight <= 0.0f)
+		{
+			return quantized;
+		}
+
+		std::array<float, 4> remainders = {};
+		uint32_t quantizedSum = 0;
+		for (uint32_t influenceIndex = 0; influenceIndex < 4; ++influenceIndex)
+		{
+			float scaled = std::min(std::max(weights[influenceIndex], 0.0f) / totalWeight * 255.0f, 255.0f);
+			quantized[influenceIndex] = static_cast<uint8_t>(scaled);
+			remainders[influenceIndex] = scaled - static_cast<float>(quantized[influenceIndex]);
+			quantizedSum += quantized[influenceIndex];
+		}
+
+		for (; quantizedSum < 255; ++quantizedSum)
+		{
+			auto itMaxRemainder = std::max_element(remainders.begin(), remainders.end());
+			++quantized[itMaxRemainder - remainders.begin()];
+			*itMaxRemainder = -1.0f;
+		}
+
+		return quantized;
+	}
+
+private:
+	static int16_t EncodeSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	// -32768 and -32767 both decode to -1.
+	static float DecodeSnorm16(int16_t value)
+	{
+		return std::max(value / 32767.0f, -1.0f);
+	}
+};
+
+}
\ No newline at end of file
@@ -1,19 +1,63 @@
 #include "WorldRenderer.h"
 
+#include "ECWorld/AnimationComponent.h"
 #include "ECWorld/CameraComponent.h"
 #include "ECWorld/MaterialComponent.h"
 #include "ECWorld/SceneWorld.h"
 #include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/TransformComponent.h"
+#include "ClusteredLightUniforms.h"
+#include "Core/Threading/ThreadPool.hpp"
 #include "Material/ShaderSchema.h"
 #include "RenderContext.h"
 #include "Scene/Texture.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
 #include <format>
+#include <iterator>
+#include <mutex>
+#include <thread>
 
 namespace engine
 {
 
+namespace
+{
+
+// Materials with the same textures get the same sort bits, so that their draws are adjacent and reuse bindings.
+uint16_t GetMaterialSortKey(const MaterialComponent& materialComponent)
+{
+	uint32_t hash = 2166136261U;
+	for (const MaterialComponent::TextureBinding& textureBinding : materialComponent.GetTextureBindings())
+	{
+		hash = (hash ^ textureBinding.slot) * 16777619U;
+		hash = (hash ^ textureBinding.textureHandle) * 16777619U;
+	}
+	return static_cast<uint16_t>(hash ^ (hash >> 16));
+}
+
+// Materials can be drawn in one instanced draw if they have the same shader option and texture bindings.
+bool HasSameBindings(const MaterialComponent& lhs, const MaterialComponent& rhs)
+{
+	return lhs.GetUberShaderOption() == rhs.GetUberShaderOption() &&
+		std::equal(lhs.GetTextureBindings().begin(), lhs.GetTextureBindings().end(),
+			rhs.GetTextureBindings().begin(), rhs.GetTextureBindings().end(),
+			[](const MaterialComponent::TextureBinding& lhsBinding, const MaterialComponent::TextureBinding& rhsBinding)
+			{
+				return lhsBinding.slot == rhsBinding.slot &&
+					lhsBinding.samplerHandle == rhsBinding.samplerHandle &&
+					lhsBinding.textureHandle == rhsBinding.textureHandle;
+			});
+}
+
+}
+
+WorldRenderer::~WorldRenderer() = default;
+
 void WorldRenderer::Init()
 {
 	m_pRenderContext->CreateUniform("s_texLUT", bgfx::UniformType::Sampler);
@@ -26,8 +70,14 @@ void WorldRenderer::Init()
 	m_pRenderContext->CreateTexture("skybox/bolonga_irr.dds", samplerFlags);
 
 	m_pRenderContext->CreateUniform("u_cameraPos", bgfx::UniformType::Vec4, 1);
+	m_pRenderContext->CreateUniform("u_positionDequantize", bgfx::UniformType::Vec4, 2);
+
+	m_pClusteredLightUniform = std::make_unique<ClusteredLightUniform>(m_pRenderContext);
 
-	bgfx::setViewName(GetViewID(), "WorldRenderer");
+	SetViewName("WorldRenderer");
+
+	// Draws are sorted by RenderQueue before submission and submit their sorted indexes as depths.
+	SetViewDepthAscending();
 }
 
 void WorldRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
@@ -35,79 +85,326 @@ void WorldRenderer::UpdateView(const float* pViewMatrix, const float* pProjectio
 	bgfx::setViewFrameBuffer(GetViewID(), *GetRenderTarget()->GetFrameBufferHandle());
 	bgfx::setViewRect(GetViewID(), 0, 0, GetRenderTarget()->GetWidth(), GetRenderTarget()->GetHeight());
 	bgfx::setViewTransform(GetViewID(), pViewMatrix, pProjectionMatrix);
+
+	m_frustum = Frustum::FromViewProjection(pViewMatrix, pProjectionMatrix, bgfx::getCaps()->homogeneousDepth);
+	m_lodErrorScale = 0.5f * GetRenderTarget()->GetHeight() * pProjectionMatrix[5];
+}
+
+// LODs are selected by their errors projected to the screen at the nearest view depth of the bounding sphere.
+uint8_t WorldRenderer::SelectLOD(const StaticMeshComponent& meshComponent, const cd::Matrix4x4* pWorldMatrix, const float* pViewMatrix) const
+{
+	if (meshComponent.GetLODCount() <= 1)
+	{
+		return 0;
+	}
+
+	const cd::AABB& aabb = meshComponent.GetAABB();
+	cd::Point center = aabb.Center();
+	float radius = 0.5f * aabb.Size().Length();
+	float worldScale = 1.0f;
+	if (pWorldMatrix)
+	{
+		worldScale = 0.0f;
+		const float* pWorld = pWorldMatrix->Begin();
+		center = cd::Point(pWorld[0] * center.x() + pWorld[4] * center.y() + pWorld[8] * center.z() + pWorld[12],
+			pWorld[1] * center.x() + pWorld[5] * center.y() + pWorld[9] * center.z() + pWorld[13],
+			pWorld[2] * center.x() + pWorld[6] * center.y() + pWorld[10] * center.z() + pWorld[14]);
+		for (int column = 0; column < 3; ++column)
+		{
+			const float* pAxis = &pWorld[column * 4];
+			worldScale = std::max(worldScale, std::sqrt(pAxis[0] * pAxis[0] + pAxis[1] * pAxis[1] + pAxis[2] * pAxis[2]));
+		}
+	}
+
+	float viewDepth = pViewMatrix[2] * center.x() + pViewMatrix[6] * center.y() + pViewMatrix[10] * center.z() + pViewMatrix[14] - radius * worldScale;
+	return static_cast<uint8_t>(SelectMeshLOD(meshComponent.GetLODs(), m_lodErrorScale * worldScale, viewDepth, m_maxLODPixelError));
 }
 
 void WorldRenderer::Render(float deltaTime)
 {
 	// TODO : Remove it. If every renderer need to submit camera related uniform, it should be done not inside Renderer class.
 	const engine::CameraComponent* pCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
-	for (Entity entity : m_pCurrentSceneWorld->GetMaterialEntities())
+
+	// Lights are binned into clusters of the camera by a job which runs during culling and batching.
+	std::atomic<bool> isLightBinningDone = false;
+	auto binLights = [this, pCameraComponent, &isLightBinningDone]()
+	{
+		m_pClusteredLightUniform->Build(*m_pCurrentSceneWorld->GetComponentsStorage<LightComponent>(), pCameraComponent->GetViewMatrix().Begin(),
+			pCameraComponent->GetProjectionMatrix().Begin(), pCameraComponent->GetNearPlane(), pCameraComponent->GetFarPlane());
+		isLightBinningDone = true;
+	};
+	if (m_pThreadPool)
+	{
+		m_pThreadPool->Submit(binLights);
+	}
+	else
+	{
+		binLights();
+	}
+
+	// Every mesh which this renderer draws is culled against the view frustum by the SIMD culler in parallel chunks.
+	// The bounding volume hierarchy serves picking, FrameAll and light queries instead.
+	// Skinned meshes are drawn by AnimationRenderer.
+	m_frustumCuller.Clear();
+	auto meshView = m_pCurrentSceneWorld->GetWorld()->View<MaterialComponent, StaticMeshComponent>(Without<AnimationComponent>());
+	for (auto [entity, materialComponent, meshComponent] : meshView)
 	{
-		MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
-		if (!pMaterialComponent ||
-			pMaterialComponent->GetMaterialType() != m_pCurrentSceneWorld->GetPBRMaterialType())
+		if (materialComponent.GetMaterialType() != m_pCurrentSceneWorld->GetPBRMaterialType())
 		{
 			// TODO : improve this condition. As we want to skip some feature-specified entities to render.
 			// For example, terrain/particle/...
 			continue;
 		}
 
-		// No mesh attached?
-		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-		if (!pMeshComponent)
-		{
-			continue;
-		}
+		const TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity);
+		m_frustumCuller.Add(entity, meshComponent.GetAABB(), pTransformComponent ? pTransformComponent->GetWorldMatrix() : cd::Matrix4x4::Identity());
+	}
+	m_frustumCuller.Cull(m_frustum, m_pThreadPool);
+
+	// Components of visible meshes are looked up here once, so that batching and submission only read resolved draws.
+	const float* pViewMatrix = pCameraComponent->GetViewMatrix().Begin();
+	m_visibleDraws.clear();
+	for (Entity entity : m_frustumCuller.GetVisibleEntities())
+	{
+		const MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
+		const StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
+		const TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity);
+		const cd::Matrix4x4* pWorldMatrix = pTransformComponent ? &pTransformComponent->GetWorldMatrix() : nullptr;
+		m_visibleDraws.push_back(VisibleDraw{ pMaterialComponent, pMeshComponent, pWorldMatrix, GetMaterialSortKey(*pMaterialComponent),
+			SelectLOD(*pMeshComponent, pWorldMatrix, pViewMatrix) });
+	}
+
+	// Group draws which share mesh, LOD, program and textures into instanced batches.
+	constexpr StringCrc useIBLCrc("USE_PBR_IBL");
+	m_instanceBatcher.Clear();
+	for (uint32_t visibleIndex = 0; visibleIndex < m_visibleDraws.size(); ++visibleIndex)
+	{
+		const VisibleDraw& draw = m_visibleDraws[visibleIndex];
+		m_instanceBatcher.Add(InstanceBatcher::MakeBatchKey(draw.pMeshComponent->GetVertexBuffer(), draw.pMeshComponent->GetIndexBuffer(),
+			draw.pMaterialComponent->GetShadingProgram(), draw.materialKey, draw.lod), visibleIndex);
+	}
+	m_instanceBatcher.Build([this](uint32_t lhsIndex, uint32_t rhsIndex)
+	{
+		return HasSameBindings(*m_visibleDraws[lhsIndex].pMaterialComponent, *m_visibleDraws[rhsIndex].pMaterialComponent);
+	});
 
-		// SkinMesh
-		if(m_pCurrentSceneWorld->GetAnimationComponent(entity))
+	// Unique objects and materials without instance programs fall back to single draws.
+	const bool supportInstancing = 0 != (bgfx::getCaps()->supported & BGFX_CAPS_INSTANCING);
+	const std::vector<uint32_t>& instances = m_instanceBatcher.GetInstances();
+	m_drawBatches.clear();
+	for (const InstanceBatcher::Batch& batch : m_instanceBatcher.GetBatches())
+	{
+		const MaterialComponent* pMaterialComponent = m_visibleDraws[instances[batch.firstInstance]].pMaterialComponent;
+		if (batch.instanceCount > 1 && supportInstancing && bgfx::kInvalidHandle != pMaterialComponent->GetInstanceShadingProgram())
 		{
+			m_drawBatches.push_back(batch);
 			continue;
 		}
 
-		// Transform
-		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
+		for (uint32_t instanceIndex = batch.firstInstance; instanceIndex < batch.firstInstance + batch.instanceCount; ++instanceIndex)
 		{
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().Begin());
+			m_drawBatches.push_back(InstanceBatcher::Batch{ instanceIndex, 1 });
 		}
+	}
 
-		// Mesh
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle(pMeshComponent->GetVertexBuffer()));
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle(pMeshComponent->GetIndexBuffer()));
+	// Sort draws by program, then material and depth. Batches are sorted by their nearest instance.
+	m_renderQueue.Clear();
+	m_renderQueueStats = RenderQueueStats();
+	uint16_t lastProgram = bgfx::kInvalidHandle;
+	for (uint32_t drawIndex = 0; drawIndex < m_drawBatches.size(); ++drawIndex)
+	{
+		const InstanceBatcher::Batch& batch = m_drawBatches[drawIndex];
+		const VisibleDraw& firstDraw = m_visibleDraws[instances[batch.firstInstance]];
 
-		for (const auto& [textureType, textureInfo] : pMaterialComponent->GetTextureResources())
+		float viewDepth = FLT_MAX;
+		for (uint32_t instanceIndex = batch.firstInstance; instanceIndex < batch.firstInstance + batch.instanceCount; ++instanceIndex)
 		{
-			std::optional<MaterialComponent::TextureInfo> optTextureInfo = pMaterialComponent->GetTextureInfo(textureType);
-			if (optTextureInfo.has_value())
+			float instanceDepth = 0.0f;
+			if (const cd::Matrix4x4* pWorldMatrix = m_visibleDraws[instances[instanceIndex]].pWorldMatrix)
 			{
-				const MaterialComponent::TextureInfo& textureInfo = optTextureInfo.value();
-				bgfx::setTexture(textureInfo.slot, bgfx::UniformHandle(textureInfo.samplerHandle), bgfx::TextureHandle(textureInfo.textureHandle));
+				const float* pWorld = pWorldMatrix->Begin();
+				instanceDepth = pViewMatrix[2] * pWorld[12] + pViewMatrix[6] * pWorld[13] + pViewMatrix[10] * pWorld[14] + pViewMatrix[14];
 			}
+			viewDepth = std::min(viewDepth, instanceDepth);
 		}
 
-		constexpr StringCrc lutSampler("s_texLUT");
-		constexpr StringCrc lutTexture("lut/ibl_brdf_lut.dds");
-		bgfx::setTexture(3, m_pRenderContext->GetUniform(lutSampler), m_pRenderContext->GetTexture(lutTexture));
+		uint16_t program = batch.instanceCount > 1 ? firstDraw.pMaterialComponent->GetInstanceShadingProgram() : firstDraw.pMaterialComponent->GetShadingProgram();
+		m_renderQueue.Push(RenderQueue::MakeSortKey(GetViewID(), 0, program, firstDraw.materialKey, RenderQueue::QuantizeDepth(viewDepth)), drawIndex);
 
-		constexpr StringCrc useIBLCrc("USE_PBR_IBL");
-		if (useIBLCrc == pMaterialComponent->GetUberShaderOption())
+		// Cost of submitting every visible object in the visible order with all bindings set per draw.
+		for (uint32_t instanceIndex = 0; instanceIndex < batch.instanceCount; ++instanceIndex)
 		{
-			constexpr StringCrc cubeSampler("s_texCube");
-			constexpr StringCrc cubeTexture("skybox/bolonga_lod.dds");
-			bgfx::setTexture(4, m_pRenderContext->GetUniform(cubeSampler), m_pRenderContext->GetTexture(cubeTexture));
+			m_renderQueueStats.unsortedProgramSwitches += program != lastProgram ? 1 : 0;
+			m_renderQueueStats.unsortedTextureBinds += static_cast<uint32_t>(firstDraw.pMaterialComponent->GetTextureBindings().size()) + (useIBLCrc == firstDraw.pMaterialComponent->GetUberShaderOption() ? 3 : 1);
+			lastProgram = program;
+		}
+	}
+	m_renderQueue.Sort();
 
-			constexpr StringCrc cubeIrrSampler("s_texCubeIrr");
-			constexpr StringCrc cubeIrrTexture("skybox/bolonga_irr.dds");
-			bgfx::setTexture(5, m_pRenderContext->GetUniform(cubeIrrSampler), m_pRenderContext->GetTexture(cubeIrrTexture));
+	while (!isLightBinningDone)
+	{
+		if (!m_pThreadPool->TryRunTask())
+		{
+			std::this_thread::yield();
 		}
+	}
+
+	if (m_renderQueue.IsEmpty())
+	{
+		return;
+	}
 
-		m_pRenderContext->FillUniform(StringCrc("u_cameraPos"), &pCameraComponent->GetEye().x(), 1);
+	// Camera and IBL resources are shared by all draws of the view. Their handles are resolved once per frame.
+	// IBL textures are bound for all materials as samplers which a program doesn't use are ignored.
+	ViewBindings& viewBindings = m_pRenderContext->GetViewBindings(GetViewID());
+	viewBindings.Clear();
+	m_pRenderContext->SetViewUniform(GetViewID(), StringCrc("u_cameraPos"), &pCameraComponent->GetEye().x(), 1);
+	m_pRenderContext->SetViewTexture(GetViewID(), 3, StringCrc("s_texLUT"), StringCrc("lut/ibl_brdf_lut.dds"));
+	m_pRenderContext->SetViewTexture(GetViewID(), 4, StringCrc("s_texCube"), StringCrc("skybox/bolonga_lod.dds"));
+	m_pRenderContext->SetViewTexture(GetViewID(), 5, StringCrc("s_texCubeIrr"), StringCrc("skybox/bolonga_irr.dds"));
+	m_pClusteredLightUniform->Submit(viewBindings);
+
+	// Sorted draws are split into chunks which are recorded on worker threads.
+	// Bindings and state are kept by the encoder for the next draw and only set when they change.
+	// bgfx copies bindings and state into every draw at submit, so the view can reorder draws of chunks by their submit depths.
+	std::mutex statsMutex;
+	// Uniforms set by one encoder don't apply to draws of others, so every chunk sets position dequantization of its meshes.
+	const bgfx::UniformHandle positionDequantizeHandle = m_pRenderContext->GetUniform(StringCrc("u_positionDequantize"));
+	SubmitDraws(static_cast<uint32_t>(m_renderQueue.GetItemCount()), [&](bgfx::Encoder* pEncoder, uint32_t beginIndex, uint32_t endIndex)
+	{
+		RenderQueueStats chunkStats;
+
+		uint32_t boundTextures[BGFX_CONFIG_MAX_TEXTURE_SAMPLERS];
+		std::fill(std::begin(boundTextures), std::end(boundTextures), UINT32_MAX);
+		auto setTexture = [pEncoder, &boundTextures, &chunkStats](uint8_t slot, uint16_t samplerHandle, uint16_t textureHandle)
+		{
+			uint32_t binding = static_cast<uint32_t>(samplerHandle) << 16 | textureHandle;
+			if (boundTextures[slot] != binding)
+			{
+				pEncoder->setTexture(slot, bgfx::UniformHandle(samplerHandle), bgfx::TextureHandle(textureHandle));
+				boundTextures[slot] = binding;
+				++chunkStats.textureBinds;
+			}
+		};
+
+		viewBindings.Apply(pEncoder);
 
 		constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_CULL_CCW | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
-		bgfx::setState(state);
+		pEncoder->setState(state);
+		++chunkStats.stateChanges;
 
-		bgfx::submit(GetViewID(), bgfx::ProgramHandle(pMaterialComponent->GetShadingProgram()));
-	}
+		// Every draw replays all uniforms which are set since the last state discard.
+		// So the state is discarded when the mesh changes, then draws only replay view uniforms and position dequantization of their mesh.
+		const cd::Vec4f* pLastPositionDequantization = nullptr;
+		auto setPositionDequantization = [&](const cd::Vec4f* pPositionDequantization)
+		{
+			if (pPositionDequantization == pLastPositionDequantization)
+			{
+				return;
+			}
+
+			if (pLastPositionDequantization)
+			{
+				pEncoder->discard(BGFX_DISCARD_STATE);
+				viewBindings.ApplyUniforms(pEncoder);
+				pEncoder->setState(state);
+				++chunkStats.stateChanges;
+			}
+			pEncoder->setUniform(positionDequantizeHandle, pPositionDequantization, 2);
+			pLastPositionDequantization = pPositionDequantization;
+		};
+
+		constexpr uint8_t discardFlags = BGFX_DISCARD_TRANSFORM | BGFX_DISCARD_VERTEX_STREAMS | BGFX_DISCARD_INDEX_BUFFER | BGFX_DISCARD_INSTANCE_DATA;
+		constexpr uint16_t instanceStride = sizeof(cd::Matrix4x4);
+		uint16_t lastProgram = bgfx::kInvalidHandle;
+		for (uint32_t itemIndex = beginIndex; itemIndex < endIndex; ++itemIndex)
+		{
+			const RenderQueue::Item& item = m_renderQueue.GetItems()[itemIndex];
+			const uint32_t submitDepth = RenderQueue::GetSubmitDepth(itemIndex);
+			const InstanceBatcher::Batch& batch = m_drawBatches[item.payload];
+			const VisibleDraw& firstDraw = m_visibleDraws[instances[batch.firstInstance]];
+			const bgfx::VertexBufferHandle vertexBufferHandle{ firstDraw.pMeshComponent->GetVertexBuffer() };
+			const bgfx::IndexBufferHandle indexBufferHandle{ firstDraw.pMeshComponent->GetIndexBuffer() };
+			const MeshLOD& lod = firstDraw.pMeshComponent->GetLOD(firstDraw.lod);
+			const cd::Vec4f* pPositionDequantization = firstDraw.pMeshComponent->GetPositionDequantization();
+			const uint32_t fullDetailTriangleCount = firstDraw.pMeshComponent->GetLOD(0).indexCount / 3;
+
+			for (const MaterialComponent::TextureBinding& textureBinding : firstDraw.pMaterialComponent->GetTextureBindings())
+			{
+				setTexture(textureBinding.slot, textureBinding.samplerHandle, textureBinding.textureHandle);
+			}
+
+			setPositionDequantization(pPositionDequantization);
+
+			uint16_t program = RenderQueue::GetProgram(item.key);
+			chunkStats.programSwitches += program != lastProgram ? 1 : 0;
+			lastProgram = program;
+
+			// Instanced batch. World matrices are written to transient instance data buffers which may be smaller than the batch.
+			uint32_t instanceIndex = batch.firstInstance;
+			const uint32_t instanceEnd = batch.firstInstance + batch.instanceCount;
+			if (batch.instanceCount > 1)
+			{
+				while (instanceIndex < instanceEnd)
+				{
+					uint32_t instanceCount = bgfx::getAvailInstanceDataBuffer(instanceEnd - instanceIndex, instanceStride);
+					if (0 == instanceCount)
+					{
+						break;
+					}
+
+					bgfx::InstanceDataBuffer instanceDataBuffer;
+					bgfx::allocInstanceDataBuffer(&instanceDataBuffer, instanceCount, instanceStride);
+					uint8_t* pInstanceData = instanceDataBuffer.data;
+					for (uint32_t batchIndex = 0; batchIndex < instanceCount; ++batchIndex, ++instanceIndex, pInstanceData += instanceStride)
+					{
+						const cd::Matrix4x4* pWorldMatrix = m_visibleDraws[instances[instanceIndex]].pWorldMatrix;
+						const cd::Matrix4x4& worldMatrix = pWorldMatrix ? *pWorldMatrix : cd::Matrix4x4::Identity();
+						std::memcpy(pInstanceData, worldMatrix.Begin(), instanceStride);
+					}
+
+					pEncoder->setVertexBuffer(0, vertexBufferHandle);
+					pEncoder->setIndexBuffer(indexBufferHandle, lod.indexOffset, lod.indexCount);
+					pEncoder->setInstanceDataBuffer(&instanceDataBuffer);
+					pEncoder->submit(GetViewID(), bgfx::ProgramHandle(firstDraw.pMaterialComponent->GetInstanceShadingProgram()), submitDepth, discardFlags);
+					++chunkStats.drawCount;
+					++chunkStats.instancedDrawCount;
+					chunkStats.instanceCount += instanceCount;
+					chunkStats.triangleCount += instanceCount * lod.indexCount / 3;
+					chunkStats.fullDetailTriangleCount += instanceCount * fullDetailTriangleCount;
+				}
+			}
+
+			// Single draws, including instances which don't fit into the instance data buffer.
+			for (; instanceIndex < instanceEnd; ++instanceIndex)
+			{
+				if (const cd::Matrix4x4* pWorldMatrix = m_visibleDraws[instances[instanceIndex]].pWorldMatrix)
+				{
+					pEncoder->setTransform(pWorldMatrix->Begin());
+				}
+
+				pEncoder->setVertexBuffer(0, vertexBufferHandle);
+				pEncoder->setIndexBuffer(indexBufferHandle, lod.indexOffset, lod.indexCount);
+				pEncoder->submit(GetViewID(), bgfx::ProgramHandle(firstDraw.pMaterialComponent->GetShadingProgram()), submitDepth, discardFlags);
+				++chunkStats.drawCount;
+				chunkStats.triangleCount += lod.indexCount / 3;
+				chunkStats.fullDetailTriangleCount += fullDetailTriangleCount;
+			}
+		}
+
+		// Don't leak kept bindings and state to draws of other renderers.
+		pEncoder->discard(BGFX_DISCARD_ALL);
+
+		std::lock_guard<std::mutex> lock(statsMutex);
+		m_renderQueueStats.drawCount += chunkStats.drawCount;
+		m_renderQueueStats.programSwitches += chunkStats.programSwitches;
+		m_renderQueueStats.textureBinds += chunkStats.textureBinds;
+		m_renderQueueStats.stateChanges += chunkStats.stateChanges;
+		m_renderQueueStats.instancedDrawCount += chunkStats.instancedDrawCount;
+		m_renderQueueStats.instanceCount += chunkStats.instanceCount;
+		m_renderQueueStats.triangleCount += chunkStats.triangleCount;
+		m_renderQueueStats.fullDetailTriangleCount += chunkStats.fullDetailTriangleCount;
+	});
 }
 
 }
\ No newline at end of file
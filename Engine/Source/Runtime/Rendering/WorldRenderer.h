@@ -1,18 +1,26 @@
 #pragma once
 
+#include "FrustumCuller.hpp"
+#include "InstanceBatcher.hpp"
+#include "RenderQueue.hpp"
 #include "Renderer.h"
 
+#include <memory>
 #include <vector>
 
 namespace engine
 {
 
+class ClusteredLightUniform;
+class MaterialComponent;
 class SceneWorld;
+class StaticMeshComponent;
 
 class WorldRenderer final : public Renderer
 {
 public:
 	using Renderer::Renderer;
+	virtual ~WorldRenderer();
 
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
@@ -20,8 +28,44 @@ public:
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 
+	const CullingStats& GetCullingStats() const { return m_frustumCuller.GetStats(); }
+	const RenderQueueStats& GetRenderQueueStats() const { return m_renderQueueStats; }
+
+	// Meshes use their coarsest LODs whose simplification errors are within this count of pixels.
+	void SetMaxLODPixelError(float pixelError) { m_maxLODPixelError = pixelError; }
+	float GetMaxLODPixelError() const { return m_maxLODPixelError; }
+
+private:
+	uint8_t SelectLOD(const StaticMeshComponent& meshComponent, const cd::Matrix4x4* pWorldMatrix, const float* pViewMatrix) const;
+
 private:
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
+
+	Frustum m_frustum;
+	FrustumCuller m_frustumCuller;
+
+	// Pixels of an object space error at view depth 1, which is viewportHeight * 0.5 * projection[5].
+	float m_lodErrorScale = 0.0f;
+	float m_maxLODPixelError = 1.0f;
+
+	// Components of a visible mesh which are looked up once per frame.
+	struct VisibleDraw
+	{
+		const MaterialComponent* pMaterialComponent;
+		const StaticMeshComponent* pMeshComponent;
+		const cd::Matrix4x4* pWorldMatrix;
+		uint16_t materialKey;
+		uint8_t lod;
+	};
+	std::vector<VisibleDraw> m_visibleDraws;
+
+	InstanceBatcher m_instanceBatcher;
+	std::vector<InstanceBatcher::Batch> m_drawBatches;
+
+	RenderQueue m_renderQueue;
+	RenderQueueStats m_renderQueueStats;
+
+	std::unique_ptr<ClusteredLightUniform> m_pClusteredLightUniform;
 };
 
 }
\ No newline at end of file
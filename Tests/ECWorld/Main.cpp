@@ -1,16 +1,33 @@
 #include "Core/StringCrc.h"
+#include "ECWorld/BoundingVolumeHierarchy.hpp"
 #include "ECWorld/CameraComponent.h"
 #include "ECWorld/LightComponent.h"
 #include "ECWorld/MaterialComponent.h"
 #include "ECWorld/HierarchyComponent.h"
+#include "ECWorld/HashMapComponentsStorage.hpp"
 #include "ECWorld/World.h"
+#include "ECWorld/WorldSnapshot.hpp"
 #include "ECWorld/StaticMeshComponent.h"
+#include "ECWorld/TransformBatch.hpp"
 #include "ECWorld/TransformComponent.h"
+#include "ECWorld/TransformHierarchy.hpp"
+#include "Rendering/FrustumCuller.hpp"
 #include "Utilities/PerformanceProfiler.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <numeric>
+#include <omp.h>
 #include <random>
 #include <set>
+#include <span>
+#include <string>
 
 namespace
 {
@@ -44,6 +61,53 @@ void Test_CreateEntity()
 	printf("[Success] Test_CreateEntity\n");
 }
 
+void Test_RecycleEntity()
+{
+	cdtools::PerformanceProfiler perf("Test_RecycleEntity");
+
+	World world;
+	ComponentsStorage<TransformComponent>* pTransform = world.Register<TransformComponent>();
+
+	constexpr int allocateCount = 1000;
+	std::vector<Entity> entities = world.CreateEntities(allocateCount);
+	for (Entity entity : entities)
+	{
+		assert(world.IsValid(entity));
+		pTransform->CreateComponent(entity);
+	}
+	assert(world.GetEntityCount() == allocateCount);
+
+	// Destroy the first half and their components.
+	std::span<const Entity> destroyEntities(entities.data(), allocateCount / 2);
+	world.DestroyEntities(destroyEntities);
+	assert(world.GetEntityCount() == allocateCount / 2);
+	assert(pTransform->GetCount() == allocateCount / 2);
+
+	// Indexes are recycled with a new version so stale handles are detected.
+	std::vector<Entity> recycledEntities = world.CreateEntities(allocateCount / 2);
+	std::set<EntityIndex> destroyedIndexes;
+	for (Entity entity : destroyEntities)
+	{
+		assert(!world.IsValid(entity));
+		destroyedIndexes.insert(GetEntityIndex(entity));
+	}
+	for (Entity entity : recycledEntities)
+	{
+		assert(world.IsValid(entity));
+		assert(destroyedIndexes.contains(GetEntityIndex(entity)));
+		assert(GetEntityVersion(entity) == 1);
+		pTransform->CreateComponent(entity);
+	}
+	for (Entity entity : destroyEntities)
+	{
+		assert(!pTransform->Contains(entity));
+		assert(nullptr == pTransform->GetComponent(entity));
+	}
+	assert(world.GetEntityCount() == allocateCount);
+
+	printf("[Success] Test_RecycleEntity\n");
+}
+
 class Factory
 {
 public:
@@ -67,6 +131,11 @@ Factory Test_RegisterComponentStorages(World& world)
 	factory.pCamera = world.Register<CameraComponent>();
 	factory.pHierarchy = world.Register<HierarchyComponent>();
 
+	// Storages are addressed by type indices which are unique per component type.
+	assert(GetComponentTypeIndex<StaticMeshComponent>() != GetComponentTypeIndex<TransformComponent>());
+	assert(world.IsRegistered<TransformComponent>());
+	assert(world.GetComponents<TransformComponent>() == factory.pTransform);
+
 	printf("\n[Success] Test_RegisterComponentStorages\n");
 
 	return factory;
@@ -82,18 +151,24 @@ std::vector<Entity> Test_CreateEntityComponents(World& world, Factory& factory)
 	constexpr int allocateCount = 100000;
 	Entity meshEntites[allocateCount];
 
-	// TODO : make it thread safe?
-	//#pragma omp parallel for
-	for (int i = 0; i < allocateCount; ++i)
+	// Every thread records to its own command buffer. Then apply them at once.
+#pragma omp parallel
 	{
-		Entity meshEntity = world.CreateEntity();
-		factory.pHierarchy->CreateComponent(meshEntity);
-		factory.pTransform->CreateComponent(meshEntity);
-		factory.pStaticMesh->CreateComponent(meshEntity);
-		factory.pMaterial->CreateComponent(meshEntity);
+		EntityCommandBuffer& commandBuffer = world.GetCommandBuffer(omp_get_thread_num());
+
+#pragma omp for
+		for (int i = 0; i < allocateCount; ++i)
+		{
+			Entity meshEntity = commandBuffer.CreateEntity();
+			commandBuffer.AddComponent<HierarchyComponent>(meshEntity);
+			commandBuffer.AddComponent<TransformComponent>(meshEntity);
+			commandBuffer.AddComponent<StaticMeshComponent>(meshEntity);
+			commandBuffer.AddComponent<MaterialComponent>(meshEntity);
 
-		meshEntites[i] = meshEntity;
+			meshEntites[i] = meshEntity;
+		}
 	}
+	world.Flush();
 
 	assert(factory.pHierarchy->GetCount() == allocateCount + 1);
 	assert(factory.pTransform->GetCount() == allocateCount);
@@ -144,10 +219,16 @@ void Test_RemoveEntityComponentsRandly(Factory& factory, const std::vector<Entit
 	assert(oldStaticMeshCount - removeMeshCount == factory.pStaticMesh->GetCount());
 	assert(oldMaterialCount - removeMeshCount == factory.pMaterial->GetCount());
 
-	assert(oldHierachyCount == factory.pHierarchy->GetCapcity());
-	assert(oldTransformCount == factory.pTransform->GetCapcity());
-	assert(oldStaticMeshCount == factory.pStaticMesh->GetCapcity());
-	assert(oldMaterialCount == factory.pMaterial->GetCapcity());
+	// Removed components are swapped out immediately so storages keep packed.
+	assert(factory.pHierarchy->GetCount() == factory.pHierarchy->GetCapcity());
+	assert(factory.pTransform->GetCount() == factory.pTransform->GetCapcity());
+	assert(factory.pStaticMesh->GetCount() == factory.pStaticMesh->GetCapcity());
+	assert(factory.pMaterial->GetCount() == factory.pMaterial->GetCapcity());
+
+	for (size_t index : randomIndexes)
+	{
+		assert(!factory.pTransform->Contains(meshEntites[index]));
+	}
 
 	printf("\n[Success] Test_RemoveEntityComponentsRandly\n");
 }
@@ -176,10 +257,10 @@ void Test_RemoveEntityComponentsByOrder(Factory& factory, const std::vector<Enti
 	assert(oldStaticMeshCount - removeMeshCount == factory.pStaticMesh->GetCount());
 	assert(oldMaterialCount - removeMeshCount == factory.pMaterial->GetCount());
 
-	assert(oldHierachyCount == factory.pHierarchy->GetCapcity());
-	assert(oldTransformCount == factory.pTransform->GetCapcity());
-	assert(oldStaticMeshCount == factory.pStaticMesh->GetCapcity());
-	assert(oldMaterialCount == factory.pMaterial->GetCapcity());
+	assert(factory.pHierarchy->GetCount() == factory.pHierarchy->GetCapcity());
+	assert(factory.pTransform->GetCount() == factory.pTransform->GetCapcity());
+	assert(factory.pStaticMesh->GetCount() == factory.pStaticMesh->GetCapcity());
+	assert(factory.pMaterial->GetCount() == factory.pMaterial->GetCapcity());
 
 	printf("\n[Success] Test_RemoveEntityComponentsByOrder\n");
 }
@@ -212,11 +293,1115 @@ void Test_CleanUnusedEntityComponents(Factory& factory)
 	printf("\n[Success] Test_CleanUnusedEntityComponents\n");
 }
 
+template<typename Storage>
+void Benchmark_ComponentsStorage(const char* pStorageName, const std::vector<Entity>& entities, const std::vector<size_t>& removeIndexes)
+{
+	printf("\n[Benchmark] %s with %zu entities\n", pStorageName, entities.size());
+
+	Storage storage;
+	{
+		cdtools::PerformanceProfiler perf("Create");
+		for (Entity entity : entities)
+		{
+			storage.CreateComponent(entity);
+		}
+	}
+	assert(storage.GetCount() == entities.size());
+
+	{
+		cdtools::PerformanceProfiler perf("Lookup");
+		size_t foundCount = 0;
+		for (Entity entity : entities)
+		{
+			if (storage.GetComponent(entity))
+			{
+				++foundCount;
+			}
+		}
+		assert(foundCount == entities.size());
+	}
+
+	{
+		cdtools::PerformanceProfiler perf("Remove");
+		for (size_t index : removeIndexes)
+		{
+			storage.RemoveComponent(entities[index]);
+		}
+	}
+	assert(storage.GetCount() == entities.size() - removeIndexes.size());
+
+	{
+		// Spread compaction over many small steps like frames do.
+		cdtools::PerformanceProfiler perf("Compact");
+		size_t stepCount = 0;
+		while (true)
+		{
+			size_t budget = 4096;
+			++stepCount;
+			if (storage.Compact(budget, true))
+			{
+				break;
+			}
+		}
+		printf("\tCompacted in %zu steps\n", stepCount);
+	}
+	assert(storage.GetStats().holeCount == 0);
+
+	{
+		// Iterate after churn. Unused slots need to be skipped by lookup if the storage doesn't keep packed.
+		cdtools::PerformanceProfiler perf("Iterate");
+		size_t visitCount = 0;
+		for (Entity entity : storage.GetEntities())
+		{
+			if (TransformComponent* pTransform = storage.GetComponent(entity))
+			{
+				pTransform->Dirty();
+				++visitCount;
+			}
+		}
+		assert(visitCount == storage.GetCount());
+	}
+}
+
+void Test_ComponentsStorageBenchmark()
+{
+	cdtools::PerformanceProfiler perf("Test_ComponentsStorageBenchmark");
+
+	World world;
+	constexpr size_t entityCount = 1000000;
+	std::vector<Entity> entities;
+	entities.reserve(entityCount);
+	for (size_t i = 0; i < entityCount; ++i)
+	{
+		entities.push_back(world.CreateEntity());
+	}
+
+	// Remove a quarter of entities randomly.
+	std::vector<size_t> removeIndexes(entityCount);
+	std::iota(removeIndexes.begin(), removeIndexes.end(), 0);
+	std::shuffle(removeIndexes.begin(), removeIndexes.end(), std::default_random_engine(0U));
+	removeIndexes.resize(entityCount / 4);
+
+	Benchmark_ComponentsStorage<HashMapComponentsStorage<TransformComponent>>("HashMapComponentsStorage", entities, removeIndexes);
+	Benchmark_ComponentsStorage<ComponentsStorage<TransformComponent>>("ComponentsStorage", entities, removeIndexes);
+
+	printf("\n[Success] Test_ComponentsStorageBenchmark\n");
+}
+
+void Test_Compact()
+{
+	cdtools::PerformanceProfiler perf("Test_Compact");
+
+	World world;
+	Factory factory = Test_RegisterComponentStorages(world);
+
+	// Store the creation order in components to validate them after compaction.
+	constexpr size_t entityCount = 20000;
+	std::vector<Entity> entities = world.CreateEntities(entityCount);
+	for (size_t i = 0; i < entityCount; ++i)
+	{
+		factory.pTransform->CreateComponent(entities[i]).GetTransform().SetTranslation(cd::Vec3f(static_cast<float>(i)));
+	}
+	assert(factory.pTransform->GetStats().isSorted);
+
+	// Destroy a continuous range to leave empty sparse pages and a random half of others to shuffle dense arrays.
+	std::vector<size_t> aliveIndexes(entityCount);
+	std::iota(aliveIndexes.begin(), aliveIndexes.end(), 0);
+	std::shuffle(aliveIndexes.begin(), aliveIndexes.end(), std::default_random_engine(0U));
+	aliveIndexes.resize(entityCount / 2);
+	std::erase_if(aliveIndexes, [](size_t index) { return index < entityCount / 2; });
+	std::set<size_t> aliveIndexSet(aliveIndexes.begin(), aliveIndexes.end());
+	for (size_t i = 0; i < entityCount; ++i)
+	{
+		if (!aliveIndexSet.contains(i))
+		{
+			world.DestroyEntity(entities[i]);
+		}
+	}
+
+	ComponentsStorageStats stats = factory.pTransform->GetStats();
+	assert(stats.count == aliveIndexSet.size());
+	assert(stats.emptySparsePageCount > 0);
+	assert(!stats.isSorted);
+	assert(stats.unsortedCount > 0);
+
+	// Storages which are less shuffled than the ratio are not sorted.
+	world.Compact(256, true, static_cast<float>(stats.unsortedCount + 1) / static_cast<float>(stats.count));
+	assert(!factory.pTransform->GetStats().isSorted);
+	assert(factory.pTransform->GetStats().unsortedCount == stats.unsortedCount);
+
+	// Churn between steps doesn't break the incremental sorting.
+	size_t frameCount = 0;
+	while (!world.Compact(256, true))
+	{
+		if (++frameCount % 8 == 0)
+		{
+			size_t aliveIndex = *aliveIndexSet.begin();
+			aliveIndexSet.erase(aliveIndexSet.begin());
+			world.DestroyEntity(entities[aliveIndex]);
+		}
+	}
+
+	stats = factory.pTransform->GetStats();
+	assert(stats.count == aliveIndexSet.size());
+	assert(stats.emptySparsePageCount == 0);
+	assert(stats.isSorted);
+	assert(stats.unsortedCount == 0);
+
+	const std::vector<Entity>& sortedEntities = factory.pTransform->GetEntities();
+	assert(std::is_sorted(sortedEntities.begin(), sortedEntities.end(), [](Entity lhs, Entity rhs) { return GetEntityIndex(lhs) < GetEntityIndex(rhs); }));
+	for (size_t index : aliveIndexSet)
+	{
+		assert(factory.pTransform->GetComponent(entities[index])->GetTransform().GetTranslation().x() == static_cast<float>(index));
+	}
+
+	// HashMapComponentsStorage compacts holes step by step too.
+	HashMapComponentsStorage<TransformComponent> hashMapStorage;
+	for (size_t i = 0; i < entityCount; ++i)
+	{
+		hashMapStorage.CreateComponent(entities[i]).GetTransform().SetTranslation(cd::Vec3f(static_cast<float>(i)));
+	}
+	for (size_t i = 0; i < entityCount; i += 3)
+	{
+		hashMapStorage.RemoveComponent(entities[i]);
+	}
+
+	size_t budget = 0;
+	while (!hashMapStorage.Compact(budget, false))
+	{
+		budget = 100;
+	}
+	assert(hashMapStorage.GetStats().holeCount == 0);
+	assert(hashMapStorage.GetEntities().size() == hashMapStorage.GetCount());
+	for (size_t i = 0; i < entityCount; ++i)
+	{
+		TransformComponent* pTransform = hashMapStorage.GetComponent(entities[i]);
+		assert((i % 3 == 0) == (pTransform == nullptr));
+		assert(!pTransform || pTransform->GetTransform().GetTranslation().x() == static_cast<float>(i));
+	}
+
+	printf("\n[Success] Test_Compact\n");
+}
+
+void Test_WorldSnapshot()
+{
+	cdtools::PerformanceProfiler perf("Test_WorldSnapshot");
+
+	constexpr size_t entityCount = 50000;
+	const std::string snapshotFilePath = (std::filesystem::temp_directory_path() / "Test_WorldSnapshot.cdws").string();
+
+	World world;
+	Factory factory = Test_RegisterComponentStorages(world);
+	std::vector<Entity> entities = world.CreateEntities(entityCount);
+	for (size_t i = 0; i < entityCount; ++i)
+	{
+		factory.pTransform->CreateComponent(entities[i]).GetTransform().SetTranslation(cd::Vec3f(static_cast<float>(i)));
+		factory.pHierarchy->CreateComponent(entities[i]).SetParentEntity(entities[i / 2]);
+		if (i % 10 == 0)
+		{
+			factory.pLight->CreateComponent(entities[i]).SetIntensity(static_cast<float>(i));
+		}
+	}
+
+	// Destroyed handles should be still stale after loading.
+	for (size_t i = 0; i < entityCount; i += 7)
+	{
+		world.DestroyEntity(entities[i]);
+	}
+
+	{
+		cdtools::PerformanceProfiler savePerf("Save");
+		// Meshes and materials are not trivially copyable, so Save fails unless skipped storages are reported.
+		assert(!WorldSnapshot::Save(world, snapshotFilePath.c_str()));
+		std::vector<uint32_t> skippedComponentNames;
+		[[maybe_unused]] bool saved = WorldSnapshot::Save(world, snapshotFilePath.c_str(), &skippedComponentNames);
+		assert(saved);
+		assert((skippedComponentNames == std::vector<uint32_t>{ StaticMeshComponent::GetClassName().Value(), MaterialComponent::GetClassName().Value() }));
+	}
+
+	World loadedWorld;
+	Factory loadedFactory = Test_RegisterComponentStorages(loadedWorld);
+	{
+		cdtools::PerformanceProfiler loadPerf("Load");
+		assert(!WorldSnapshot::Load(loadedWorld, snapshotFilePath.c_str()));
+		assert(loadedWorld.GetEntityCount() == 0);
+		std::vector<uint32_t> skippedComponentNames;
+		[[maybe_unused]] bool loaded = WorldSnapshot::Load(loadedWorld, snapshotFilePath.c_str(), &skippedComponentNames);
+		assert(loaded);
+		assert(skippedComponentNames.size() == 2);
+	}
+
+	assert(loadedWorld.GetEntityCount() == world.GetEntityCount());
+	assert(loadedFactory.pTransform->GetCount() == factory.pTransform->GetCount());
+	assert(loadedFactory.pHierarchy->GetCount() == factory.pHierarchy->GetCount());
+	assert(loadedFactory.pLight->GetCount() == factory.pLight->GetCount());
+	for (size_t i = 0; i < entityCount; ++i)
+	{
+		Entity entity = entities[i];
+		assert(loadedWorld.IsValid(entity) == world.IsValid(entity));
+		if (!world.IsValid(entity))
+		{
+			continue;
+		}
+
+		assert(loadedFactory.pTransform->GetComponent(entity)->GetTransform().GetTranslation().x() == static_cast<float>(i));
+		assert(loadedFactory.pHierarchy->GetComponent(entity)->GetParentEntity() == entities[i / 2]);
+		assert(loadedFactory.pLight->Contains(entity) == (i % 10 == 0));
+	}
+
+	// Loaded components are changed in the current tick and cached views see them.
+	assert(loadedFactory.pTransform->HasChangedSince(loadedWorld.GetChangeTick()));
+	assert((loadedWorld.View<TransformComponent, LightComponent>().GetCount() == world.View<TransformComponent, LightComponent>().GetCount()));
+
+	// Allocators continue from the same state.
+	assert(loadedWorld.CreateEntity() == world.CreateEntity());
+
+	// Reject snapshots of other versions or to a World which is not empty.
+	MappedFile mappedFile(snapshotFilePath.c_str());
+	assert(mappedFile.IsOpen());
+	std::vector<std::byte> bytes(mappedFile.GetBytes().begin(), mappedFile.GetBytes().end());
+	std::vector<uint32_t> skippedComponentNames;
+	assert(!WorldSnapshot::Load(loadedWorld, bytes, &skippedComponentNames));
+
+	// Reject corrupted snapshots without changing the World.
+	WorldSnapshot::Header header;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	WorldSnapshot::StorageHeader storageHeader;
+	std::memcpy(&storageHeader, bytes.data() + sizeof(header), sizeof(storageHeader));
+	assert(header.freeIndexCount >= 2 && storageHeader.count >= 2);
+	auto loadCorrupted = [&bytes](size_t offset, const auto& value)
+	{
+		std::vector<std::byte> corruptedBytes = bytes;
+		std::memcpy(corruptedBytes.data() + offset, &value, sizeof(value));
+		World otherWorld;
+		Test_RegisterComponentStorages(otherWorld);
+		std::vector<uint32_t> skippedComponentNames;
+		bool loaded = WorldSnapshot::Load(otherWorld, corruptedBytes, &skippedComponentNames);
+		assert(otherWorld.GetEntityCount() == 0);
+		return loaded;
+	};
+
+	// Other versions.
+	assert(!loadCorrupted(offsetof(WorldSnapshot::Header, version), WorldSnapshot::Version + 1));
+
+	// A storage lists the same entity twice.
+	Entity firstStorageEntity;
+	std::memcpy(&firstStorageEntity, bytes.data() + storageHeader.entitiesOffset, sizeof(Entity));
+	assert(!loadCorrupted(storageHeader.entitiesOffset + sizeof(Entity), firstStorageEntity));
+
+	// Free indexes which are out of range, duplicated or alive.
+	EntityIndex firstFreeIndex;
+	std::memcpy(&firstFreeIndex, bytes.data() + header.freeIndexesOffset, sizeof(EntityIndex));
+	assert(!loadCorrupted(header.freeIndexesOffset, header.entityVersionCount));
+	assert(!loadCorrupted(header.freeIndexesOffset + sizeof(EntityIndex), firstFreeIndex));
+	assert(!loadCorrupted(header.freeIndexesOffset, GetEntityIndex(firstStorageEntity)));
+
+	mappedFile.Close();
+	std::filesystem::remove(snapshotFilePath);
+
+	printf("\n[Success] Test_WorldSnapshot\n");
+}
+
+void Test_View()
+{
+	cdtools::PerformanceProfiler perf("Test_View");
+
+	World world;
+	Factory factory = Test_RegisterComponentStorages(world);
+
+	// Every entity has a transform. Half of them have a mesh and a quarter of them have a light.
+	constexpr int allocateCount = 1000;
+	std::vector<Entity> entities;
+	for (int i = 0; i < allocateCount; ++i)
+	{
+		Entity entity = world.CreateEntity();
+		factory.pTransform->CreateComponent(entity);
+		if (i % 2 == 0)
+		{
+			factory.pStaticMesh->CreateComponent(entity);
+		}
+		if (i % 4 == 0)
+		{
+			factory.pLight->CreateComponent(entity);
+		}
+		entities.push_back(entity);
+	}
+
+	auto meshView = world.View<TransformComponent, StaticMeshComponent>();
+	auto meshWithoutLightView = world.View<TransformComponent, StaticMeshComponent>(Without<LightComponent>());
+	assert(meshView.GetCount() == allocateCount / 2);
+	assert(meshWithoutLightView.GetCount() == allocateCount / 4);
+
+	size_t visitCount = 0;
+	for (auto [entity, transformComponent, meshComponent] : meshWithoutLightView)
+	{
+		assert(factory.pTransform->GetComponent(entity) == &transformComponent);
+		assert(factory.pStaticMesh->GetComponent(entity) == &meshComponent);
+		assert(!factory.pLight->Contains(entity));
+		++visitCount;
+	}
+	assert(visitCount == meshWithoutLightView.GetCount());
+
+	// Views are cached in the world and updated incrementally.
+	factory.pLight->RemoveComponent(entities[0]);
+	assert(meshWithoutLightView.GetCount() == allocateCount / 4 + 1);
+	factory.pStaticMesh->RemoveComponent(entities[0]);
+	assert(meshView.GetCount() == allocateCount / 2 - 1);
+	assert(meshWithoutLightView.GetCount() == allocateCount / 4);
+	factory.pStaticMesh->CreateComponent(entities[1]);
+	assert(meshView.GetCount() == allocateCount / 2);
+	assert((world.View<TransformComponent, StaticMeshComponent>(Without<LightComponent>()).GetCount() == allocateCount / 4 + 1));
+
+	visitCount = 0;
+	meshView.Each([&visitCount](Entity, TransformComponent&, StaticMeshComponent&) { ++visitCount; });
+	assert(visitCount == meshView.GetCount());
+
+	printf("\n[Success] Test_View\n");
+}
+
+void Test_ArchetypeStorage()
+{
+	cdtools::PerformanceProfiler perf("Test_ArchetypeStorage");
+
+	World world;
+	ArchetypeStorage& archetypes = world.GetArchetypeStorage();
+
+	constexpr int allocateCount = 10000;
+	std::vector<Entity> entities = world.CreateEntities(allocateCount);
+	for (Entity entity : entities)
+	{
+		archetypes.AddEntity<TransformComponent, StaticMeshComponent, MaterialComponent>(entity);
+	}
+	assert(archetypes.GetArchetypeCount() == 1);
+	assert(archetypes.GetEntityCount() == allocateCount);
+
+	// Chunks hand out aligned columns in the same order as entities.
+	size_t visitCount = 0;
+	archetypes.ForEachChunk<TransformComponent, MaterialComponent>([&](std::span<const Entity> chunkEntities,
+		std::span<TransformComponent> transforms, std::span<MaterialComponent> materials)
+	{
+		assert(transforms.size() == chunkEntities.size() && materials.size() == chunkEntities.size());
+		assert(reinterpret_cast<uintptr_t>(transforms.data()) % ArchetypeChunk::ColumnAlignment == 0);
+		for (size_t rowIndex = 0; rowIndex < chunkEntities.size(); ++rowIndex)
+		{
+			assert(archetypes.GetComponent<TransformComponent>(chunkEntities[rowIndex]) == &transforms[rowIndex]);
+		}
+		visitCount += chunkEntities.size();
+	});
+	assert(visitCount == allocateCount);
+
+	// Adding a component moves the entity to another archetype and keeps its components.
+	for (int i = 0; i < allocateCount; i += 2)
+	{
+		archetypes.GetComponent<TransformComponent>(entities[i])->GetTransform().SetTranslation(cd::Vec3f(static_cast<float>(i)));
+		archetypes.AddComponent<LightComponent>(entities[i]);
+	}
+	assert(archetypes.GetArchetypeCount() == 2);
+	for (int i = 0; i < allocateCount; ++i)
+	{
+		assert(archetypes.HasComponent<LightComponent>(entities[i]) == (i % 2 == 0));
+		if (i % 2 == 0)
+		{
+			assert(archetypes.GetComponent<TransformComponent>(entities[i])->GetTransform().GetTranslation().x() == static_cast<float>(i));
+		}
+	}
+
+	visitCount = 0;
+	archetypes.Each<TransformComponent, LightComponent>([&visitCount](Entity, TransformComponent&, LightComponent&) { ++visitCount; });
+	assert(visitCount == allocateCount / 2);
+
+	// Removing a component moves the entity back.
+	archetypes.RemoveComponent<LightComponent>(entities[0]);
+	assert(!archetypes.HasComponent<LightComponent>(entities[0]));
+	assert(archetypes.GetComponent<TransformComponent>(entities[0])->GetTransform().GetTranslation().x() == 0.0f);
+
+	// Destroying entities removes them from the archetype storage too.
+	world.DestroyEntities(entities);
+	assert(archetypes.GetEntityCount() == 0);
+	for (Entity entity : entities)
+	{
+		assert(!archetypes.Contains(entity));
+	}
+
+	printf("\n[Success] Test_ArchetypeStorage\n");
+}
+
+void Benchmark_ArchetypeStorage()
+{
+	cdtools::PerformanceProfiler perf("Benchmark_ArchetypeStorage");
+
+	constexpr size_t entityCount = 100000;
+	constexpr int iterateTimes = 10;
+
+	// Compare the Transform + StaticMesh + Material triplet which most scene entities have.
+	World world;
+	Factory factory = Test_RegisterComponentStorages(world);
+	std::vector<Entity> entities = world.CreateEntities(entityCount);
+	std::vector<Entity> archetypeEntities = world.CreateEntities(entityCount);
+
+	printf("\n[Benchmark] ComponentsStorage vs ArchetypeStorage with %zu entities\n", entityCount);
+	{
+		cdtools::PerformanceProfiler createPerf("ComponentsStorage Create");
+		for (Entity entity : entities)
+		{
+			factory.pTransform->CreateComponent(entity);
+			factory.pStaticMesh->CreateComponent(entity);
+			factory.pMaterial->CreateComponent(entity);
+		}
+	}
+
+	ArchetypeStorage& archetypes = world.GetArchetypeStorage();
+	{
+		cdtools::PerformanceProfiler createPerf("ArchetypeStorage Create");
+		for (Entity entity : archetypeEntities)
+		{
+			archetypes.AddEntity<TransformComponent, StaticMeshComponent, MaterialComponent>(entity);
+		}
+	}
+
+	size_t viewResult = 0;
+	{
+		cdtools::PerformanceProfiler iteratePerf("ComponentsStorage View Iterate");
+		auto meshView = world.View<TransformComponent, StaticMeshComponent, MaterialComponent>();
+		for (int times = 0; times < iterateTimes; ++times)
+		{
+			for (auto [entity, transformComponent, meshComponent, materialComponent] : meshView)
+			{
+				transformComponent.Dirty();
+				viewResult += meshComponent.GetVertexBuffer() + (materialComponent.GetMaterialType() ? 1 : 0);
+			}
+		}
+	}
+
+	size_t chunkResult = 0;
+	{
+		cdtools::PerformanceProfiler iteratePerf("ArchetypeStorage Chunk Iterate");
+		for (int times = 0; times < iterateTimes; ++times)
+		{
+			archetypes.ForEachChunk<TransformComponent, StaticMeshComponent, MaterialComponent>([&chunkResult](std::span<const Entity>,
+				std::span<TransformComponent> transforms, std::span<StaticMeshComponent> meshes, std::span<MaterialComponent> materials)
+			{
+				for (size_t rowIndex = 0; rowIndex < transforms.size(); ++rowIndex)
+				{
+					transforms[rowIndex].Dirty();
+					chunkResult += meshes[rowIndex].GetVertexBuffer() + (materials[rowIndex].GetMaterialType() ? 1 : 0);
+				}
+			});
+		}
+	}
+	assert(viewResult == chunkResult);
+
+	{
+		cdtools::PerformanceProfiler movePerf("ArchetypeStorage Add Component");
+		for (Entity entity : archetypeEntities)
+		{
+			archetypes.AddComponent<LightComponent>(entity);
+		}
+	}
+	{
+		cdtools::PerformanceProfiler movePerf("ArchetypeStorage Remove Component");
+		for (Entity entity : archetypeEntities)
+		{
+			archetypes.RemoveComponent<LightComponent>(entity);
+		}
+	}
+	assert(archetypes.GetEntityCount() == entityCount);
+
+	printf("\n[Success] Benchmark_ArchetypeStorage\n");
+}
+
+void Test_SystemScheduler()
+{
+	cdtools::PerformanceProfiler perf("Test_SystemScheduler");
+
+	World world;
+	Test_RegisterComponentStorages(world);
+
+	// Record the last frame which every system finished in.
+	constexpr int frameCount = 1000;
+	std::atomic<int> writeTransformFrame = -1;
+	std::atomic<int> readTransformFrame = -1;
+	std::atomic<int> writeLightFrame = -1;
+	std::atomic<int> rewriteTransformFrame = -1;
+	int currentFrame = 0;
+
+	world.AddSystem("WriteTransform", Reads<>(), Writes<TransformComponent>(), [&](World&, float)
+	{
+		assert(rewriteTransformFrame == currentFrame - 1);
+		writeTransformFrame = currentFrame;
+	});
+	world.AddSystem("ReadTransform", Reads<TransformComponent>(), Writes<CameraComponent>(), [&](World&, float)
+	{
+		assert(writeTransformFrame == currentFrame);
+		readTransformFrame = currentFrame;
+	});
+	world.AddSystem("WriteLight", Reads<>(), Writes<LightComponent>(), [&](World&, float)
+	{
+		writeLightFrame = currentFrame;
+	});
+	world.AddSystem("RewriteTransform", Reads<CameraComponent>(), Writes<TransformComponent>(), [&](World&, float)
+	{
+		assert(writeTransformFrame == currentFrame && readTransformFrame == currentFrame);
+		rewriteTransformFrame = currentFrame;
+	});
+
+	// Conflicting systems keep the registration order on both serial and parallel paths.
+	ThreadPool threadPool(4);
+	for (; currentFrame < frameCount; ++currentFrame)
+	{
+		world.UpdateSystems(1.0f / 60.0f, currentFrame % 2 == 0 ? &threadPool : nullptr);
+		assert(writeTransformFrame == currentFrame && readTransformFrame == currentFrame);
+		assert(writeLightFrame == currentFrame && rewriteTransformFrame == currentFrame);
+	}
+
+	// Disabled systems are skipped.
+	world.SetSystemEnabled("WriteLight", false);
+	world.UpdateSystems(1.0f / 60.0f, &threadPool);
+	assert(writeLightFrame == frameCount - 1 && rewriteTransformFrame == frameCount);
+
+	printf("\n[Success] Test_SystemScheduler\n");
+}
+
+void Test_CommandBuffer()
+{
+	cdtools::PerformanceProfiler perf("Test_CommandBuffer");
+
+	World world;
+	Factory factory = Test_RegisterComponentStorages(world);
+
+	// Nothing changes until the world is flushed.
+	EntityCommandBuffer& firstBuffer = world.GetCommandBuffer(0);
+	EntityCommandBuffer& secondBuffer = world.GetCommandBuffer(1);
+	Entity entity = firstBuffer.CreateEntity();
+	assert(world.IsValid(entity));
+	firstBuffer.AddComponent<TransformComponent>(entity).GetTransform().SetTranslation(cd::Vec3f(1.0f));
+	firstBuffer.AddComponent<LightComponent>(entity);
+	assert(!factory.pTransform->Contains(entity));
+
+	// Buffers are applied in slot order so the later slot wins.
+	secondBuffer.AddComponent<TransformComponent>(entity).GetTransform().SetTranslation(cd::Vec3f(2.0f));
+	secondBuffer.RemoveComponent<LightComponent>(entity);
+	world.Flush();
+	assert(firstBuffer.IsEmpty() && secondBuffer.IsEmpty());
+	assert(factory.pTransform->GetComponent(entity)->GetTransform().GetTranslation().x() == 2.0f);
+	assert(!factory.pLight->Contains(entity));
+
+	// Commands for destroyed entities are skipped.
+	firstBuffer.DestroyEntity(entity);
+	secondBuffer.AddComponent<CameraComponent>(entity);
+	world.Flush();
+	assert(!world.IsValid(entity));
+	assert(!factory.pTransform->Contains(entity));
+	assert(factory.pCamera->GetCount() == 0);
+
+	printf("\n[Success] Test_CommandBuffer\n");
+}
+
+void Test_ChangeTick()
+{
+	cdtools::PerformanceProfiler perf("Test_ChangeTick");
+
+	World world;
+	Factory factory = Test_RegisterComponentStorages(world);
+
+	// Created components are stamped with the current tick.
+	std::vector<Entity> entities = world.CreateEntities(8);
+	for (Entity entity : entities)
+	{
+		factory.pTransform->CreateComponent(entity);
+	}
+	factory.pLight->CreateComponent(entities[0]);
+	ChangeTick createTick = world.GetChangeTick();
+	assert(factory.pTransform->GetChangeTick(entities[0]) == createTick);
+	assert(factory.pCamera->GetChangeTick(entities[0]) == 0);
+
+	// Nothing changed in the new frame.
+	ChangeTick frameTick = world.IncrementChangeTick();
+	assert(!factory.pTransform->HasChangedSince(frameTick));
+	assert(!factory.pLight->HasChangedSince(frameTick));
+
+	factory.pTransform->MarkChanged(entities[2]);
+	factory.pTransform->ModifyComponent(entities[5])->Dirty();
+	assert(factory.pTransform->HasChangedSince(frameTick));
+	assert(!factory.pLight->HasChangedSince(frameTick));
+
+	std::vector<Entity> changedEntities;
+	factory.pTransform->GetChangedEntities(frameTick, changedEntities);
+	std::sort(changedEntities.begin(), changedEntities.end());
+	assert((changedEntities == std::vector<Entity>{ entities[2], entities[5] }));
+
+	size_t changedCount = 0;
+	factory.pTransform->ForEachChanged(createTick, [&changedCount](Entity, TransformComponent&) { ++changedCount; });
+	assert(changedCount == entities.size());
+
+	// Removal is a change of the storage but leaves no entity to visit.
+	frameTick = world.IncrementChangeTick();
+	factory.pLight->RemoveComponent(entities[0]);
+	assert(factory.pLight->HasChangedSince(frameTick));
+	changedEntities.clear();
+	factory.pLight->GetChangedEntities(frameTick, changedEntities);
+	assert(changedEntities.empty());
+
+	// Swap-pop keeps ticks attached to their entities.
+	factory.pTransform->RemoveComponent(entities[2]);
+	assert(factory.pTransform->GetChangeTick(entities[5]) == frameTick - 1);
+	assert(factory.pTransform->GetChangeTick(entities[7]) == createTick);
+
+	printf("\n[Success] Test_ChangeTick\n");
+}
+
+// Composes offsets instead of matrices so that results are easy to check.
+class OffsetTransformComponent final
+{
+public:
+	static constexpr StringCrc GetClassName()
+	{
+		constexpr StringCrc className("OffsetTransformComponent");
+		return className;
+	}
+
+public:
+	int GetWorldMatrix() const { return m_worldOffset; }
+	void SetLocalOffset(int offset) { m_localOffset = offset; m_isDirty = true; }
+	void Dirty() const { m_isDirty = true; }
+
+	void Build()
+	{
+		if (m_isDirty)
+		{
+			m_worldOffset = m_localOffset;
+			m_isDirty = false;
+		}
+		++m_buildCount;
+	}
+
+	void Build(int parentWorldOffset)
+	{
+		m_worldOffset = parentWorldOffset + m_localOffset;
+		m_isDirty = false;
+		++m_buildCount;
+	}
+
+	int GetBuildCount() const { return m_buildCount; }
+
+private:
+	int m_localOffset = 0;
+	int m_worldOffset = 0;
+	int m_buildCount = 0;
+	mutable bool m_isDirty = true;
+};
+
+void Test_TransformHierarchy()
+{
+	cdtools::PerformanceProfiler perf("Test_TransformHierarchy");
+
+	World world;
+	ComponentsStorage<OffsetTransformComponent>* pTransform = world.Register<OffsetTransformComponent>();
+	ComponentsStorage<HierarchyComponent>* pHierarchy = world.Register<HierarchyComponent>();
+
+	auto createNode = [&](int localOffset, Entity parentEntity)
+	{
+		Entity entity = world.CreateEntity();
+		pTransform->CreateComponent(entity).SetLocalOffset(localOffset);
+		if (INVALID_ENTITY != parentEntity)
+		{
+			pHierarchy->CreateComponent(entity).SetParentEntity(parentEntity);
+		}
+		return entity;
+	};
+
+	// Children are created before their parents so that the dense order differs from the hierarchy order.
+	Entity firstRoot = world.CreateEntity();
+	Entity child = createNode(10, firstRoot);
+	Entity grandChild = createNode(100, child);
+	pTransform->CreateComponent(firstRoot).SetLocalOffset(1);
+	Entity secondRoot = createNode(2, INVALID_ENTITY);
+
+	// A level wide enough to be split into tasks.
+	constexpr int wideLevelCount = 5000;
+	std::vector<Entity> wideEntities;
+	for (int wideIndex = 0; wideIndex < wideLevelCount; ++wideIndex)
+	{
+		wideEntities.push_back(createNode(wideIndex, secondRoot));
+	}
+
+	ThreadPool threadPool(4);
+	TransformHierarchy<OffsetTransformComponent> hierarchy;
+	hierarchy.Update(*pTransform, *pHierarchy, &threadPool);
+	assert(hierarchy.GetNodeCount() == pTransform->GetCount());
+	assert(hierarchy.GetLevelCount() == 3);
+	assert(hierarchy.GetUpdatedNodeCount() == pTransform->GetCount());
+	assert(pTransform->GetComponent(grandChild)->GetWorldMatrix() == 111);
+	for (int wideIndex = 0; wideIndex < wideLevelCount; ++wideIndex)
+	{
+		assert(pTransform->GetComponent(wideEntities[wideIndex])->GetWorldMatrix() == 2 + wideIndex);
+	}
+
+	// Parents always come before children and levels are contiguous.
+	for (TransformHierarchy<OffsetTransformComponent>::NodeIndex nodeIndex = 0; nodeIndex < hierarchy.GetNodeCount(); ++nodeIndex)
+	{
+		auto parentNodeIndex = hierarchy.GetParentNodeIndex(nodeIndex);
+		assert(TransformHierarchy<OffsetTransformComponent>::INVALID_NODE_INDEX == parentNodeIndex || parentNodeIndex < nodeIndex);
+	}
+	assert(hierarchy.GetNodeEntity(hierarchy.GetNodeIndex(grandChild)) == grandChild);
+
+	// Nothing changed in the new frame.
+	world.IncrementChangeTick();
+	hierarchy.Update(*pTransform, *pHierarchy, &threadPool);
+	world.IncrementChangeTick();
+	hierarchy.Update(*pTransform, *pHierarchy, &threadPool);
+	assert(0 == hierarchy.GetUpdatedNodeCount());
+
+	// Only the changed subtree is rebuilt.
+	world.IncrementChangeTick();
+	int secondRootBuildCount = pTransform->GetComponent(secondRoot)->GetBuildCount();
+	pTransform->ModifyComponent(child)->SetLocalOffset(50);
+	hierarchy.Update(*pTransform, *pHierarchy, &threadPool);
+	assert(2 == hierarchy.GetUpdatedNodeCount());
+	assert(pTransform->GetComponent(grandChild)->GetWorldMatrix() == 151);
+	assert(pTransform->GetComponent(secondRoot)->GetBuildCount() == secondRootBuildCount);
+
+	// A changed parent and its changed child are built once.
+	world.IncrementChangeTick();
+	hierarchy.Update(*pTransform, *pHierarchy);
+	world.IncrementChangeTick();
+	pTransform->ModifyComponent(child)->SetLocalOffset(20);
+	pTransform->ModifyComponent(grandChild)->SetLocalOffset(200);
+	hierarchy.Update(*pTransform, *pHierarchy);
+	assert(2 == hierarchy.GetUpdatedNodeCount());
+	assert(pTransform->GetComponent(grandChild)->GetWorldMatrix() == 221);
+
+	// Reparenting rebuilds the order.
+	world.IncrementChangeTick();
+	pHierarchy->ModifyComponent(grandChild)->SetParentEntity(secondRoot);
+	hierarchy.Update(*pTransform, *pHierarchy, &threadPool);
+	assert(hierarchy.GetLevelCount() == 2);
+	assert(pTransform->GetComponent(grandChild)->GetWorldMatrix() == 202);
+
+	// Children of a removed parent become roots.
+	world.IncrementChangeTick();
+	pTransform->RemoveComponent(secondRoot);
+	hierarchy.Update(*pTransform, *pHierarchy, &threadPool);
+	assert(hierarchy.GetNodeCount() == pTransform->GetCount());
+	assert(TransformHierarchy<OffsetTransformComponent>::INVALID_NODE_INDEX == hierarchy.GetNodeIndex(secondRoot));
+	assert(pTransform->GetComponent(grandChild)->GetWorldMatrix() == 200);
+	assert(pTransform->GetComponent(wideEntities.back())->GetWorldMatrix() == wideLevelCount - 1);
+
+	printf("\n[Success] Test_TransformHierarchy\n");
+}
+
+void Benchmark_TransformBatch()
+{
+	cdtools::PerformanceProfiler perf("Benchmark_TransformBatch");
+
+	constexpr size_t transformCounts[] = { 10000, 100000, 1000000 };
+	constexpr SIMDLevel simdLevels[] = { SIMDLevel::Scalar, SIMDLevel::SSE2, SIMDLevel::AVX2 };
+
+	std::mt19937 randomEngine(42);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	printf("\n[Benchmark] TransformBatch on %s\n", GetSIMDLevelName(GetSIMDLevel()));
+
+	for (size_t transformCount : transformCounts)
+	{
+		std::vector<cd::Transform> transforms(transformCount);
+		TransformBatch batch;
+		batch.Reserve(transformCount);
+		for (cd::Transform& transform : transforms)
+		{
+			cd::Vec3f axis(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine) + 2.0f);
+			cd::Quaternion rotation = cd::Quaternion::FromAxisAngle(axis.Normalize(), distribution(randomEngine) * 3.14f);
+			transform = cd::Transform(cd::Vec3f(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine)),
+				rotation, cd::Vec3f(distribution(randomEngine) + 2.0f, distribution(randomEngine) + 2.0f, distribution(randomEngine) + 2.0f));
+			batch.Add(transform);
+		}
+		assert(batch.GetCount() == transformCount);
+
+		std::vector<cd::Matrix4x4> expectedMatrices(transformCount);
+		{
+			std::string perfName = "Per-entity GetMatrix " + std::to_string(transformCount);
+			cdtools::PerformanceProfiler entityPerf(perfName.c_str());
+			for (size_t transformIndex = 0; transformIndex < transformCount; ++transformIndex)
+			{
+				expectedMatrices[transformIndex] = transforms[transformIndex].GetMatrix();
+			}
+		}
+
+		// Kernels which the CPU doesn't support are skipped. All of them match the per-entity path.
+		std::vector<cd::Matrix4x4> batchMatrices(transformCount);
+		for (SIMDLevel simdLevel : simdLevels)
+		{
+			if (simdLevel > GetSIMDLevel())
+			{
+				continue;
+			}
+
+			{
+				std::string perfName = std::string("Batch ") + GetSIMDLevelName(simdLevel) + " " + std::to_string(transformCount);
+				cdtools::PerformanceProfiler batchPerf(perfName.c_str());
+				batch.Build(batchMatrices.data(), simdLevel);
+			}
+
+			for (size_t transformIndex = 0; transformIndex < transformCount; ++transformIndex)
+			{
+				const float* pExpected = expectedMatrices[transformIndex].Begin();
+				const float* pActual = batchMatrices[transformIndex].Begin();
+				for (int elementIndex = 0; elementIndex < 16; ++elementIndex)
+				{
+					assert(std::abs(pExpected[elementIndex] - pActual[elementIndex]) < 1e-4f);
+				}
+			}
+		}
+	}
+
+	printf("\n[Success] Benchmark_TransformBatch\n");
+}
+
+void Test_ComponentSignature()
+{
+	cdtools::PerformanceProfiler perf("Test_ComponentSignature");
+
+	World world;
+	Factory factory = Test_RegisterComponentStorages(world);
+
+	std::vector<Entity> entities = world.CreateEntities(4);
+	factory.pTransform->CreateComponent(entities[0]);
+	factory.pStaticMesh->CreateComponent(entities[0]);
+	factory.pTransform->CreateComponent(entities[1]);
+	factory.pLight->CreateComponent(entities[1]);
+	world.CreateComponent<CameraComponent>(entities[2]);
+
+	assert(world.GetSignature(entities[0]) == (GetComponentSignature<TransformComponent, StaticMeshComponent>()));
+	assert((world.Has<TransformComponent, StaticMeshComponent>(entities[0])));
+	assert((!world.Has<TransformComponent, LightComponent>(entities[0])));
+	assert((world.HasAny<LightComponent, CameraComponent>(entities[2])));
+	assert((!world.HasAny<LightComponent, CameraComponent>(entities[0])));
+	assert(0 == world.GetSignature(entities[3]));
+
+	// Signatures are updated before views are notified.
+	auto lightView = world.View<TransformComponent>(Without<LightComponent>());
+	assert(lightView.GetCount() == 1);
+	factory.pLight->RemoveComponent(entities[1]);
+	assert(!world.Has<LightComponent>(entities[1]));
+	assert(lightView.GetCount() == 2);
+
+	// Destroying touches only storages in the signature. Recycled indexes start empty.
+	world.DestroyEntity(entities[0]);
+	assert(!world.Has<TransformComponent>(entities[0]));
+	assert(!factory.pTransform->Contains(entities[0]) && !factory.pStaticMesh->Contains(entities[0]));
+	assert(factory.pTransform->GetCount() == 1);
+	assert(lightView.GetCount() == 1);
+	Entity recycledEntity = world.CreateEntity();
+	assert(GetEntityIndex(recycledEntity) == GetEntityIndex(entities[0]));
+	assert(0 == world.GetSignature(recycledEntity));
+
+	// Bulk delete of entities which have a few of the registered components.
+	constexpr size_t bulkCount = 100000;
+	std::vector<Entity> bulkEntities = world.CreateEntities(bulkCount);
+	for (Entity entity : bulkEntities)
+	{
+		factory.pTransform->CreateComponent(entity);
+		factory.pStaticMesh->CreateComponent(entity);
+	}
+	{
+		cdtools::PerformanceProfiler destroyPerf("DestroyEntities");
+		world.DestroyEntities(bulkEntities);
+	}
+	assert(factory.pTransform->GetCount() == 1 && factory.pStaticMesh->GetCount() == 0);
+
+	printf("\n[Success] Test_ComponentSignature\n");
+}
+
+void Test_BoundingVolumeHierarchy()
+{
+	cdtools::PerformanceProfiler perf("Test_BoundingVolumeHierarchy");
+
+	constexpr uint32_t entityCount = 20000;
+	std::mt19937 randomEngine(11);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	auto randomAABB = [&]()
+	{
+		cd::Vec3f center(distribution(randomEngine) * 500.0f, distribution(randomEngine) * 500.0f, distribution(randomEngine) * 500.0f);
+		cd::Vec3f extents(distribution(randomEngine) + 1.5f, distribution(randomEngine) + 1.5f, distribution(randomEngine) + 1.5f);
+		return cd::AABB(center + extents * -1.0f, center + extents);
+	};
+
+	BoundingVolumeHierarchy bvh;
+	std::vector<cd::AABB> worldAABBs(entityCount);
+	std::vector<bool> isAlive(entityCount, true);
+	for (Entity entity = 0; entity < entityCount; ++entity)
+	{
+		worldAABBs[entity] = randomAABB();
+		bvh.Update(entity, worldAABBs[entity]);
+	}
+	assert(bvh.GetLeafCount() == entityCount);
+
+	auto overlaps = [](const cd::AABB& lhs, const cd::AABB& rhs)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (lhs.Min()[axis] > rhs.Max()[axis] || lhs.Max()[axis] < rhs.Min()[axis])
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	auto rayTime = [](const cd::AABB& aabb, const cd::Ray& ray, float& hitTime)
+	{
+		float enterTime = 0.0f;
+		float exitTime = FLT_MAX;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float time0 = (aabb.Min()[axis] - ray.Origin()[axis]) / ray.Direction()[axis];
+			float time1 = (aabb.Max()[axis] - ray.Origin()[axis]) / ray.Direction()[axis];
+			enterTime = std::max(enterTime, std::min(time0, time1));
+			exitTime = std::min(exitTime, std::max(time0, time1));
+		}
+		hitTime = enterTime;
+		return enterTime <= exitTime;
+	};
+
+	float viewMatrix[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	float projectionMatrix[16] = {};
+	projectionMatrix[0] = 1.0f;
+	projectionMatrix[5] = 1.0f;
+	projectionMatrix[10] = 1.0f;
+	projectionMatrix[11] = 1.0f;
+	projectionMatrix[14] = -1.0f;
+	Frustum frustum = Frustum::FromViewProjection(viewMatrix, projectionMatrix, false);
+
+	// All queries match testing every alive entity.
+	auto checkQueries = [&]()
+	{
+		std::vector<Entity> expectedEntities;
+		std::vector<Entity> actualEntities;
+		auto collect = [&actualEntities](Entity entity) { actualEntities.push_back(entity); };
+		auto compare = [&]()
+		{
+			std::sort(actualEntities.begin(), actualEntities.end());
+			assert(actualEntities == expectedEntities);
+			expectedEntities.clear();
+			actualEntities.clear();
+		};
+
+		cd::AABB queryBox(cd::Vec3f(-100.0f, -50.0f, 0.0f), cd::Vec3f(100.0f, 150.0f, 60.0f));
+		cd::Vec3f sphereCenter(50.0f, -20.0f, 10.0f);
+		constexpr float sphereRadius = 80.0f;
+		for (Entity entity = 0; entity < entityCount; ++entity)
+		{
+			if (isAlive[entity] && overlaps(worldAABBs[entity], queryBox))
+			{
+				expectedEntities.push_back(entity);
+			}
+		}
+		bvh.QueryBox(queryBox, collect);
+		compare();
+
+		for (Entity entity = 0; entity < entityCount; ++entity)
+		{
+			float squaredDistance = 0.0f;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				float nearest = std::clamp(sphereCenter[axis], worldAABBs[entity].Min()[axis], worldAABBs[entity].Max()[axis]);
+				squaredDistance += (sphereCenter[axis] - nearest) * (sphereCenter[axis] - nearest);
+			}
+			if (isAlive[entity] && squaredDistance <= sphereRadius * sphereRadius)
+			{
+				expectedEntities.push_back(entity);
+			}
+		}
+		bvh.QuerySphere(sphereCenter, sphereRadius, collect);
+		compare();
+
+		for (Entity entity = 0; entity < entityCount; ++entity)
+		{
+			const cd::AABB& aabb = worldAABBs[entity];
+			if (isAlive[entity] && frustum.Intersects((aabb.Min() + aabb.Max()) * 0.5f, (aabb.Max() - aabb.Min()) * 0.5f))
+			{
+				expectedEntities.push_back(entity);
+			}
+		}
+		bvh.QueryFrustum(frustum, collect);
+		compare();
+
+		for (int rayIndex = 0; rayIndex < 64; ++rayIndex)
+		{
+			cd::Vec3f direction(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine) + 0.01f);
+			cd::Ray ray(cd::Vec3f(distribution(randomEngine) * 50.0f, distribution(randomEngine) * 50.0f, -600.0f), direction.Normalize());
+
+			float nearestTime = FLT_MAX;
+			Entity nearestEntity = INVALID_ENTITY;
+			for (Entity entity = 0; entity < entityCount; ++entity)
+			{
+				float hitTime;
+				if (isAlive[entity] && rayTime(worldAABBs[entity], ray, hitTime) && hitTime < nearestTime)
+				{
+					nearestTime = hitTime;
+					nearestEntity = entity;
+				}
+			}
+
+			float hitTime;
+			Entity hitEntity = bvh.Raycast(ray, hitTime);
+			assert(hitEntity == nearestEntity || std::abs(hitTime - nearestTime) < 1e-3f);
+		}
+	};
+	checkQueries();
+
+	// Refitting keeps results correct after moving and removing entities.
+	for (Entity entity = 0; entity < entityCount; entity += 2)
+	{
+		worldAABBs[entity] = randomAABB();
+		bvh.Update(entity, worldAABBs[entity]);
+	}
+	for (Entity entity = 1; entity < entityCount; entity += 7)
+	{
+		isAlive[entity] = false;
+		bvh.Remove(entity);
+		assert(!bvh.Contains(entity));
+	}
+	checkQueries();
+
+	// A rebuilt tree is balanced and cheaper to query.
+	float refitCost = bvh.GetSurfaceAreaCost();
+	uint32_t leafCount = bvh.GetLeafCount();
+	bvh.Rebuild();
+	assert(bvh.GetLeafCount() == leafCount);
+	assert(bvh.GetSurfaceAreaCost() <= refitCost);
+	assert(bvh.GetHeight() < 64);
+	assert(!bvh.NeedsRebuild());
+	checkQueries();
+
+	// Boxes of the root and a transformed local AABB.
+	cd::AABB bounds = bvh.GetBounds();
+	for (Entity entity = 0; entity < entityCount; ++entity)
+	{
+		if (isAlive[entity])
+		{
+			assert(overlaps(bounds, worldAABBs[entity]));
+		}
+	}
+
+	cd::Matrix4x4 worldMatrix = cd::Matrix4x4::Identity();
+	worldMatrix.Begin()[0] = 0.0f;
+	worldMatrix.Begin()[1] = 2.0f;
+	worldMatrix.Begin()[4] = -1.0f;
+	worldMatrix.Begin()[5] = 0.0f;
+	worldMatrix.Begin()[12] = 10.0f;
+	cd::AABB transformedAABB = BoundingVolumeHierarchy::TransformAABB(cd::AABB(cd::Vec3f(1.0f, 2.0f, 3.0f), cd::Vec3f(2.0f, 4.0f, 5.0f)), worldMatrix);
+	assert(transformedAABB.Min().x() == 6.0f && transformedAABB.Max().x() == 8.0f);
+	assert(transformedAABB.Min().y() == 2.0f && transformedAABB.Max().y() == 4.0f);
+	assert(transformedAABB.Min().z() == 3.0f && transformedAABB.Max().z() == 5.0f);
+
+	printf("\n[Success] Test_BoundingVolumeHierarchy\n");
+}
 }
 
 int main()
 {
 	Test_CreateEntity();
+	Test_RecycleEntity();
 
 	World world;
 	Factory factory = Test_RegisterComponentStorages(world);
@@ -226,5 +1411,19 @@ int main()
 	Test_RemoveEntityComponentsByOrder(factory, meshEntites);
 	Test_CleanUnusedEntityComponents(factory);
 
+	Test_ComponentsStorageBenchmark();
+	Test_Compact();
+	Test_WorldSnapshot();
+	Test_View();
+	Test_ArchetypeStorage();
+	Benchmark_ArchetypeStorage();
+	Test_SystemScheduler();
+	Test_CommandBuffer();
+	Test_ChangeTick();
+	Test_TransformHierarchy();
+	Benchmark_TransformBatch();
+	Test_ComponentSignature();
+	Test_BoundingVolumeHierarchy();
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,1152 @@
+#include "Core/Threading/ThreadPool.hpp"
+#include "Math/Transform.hpp"
+#include "Rendering/FrustumCuller.hpp"
+#include "Rendering/InstanceBatcher.hpp"
+#include "Rendering/LightClusterGrid.hpp"
+#include "Rendering/MeshLODBuilder.hpp"
+#include "Rendering/MeshOptimizer.hpp"
+#include "Rendering/RenderGraph.hpp"
+#include "Rendering/RenderQuality.h"
+#include "Rendering/RenderQueue.hpp"
+#include "Rendering/RenderTargetPool.hpp"
+#include "Rendering/VertexCompression.hpp"
+#include "Utilities/PerformanceProfiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace
+{
+
+using namespace engine;
+
+void Test_FrustumCulling()
+{
+	cdtools::PerformanceProfiler perf("Test_FrustumCulling");
+
+	// Perspective projection looking at +Z with 90 degrees fov, near 1 and far 100. NDC depth is in [-1, 1].
+	constexpr float nearPlane = 1.0f;
+	constexpr float farPlane = 100.0f;
+	float viewMatrix[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	float projectionMatrix[16] = {};
+	projectionMatrix[0] = 1.0f;
+	projectionMatrix[5] = 1.0f;
+	projectionMatrix[10] = (farPlane + nearPlane) / (farPlane - nearPlane);
+	projectionMatrix[11] = 1.0f;
+	projectionMatrix[14] = -2.0f * farPlane * nearPlane / (farPlane - nearPlane);
+	Frustum frustum = Frustum::FromViewProjection(viewMatrix, projectionMatrix, true);
+
+	cd::AABB unitBox(cd::Vec3f(-0.5f, -0.5f, -0.5f), cd::Vec3f(0.5f, 0.5f, 0.5f));
+	auto translate = [](float x, float y, float z)
+	{
+		cd::Matrix4x4 matrix = cd::Matrix4x4::Identity();
+		matrix.Begin()[12] = x;
+		matrix.Begin()[13] = y;
+		matrix.Begin()[14] = z;
+		return matrix;
+	};
+
+	{
+		FrustumCuller culler;
+		culler.Add(0, unitBox, translate(0.0f, 0.0f, 50.0f));		// Inside
+		culler.Add(1, unitBox, translate(60.0f, 0.0f, 50.0f));	// Right
+		culler.Add(2, unitBox, translate(0.0f, 0.0f, -5.0f));		// Behind
+		culler.Add(3, unitBox, translate(0.0f, 0.0f, 150.0f));	// Beyond far plane
+		culler.Add(4, unitBox, translate(-50.2f, 0.0f, 50.0f));	// Crosses left plane
+		culler.Add(5, cd::AABB(), translate(0.0f, 0.0f, -500.0f));	// No bounds
+		culler.Cull(frustum);
+
+		const std::vector<Entity>& visibleEntities = culler.GetVisibleEntities();
+		assert((visibleEntities == std::vector<Entity>{ 0, 4, 5 }));
+		assert(culler.GetStats().candidateCount == 6);
+		assert(culler.GetStats().visibleCount == 3);
+		assert(culler.GetStats().culledCount == 3);
+	}
+
+	// Random rotated and scaled boxes. Kernels and tasks output the same list as testing transformed corners.
+	constexpr uint32_t candidateCount = FrustumCuller::ChunkSize * 3 + 7;
+	std::mt19937 randomEngine(7);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+	FrustumCuller culler;
+	std::vector<Entity> expectedEntities;
+	for (uint32_t candidateIndex = 0; candidateIndex < candidateCount; ++candidateIndex)
+	{
+		cd::Vec3f min(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine));
+		cd::Vec3f size(distribution(randomEngine) + 1.5f, distribution(randomEngine) + 1.5f, distribution(randomEngine) + 1.5f);
+		cd::AABB localAABB(min, min + size * 4.0f);
+
+		cd::Vec3f axis(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine) + 2.0f);
+		cd::Transform transform(cd::Vec3f(distribution(randomEngine) * 150.0f, distribution(randomEngine) * 150.0f, distribution(randomEngine) * 150.0f),
+			cd::Quaternion::FromAxisAngle(axis.Normalize(), distribution(randomEngine) * 3.14f),
+			cd::Vec3f(distribution(randomEngine) + 2.0f, distribution(randomEngine) + 2.0f, distribution(randomEngine) + 2.0f));
+		cd::Matrix4x4 worldMatrix = transform.GetMatrix();
+		culler.Add(candidateIndex, localAABB, worldMatrix);
+
+		cd::Vec3f worldMin(FLT_MAX);
+		cd::Vec3f worldMax(-FLT_MAX);
+		const float* pMatrix = worldMatrix.Begin();
+		for (int cornerIndex = 0; cornerIndex < 8; ++cornerIndex)
+		{
+			float x = (cornerIndex & 1) ? localAABB.Max().x() : localAABB.Min().x();
+			float y = (cornerIndex & 2) ? localAABB.Max().y() : localAABB.Min().y();
+			float z = (cornerIndex & 4) ? localAABB.Max().z() : localAABB.Min().z();
+			cd::Vec3f corner(pMatrix[0] * x + pMatrix[4] * y + pMatrix[8] * z + pMatrix[12],
+				pMatrix[1] * x + pMatrix[5] * y + pMatrix[9] * z + pMatrix[13],
+				pMatrix[2] * x + pMatrix[6] * y + pMatrix[10] * z + pMatrix[14]);
+			for (int axisIndex = 0; axisIndex < 3; ++axisIndex)
+			{
+				worldMin[axisIndex] = std::min(worldMin[axisIndex], corner[axisIndex]);
+				worldMax[axisIndex] = std::max(worldMax[axisIndex], corner[axisIndex]);
+			}
+		}
+		if (frustum.Intersects((worldMin + worldMax) * 0.5f, (worldMax - worldMin) * 0.5f))
+		{
+			expectedEntities.push_back(candidateIndex);
+		}
+	}
+	assert(!expectedEntities.empty() && expectedEntities.size() < candidateCount);
+
+	ThreadPool threadPool(4);
+	constexpr SIMDLevel simdLevels[] = { SIMDLevel::Scalar, SIMDLevel::SSE2, SIMDLevel::AVX2 };
+	for (SIMDLevel simdLevel : simdLevels)
+	{
+		if (simdLevel > GetSIMDLevel())
+		{
+			continue;
+		}
+
+		for (ThreadPool* pThreadPool : { static_cast<ThreadPool*>(nullptr), &threadPool })
+		{
+			culler.Cull(frustum, pThreadPool, simdLevel);
+
+			// Boxes touching a plane within float error may differ between the kernels and the reference.
+			const std::vector<Entity>& visibleEntities = culler.GetVisibleEntities();
+			std::vector<Entity> differentEntities;
+			std::set_symmetric_difference(visibleEntities.begin(), visibleEntities.end(),
+				expectedEntities.begin(), expectedEntities.end(), std::back_inserter(differentEntities));
+			assert(differentEntities.size() <= 2);
+			assert(culler.GetStats().visibleCount == visibleEntities.size());
+			assert(culler.GetStats().visibleCount + culler.GetStats().culledCount == candidateCount);
+		}
+	}
+
+	printf("\n[Success] Test_FrustumCulling\n");
+}
+
+void Test_RenderQueue()
+{
+	cdtools::PerformanceProfiler perf("Test_RenderQueue");
+
+	SortKey key = RenderQueue::MakeSortKey(3, 1, 511, 0xBEEF, RenderQueue::QuantizeDepth(12.5f));
+	assert(RenderQueue::GetViewID(key) == 3);
+	assert(RenderQueue::GetLayer(key) == 1);
+	assert(RenderQueue::GetProgram(key) == 511);
+	assert(RenderQueue::GetMaterial(key) == 0xBEEF);
+	assert(RenderQueue::GetDepth(key) == RenderQueue::QuantizeDepth(12.5f));
+
+	// Nearer draws come first. Depths behind the camera are clamped.
+	assert(RenderQueue::QuantizeDepth(-1.0f) == 0);
+	assert(RenderQueue::QuantizeDepth(0.5f) < RenderQueue::QuantizeDepth(1.0f));
+	assert(RenderQueue::QuantizeDepth(1.0f) < RenderQueue::QuantizeDepth(1000.0f));
+
+	// Radix sort matches a stable sort. Few programs and materials make lots of equal keys.
+	std::mt19937 randomEngine(5);
+	std::uniform_int_distribution<uint32_t> programDistribution(0, 7);
+	std::uniform_int_distribution<uint32_t> materialDistribution(0, 31);
+	std::uniform_real_distribution<float> depthDistribution(-10.0f, 1000.0f);
+	RenderQueue queue;
+	std::vector<RenderQueue::Item> expectedItems;
+	for (uint32_t itemIndex = 0; itemIndex < 100000; ++itemIndex)
+	{
+		float depth = itemIndex % 3 ? depthDistribution(randomEngine) : 1.0f;
+		SortKey itemKey = RenderQueue::MakeSortKey(7, 0, static_cast<uint16_t>(programDistribution(randomEngine)),
+			static_cast<uint16_t>(materialDistribution(randomEngine)), RenderQueue::QuantizeDepth(depth));
+		queue.Push(itemKey, itemIndex);
+		expectedItems.push_back(RenderQueue::Item{ itemKey, itemIndex });
+	}
+
+	queue.Sort();
+	std::stable_sort(expectedItems.begin(), expectedItems.end(), [](const RenderQueue::Item& lhs, const RenderQueue::Item& rhs) { return lhs.key < rhs.key; });
+	assert(queue.GetItemCount() == expectedItems.size());
+	for (size_t itemIndex = 0; itemIndex < expectedItems.size(); ++itemIndex)
+	{
+		assert(queue.GetItems()[itemIndex].key == expectedItems[itemIndex].key);
+		assert(queue.GetItems()[itemIndex].payload == expectedItems[itemIndex].payload);
+	}
+
+	// Sorted draws switch programs once per program.
+	uint32_t programSwitches = 0;
+	uint16_t lastProgram = UINT16_MAX;
+	for (const RenderQueue::Item& item : queue.GetItems())
+	{
+		programSwitches += RenderQueue::GetProgram(item.key) != lastProgram ? 1 : 0;
+		lastProgram = RenderQueue::GetProgram(item.key);
+	}
+	assert(programSwitches == 8);
+
+	queue.Clear();
+	queue.Sort();
+	assert(queue.IsEmpty());
+
+	printf("\n[Success] Test_RenderQueue\n");
+}
+
+void Test_RenderQueueSubmitOrder()
+{
+	cdtools::PerformanceProfiler perf("Test_RenderQueueSubmitOrder");
+
+	std::mt19937 randomEngine(7);
+	std::uniform_int_distribution<uint32_t> programDistribution(0, 15);
+	std::uniform_real_distribution<float> depthDistribution(0.1f, 1000.0f);
+	RenderQueue queue;
+	for (uint32_t itemIndex = 0; itemIndex < 4096; ++itemIndex)
+	{
+		queue.Push(RenderQueue::MakeSortKey(0, 0, static_cast<uint16_t>(programDistribution(randomEngine)), 0,
+			RenderQueue::QuantizeDepth(depthDistribution(randomEngine))), itemIndex);
+	}
+	queue.Sort();
+
+	// Chunks are recorded concurrently as Renderer::SubmitDraws does, so submits of chunks interleave.
+	// Items submit twice as batches which are split into several draws do.
+	struct SubmittedDraw
+	{
+		uint32_t depth;
+		uint32_t payload;
+	};
+	std::mutex submitMutex;
+	std::vector<SubmittedDraw> submittedDraws;
+	auto submitChunk = [&](uint32_t beginIndex, uint32_t endIndex)
+	{
+		for (uint32_t itemIndex = beginIndex; itemIndex < endIndex; ++itemIndex)
+		{
+			for (uint32_t drawIndex = 0; drawIndex < 2; ++drawIndex)
+			{
+				std::lock_guard<std::mutex> lock(submitMutex);
+				submittedDraws.push_back(SubmittedDraw{ RenderQueue::GetSubmitDepth(itemIndex), queue.GetItems()[itemIndex].payload });
+			}
+		}
+	};
+
+	ThreadPool threadPool(4);
+	constexpr uint32_t chunkSize = 256;
+	const uint32_t itemCount = static_cast<uint32_t>(queue.GetItemCount());
+	std::atomic<uint32_t> finishedChunkCount = 0;
+	uint32_t chunkCount = 0;
+	for (uint32_t beginIndex = 0; beginIndex < itemCount; beginIndex += chunkSize, ++chunkCount)
+	{
+		threadPool.Submit([&submitChunk, &finishedChunkCount, beginIndex, itemCount]()
+		{
+			submitChunk(beginIndex, std::min(beginIndex + chunkSize, itemCount));
+			finishedChunkCount.fetch_add(1, std::memory_order_release);
+		});
+	}
+	while (finishedChunkCount.load(std::memory_order_acquire) < chunkCount)
+	{
+		threadPool.TryRunTask();
+	}
+
+	// A DepthAscending view sorts draws by depth, then the order of draws matches the sorted queue.
+	assert(submittedDraws.size() == 2 * queue.GetItemCount());
+	std::stable_sort(submittedDraws.begin(), submittedDraws.end(), [](const SubmittedDraw& lhs, const SubmittedDraw& rhs) { return lhs.depth < rhs.depth; });
+	for (size_t drawIndex = 0; drawIndex < submittedDraws.size(); ++drawIndex)
+	{
+		assert(submittedDraws[drawIndex].payload == queue.GetItems()[drawIndex / 2].payload);
+	}
+
+	printf("\n[Success] Test_RenderQueueSubmitOrder\n");
+}
+
+void Test_InstanceBatcher()
+{
+	cdtools::PerformanceProfiler perf("Test_InstanceBatcher");
+
+	// Draws of 3 meshes with 2 materials. Material of draw 5 has a colliding hash but different textures.
+	struct Draw
+	{
+		uint16_t mesh;
+		uint16_t material;
+		uint32_t textures;
+	};
+	std::vector<Draw> draws = { { 1, 1, 10 }, { 2, 1, 10 }, { 1, 1, 10 }, { 3, 2, 20 }, { 1, 1, 10 }, { 1, 1, 11 }, { 2, 1, 10 } };
+
+	InstanceBatcher batcher;
+	for (uint32_t drawIndex = 0; drawIndex < draws.size(); ++drawIndex)
+	{
+		batcher.Add(InstanceBatcher::MakeBatchKey(draws[drawIndex].mesh, draws[drawIndex].mesh, 7, draws[drawIndex].material), drawIndex);
+	}
+	batcher.Build([&draws](uint32_t lhs, uint32_t rhs) { return draws[lhs].textures == draws[rhs].textures; });
+
+	// Every draw is in one batch, and draws of a batch are identical.
+	const std::vector<uint32_t>& instances = batcher.GetInstances();
+	assert(instances.size() == draws.size());
+	uint32_t batchedCount = 0;
+	for (const InstanceBatcher::Batch& batch : batcher.GetBatches())
+	{
+		assert(batch.firstInstance == batchedCount);
+		const Draw& firstDraw = draws[instances[batch.firstInstance]];
+		for (uint32_t instanceIndex = batch.firstInstance; instanceIndex < batch.firstInstance + batch.instanceCount; ++instanceIndex)
+		{
+			const Draw& draw = draws[instances[instanceIndex]];
+			assert(draw.mesh == firstDraw.mesh && draw.material == firstDraw.material && draw.textures == firstDraw.textures);
+		}
+		batchedCount += batch.instanceCount;
+	}
+	assert(batchedCount == draws.size());
+
+	// { 0, 2, 4 }, { 5 }, { 1, 6 }, { 3 }. Instances keep the order which they are added in.
+	assert(batcher.GetBatches().size() == 4);
+	assert(batcher.GetBatches()[0].instanceCount == 3);
+	assert(instances[0] == 0 && instances[1] == 2 && instances[2] == 4);
+	assert(batcher.GetBatches()[1].instanceCount == 1 && instances[3] == 5);
+	assert(batcher.GetBatches()[2].instanceCount == 2);
+	assert(batcher.GetBatches()[3].instanceCount == 1);
+
+	batcher.Clear();
+	batcher.Build([](uint32_t, uint32_t) { return true; });
+	assert(batcher.GetBatches().empty() && batcher.GetInstances().empty());
+
+	printf("\n[Success] Test_InstanceBatcher\n");
+}
+
+void Test_RenderGraph()
+{
+	cdtools::PerformanceProfiler perf("Test_RenderGraph");
+
+	// Passes of the editor. Blit copies scene color for post processing which is not added.
+	{
+		RenderGraph graph;
+		RenderGraph::ResourceHandle sceneColor = graph.ImportTexture("SceneRenderTarget");
+		RenderGraph::ResourceHandle sceneColorCopy = graph.CreateTexture("SceneColorCopy", RenderGraph::TextureDescriptor{ 1280, 720, TextureFormat::RGBA32F });
+
+		RenderGraph::PassHandle skyPass = graph.AddPass("Sky");
+		graph.Write(skyPass, sceneColor);
+		RenderGraph::PassHandle worldPass = graph.AddPass("World");
+		graph.Read(worldPass, sceneColor);
+		graph.Write(worldPass, sceneColor);
+		RenderGraph::PassHandle debugPass = graph.AddPass("Debug");
+		graph.Read(debugPass, sceneColor);
+		graph.Write(debugPass, sceneColor);
+		RenderGraph::PassHandle blitPass = graph.AddPass("Blit");
+		graph.Read(blitPass, sceneColor);
+		graph.Write(blitPass, sceneColorCopy);
+		RenderGraph::PassHandle uiPass = graph.AddPass("UI");
+		graph.Read(uiPass, sceneColor);
+		graph.Write(uiPass, sceneColor);
+
+		graph.SetPassEnabled(debugPass, false);
+		graph.Compile(10);
+		assert(graph.GetCompiledPasses() == std::vector<RenderGraph::PassHandle>({ skyPass, worldPass, uiPass }));
+		assert(graph.IsPassCulled(debugPass) && graph.IsPassCulled(blitPass));
+		assert(graph.GetPassViewID(skyPass) == 10 && graph.GetPassViewID(worldPass) == 11 && graph.GetPassViewID(uiPass) == 12);
+		assert(graph.GetPassViewID(blitPass) == RenderGraph::InvalidViewID);
+		assert(graph.GetResourceLifetime(sceneColor).firstPass == 0 && graph.GetResourceLifetime(sceneColor).lastPass == 2);
+		assert(!graph.GetResourceLifetime(sceneColorCopy).IsValid());
+		assert(0 == graph.GetPhysicalTextureCount() && 0 == graph.GetTransientMemorySize());
+
+		// Enabling a pass moves views of the following passes.
+		graph.SetPassEnabled(debugPass, true);
+		graph.Compile(10);
+		assert(graph.GetCompiledPasses().size() == 4);
+		assert(graph.GetPassViewID(debugPass) == 12 && graph.GetPassViewID(uiPass) == 13);
+
+		// A reader of the copy keeps the blit.
+		RenderGraph::PassHandle postProcessPass = graph.AddPass("PostProcess");
+		graph.Read(postProcessPass, sceneColorCopy);
+		graph.Write(postProcessPass, sceneColor);
+		graph.Compile();
+		assert(!graph.IsPassCulled(blitPass));
+		assert(graph.GetResourceLifetime(sceneColorCopy).firstPass == 3 && graph.GetResourceLifetime(sceneColorCopy).lastPass == 5);
+		assert(graph.GetTransientMemorySize() == 1280ULL * 720 * 16);
+	}
+
+	// Chain of transient textures. Textures which are not alive at the same time share memory.
+	{
+		RenderGraph graph;
+		RenderGraph::TextureDescriptor descriptor{ 256, 256, TextureFormat::RGBA32F };
+		RenderGraph::ResourceHandle backBuffer = graph.ImportTexture("BackBuffer");
+		RenderGraph::ResourceHandle textureA = graph.CreateTexture("A", descriptor);
+		RenderGraph::ResourceHandle textureB = graph.CreateTexture("B", descriptor);
+		RenderGraph::ResourceHandle textureC = graph.CreateTexture("C", descriptor);
+		RenderGraph::ResourceHandle depth = graph.CreateTexture("Depth", RenderGraph::TextureDescriptor{ 256, 256, TextureFormat::D32F });
+		RenderGraph::ResourceHandle unused = graph.CreateTexture("Unused", descriptor);
+
+		// Overwritten before it is read, so the first writer is culled.
+		RenderGraph::PassHandle deadPass = graph.AddPass("Dead");
+		graph.Write(deadPass, textureA);
+		RenderGraph::PassHandle passA = graph.AddPass("A");
+		graph.Write(passA, textureA);
+		graph.Write(passA, depth);
+		RenderGraph::PassHandle passB = graph.AddPass("B");
+		graph.Read(passB, textureA);
+		graph.Write(passB, textureB);
+		RenderGraph::PassHandle passC = graph.AddPass("C");
+		graph.Read(passC, textureB);
+		graph.Read(passC, depth);
+		graph.Write(passC, textureC);
+		RenderGraph::PassHandle unusedPass = graph.AddPass("Unused");
+		graph.Read(unusedPass, textureC);
+		graph.Write(unusedPass, unused);
+		RenderGraph::PassHandle presentPass = graph.AddPass("Present");
+		graph.Read(presentPass, textureC);
+		graph.Write(presentPass, backBuffer);
+
+		graph.Compile();
+		assert(graph.GetCompiledPasses() == std::vector<RenderGraph::PassHandle>({ passA, passB, passC, presentPass }));
+		assert(graph.IsPassCulled(deadPass) && graph.IsPassCulled(unusedPass));
+
+		assert(graph.GetResourceLifetime(textureA).firstPass == 0 && graph.GetResourceLifetime(textureA).lastPass == 1);
+		assert(graph.GetResourceLifetime(textureB).firstPass == 1 && graph.GetResourceLifetime(textureB).lastPass == 2);
+		assert(graph.GetResourceLifetime(textureC).firstPass == 2 && graph.GetResourceLifetime(textureC).lastPass == 3);
+		assert(graph.GetResourceLifetime(depth).firstPass == 0 && graph.GetResourceLifetime(depth).lastPass == 2);
+		assert(!graph.GetResourceLifetime(unused).IsValid());
+
+		// A and C don't overlap. Depth has another format.
+		assert(graph.GetPhysicalTexture(textureA) == graph.GetPhysicalTexture(textureC));
+		assert(graph.GetPhysicalTexture(textureA) != graph.GetPhysicalTexture(textureB));
+		assert(graph.GetPhysicalTexture(depth) != graph.GetPhysicalTexture(textureA) && graph.GetPhysicalTexture(depth) != graph.GetPhysicalTexture(textureB));
+		assert(graph.GetPhysicalTexture(unused) == RenderGraph::InvalidHandle && graph.GetPhysicalTexture(backBuffer) == RenderGraph::InvalidHandle);
+		assert(graph.GetPhysicalTextureCount() == 3);
+		assert(graph.GetUnaliasedMemorySize() == 3 * descriptor.GetSize() + 256 * 256 * 4);
+		assert(graph.GetTransientMemorySize() == 2 * descriptor.GetSize() + 256 * 256 * 4);
+
+		// Execute holds physical textures from the pool only during their lifetimes. Passes get textures of their resources.
+		std::set<RenderTargetPool::TextureHandle> aliveTextures;
+		RenderTargetPool::TextureHandle nextTexture = 0;
+		RenderTargetPool pool;
+		pool.Init(
+			[&aliveTextures, &nextTexture](const TextureDescriptor&) { aliveTextures.insert(nextTexture); return nextTexture++; },
+			[&aliveTextures](RenderTargetPool::TextureHandle texture) { aliveTextures.erase(texture); });
+
+		std::vector<RenderGraph::PassHandle> executedPasses;
+		graph.Execute(pool, [&](RenderGraph::PassHandle pass)
+		{
+			executedPasses.push_back(pass);
+			assert(RenderTargetPool::InvalidTexture == graph.GetTexture(backBuffer) && RenderTargetPool::InvalidTexture == graph.GetTexture(unused));
+			if (passA == pass)
+			{
+				assert(RenderTargetPool::InvalidTexture != graph.GetTexture(textureA) && RenderTargetPool::InvalidTexture != graph.GetTexture(depth));
+				assert(RenderTargetPool::InvalidTexture == graph.GetTexture(textureB));
+				assert(pool.GetTextureCount() == 2 && pool.GetFreeTextureCount() == 0);
+			}
+			else if (passB == pass)
+			{
+				assert(RenderTargetPool::InvalidTexture != graph.GetTexture(textureB) && graph.GetTexture(textureA) != graph.GetTexture(textureB));
+				assert(pool.GetTextureCount() == 3 && pool.GetFreeTextureCount() == 0);
+			}
+			else if (passC == pass)
+			{
+				assert(graph.GetTexture(textureC) == graph.GetTexture(textureA));
+				assert(pool.GetTextureCount() == 3 && pool.GetFreeTextureCount() == 0);
+			}
+			else
+			{
+				// B and depth are released after C, the last pass which uses them.
+				assert(RenderTargetPool::InvalidTexture != graph.GetTexture(textureC));
+				assert(RenderTargetPool::InvalidTexture == graph.GetTexture(textureB) && RenderTargetPool::InvalidTexture == graph.GetTexture(depth));
+				assert(pool.GetFreeTextureCount() == 2);
+			}
+		});
+		assert(executedPasses == graph.GetCompiledPasses());
+		assert(RenderTargetPool::InvalidTexture == graph.GetTexture(textureC));
+		assert(pool.GetCreatedTextureCount() == 3 && pool.GetFreeTextureCount() == 3);
+
+		// The next frame reuses the same textures.
+		graph.Compile();
+		graph.Execute(pool, [](RenderGraph::PassHandle) {});
+		assert(pool.GetCreatedTextureCount() == 3 && aliveTextures.size() == 3);
+		pool.Clear();
+		assert(aliveTextures.empty());
+	}
+
+	printf("\n[Success] Test_RenderGraph\n");
+}
+
+void Test_RenderTargetPool()
+{
+	cdtools::PerformanceProfiler perf("Test_RenderTargetPool");
+
+	std::set<RenderTargetPool::TextureHandle> aliveTextures;
+	RenderTargetPool::TextureHandle nextTexture = 0;
+	RenderTargetPool pool;
+	pool.Init(
+		[&aliveTextures, &nextTexture](const TextureDescriptor&) { aliveTextures.insert(nextTexture); return nextTexture++; },
+		[&aliveTextures](RenderTargetPool::TextureHandle texture) { aliveTextures.erase(texture); });
+	pool.SetMaxUnusedFrames(2);
+
+	// Attachments of the scene render target.
+	TextureDescriptor color{ 1280, 720, TextureFormat::RGBA16F, 4 };
+	TextureDescriptor depth{ 1280, 720, TextureFormat::D32F, 4 };
+	RenderTargetPool::TextureHandle sceneColor = pool.Acquire(color, "SceneRenderTarget");
+	RenderTargetPool::TextureHandle sceneDepth = pool.Acquire(depth, "SceneRenderTarget");
+	assert(sceneColor != sceneDepth && pool.GetCreatedTextureCount() == 2);
+
+	// Acquired textures are not shared, even if descriptors are equal.
+	RenderTargetPool::TextureHandle otherColor = pool.Acquire(color, "Other");
+	assert(otherColor != sceneColor && pool.GetCreatedTextureCount() == 3);
+
+	// MSAA color takes samples and the resolved copy. MSAA depth only takes samples.
+	assert(color.GetSize() == 1280ULL * 720 * 8 * 5);
+	assert(depth.GetSize() == 1280ULL * 720 * 4 * 4);
+	assert(pool.GetMemorySize() == 2 * color.GetSize() + depth.GetSize());
+
+	// A released texture is reused by the next pass which asks for the same descriptor.
+	pool.Release(otherColor);
+	assert(pool.GetFreeTextureCount() == 1);
+	assert(pool.Acquire(color, "PostProcess") == otherColor && pool.GetCreatedTextureCount() == 3);
+
+	std::vector<RenderTargetPool::MemoryReportEntry> report = pool.GetMemoryReport();
+	assert(report.size() == 3);
+	assert(report[0].owner == "SceneRenderTarget" && report[1].owner == "SceneRenderTarget" && report[2].owner == "PostProcess");
+	assert(report[1].descriptor == depth && report[1].size == depth.GetSize());
+
+	// Resizing releases old attachments. They are kept for a few frames in case the old size comes back, then destroyed.
+	pool.Release(sceneColor);
+	pool.Release(sceneDepth);
+	TextureDescriptor resizedColor{ 1920, 1080, TextureFormat::RGBA16F, 4 };
+	RenderTargetPool::TextureHandle resizedSceneColor = pool.Acquire(resizedColor, "SceneRenderTarget");
+	assert(resizedSceneColor != sceneColor && pool.GetTextureCount() == 4);
+	assert(pool.GetMemoryReport()[0].owner.empty());
+
+	pool.Update();
+	pool.Update();
+	assert(pool.GetTextureCount() == 4);
+	pool.Update();
+	assert(pool.GetTextureCount() == 2 && pool.GetFreeTextureCount() == 0);
+	assert(!aliveTextures.contains(sceneColor) && !aliveTextures.contains(sceneDepth));
+	assert(pool.GetMemorySize() == color.GetSize() + resizedColor.GetSize());
+
+	// Textures in use are never evicted.
+	for (uint32_t frame = 0; frame < 10; ++frame)
+	{
+		pool.Update();
+	}
+	assert(pool.GetTextureCount() == 2);
+
+	pool.Clear();
+	assert(aliveTextures.empty() && 0 == pool.GetMemorySize());
+
+	// Bytes of scene attachments per quality tier at 1080p.
+	uint64_t previousSize = 0;
+	for (RenderQuality quality : { RenderQuality::Low, RenderQuality::Medium, RenderQuality::High, RenderQuality::Ultra })
+	{
+		RenderQualitySettings settings = GetRenderQualitySettings(quality);
+		uint64_t size = TextureDescriptor{ 1920, 1080, settings.colorFormat, settings.sampleCount }.GetSize() +
+			TextureDescriptor{ 1920, 1080, settings.depthFormat, settings.sampleCount }.GetSize();
+		printf("RenderQuality %d : %s + %s x%d, %llu bytes\n", static_cast<int>(quality), GetTextureFormatName(settings.colorFormat),
+			GetTextureFormatName(settings.depthFormat), settings.sampleCount, static_cast<unsigned long long>(size));
+		assert(size > previousSize);
+		previousSize = size;
+	}
+	assert(GetRenderQualitySettings(RenderQuality::Low).sampleCount == 1);
+
+	printf("\n[Success] Test_RenderTargetPool\n");
+}
+
+void Test_LightClusterGrid()
+{
+	cdtools::PerformanceProfiler perf("Test_LightClusterGrid");
+
+	// 16:9 view with 60 degrees vertical field of view.
+	constexpr float nearPlane = 0.1f;
+	constexpr float farPlane = 1000.0f;
+	const float yScale = 1.0f / std::tan(3.14159265f / 6.0f);
+	const float xScale = yScale * 9.0f / 16.0f;
+	LightClusterGrid grid;
+	grid.SetGridSize(16, 9, 24);
+	grid.SetProjection(xScale, yScale, nearPlane, farPlane);
+	assert(grid.GetClusterCount() == 16 * 9 * 24);
+
+	// Slices are exponential and cover the depth range.
+	assert(std::abs(grid.GetSliceDepth(0) - nearPlane) < 1e-5f && std::abs(grid.GetSliceDepth(24) - farPlane) < 1e-1f);
+	for (uint32_t slice = 0; slice < grid.GetSliceCount(); ++slice)
+	{
+		float middleDepth = std::sqrt(grid.GetSliceDepth(slice) * grid.GetSliceDepth(slice + 1));
+		assert(grid.GetSliceIndex(middleDepth) == slice);
+	}
+	assert(grid.GetSliceIndex(0.0f) == 0 && grid.GetSliceIndex(farPlane * 2.0f) == 23u);
+
+	// Returns the cluster of a view space point, or UINT32_MAX if it is outside of the view.
+	auto getPointCluster = [&grid, xScale, yScale](const cd::Vec3f& point)
+	{
+		if (point.z() < nearPlane || point.z() > farPlane)
+		{
+			return UINT32_MAX;
+		}
+
+		float tileX = std::floor((point.x() * xScale / point.z() * 0.5f + 0.5f) * grid.GetTileCountX());
+		float tileY = std::floor((point.y() * yScale / point.z() * 0.5f + 0.5f) * grid.GetTileCountY());
+		if (tileX < 0.0f || tileX >= grid.GetTileCountX() || tileY < 0.0f || tileY >= grid.GetTileCountY())
+		{
+			return UINT32_MAX;
+		}
+		return grid.GetClusterIndex(static_cast<uint32_t>(tileX), static_cast<uint32_t>(tileY), grid.GetSliceIndex(point.z()));
+	};
+
+	std::mt19937 randomEngine(22);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	auto randomPointInSphere = [&](const LightClusterGrid::LightBounds& bounds)
+	{
+		cd::Vec3f offset;
+		do
+		{
+			offset = cd::Vec3f(distribution(randomEngine), distribution(randomEngine), distribution(randomEngine));
+		} while (offset.Dot(offset) > 1.0f);
+		return bounds.center + offset * bounds.radius;
+	};
+
+	constexpr uint32_t lightCount = 4096;
+	std::vector<LightClusterGrid::LightBounds> lights;
+	for (uint32_t lightIndex = 0; lightIndex < lightCount; ++lightIndex)
+	{
+		float depth = std::pow(distribution(randomEngine) * 0.5f + 0.5f, 2.0f) * 120.0f - 10.0f;
+		cd::Vec3f center(distribution(randomEngine) * (std::abs(depth) + 1.0f), distribution(randomEngine) * (std::abs(depth) + 1.0f) * 0.6f, depth);
+		lights.push_back(LightClusterGrid::MakeSphereBounds(center, distribution(randomEngine) * 2.0f + 3.0f));
+	}
+
+	// Lights behind the camera and beyond the far plane touch no cluster. A directional light touches every cluster.
+	lights.push_back(LightClusterGrid::MakeSphereBounds(cd::Vec3f(0.0f, 0.0f, -5.0f), 1.0f));
+	lights.push_back(LightClusterGrid::MakeSphereBounds(cd::Vec3f(0.0f, 0.0f, farPlane + 5.0f), 1.0f));
+	lights.push_back(LightClusterGrid::MakeUnboundedBounds());
+
+	{
+		cdtools::PerformanceProfiler buildPerf("LightClusterGrid::Build");
+		grid.Build(lights);
+	}
+
+	const std::vector<LightClusterGrid::ClusterRange>& clusterRanges = grid.GetClusterRanges();
+	const std::vector<uint32_t>& lightIndices = grid.GetLightIndices();
+	std::vector<std::set<uint32_t>> clusterLights(grid.GetClusterCount());
+	uint32_t maxLightCount = 0;
+	for (uint32_t clusterIndex = 0; clusterIndex < grid.GetClusterCount(); ++clusterIndex)
+	{
+		const LightClusterGrid::ClusterRange& clusterRange = clusterRanges[clusterIndex];
+		assert(clusterRange.offset + clusterRange.count <= lightIndices.size());
+		assert(std::is_sorted(lightIndices.begin() + clusterRange.offset, lightIndices.begin() + clusterRange.offset + clusterRange.count));
+		clusterLights[clusterIndex].insert(lightIndices.begin() + clusterRange.offset, lightIndices.begin() + clusterRange.offset + clusterRange.count);
+		assert(clusterLights[clusterIndex].size() == clusterRange.count);
+		assert(clusterLights[clusterIndex].contains(lightCount + 2));
+		assert(!clusterLights[clusterIndex].contains(lightCount) && !clusterLights[clusterIndex].contains(lightCount + 1));
+		maxLightCount = std::max(maxLightCount, clusterRange.count);
+	}
+	assert(maxLightCount == grid.GetMaxLightCountPerCluster());
+
+	// Culling is conservative : every point of a light is in a cluster which lists the light.
+	// And culling is tight : every listed light intersects the bounding box of the cluster.
+	for (uint32_t lightIndex = 0; lightIndex < lightCount; ++lightIndex)
+	{
+		for (uint32_t sampleIndex = 0; sampleIndex < 64; ++sampleIndex)
+		{
+			uint32_t clusterIndex = getPointCluster(randomPointInSphere(lights[lightIndex]));
+			assert(UINT32_MAX == clusterIndex || clusterLights[clusterIndex].contains(lightIndex));
+		}
+	}
+
+	uint64_t pairCount = 0;
+	for (uint32_t clusterIndex = 0; clusterIndex < grid.GetClusterCount(); ++clusterIndex)
+	{
+		const LightClusterGrid::ClusterAABB& aabb = grid.GetClusterAABB(clusterIndex);
+		for (uint32_t lightIndex : clusterLights[clusterIndex])
+		{
+			if (lights[lightIndex].IsUnbounded())
+			{
+				continue;
+			}
+
+			float squaredDistance = 0.0f;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				float distance = std::max({ aabb.min[axis] - lights[lightIndex].center[axis], 0.0f, lights[lightIndex].center[axis] - aabb.max[axis] });
+				squaredDistance += distance * distance;
+			}
+			assert(squaredDistance <= lights[lightIndex].radius * lights[lightIndex].radius);
+			++pairCount;
+		}
+	}
+	printf("LightClusterGrid : %u lights, %u clusters, %llu light cluster pairs, max %u lights per cluster\n", static_cast<uint32_t>(lights.size()),
+		grid.GetClusterCount(), static_cast<unsigned long long>(pairCount), maxLightCount);
+
+	// Cone bounds contain the apex and the cap of both narrow and wide spot lights.
+	for (float cosHalfAngle : { 0.95f, 0.8f, 0.5f, 0.1f })
+	{
+		cd::Vec3f apex(1.0f, 2.0f, 3.0f);
+		cd::Vec3f direction(0.0f, 0.6f, 0.8f);
+		float range = 10.0f;
+		LightClusterGrid::LightBounds bounds = LightClusterGrid::MakeConeBounds(apex, direction, range, cosHalfAngle);
+		float sinHalfAngle = std::sqrt(1.0f - cosHalfAngle * cosHalfAngle);
+		cd::Vec3f capCenter = apex + direction * (range * cosHalfAngle);
+		cd::Vec3f capEdge = capCenter + cd::Vec3f(1.0f, 0.0f, 0.0f) * (range * sinHalfAngle);
+		for (const cd::Vec3f& point : { apex, capEdge, apex + direction * range })
+		{
+			assert((point - bounds.center).Length() <= bounds.radius + 1e-4f);
+		}
+		assert(bounds.radius <= range);
+	}
+
+	printf("\n[Success] Test_LightClusterGrid\n");
+}
+
+void Test_MeshLODBuilder()
+{
+	cdtools::PerformanceProfiler perf("Test_MeshLODBuilder");
+
+	auto pointTriangleDistance = [](const cd::Vec3f& point, const cd::Vec3f& a, const cd::Vec3f& b, const cd::Vec3f& c)
+	{
+		// Closest point on the triangle by Voronoi regions of vertices, edges and the face.
+		cd::Vec3f ab = b - a, ac = c - a, ap = point - a;
+		float d1 = ab.Dot(ap), d2 = ac.Dot(ap);
+		if (d1 <= 0.0f && d2 <= 0.0f) return (point - a).Length();
+		cd::Vec3f bp = point - b;
+		float d3 = ab.Dot(bp), d4 = ac.Dot(bp);
+		if (d3 >= 0.0f && d4 <= d3) return (point - b).Length();
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return (point - (a + ab * (d1 / (d1 - d3)))).Length();
+		cd::Vec3f cp = point - c;
+		float d5 = ab.Dot(cp), d6 = ac.Dot(cp);
+		if (d6 >= 0.0f && d5 <= d6) return (point - c).Length();
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return (point - (a + ac * (d2 / (d2 - d6)))).Length();
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) return (point - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))))).Length();
+		float denominator = 1.0f / (va + vb + vc);
+		return (point - (a + ab * (vb * denominator) + ac * (vc * denominator))).Length();
+	};
+
+	// Closed sphere with outward triangles.
+	constexpr uint32_t ringCount = 32;
+	constexpr uint32_t segmentCount = 64;
+	constexpr float radius = 10.0f;
+	std::vector<cd::Vec3f> positions;
+	positions.push_back(cd::Vec3f(0.0f, radius, 0.0f));
+	for (uint32_t ring = 1; ring < ringCount; ++ring)
+	{
+		for (uint32_t segment = 0; segment < segmentCount; ++segment)
+		{
+			float theta = 3.14159265f * ring / ringCount;
+			float phi = 2.0f * 3.14159265f * segment / segmentCount;
+			positions.push_back(cd::Vec3f(radius * std::sin(theta) * std::cos(phi), radius * std::cos(theta), radius * std::sin(theta) * std::sin(phi)));
+		}
+	}
+	positions.push_back(cd::Vec3f(0.0f, -radius, 0.0f));
+	const uint32_t southPole = static_cast<uint32_t>(positions.size() - 1);
+
+	std::vector<uint32_t> indices;
+	auto ringVertex = [](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * segmentCount + segment % segmentCount; };
+	auto addTriangle = [&positions, &indices](uint32_t v0, uint32_t v1, uint32_t v2)
+	{
+		cd::Vec3f normal = (positions[v1] - positions[v0]).Cross(positions[v2] - positions[v0]);
+		if (normal.Dot(positions[v0] + positions[v1] + positions[v2]) < 0.0f)
+		{
+			std::swap(v1, v2);
+		}
+		indices.insert(indices.end(), { v0, v1, v2 });
+	};
+	for (uint32_t segment = 0; segment < segmentCount; ++segment)
+	{
+		addTriangle(0, ringVertex(1, segment), ringVertex(1, segment + 1));
+		addTriangle(southPole, ringVertex(ringCount - 1, segment), ringVertex(ringCount - 1, segment + 1));
+		for (uint32_t ring = 1; ring < ringCount - 1; ++ring)
+		{
+			addTriangle(ringVertex(ring, segment), ringVertex(ring + 1, segment), ringVertex(ring + 1, segment + 1));
+			addTriangle(ringVertex(ring, segment), ringVertex(ring + 1, segment + 1), ringVertex(ring, segment + 1));
+		}
+	}
+
+	MeshLODBuilder::Settings settings;
+	MeshLODBuilder builder(settings);
+	{
+		cdtools::PerformanceProfiler buildPerf("MeshLODBuilder::Build");
+		builder.Build(positions.data(), static_cast<uint32_t>(positions.size()), indices.data(), static_cast<uint32_t>(indices.size()));
+	}
+
+	// Diagonal of the bounds is 2 * sqrt(3) * radius.
+	const float maxError = settings.maxRelativeError * std::sqrt(3.0f) * radius;
+	const std::vector<MeshLOD>& lods = builder.GetLODs();
+	const std::vector<uint32_t>& lodIndices = builder.GetIndices();
+	assert(lods.size() > 2 && lods.size() <= settings.lodCount + 1);
+	assert(0 == lods[0].indexOffset && lods[0].indexCount == indices.size() && 0.0f == lods[0].error);
+	assert(std::equal(indices.begin(), indices.end(), lodIndices.begin()));
+	for (uint32_t lodIndex = 1; lodIndex < lods.size(); ++lodIndex)
+	{
+		const MeshLOD& lod = lods[lodIndex];
+		const MeshLOD& previousLOD = lods[lodIndex - 1];
+		assert(lod.indexOffset == previousLOD.indexOffset + previousLOD.indexCount);
+		assert(lod.indexOffset + lod.indexCount <= lodIndices.size() && lod.indexCount % 3 == 0);
+
+		// Triangle counts halve until the error bound is reached. Errors grow along the chain and stay in the bound.
+		assert(lod.indexCount < previousLOD.indexCount);
+		assert(lod.indexCount / 3 <= static_cast<uint32_t>(previousLOD.indexCount / 3 * settings.triangleRatio) || lodIndex + 1 == lods.size());
+		assert(lod.error >= previousLOD.error && lod.error <= maxError);
+
+		// Triangles are not degenerate and keep facing outward.
+		for (uint32_t index = lod.indexOffset; index < lod.indexOffset + lod.indexCount; index += 3)
+		{
+			uint32_t v0 = lodIndices[index], v1 = lodIndices[index + 1], v2 = lodIndices[index + 2];
+			assert(v0 < positions.size() && v1 < positions.size() && v2 < positions.size());
+			assert(v0 != v1 && v1 != v2 && v2 != v0);
+			cd::Vec3f normal = (positions[v1] - positions[v0]).Cross(positions[v2] - positions[v0]);
+			assert(normal.Dot(positions[v0] + positions[v1] + positions[v2]) > 0.0f);
+		}
+
+		// Every vertex of the full mesh is within the error bound of the LOD surface.
+		float maxDistance = 0.0f;
+		for (const cd::Vec3f& position : positions)
+		{
+			float distance = FLT_MAX;
+			for (uint32_t index = lod.indexOffset; index < lod.indexOffset + lod.indexCount; index += 3)
+			{
+				distance = std::min(distance, pointTriangleDistance(position, positions[lodIndices[index]], positions[lodIndices[index + 1]], positions[lodIndices[index + 2]]));
+			}
+			maxDistance = std::max(maxDistance, distance);
+		}
+		assert(maxDistance <= lod.error + 1e-4f);
+		printf("MeshLOD %u : %u triangles, error %f, distance to full mesh %f\n", lodIndex, lod.indexCount / 3, lod.error, maxDistance);
+	}
+
+	// A flat grid simplifies without errors. Border vertices are locked, so the outline is kept.
+	constexpr uint32_t gridSize = 32;
+	std::vector<cd::Vec3f> gridPositions;
+	std::vector<uint32_t> gridIndices;
+	for (uint32_t y = 0; y <= gridSize; ++y)
+	{
+		for (uint32_t x = 0; x <= gridSize; ++x)
+		{
+			gridPositions.push_back(cd::Vec3f(static_cast<float>(x), 0.0f, static_cast<float>(y)));
+			if (x < gridSize && y < gridSize)
+			{
+				uint32_t corner = y * (gridSize + 1) + x;
+				gridIndices.insert(gridIndices.end(), { corner, corner + gridSize + 1, corner + 1, corner + 1, corner + gridSize + 1, corner + gridSize + 2 });
+			}
+		}
+	}
+	builder.Build(gridPositions.data(), static_cast<uint32_t>(gridPositions.size()), gridIndices.data(), static_cast<uint32_t>(gridIndices.size()));
+	assert(builder.GetLODs().size() == settings.lodCount + 1);
+	const MeshLOD& coarsestGridLOD = builder.GetLODs().back();
+	assert(0.0f == coarsestGridLOD.error && coarsestGridLOD.indexCount * 8 <= gridIndices.size());
+	std::set<uint32_t> coarsestGridVertices(builder.GetIndices().begin() + coarsestGridLOD.indexOffset,
+		builder.GetIndices().begin() + coarsestGridLOD.indexOffset + coarsestGridLOD.indexCount);
+	for (uint32_t vertex = 0; vertex < gridPositions.size(); ++vertex)
+	{
+		const cd::Vec3f& position = gridPositions[vertex];
+		bool isBorder = 0.0f == position.x() || 0.0f == position.z() || gridSize == position.x() || gridSize == position.z();
+		assert(!isBorder || coarsestGridVertices.contains(vertex));
+	}
+
+	// Small meshes only have the full LOD.
+	builder.Build(gridPositions.data(), static_cast<uint32_t>(gridPositions.size()), gridIndices.data(), 6 * 10);
+	assert(builder.GetLODs().size() == 1 && builder.GetIndices().size() == 6 * 10);
+
+	// The coarsest LOD whose error is within a pixel is selected, and LODs get coarser with distance.
+	// A 1080p viewport with 60 degrees vertical field of view.
+	const float errorScale = 1080.0f * 0.5f / std::tan(3.14159265f / 6.0f);
+	assert(0 == SelectMeshLOD(lods, errorScale, -1.0f, 1.0f));
+	assert(0 == SelectMeshLOD(lods, errorScale, 0.1f, 1.0f));
+	assert(lods.size() - 1 == SelectMeshLOD(lods, errorScale, 1e6f, 1.0f));
+	uint32_t previousLODIndex = 0;
+	for (float viewDepth = 1.0f; viewDepth < 1000.0f; viewDepth *= 1.5f)
+	{
+		uint32_t lodIndex = SelectMeshLOD(lods, errorScale, viewDepth, 1.0f);
+		assert(lodIndex >= previousLODIndex && lods[lodIndex].error * errorScale <= viewDepth);
+		previousLODIndex = lodIndex;
+	}
+
+	printf("\n[Success] Test_MeshLODBuilder\n");
+}
+
+void Test_MeshOptimizer()
+{
+	cdtools::PerformanceProfiler perf("Test_MeshOptimizer");
+
+	// Triangles are compared by rotating their smallest index to the front, which keeps windings.
+	auto getSortedTriangles = [](const std::vector<uint32_t>& indices)
+	{
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (size_t index = 0; index < indices.size(); index += 3)
+		{
+			std::array<uint32_t, 3> triangle = { indices[index], indices[index + 1], indices[index + 2] };
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+
+	// A grid with shuffled triangles and vertexes, which is the worst case of importers.
+	constexpr uint32_t gridSize = 64;
+	constexpr uint32_t gridVertexCount = (gridSize + 1) * (gridSize + 1);
+	std::mt19937 randomEngine(24);
+	std::vector<uint32_t> vertexShuffle(gridVertexCount);
+	std::iota(vertexShuffle.begin(), vertexShuffle.end(), 0);
+	std::shuffle(vertexShuffle.begin(), vertexShuffle.end(), randomEngine);
+	std::vector<cd::Vec3f> gridPositions(gridVertexCount);
+	std::vector<std::array<uint32_t, 3>> gridTriangles;
+	for (uint32_t y = 0; y <= gridSize; ++y)
+	{
+		for (uint32_t x = 0; x <= gridSize; ++x)
+		{
+			uint32_t corner = y * (gridSize + 1) + x;
+			gridPositions[vertexShuffle[corner]] = cd::Vec3f(static_cast<float>(x), 0.0f, static_cast<float>(y));
+			if (x < gridSize && y < gridSize)
+			{
+				gridTriangles.push_back({ vertexShuffle[corner], vertexShuffle[corner + gridSize + 1], vertexShuffle[corner + 1] });
+				gridTriangles.push_back({ vertexShuffle[corner + 1], vertexShuffle[corner + gridSize + 1], vertexShuffle[corner + gridSize + 2] });
+			}
+		}
+	}
+	std::shuffle(gridTriangles.begin(), gridTriangles.end(), randomEngine);
+	std::vector<uint32_t> indices;
+	for (const std::array<uint32_t, 3>& triangle : gridTriangles)
+	{
+		indices.insert(indices.end(), triangle.begin(), triangle.end());
+	}
+	const uint32_t indexCount = static_cast<uint32_t>(indices.size());
+	const std::vector<std::array<uint32_t, 3>> originalTriangles = getSortedTriangles(indices);
+
+	VertexCacheStats originalStats = MeshOptimizer::AnalyzeVertexCache(indices.data(), indexCount, gridVertexCount);
+	std::vector<uint32_t> hardBoundaries;
+	{
+		cdtools::PerformanceProfiler optimizePerf("MeshOptimizer::OptimizeVertexCache");
+		MeshOptimizer::OptimizeVertexCache(indices.data(), indexCount, gridVertexCount, &hardBoundaries);
+	}
+	VertexCacheStats cacheStats = MeshOptimizer::AnalyzeVertexCache(indices.data(), indexCount, gridVertexCount);
+	assert(getSortedTriangles(indices) == originalTriangles);
+	assert(originalStats.acmr > 2.0f && cacheStats.acmr < 0.8f);
+	assert(cacheStats.atvr >= 1.0f && cacheStats.atvr < originalStats.atvr * 0.5f);
+	assert(std::is_sorted(hardBoundaries.begin(), hardBoundaries.end()) && (hardBoundaries.empty() || hardBoundaries.back() < indexCount / 3));
+
+	// Clustering for overdraw keeps the cache efficiency close to the threshold.
+	MeshOptimizer::OptimizeOverdraw(indices.data(), indexCount, gridPositions.data(), gridVertexCount, hardBoundaries);
+	VertexCacheStats overdrawStats = MeshOptimizer::AnalyzeVertexCache(indices.data(), indexCount, gridVertexCount);
+	assert(getSortedTriangles(indices) == originalTriangles);
+	assert(overdrawStats.acmr < 1.05f);
+	printf("Grid ACMR %f -> %f -> %f, ATVR %f -> %f -> %f\n", originalStats.acmr, cacheStats.acmr, overdrawStats.acmr,
+		originalStats.atvr, cacheStats.atvr, overdrawStats.atvr);
+
+	// Vertexes are renumbered by first use. The unused vertex is dropped.
+	std::vector<uint32_t> fetchIndices = indices;
+	std::vector<uint32_t> vertexOrder = MeshOptimizer::OptimizeVertexFetch(fetchIndices.data(), indexCount, gridVertexCount + 1);
+	assert(vertexOrder.size() == gridVertexCount);
+	uint32_t nextNewVertex = 0;
+	for (uint32_t index = 0; index < indexCount; ++index)
+	{
+		assert(fetchIndices[index] <= nextNewVertex && vertexOrder[fetchIndices[index]] == indices[index]);
+		nextNewVertex = std::max(nextNewVertex, fetchIndices[index] + 1);
+	}
+	assert(std::find(vertexOrder.begin(), vertexOrder.end(), gridVertexCount) == vertexOrder.end());
+	assert(MeshOptimizer::AnalyzeVertexCache(fetchIndices.data(), indexCount, gridVertexCount).acmr == overdrawStats.acmr);
+
+	// An inner box in an outer box. Faces of the outer box occlude the inner box from every view outside, so they go first.
+	std::vector<cd::Vec3f> boxPositions;
+	std::vector<uint32_t> boxIndices;
+	auto addBox = [&boxPositions, &boxIndices](float halfSize, uint32_t subdivision)
+	{
+		// Every face is a subdivided grid with outward triangles.
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			for (float side : { -1.0f, 1.0f })
+			{
+				uint32_t firstVertex = static_cast<uint32_t>(boxPositions.size());
+				for (uint32_t v = 0; v <= subdivision; ++v)
+				{
+					for (uint32_t u = 0; u <= subdivision; ++u)
+					{
+						cd::Vec3f position;
+						position[axis] = side * halfSize;
+						position[(axis + 1) % 3] = (2.0f * u / subdivision - 1.0f) * halfSize;
+						position[(axis + 2) % 3] = (2.0f * v / subdivision - 1.0f) * halfSize;
+						boxPositions.push_back(position);
+					}
+				}
+
+				for (uint32_t v = 0; v < subdivision; ++v)
+				{
+					for (uint32_t u = 0; u < subdivision; ++u)
+					{
+						uint32_t corner = firstVertex + v * (subdivision + 1) + u;
+						std::array<uint32_t, 6> quad = { corner, corner + 1, corner + subdivision + 2, corner, corner + subdivision + 2, corner + subdivision + 1 };
+						if (side < 0.0f)
+						{
+							std::swap(quad[1], quad[2]);
+							std::swap(quad[4], quad[5]);
+						}
+						boxIndices.insert(boxIndices.end(), quad.begin(), quad.end());
+					}
+				}
+			}
+		}
+	};
+	addBox(1.0f, 8);
+	const uint32_t innerTriangleCount = static_cast<uint32_t>(boxIndices.size() / 3);
+	const uint32_t innerVertexCount = static_cast<uint32_t>(boxPositions.size());
+	addBox(4.0f, 8);
+	const uint32_t boxIndexCount = static_cast<uint32_t>(boxIndices.size());
+	const uint32_t boxVertexCount = static_cast<uint32_t>(boxPositions.size());
+
+	// Clusters which are not cache efficient yet may continue into the inner box. They don't with the largest threshold,
+	// which splits clusters at every hard boundary.
+	auto countOuterFirstTriangles = [&](float acmrThreshold)
+	{
+		std::vector<uint32_t> optimizedIndices = boxIndices;
+		hardBoundaries.clear();
+		MeshOptimizer::OptimizeVertexCache(optimizedIndices.data(), boxIndexCount, boxVertexCount, &hardBoundaries);
+		MeshOptimizer::OptimizeOverdraw(optimizedIndices.data(), boxIndexCount, boxPositions.data(), boxVertexCount, hardBoundaries, acmrThreshold);
+		assert(getSortedTriangles(optimizedIndices) == getSortedTriangles(boxIndices));
+
+		uint32_t outerFirstCount = 0;
+		for (uint32_t triangle = 0; triangle < boxIndexCount / 3 - innerTriangleCount; ++triangle)
+		{
+			outerFirstCount += optimizedIndices[triangle * 3] >= innerVertexCount ? 1 : 0;
+		}
+		return outerFirstCount;
+	};
+	const uint32_t outerTriangleCount = boxIndexCount / 3 - innerTriangleCount;
+	uint32_t outerFirstCount = countOuterFirstTriangles(1.05f);
+	printf("Nested boxes : %u of %u outer triangles are drawn before inner triangles\n", outerFirstCount, outerTriangleCount);
+	assert(outerFirstCount * 20 >= outerTriangleCount * 19);
+	assert(countOuterFirstTriangles(3.0f) == outerTriangleCount);
+
+	printf("\n[Success] Test_MeshOptimizer\n");
+}
+
+void Test_VertexQuantization()
+{
+	cdtools::PerformanceProfiler perf("Test_VertexQuantization");
+
+	std::mt19937 randomEngine(25);
+	std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+
+	// Octahedral unorm8 directions. Axes and diagonals are tested too as they are on the folds.
+	std::vector<cd::Direction> directions = {
+		cd::Direction(1.0f, 0.0f, 0.0f), cd::Direction(-1.0f, 0.0f, 0.0f), cd::Direction(0.0f, 1.0f, 0.0f),
+		cd::Direction(0.0f, -1.0f, 0.0f), cd::Direction(0.0f, 0.0f, 1.0f), cd::Direction(0.0f, 0.0f, -1.0f),
+		cd::Direction(1.0f, 1.0f, -1.0f), cd::Direction(-1.0f, 1.0f, -1.0f), cd::Direction(-1.0f, -1.0f, 1.0f) };
+	while (directions.size() < 100000)
+	{
+		cd::Direction direction(unitDistribution(randomEngine), unitDistribution(randomEngine), unitDistribution(randomEngine));
+		if (direction.Length() > 0.01f && direction.Length() <= 1.0f)
+		{
+			directions.push_back(direction);
+		}
+	}
+
+	float minOctahedralCosine = 1.0f;
+	for (cd::Direction& direction : directions)
+	{
+		direction.Normalize();
+		cd::Direction decoded = VertexQuantizer::DecodeOctahedral(VertexQuantizer::EncodeOctahedral(direction));
+		assert(std::abs(decoded.Length() - 1.0f) < 1e-5f);
+		minOctahedralCosine = std::min(minOctahedralCosine, decoded.Dot(direction));
+	}
+	float maxOctahedralDegrees = std::acos(minOctahedralCosine) * 180.0f / 3.14159265f;
+	printf("Octahedral unorm8 : max error %.3f degrees\n", maxOctahedralDegrees);
+	assert(maxOctahedralDegrees < 1.0f);
+	assert(VertexQuantizer::DecodeOctahedral(VertexQuantizer::EncodeOctahedral(cd::Direction(0.0f))).Length() > 0.99f);
+
+	// Halves round trip exactly, except NaNs whose payloads may change.
+	for (uint32_t half = 0; half <= UINT16_MAX; ++half)
+	{
+		float value = VertexQuantizer::HalfToFloat(static_cast<uint16_t>(half));
+		if (!std::isnan(value))
+		{
+			assert(VertexQuantizer::FloatToHalf(value) == half);
+		}
+	}
+	assert(VertexQuantizer::FloatToHalf(1.0f) == 0x3C00);
+	assert(VertexQuantizer::FloatToHalf(-2.0f) == 0xC000);
+	assert(VertexQuantizer::FloatToHalf(65504.0f) == 0x7BFF);
+	assert(VertexQuantizer::FloatToHalf(65520.0f) == 0x7C00);
+	assert(VertexQuantizer::FloatToHalf(std::ldexp(1.0f, -24)) == 0x0001);
+	assert(VertexQuantizer::FloatToHalf(std::ldexp(1.0f, -26)) == 0x0000);
+
+	// Half UVs keep 11 significant bits, so errors are within half of an ulp relative to the value.
+	std::uniform_real_distribution<float> uvDistribution(-16.0f, 16.0f);
+	float maxUVRelativeError = 0.0f;
+	for (uint32_t sampleIndex = 0; sampleIndex < 100000; ++sampleIndex)
+	{
+		float uv = uvDistribution(randomEngine);
+		float error = std::abs(VertexQuantizer::HalfToFloat(VertexQuantizer::FloatToHalf(uv)) - uv);
+		assert(error <= std::max(std::abs(uv), std::ldexp(1.0f, -14)) * std::ldexp(1.0f, -11));
+		maxUVRelativeError = std::max(maxUVRelativeError, error / std::max(std::abs(uv), std::ldexp(1.0f, -14)));
+	}
+	printf("Half UV : max relative error %g\n", maxUVRelativeError);
+
+	// Snorm16 positions in the bounding box. The flat axis is kept exactly.
+	std::vector<cd::Point> positions;
+	for (uint32_t vertexIndex = 0; vertexIndex < 10000; ++vertexIndex)
+	{
+		positions.emplace_back(unitDistribution(randomEngine) * 50.0f + 100.0f, unitDistribution(randomEngine) * 0.25f, -3.0f);
+	}
+	PositionQuantization quantization = VertexQuantizer::MakePositionQuantization(positions.data(), static_cast<uint32_t>(positions.size()));
+	for (const cd::Point& position : positions)
+	{
+		cd::Point decoded = VertexQuantizer::DequantizePosition(VertexQuantizer::QuantizePosition(position, quantization), quantization);
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			assert(std::abs(decoded[axis] - position[axis]) <= quantization.scale[axis] / 32767.0f * 0.5f + std::abs(position[axis]) * FLT_EPSILON * 4.0f);
+		}
+		assert(decoded.z() == -3.0f);
+	}
+	printf("Position snorm16 : max error (%g, %g) and exact flat axis\n", quantization.scale.x() / 65534.0f, quantization.scale.y() / 65534.0f);
+
+	// Bone weights always sum to 1 after decoding.
+	std::uniform_real_distribution<float> weightDistribution(0.0f, 1.0f);
+	std::uniform_int_distribution<uint32_t> influenceDistribution(1, 4);
+	for (uint32_t sampleIndex = 0; sampleIndex < 100000; ++sampleIndex)
+	{
+		std::array<float, 4> weights = {};
+		uint32_t influenceCount = influenceDistribution(randomEngine);
+		float totalWeight = 0.0f;
+		for (uint32_t influenceIndex = 0; influenceIndex < influenceCount; ++influenceIndex)
+		{
+			weights[influenceIndex] = weightDistribution(randomEngine) + 1e-3f;
+			totalWeight += weights[influenceIndex];
+		}
+
+		std::array<uint8_t, 4> quantized = VertexQuantizer::QuantizeBoneWeights(weights);
+		uint32_t quantizedSum = 0;
+		for (uint32_t influenceIndex = 0; influenceIndex < 4; ++influenceIndex)
+		{
+			quantizedSum += quantized[influenceIndex];
+			assert(std::abs(quantized[influenceIndex] / 255.0f - weights[influenceIndex] / totalWeight) < 1.0f / 255.0f);
+		}
+		assert(255 == quantizedSum);
+	}
+	assert(VertexQuantizer::QuantizeBoneWeights({ 0.0f, 0.0f, 0.0f, 0.0f }) == (std::array<uint8_t, 4>{}));
+
+	// Strides of vs_PBR and vs_animation inputs.
+	constexpr uint32_t pbrStride = static_cast<uint32_t>(3 * sizeof(float) * 3 + 2 * sizeof(float));
+	constexpr uint32_t packedPBRStride = static_cast<uint32_t>(sizeof(std::array<int16_t, 4>) + sizeof(std::array<uint8_t, 4>) + sizeof(std::array<uint16_t, 2>));
+	constexpr uint32_t animationStride = static_cast<uint32_t>(3 * sizeof(float) + 4 * sizeof(uint16_t) + 4 * sizeof(float));
+	constexpr uint32_t packedAnimationStride = static_cast<uint32_t>(sizeof(std::array<int16_t, 4>) + sizeof(std::array<uint8_t, 4>) * 2);
+	printf("Vertex stride : PBR %u -> %u bytes, animation %u -> %u bytes\n", pbrStride, packedPBRStride, animationStride, packedAnimationStride);
+	static_assert(packedPBRStride * 2 < pbrStride && packedAnimationStride * 2 < animationStride);
+
+	printf("\n[Success] Test_VertexQuantization\n");
+}
+}
+
+int main()
+{
+	Test_FrustumCulling();
+	Test_RenderQueue();
+	Test_RenderQueueSubmitOrder();
+	Test_InstanceBatcher();
+	Test_RenderGraph();
+	Test_RenderTargetPool();
+	Test_LightClusterGrid();
+	Test_MeshLODBuilder();
+	Test_MeshOptimizer();
+	Test_VertexQuantization();
+
+	return 0;
+}
\ No newline at end of file